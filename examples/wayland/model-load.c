@@ -13,6 +13,8 @@
 #include "vulkan.h"
 #include "shader.h"
 #include "gltf-loader.h"
+#include "gltf-scene-graph.h"
+#include "gltf-mesh-lod.h"
 
 #define WIDTH 1920
 #define HEIGHT 1080
@@ -71,13 +73,17 @@ struct app_vk {
 	 * Keep track of data related to FlightHelmet.gltf
 	 */
 	struct kmr_gltf_loader_mesh *kmr_gltf_loader_mesh;
+	struct kmr_gltf_loader_mesh_lod *kmr_gltf_loader_mesh_lod;
 	struct kmr_gltf_loader_texture_image *kmr_gltf_loader_texture_image;
 	struct kmr_gltf_loader_material *kmr_gltf_loader_material;
+	struct kmr_gltf_loader_scene_graph *kmr_gltf_loader_scene_graph;
 
 	/*
 	 * Other required data needed for draw operations
 	 */
 	uint32_t indexBufferOffset;
+	uint32_t drawCount;
+	uint32_t *drawList; // Scene graph nodes visible to the camera
 	struct kmr_utils_aligned_buffer modelTransferSpace;
 
 	// A primitive contains the data for a single draw call
@@ -86,7 +92,13 @@ struct app_vk {
 		mat4 matrix;
 		uint32_t firstIndex;
 		uint32_t indexCount;
+		uint32_t materialIndex; // Index into kmr_gltf_loader_material { materialData } and samplerColorMap
 		uint32_t bufferOffset; // Offset in VkBuffer. VkBuffer contains struct app_vertex_data data.
+		uint32_t lod; // Level returned by kmr_gltf_loader_mesh_lod_select(3), 0 draws @firstIndex/@indexCount
+		struct {
+			uint32_t firstIndex;
+			uint32_t indexCount;
+		} lods[KMR_GLTF_LOADER_MESH_LOD_LEVEL_MAX];
 	} *meshData;
 };
 
@@ -241,8 +253,8 @@ render (volatile bool *running, uint8_t *imageIndex, void *data)
 	vkAcquireNextImageKHR(app->kmr_vk_lgdev.logicalDevice, app->kmr_vk_swapchain.swapchain,
 	                      UINT64_MAX, imageSemaphore, VK_NULL_HANDLE, (uint32_t*)imageIndex);
 
-	record_vk_draw_commands(app, *imageIndex, extent2D);
 	update_uniform_buffer(app, *imageIndex, extent2D);
+	record_vk_draw_commands(app, *imageIndex, extent2D);
 
 	VkSemaphore waitSemaphores[1] = { imageSemaphore };
 	VkSemaphore signalSemaphores[1] = { renderSemaphore };
@@ -378,6 +390,10 @@ main (void)
 exit_error:
 	free(app.modelTransferSpace.alignedBufferMemory);
 	free(app.meshData);
+	free(app.drawList);
+	kmr_gltf_loader_scene_graph_destroy(app.kmr_gltf_loader_scene_graph);
+	kmr_gltf_loader_mesh_lod_destroy(app.kmr_gltf_loader_mesh_lod);
+	kmr_gltf_loader_mesh_destroy(app.kmr_gltf_loader_mesh);
 
 	/*
 	 * Let the api know of what addresses to free and fd's to close
@@ -916,6 +932,7 @@ create_vk_buffers (struct app_vk *app)
 		app->meshData[m].bufferOffset += vertexBufferDataSize;
 		vertexBufferDataSize += app->kmr_gltf_loader_mesh->meshData[m].vertexBufferDataSize;
 		indexBufferDataSize += app->kmr_gltf_loader_mesh->meshData[m].indexBufferDataSize;
+		indexBufferDataSize += app->kmr_gltf_loader_mesh_lod->lodData[m].indexBufferDataSize;
 	}
 
 	vertexBufferData = alloca(vertexBufferDataSize);		
@@ -955,9 +972,21 @@ create_vk_buffers (struct app_vk *app)
 		// kmr_utils_log(KMR_WARNING, "curVertexBufferIndex: %u, curIndexBufferIndex: %u", curVertexBufferIndex, curIndexBufferIndex);
 	}
 
-	// Free'ing kmr_gltf_loader_mesh no longer required
-	kmr_gltf_loader_mesh_destroy(app->kmr_gltf_loader_mesh);
-	app->kmr_gltf_loader_mesh = NULL;
+	// Simplified levels go after every mesh, they index the same vertices as the full mesh
+	for (m = 0; m < app->kmr_gltf_loader_mesh_lod->lodDataCount; m++) {
+		for (v = 0; v < app->kmr_gltf_loader_mesh_lod->levelCount; v++) {
+			app->meshData[m].lods[v].firstIndex = curIndexBufferIndex + app->kmr_gltf_loader_mesh_lod->lodData[m].levels[v].firstIndex;
+			app->meshData[m].lods[v].indexCount = app->kmr_gltf_loader_mesh_lod->lodData[m].levels[v].indexCount;
+		}
+
+		for (v = 0; v < app->kmr_gltf_loader_mesh_lod->lodData[m].indexBufferDataCount; v++) {
+			indexBufferData[curIndexBufferIndex + v] = app->kmr_gltf_loader_mesh_lod->lodData[m].indexBufferData[v];
+		}
+
+		curIndexBufferIndex += app->kmr_gltf_loader_mesh_lod->lodData[m].indexBufferDataCount;
+	}
+
+	// kmr_gltf_loader_mesh is kept until exit, culling and LOD selection need its bounding spheres
 
 	/*
 	 * Create CPU visible buffer [vertex + index]
@@ -1067,7 +1096,7 @@ static int
 create_vk_texture_images (struct app_vk *app)
 {
 	struct kmr_utils_image_buffer *imageData = NULL;
-	uint32_t curImage, imageCount = 0;
+	uint32_t curImage, mipLevel, imageCount = 0;
 	uint8_t textureImageIndex = 2, cpuVisibleImageBuffer = 3;
 
 	imageCount = app->kmr_gltf_loader_texture_image->imageCount;
@@ -1107,19 +1136,20 @@ create_vk_texture_images (struct app_vk *app)
 
 		imageViewCreateInfos[curImage].imageViewflags = 0;
 		imageViewCreateInfos[curImage].imageViewType = VK_IMAGE_VIEW_TYPE_2D;
-		imageViewCreateInfos[curImage].imageViewFormat = VK_FORMAT_R8G8B8A8_SRGB;
+		// KTX2/DDS textures are uploaded block compressed as is
+		imageViewCreateInfos[curImage].imageViewFormat = (imageData[curImage].vkFormat) ? imageData[curImage].vkFormat : VK_FORMAT_R8G8B8A8_SRGB;
 		imageViewCreateInfos[curImage].imageViewComponents = (VkComponentMapping) { .r = 0, .g = 0, .b = 0, .a = 0 };
 		imageViewCreateInfos[curImage].imageViewSubresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT; // Which aspect of image to view (i.e VK_IMAGE_ASPECT_COLOR_BIT view color)
 		imageViewCreateInfos[curImage].imageViewSubresourceRange.baseMipLevel = 0;                       // Start mipmap level to view from (https://en.wikipedia.org/wiki/Mipmap)
-		imageViewCreateInfos[curImage].imageViewSubresourceRange.levelCount = 1;                         // Number of mipmap levels to view
+		imageViewCreateInfos[curImage].imageViewSubresourceRange.levelCount = imageData[curImage].mipLevelCount; // Number of mipmap levels to view
 		imageViewCreateInfos[curImage].imageViewSubresourceRange.baseArrayLayer = 0;                     // Start array level to view from
 		imageViewCreateInfos[curImage].imageViewSubresourceRange.layerCount = 1;                         // Number of array levels to view
 
 		vimageCreateInfos[curImage].imageflags = 0;
 		vimageCreateInfos[curImage].imageType = VK_IMAGE_TYPE_2D;
-		vimageCreateInfos[curImage].imageFormat = VK_FORMAT_R8G8B8A8_SRGB;
+		vimageCreateInfos[curImage].imageFormat = imageViewCreateInfos[curImage].imageViewFormat;
 		vimageCreateInfos[curImage].imageExtent3D = (VkExtent3D) { .width = imageData[curImage].imageWidth, .height = imageData[curImage].imageHeight, .depth = 1 };
-		vimageCreateInfos[curImage].imageMipLevels = 1;
+		vimageCreateInfos[curImage].imageMipLevels = imageData[curImage].mipLevelCount;
 		vimageCreateInfos[curImage].imageArrayLayers = 1;
 		vimageCreateInfos[curImage].imageSamples = VK_SAMPLE_COUNT_1_BIT;
 		vimageCreateInfos[curImage].imageTiling = VK_IMAGE_TILING_OPTIMAL;
@@ -1207,21 +1237,26 @@ create_vk_texture_images (struct app_vk *app)
 			return -1;
 		}
 
-		/* Copy pixel buffer to VkImage Resource */
+		/* Copy pixel buffer to VkImage Resource, one region per mip level */
 		copyRegion.imageSubresource.aspectMask = imageViewCreateInfos[curImage].imageViewSubresourceRange.aspectMask;
-		copyRegion.imageSubresource.mipLevel = imageViewCreateInfos[curImage].imageViewSubresourceRange.baseMipLevel;
 		copyRegion.imageSubresource.baseArrayLayer = imageViewCreateInfos[curImage].imageViewSubresourceRange.baseArrayLayer;
 		copyRegion.imageSubresource.layerCount = imageViewCreateInfos[curImage].imageViewSubresourceRange.layerCount;
 		copyRegion.imageOffset = (VkOffset3D) { .x = 0, .y = 0, .z = 0 };
-		copyRegion.imageExtent = vimageCreateInfos[curImage].imageExtent3D;
-		copyRegion.bufferOffset = imageData[curImage].imageBufferOffset;
 
 		bufferCopyInfo.dstResource = app->kmr_vk_image[textureImageIndex].imageHandles[curImage].image;
 
-		if (kmr_vk_resource_copy(&bufferCopyInfo) == -1) {
-			kmr_gltf_loader_texture_image_destroy(app->kmr_gltf_loader_texture_image);
-			app->kmr_gltf_loader_texture_image = NULL;
-			return -1;
+		for (mipLevel = 0; mipLevel < imageData[curImage].mipLevelCount; mipLevel++) {
+			copyRegion.imageSubresource.mipLevel = mipLevel;
+			copyRegion.imageExtent = (VkExtent3D) { .width = imageData[curImage].mipLevels[mipLevel].width,
+			                                        .height = imageData[curImage].mipLevels[mipLevel].height,
+			                                        .depth = 1 };
+			copyRegion.bufferOffset = imageData[curImage].imageBufferOffset + imageData[curImage].mipLevels[mipLevel].offset;
+
+			if (kmr_vk_resource_copy(&bufferCopyInfo) == -1) {
+				kmr_gltf_loader_texture_image_destroy(app->kmr_gltf_loader_texture_image);
+				app->kmr_gltf_loader_texture_image = NULL;
+				return -1;
+			}
 		}
 
 		imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
@@ -1255,38 +1290,56 @@ create_vk_texture_images (struct app_vk *app)
 static int
 create_gltf_load_required_data (struct app_vk *app)
 {
-	uint32_t meshIndex;
+	uint32_t meshIndex, nodeIndex;
 
 	struct kmr_gltf_loader_file *gltfLoaderFile = NULL;
-	struct kmr_gltf_loader_node *gltfLoaderFileNodes = NULL;
 
 	struct kmr_gltf_loader_file_create_info gltfLoaderFileCreateInfo;
 	struct kmr_gltf_loader_mesh_create_info gltfMeshInfo;
+	struct kmr_gltf_loader_mesh_lod_create_info gltfMeshLodInfo;
 	struct kmr_gltf_loader_texture_image_create_info gltfTextureImagesInfo;
-	struct kmr_gltf_loader_node_create_info gltfLoaderFileNodeInfo;
+	struct kmr_gltf_loader_scene_graph_create_info gltfSceneGraphInfo;
 	struct kmr_gltf_loader_material_create_info gltfLoaderMaterialInfo;
 
 	gltfLoaderFileCreateInfo.fileName = GLTF_MODEL;
+	gltfLoaderFileCreateInfo.flags = KMR_GLTF_LOADER_FILE_CREATE_MMAP;
 	gltfLoaderFile = kmr_gltf_loader_file_create(&gltfLoaderFileCreateInfo);
 	if (!gltfLoaderFile->gltfData)
 		return -1;
 
 	gltfMeshInfo.gltfFile = gltfLoaderFile;
 	gltfMeshInfo.bufferIndex = 0;
+	gltfMeshInfo.threadCount = 0;
+	gltfMeshInfo.flags = 0;
+	gltfMeshInfo.vertexLayout = KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_INTERLEAVED;
+	gltfMeshInfo.arena = NULL;
+	gltfMeshInfo.arenaSize = 0;
 	app->kmr_gltf_loader_mesh = kmr_gltf_loader_mesh_create(&gltfMeshInfo);
 	if (!app->kmr_gltf_loader_mesh)
 		goto exit_error_create_gltf_load_required_data;
 
+	gltfMeshLodInfo.mesh = app->kmr_gltf_loader_mesh;
+	gltfMeshLodInfo.levelCount = 3;
+	gltfMeshLodInfo.ratios[0] = 0.5f;
+	gltfMeshLodInfo.ratios[1] = 0.25f;
+	gltfMeshLodInfo.ratios[2] = 0.125f;
+	gltfMeshLodInfo.threadCount = 0;
+	app->kmr_gltf_loader_mesh_lod = kmr_gltf_loader_mesh_lod_create(&gltfMeshLodInfo);
+	if (!app->kmr_gltf_loader_mesh_lod)
+		goto exit_error_create_gltf_load_required_data;
+
 	gltfTextureImagesInfo.gltfFile = gltfLoaderFile;
 	gltfTextureImagesInfo.directory = gltfLoaderFileCreateInfo.fileName;
+	gltfTextureImagesInfo.threadCount = 0;
+	gltfTextureImagesInfo.mipFilter = KMR_UTILS_IMAGE_BUFFER_MIP_FILTER_BOX;
 	app->kmr_gltf_loader_texture_image = kmr_gltf_loader_texture_image_create(&gltfTextureImagesInfo);
 	if (!app->kmr_gltf_loader_texture_image)
 		goto exit_error_create_gltf_load_required_data;
 
-	gltfLoaderFileNodeInfo.gltfFile = gltfLoaderFile;
-	gltfLoaderFileNodeInfo.sceneIndex = 0;
-	gltfLoaderFileNodes = kmr_gltf_loader_node_create(&gltfLoaderFileNodeInfo);
-	if (!gltfLoaderFileNodes->nodeData)
+	gltfSceneGraphInfo.gltfFile = gltfLoaderFile;
+	gltfSceneGraphInfo.sceneIndex = 0;
+	app->kmr_gltf_loader_scene_graph = kmr_gltf_loader_scene_graph_create(&gltfSceneGraphInfo);
+	if (!app->kmr_gltf_loader_scene_graph)
 		goto exit_error_create_gltf_load_required_data;
 
 	gltfLoaderMaterialInfo.gltfFile = gltfLoaderFile;
@@ -1301,30 +1354,48 @@ create_gltf_load_required_data (struct app_vk *app)
 		goto exit_error_create_gltf_load_required_data;
 	}
 
-	// Copy TRS matrix transform data to the passable buffer used during draw operations
-	for (meshIndex = 0; meshIndex < gltfLoaderFileNodes->nodeDataCount; meshIndex++) {
-		// glm_mat4_copy(gltfLoaderFileNodes.nodeData[meshIndex].matrixTransform, app->meshData[gltfLoaderFileNodes.nodeData[meshIndex].objectIndex].matrix);
-		memcpy(app->meshData[gltfLoaderFileNodes->nodeData[meshIndex].objectIndex].matrix, \
-		       gltfLoaderFileNodes->nodeData[meshIndex].matrixTransform, \
+	app->drawList = calloc(app->kmr_gltf_loader_scene_graph->nodeCount, sizeof(uint32_t));
+	if (!app->drawList) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(app->drawList): %s", strerror(errno));
+		goto exit_error_create_gltf_load_required_data;
+	}
+
+	// Copy world matrix of mesh nodes to the passable buffer used during draw operations
+	for (nodeIndex = 0; nodeIndex < app->kmr_gltf_loader_scene_graph->nodeCount; nodeIndex++) {
+		if (app->kmr_gltf_loader_scene_graph->objectType[nodeIndex] != KMR_GLTF_LOADER_GLTF_MESH)
+			continue;
+
+		memcpy(app->meshData[app->kmr_gltf_loader_scene_graph->objectIndex[nodeIndex]].matrix, \
+		       app->kmr_gltf_loader_scene_graph->worldMatrix[nodeIndex], \
 		       sizeof(mat4));
+	}
+
+	for (meshIndex = 0; meshIndex < app->meshCount; meshIndex++) {
 		app->meshData[meshIndex].firstIndex = app->kmr_gltf_loader_mesh->meshData[meshIndex].firstIndex;
 		app->meshData[meshIndex].indexCount = app->kmr_gltf_loader_mesh->meshData[meshIndex].indexBufferDataCount;
+		// Materials are shared between primitives, every primitive of a mesh uses the first one's material
+		app->meshData[meshIndex].materialIndex = (app->kmr_gltf_loader_mesh->meshData[meshIndex].primitiveCount) ?
+			app->kmr_gltf_loader_mesh->meshData[meshIndex].primitives[0].materialIndex : UINT32_MAX;
+		if (app->meshData[meshIndex].materialIndex == UINT32_MAX)
+			app->meshData[meshIndex].materialIndex = 0;
 	}
 
 	// Have everything we need free memory created
-	kmr_gltf_loader_node_destroy(gltfLoaderFileNodes);
 	kmr_gltf_loader_file_destroy(gltfLoaderFile);
 	return 0;
 
 exit_error_create_gltf_load_required_data:
-	kmr_gltf_loader_node_destroy(gltfLoaderFileNodes);
+	kmr_gltf_loader_scene_graph_destroy(app->kmr_gltf_loader_scene_graph);
 	kmr_gltf_loader_material_destroy(app->kmr_gltf_loader_material);
 	kmr_gltf_loader_texture_image_destroy(app->kmr_gltf_loader_texture_image);
+	kmr_gltf_loader_mesh_lod_destroy(app->kmr_gltf_loader_mesh_lod);
 	kmr_gltf_loader_mesh_destroy(app->kmr_gltf_loader_mesh);
 	kmr_gltf_loader_file_destroy(gltfLoaderFile);
 	app->kmr_gltf_loader_material = NULL;
 	app->kmr_gltf_loader_texture_image = NULL;
+	app->kmr_gltf_loader_mesh_lod = NULL;
 	app->kmr_gltf_loader_mesh = NULL;
+	app->kmr_gltf_loader_scene_graph = NULL;
 	return -1;
 }
 
@@ -1344,7 +1415,7 @@ create_vk_image_sampler (struct app_vk *app)
 	vkSamplerCreateInfo.samplerMipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
 	vkSamplerCreateInfo.samplerMipLodBias = 0.0f;
 	vkSamplerCreateInfo.samplerMinLod = 0.0f;
-	vkSamplerCreateInfo.samplerMaxLod = 0.0f;
+	vkSamplerCreateInfo.samplerMaxLod = VK_LOD_CLAMP_NONE;                 // Sample every mip level a texture has
 	vkSamplerCreateInfo.samplerUnnormalizedCoordinates = VK_FALSE;
 	vkSamplerCreateInfo.samplerBorderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
 	vkSamplerCreateInfo.samplerAnisotropyEnable = VK_TRUE;
@@ -1437,10 +1508,13 @@ create_vk_resource_descriptor_sets (struct app_vk *app)
 	bufferInfos[1].range = app->modelTransferSpace.bufferAlignment;
 
 	// Texture images from GLTF file
-	uint8_t baseColorTextureImageIndex;
+	uint32_t baseColorTextureImageIndex;
 	VkDescriptorImageInfo imageInfos[materialCount];
 	for (i = 0; i < materialCount; i++) {
+		// Untextured materials sample the first image
 		baseColorTextureImageIndex = materialData[i].pbrMetallicRoughness.baseColorTexture.imageIndex;
+		if (baseColorTextureImageIndex == UINT32_MAX)
+			baseColorTextureImageIndex = 0;
 		imageInfos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 		imageInfos[i].imageView = app->kmr_vk_image[2].imageViewHandles[baseColorTextureImageIndex].view; // created in create_vk_texture_image
 		imageInfos[i].sampler = app->kmr_vk_sampler.sampler;                                              // created in create_vk_image_sampler
@@ -1886,13 +1960,19 @@ record_vk_draw_commands (struct app_vk *app,
 
 	VkDeviceSize offset;
 	uint32_t dynamicUniformBufferOffset = 0;
-	for (uint32_t mesh = 0; mesh < app->meshCount; mesh++) {
+	for (uint32_t draw = 0, mesh, lod; draw < app->drawCount; draw++) {
+		mesh = app->kmr_gltf_loader_scene_graph->objectIndex[app->drawList[draw]];
 		offset = app->meshData[mesh].bufferOffset;
 		dynamicUniformBufferOffset = mesh * app->modelTransferSpace.bufferAlignment;
 		vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, app->kmr_vk_pipeline_layout.pipelineLayout, 0, 1,
 		                        &app->kmr_vk_descriptor_set.descriptorSetHandles[0].descriptorSet, 1, &dynamicUniformBufferOffset);
 		vkCmdBindVertexBuffers(cmdBuffer, 0, 1, &vertexBuffer, &offset);
-		vkCmdDrawIndexed(cmdBuffer, app->meshData[mesh].indexCount, 1, app->meshData[mesh].firstIndex, 0, 0);
+		lod = app->meshData[mesh].lod;
+		if (lod) {
+			vkCmdDrawIndexed(cmdBuffer, app->meshData[mesh].lods[lod-1].indexCount, 1, app->meshData[mesh].lods[lod-1].firstIndex, 0, 0);
+		} else {
+			vkCmdDrawIndexed(cmdBuffer, app->meshData[mesh].indexCount, 1, app->meshData[mesh].firstIndex, 0, 0);
+		}
 	}
 
 	vkCmdEndRenderPass(cmdBuffer);
@@ -1959,7 +2039,34 @@ update_uniform_buffer (struct app_vk *app,
 		sceneModel = (struct app_uniform_buffer_scene_model *) ((uint64_t) app->modelTransferSpace.alignedBufferMemory + (mesh * app->modelTransferSpace.bufferAlignment));
 		glm_rotate(app->meshData[mesh].matrix, glm_rad(angle), axis);
 		memcpy(sceneModel->model, app->meshData[mesh].matrix, sizeof(mat4));
-		sceneModel->textureIndex = mesh;
+		sceneModel->textureIndex = app->meshData[mesh].materialIndex;
+	}
+
+	// Cull mesh nodes with their spun matrices, only those visible get recorded
+	struct kmr_gltf_loader_scene_graph *sceneGraph = app->kmr_gltf_loader_scene_graph;
+	for (uint32_t node = 0; node < sceneGraph->nodeCount; node++) {
+		if (sceneGraph->objectType[node] == KMR_GLTF_LOADER_GLTF_MESH)
+			memcpy(sceneGraph->worldMatrix[node], app->meshData[sceneGraph->objectIndex[node]].matrix, sizeof(mat4));
+	}
+
+	struct kmr_gltf_loader_scene_graph_cull_info cullInfo;
+	cullInfo.mesh = app->kmr_gltf_loader_mesh;
+	cullInfo.sceneGraph = sceneGraph;
+	cullInfo.skin = NULL;
+	cullInfo.drawList = app->drawList;
+	glm_mat4_mul(ubo.projection, ubo.view, cullInfo.viewProjection);
+	app->drawCount = kmr_gltf_loader_scene_graph_cull(&cullInfo);
+
+	// Visible meshes far from the camera get drawn with one of their simplified levels
+	struct kmr_gltf_loader_mesh_lod_select_info lodSelectInfo;
+	lodSelectInfo.lod = app->kmr_gltf_loader_mesh_lod;
+	lodSelectInfo.mesh = app->kmr_gltf_loader_mesh;
+	lodSelectInfo.projectionScale = -ubo.projection[1][1] * (float) extent2D.height * 0.5f;
+	lodSelectInfo.pixelError = 1.0f;
+	for (uint32_t draw = 0; draw < app->drawCount; draw++) {
+		lodSelectInfo.meshIndex = sceneGraph->objectIndex[app->drawList[draw]];
+		glm_mat4_mul(ubo.view, app->meshData[lodSelectInfo.meshIndex].matrix, lodSelectInfo.modelView);
+		app->meshData[lodSelectInfo.meshIndex].lod = kmr_gltf_loader_mesh_lod_select(&lodSelectInfo);
 	}
 
 	// Map all Model data
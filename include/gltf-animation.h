@@ -0,0 +1,185 @@
+#ifndef KMR_GLTF_ANIMATION_H
+#define KMR_GLTF_ANIMATION_H
+
+#include "gltf-scene-graph.h"
+
+
+/*
+ * enum kmr_gltf_loader_animation_path (kmsroots GLTF Loader Animation Path)
+ *
+ * Node property animated by a channel. Morph target weights aren't supported.
+ */
+enum kmr_gltf_loader_animation_path {
+	KMR_GLTF_LOADER_ANIMATION_PATH_TRANSLATION = 0,
+	KMR_GLTF_LOADER_ANIMATION_PATH_ROTATION    = 1,
+	KMR_GLTF_LOADER_ANIMATION_PATH_SCALE       = 2,
+};
+
+
+/*
+ * enum kmr_gltf_loader_animation_interpolation (kmsroots GLTF Loader Animation Interpolation)
+ *
+ * @KMR_GLTF_LOADER_ANIMATION_INTERPOLATION_LINEAR      - Linear interpolation. Rotations are spherically interpolated.
+ * @KMR_GLTF_LOADER_ANIMATION_INTERPOLATION_STEP        - Value of the previous key is held until the next key.
+ * @KMR_GLTF_LOADER_ANIMATION_INTERPOLATION_CUBICSPLINE - Cubic hermite spline. Every key stores an in-tangent,
+ *                                                        value and out-tangent.
+ */
+enum kmr_gltf_loader_animation_interpolation {
+	KMR_GLTF_LOADER_ANIMATION_INTERPOLATION_LINEAR      = 0,
+	KMR_GLTF_LOADER_ANIMATION_INTERPOLATION_STEP        = 1,
+	KMR_GLTF_LOADER_ANIMATION_INTERPOLATION_CUBICSPLINE = 2,
+};
+
+
+/*
+ * struct kmr_gltf_loader_animation_channel (kmsroots GLTF Loader Animation Channel)
+ *
+ * members:
+ * @node          - Flattened index of the animated node in struct kmr_gltf_loader_scene_graph
+ * @path          - Node property written to
+ * @interpolation - How values in between keys are computed
+ * @keyCount      - Amount of keys
+ * @timeOffset    - Offset in floats of the first key time in struct kmr_gltf_loader_animation { @times }.
+ *                  Channels sharing an input accessor share key times.
+ * @valueOffset   - Offset in floats of the first value in struct kmr_gltf_loader_animation { @values }.
+ *                  Values are 3 (translation, scale) or 4 (rotation) floats per key, three
+ *                  times that for cubic splines (in-tangent, value, out-tangent).
+ * @lastKey       - Key found by the previous sample. Searching starts from here as playback
+ *                  usually only moves forward by a few keys per frame.
+ */
+struct kmr_gltf_loader_animation_channel {
+	uint32_t                                     node;
+	enum kmr_gltf_loader_animation_path          path;
+	enum kmr_gltf_loader_animation_interpolation interpolation;
+	uint32_t                                     keyCount;
+	uint32_t                                     timeOffset;
+	uint32_t                                     valueOffset;
+	uint32_t                                     lastKey;
+};
+
+
+/*
+ * struct kmr_gltf_loader_animation_data (kmsroots GLTF Loader Animation Data)
+ *
+ * members:
+ * @firstChannel - Index of the animation's first channel in struct kmr_gltf_loader_animation { @channels }
+ * @channelCount - Amount of channels belonging to the animation
+ * @duration     - Time in seconds of the animation's last key
+ */
+struct kmr_gltf_loader_animation_data {
+	uint32_t firstChannel;
+	uint32_t channelCount;
+	float    duration;
+};
+
+
+/*
+ * struct kmr_gltf_loader_animation (kmsroots GLTF Loader Animation)
+ *
+ * members:
+ * @animationDataCount - Amount of elements in @animationData array. Same as the amount of
+ *                       animations in GLTF file "animations" (json key) array.
+ * @animationData      - Pointer to an array of struct kmr_gltf_loader_animation_data
+ * @channelCount       - Amount of elements in @channels array
+ * @channels           - Pointer to an array of struct kmr_gltf_loader_animation_channel.
+ *                       Channels of one animation are contiguous.
+ * @timeCount          - Amount of elements in @times array
+ * @times              - Key times of every channel in seconds
+ * @valueCount         - Amount of elements in @values array
+ * @values             - Key values of every channel
+ */
+struct kmr_gltf_loader_animation {
+	uint32_t                                 animationDataCount;
+	struct kmr_gltf_loader_animation_data    *animationData;
+	uint32_t                                 channelCount;
+	struct kmr_gltf_loader_animation_channel *channels;
+	uint32_t                                 timeCount;
+	float                                    *times;
+	uint32_t                                 valueCount;
+	float                                    *values;
+};
+
+
+/*
+ * struct kmr_gltf_loader_animation_create_info (kmsroots GLTF Loader Animation Create Information)
+ *
+ * members:
+ * @gltfFile   - Must pass a valid pointer to a struct kmr_gltf_loader_file
+ *               for cgltf_data @gltfData member.
+ * @sceneGraph - Must pass a valid pointer to the struct kmr_gltf_loader_scene_graph animations
+ *               are played on. Channels targeting nodes outside of the scene are dropped.
+ */
+struct kmr_gltf_loader_animation_create_info {
+	struct kmr_gltf_loader_file        *gltfFile;
+	struct kmr_gltf_loader_scene_graph *sceneGraph;
+};
+
+
+/*
+ * kmr_gltf_loader_animation_create: Bakes the key times and values of every animation channel in a GLTF file into
+ *                                   contiguous float arrays. Integer (quantized) values are converted to floats.
+ *
+ * parameters:
+ * @animationInfo - Must pass a pointer to a struct kmr_gltf_loader_animation_create_info
+ * returns:
+ *	on success pointer to a struct kmr_gltf_loader_animation
+ *	on failure NULL
+ */
+struct kmr_gltf_loader_animation *
+kmr_gltf_loader_animation_create (struct kmr_gltf_loader_animation_create_info *animationInfo);
+
+
+/*
+ * struct kmr_gltf_loader_animation_sample_info (kmsroots GLTF Loader Animation Sample Information)
+ *
+ * members:
+ * @animation      - Must pass a valid pointer to a struct kmr_gltf_loader_animation
+ * @sceneGraph     - Must pass a valid pointer to the struct kmr_gltf_loader_scene_graph
+ *                   passed to kmr_gltf_loader_animation_create()
+ * @animationIndex - Index in GLTF file "animations" (json key) array
+ * @time           - Time in seconds. Values before the first and after the last key are clamped,
+ *                   wrap @time with struct kmr_gltf_loader_animation_data { @duration } to loop.
+ */
+struct kmr_gltf_loader_animation_sample_info {
+	struct kmr_gltf_loader_animation   *animation;
+	struct kmr_gltf_loader_scene_graph *sceneGraph;
+	uint32_t                           animationIndex;
+	float                              time;
+};
+
+
+/*
+ * kmr_gltf_loader_animation_sample: Evaluates every channel of an animation at a given time and writes the results into
+ *                                   the scene graph's node translation, rotation and scale. Animated nodes are marked
+ *                                   dirty, call kmr_gltf_loader_scene_graph_update() afterwards. Linear rotations are
+ *                                   interpolated in batches with SIMD using a corrected nlerp that approximates slerp.
+ *                                   Not thread safe for the same @animation, channels cache the last key found.
+ *
+ * parameters:
+ * @sampleInfo - Must pass a pointer to a struct kmr_gltf_loader_animation_sample_info
+ * returns:
+ *	on success 0
+ *	on failure -1
+ */
+int
+kmr_gltf_loader_animation_sample (struct kmr_gltf_loader_animation_sample_info *sampleInfo);
+
+
+/*
+ * kmr_gltf_loader_animation_destroy: Frees any allocated memory created after kmr_gltf_loader_animation_create() call.
+ *
+ * parameters:
+ * @animation - Pointer to a valid struct kmr_gltf_loader_animation
+ *
+ *              Free'd members
+ *              struct kmr_gltf_loader_animation {
+ *                  struct kmr_gltf_loader_animation_data    *animationData;
+ *                  struct kmr_gltf_loader_animation_channel *channels;
+ *                  float                                    *times;
+ *                  float                                    *values;
+ *              }
+ */
+void
+kmr_gltf_loader_animation_destroy (struct kmr_gltf_loader_animation *animation);
+
+#endif /* KMR_GLTF_ANIMATION_H */
@@ -0,0 +1,153 @@
+#ifndef KMR_GLTF_ASYNC_H
+#define KMR_GLTF_ASYNC_H
+
+#include "gltf-scene-graph.h"
+
+
+/*
+ * enum kmr_gltf_loader_async_stage (kmsroots GLTF Loader Async Stage)
+ *
+ * Stages of a background load started by kmr_gltf_loader_async_create(). Stages complete in the order listed.
+ *
+ * @KMR_GLTF_LOADER_ASYNC_STAGE_GEOMETRY      - struct kmr_gltf_loader_async { @gltfFile, @mesh, @sceneGraph } are populated.
+ *                                              Enough to create vertex/index buffers and record the first frame.
+ * @KMR_GLTF_LOADER_ASYNC_STAGE_MATERIAL      - struct kmr_gltf_loader_async { @material } is populated
+ * @KMR_GLTF_LOADER_ASYNC_STAGE_TEXTURE_IMAGE - struct kmr_gltf_loader_async { @textureImage } is populated
+ * @KMR_GLTF_LOADER_ASYNC_STAGE_FAILED        - A stage failed, no further stages complete
+ */
+enum kmr_gltf_loader_async_stage {
+	KMR_GLTF_LOADER_ASYNC_STAGE_GEOMETRY      = (1 << 0),
+	KMR_GLTF_LOADER_ASYNC_STAGE_MATERIAL      = (1 << 1),
+	KMR_GLTF_LOADER_ASYNC_STAGE_TEXTURE_IMAGE = (1 << 2),
+	KMR_GLTF_LOADER_ASYNC_STAGE_FAILED        = (1 << 3),
+};
+
+
+/*
+ * struct kmr_gltf_loader_async (kmsroots GLTF Loader Async)
+ *
+ * members:
+ * @eventFd          - eventfd(2) file descriptor, readable after a stage completes. May be added to an
+ *                     epoll(7) set, the application then calls kmr_gltf_loader_async_poll().
+ * @gltfFile         - Pointer to the loaded struct kmr_gltf_loader_file
+ * @mesh             - Pointer to a struct kmr_gltf_loader_mesh
+ * @sceneGraph       - Pointer to a struct kmr_gltf_loader_scene_graph
+ * @material         - Pointer to a struct kmr_gltf_loader_material
+ * @textureImage     - Pointer to a struct kmr_gltf_loader_texture_image
+ * @geometryTime     - Nanoseconds between kmr_gltf_loader_async_create() and completion of each stage.
+ * @materialTime       Zero until the stage completes.
+ * @textureImageTime
+ *
+ * Members only become valid once their stage has been returned by kmr_gltf_loader_async_poll() or passed
+ * to the completion callback. After that an application may take ownership of a member by setting
+ * it to NULL, except @gltfFile which is in use until the last requested stage completes.
+ */
+struct kmr_gltf_loader_async {
+	int                                  eventFd;
+	struct kmr_gltf_loader_file          *gltfFile;
+	struct kmr_gltf_loader_mesh          *mesh;
+	struct kmr_gltf_loader_scene_graph   *sceneGraph;
+	struct kmr_gltf_loader_material      *material;
+	struct kmr_gltf_loader_texture_image *textureImage;
+	uint64_t                             geometryTime;
+	uint64_t                             materialTime;
+	uint64_t                             textureImageTime;
+};
+
+
+/*
+ * kmr_gltf_loader_async_callback: Function pointer prototype for the completion callback ran after each stage.
+ *                                 Called from the loader thread, so must not block for long.
+ *
+ * parameters:
+ * @async    - Pointer to the struct kmr_gltf_loader_async being loaded
+ * @stage    - The single stage that completed
+ * @userData - Pointer passed via struct kmr_gltf_loader_async_create_info { @userData }
+ */
+typedef void (*kmr_gltf_loader_async_callback)(struct kmr_gltf_loader_async *async,
+                                               enum kmr_gltf_loader_async_stage stage,
+                                               void *userData);
+
+
+/*
+ * struct kmr_gltf_loader_async_create_info (kmsroots GLTF Loader Async Create Information)
+ *
+ * members:
+ * @fileName     - Must pass the path to the gltf file to load. Copied, doesn't have to outlive the call.
+ * @fileFlags    - See struct kmr_gltf_loader_file_create_info { @flags }
+ * @bufferIndex  - See struct kmr_gltf_loader_mesh_create_info { @bufferIndex }
+ * @meshFlags    - See struct kmr_gltf_loader_mesh_create_info { @flags }
+ * @vertexLayout - See struct kmr_gltf_loader_mesh_create_info { @vertexLayout }
+ * @sceneIndex   - See struct kmr_gltf_loader_scene_graph_create_info { @sceneIndex }
+ * @stages       - Bitmask of enum kmr_gltf_loader_async_stage to load. KMR_GLTF_LOADER_ASYNC_STAGE_GEOMETRY
+ *                 is always loaded.
+ * @threadCount  - Amount of worker threads each stage may use. 0 uses every online CPU.
+ * @mipFilter    - See struct kmr_gltf_loader_texture_image_create_info { @mipFilter }
+ * @callback     - Optional function called on the loader thread after each stage completes. May be NULL.
+ * @userData     - Pointer passed to @callback
+ */
+struct kmr_gltf_loader_async_create_info {
+	const char                              *fileName;
+	enum kmr_gltf_loader_file_create_flags  fileFlags;
+	uint16_t                                bufferIndex;
+	enum kmr_gltf_loader_mesh_create_flags  meshFlags;
+	enum kmr_gltf_loader_mesh_vertex_layout vertexLayout;
+	uint32_t                                sceneIndex;
+	uint32_t                                stages;
+	uint32_t                                threadCount;
+	enum kmr_utils_image_buffer_mip_filter  mipFilter;
+	kmr_gltf_loader_async_callback          callback;
+	void                                    *userData;
+};
+
+
+/*
+ * kmr_gltf_loader_async_create: Starts loading a gltf file on a background thread and returns immediately.
+ *                               Geometry (file, meshes, scene graph) is loaded first so an application can
+ *                               start drawing before materials and texture images are decoded. Completion
+ *                               of each stage is reported through the optional callback and @eventFd.
+ *
+ * parameters:
+ * @asyncInfo - Must pass a pointer to a struct kmr_gltf_loader_async_create_info
+ * returns:
+ *	on success pointer to a struct kmr_gltf_loader_async
+ *	on failure NULL
+ */
+struct kmr_gltf_loader_async *
+kmr_gltf_loader_async_create (struct kmr_gltf_loader_async_create_info *asyncInfo);
+
+
+/*
+ * kmr_gltf_loader_async_poll: Clears @eventFd and returns the stages completed since the last call. Never blocks.
+ *                             Can return 0 if stages were already returned by an earlier call.
+ *
+ * parameters:
+ * @async - Pointer to a valid struct kmr_gltf_loader_async
+ * returns:
+ *	Bitmask of enum kmr_gltf_loader_async_stage
+ */
+uint32_t
+kmr_gltf_loader_async_poll (struct kmr_gltf_loader_async *async);
+
+
+/*
+ * kmr_gltf_loader_async_destroy: Cancels stages not yet started, waits for the loader thread to exit then frees
+ *                                any allocated memory and closes fd's created after kmr_gltf_loader_async_create() call.
+ *
+ * parameters:
+ * @async - Pointer to a valid struct kmr_gltf_loader_async
+ *
+ *          Free'd members with fd's closed
+ *          struct kmr_gltf_loader_async {
+ *              int                                  eventFd;
+ *              struct kmr_gltf_loader_file          *gltfFile;
+ *              struct kmr_gltf_loader_mesh          *mesh;
+ *              struct kmr_gltf_loader_scene_graph   *sceneGraph;
+ *              struct kmr_gltf_loader_material      *material;
+ *              struct kmr_gltf_loader_texture_image *textureImage;
+ *          }
+ */
+void
+kmr_gltf_loader_async_destroy (struct kmr_gltf_loader_async *async);
+
+#endif /* KMR_GLTF_ASYNC_H */
@@ -0,0 +1,175 @@
+#ifndef KMR_GLTF_BVH_H
+#define KMR_GLTF_BVH_H
+
+#include "gltf-skin.h"
+
+
+/*
+ * struct kmr_gltf_loader_bvh_node (kmsroots GLTF Loader Bounding Volume Hierarchy Node)
+ *
+ * members:
+ * @aabbMin - Minimum corner of the world space box bounding every item below the node
+ * @first   - Leaf: Index of the node's first item in struct kmr_gltf_loader_bvh { @items }.
+ *            Interior: Index of the left child in struct kmr_gltf_loader_bvh { @bvhNodes }, the
+ *            right child directly follows it.
+ * @aabbMax - Maximum corner of the world space box bounding every item below the node
+ * @count   - Leaf: Amount of items in node. Interior: 0
+ */
+struct kmr_gltf_loader_bvh_node {
+	vec3     aabbMin;
+	uint32_t first;
+	vec3     aabbMax;
+	uint32_t count;
+};
+
+
+/*
+ * struct kmr_gltf_loader_bvh (kmsroots GLTF Loader Bounding Volume Hierarchy)
+ *
+ * members:
+ * @bvhNodeCount - Amount of elements in @bvhNodes array
+ * @bvhNodes     - Pointer to an array of struct kmr_gltf_loader_bvh_node. Index 0 is the root,
+ *                 children are always stored after their parent.
+ * @itemCount    - Amount of elements in @items, @itemAabbMin and @itemAabbMax arrays
+ * @items        - Flattened index in struct kmr_gltf_loader_scene_graph of every mesh or skinned
+ *                 node. Items of a leaf are stored back to back.
+ * @itemAabbMin  - Minimum corner of the world space box bounding each item
+ * @itemAabbMax  - Maximum corner of the world space box bounding each item
+ */
+struct kmr_gltf_loader_bvh {
+	uint32_t                        bvhNodeCount;
+	struct kmr_gltf_loader_bvh_node *bvhNodes;
+	uint32_t                        itemCount;
+	uint32_t                        *items;
+	vec3                            *itemAabbMin;
+	vec3                            *itemAabbMax;
+};
+
+
+/*
+ * struct kmr_gltf_loader_bvh_create_info (kmsroots GLTF Loader Bounding Volume Hierarchy Create Information)
+ *
+ * members:
+ * @mesh       - Must pass a valid pointer to a struct kmr_gltf_loader_mesh holding the
+ *               bounds of every mesh referenced by the scene graph
+ * @sceneGraph - Must pass a valid pointer to a struct kmr_gltf_loader_scene_graph with up to date world matrices
+ * @skin       - Pointer to a struct kmr_gltf_loader_skin with an up to date @palette. May be NULL
+ *               in which case skinned nodes are bounded like mesh nodes, by their bind pose box
+ *               moved by the node's world matrix.
+ */
+struct kmr_gltf_loader_bvh_create_info {
+	struct kmr_gltf_loader_mesh        *mesh;
+	struct kmr_gltf_loader_scene_graph *sceneGraph;
+	struct kmr_gltf_loader_skin        *skin;
+};
+
+
+/*
+ * kmr_gltf_loader_bvh_create: Builds a bounding volume hierarchy over the world space boxes of every mesh and skinned node
+ *                             of a scene graph. Nodes are split top down with a binned surface area heuristic. Mesh boxes
+ *                             are moved into world space by the node's world matrix, skinned nodes use the box around
+ *                             the sphere described in kmr_gltf_loader_scene_graph_cull().
+ *
+ * parameters:
+ * @bvhInfo - Must pass a pointer to a struct kmr_gltf_loader_bvh_create_info
+ * returns:
+ *	on success pointer to a struct kmr_gltf_loader_bvh
+ *	on failure NULL
+ */
+struct kmr_gltf_loader_bvh *
+kmr_gltf_loader_bvh_create (struct kmr_gltf_loader_bvh_create_info *bvhInfo);
+
+
+/*
+ * kmr_gltf_loader_bvh_refit: Recomputes item boxes from current world matrices (joint matrices for skinned nodes)
+ *                            and grows/shrinks every node box bottom up. The tree topology is kept, rebuild
+ *                            with kmr_gltf_loader_bvh_create() if nodes moved far from where they started.
+ *
+ * parameters:
+ * @bvh     - Must pass a pointer to a struct kmr_gltf_loader_bvh
+ * @bvhInfo - Must pass a pointer to the struct kmr_gltf_loader_bvh_create_info @bvh was created with.
+ *            Members may point to updated data but must describe the same scene.
+ */
+void
+kmr_gltf_loader_bvh_refit (struct kmr_gltf_loader_bvh *bvh, struct kmr_gltf_loader_bvh_create_info *bvhInfo);
+
+
+/*
+ * struct kmr_gltf_loader_bvh_cull_info (kmsroots GLTF Loader Bounding Volume Hierarchy Cull Information)
+ *
+ * members:
+ * @bvh            - Must pass a valid pointer to a struct kmr_gltf_loader_bvh
+ * @viewProjection - Projection * view matrix of the camera. Vulkan clip space (depth in [0, w]) is assumed.
+ * @drawList       - Must pass a pointer to an array of at least struct kmr_gltf_loader_bvh { @itemCount }
+ *                   elements. Populated with the flattened scene graph index of every visible item,
+ *                   in @items order.
+ */
+struct kmr_gltf_loader_bvh_cull_info {
+	struct kmr_gltf_loader_bvh *bvh;
+	mat4                       viewProjection;
+	uint32_t                   *drawList;
+};
+
+
+/*
+ * kmr_gltf_loader_bvh_cull: Frustum culls the hierarchy. Subtrees outside of any plane are skipped, planes a subtree
+ *                           is entirely inside of aren't tested again below it.
+ *
+ * parameters:
+ * @cullInfo - Must pass a pointer to a struct kmr_gltf_loader_bvh_cull_info
+ * returns:
+ *	Amount of visible items written to @drawList
+ */
+uint32_t
+kmr_gltf_loader_bvh_cull (struct kmr_gltf_loader_bvh_cull_info *cullInfo);
+
+
+/*
+ * struct kmr_gltf_loader_bvh_pick_info (kmsroots GLTF Loader Bounding Volume Hierarchy Pick Information)
+ *
+ * members:
+ * @bvh         - Must pass a valid pointer to a struct kmr_gltf_loader_bvh
+ * @origin      - World space origin of the ray
+ * @direction   - World space direction of the ray. Distances are in multiples of its length.
+ * @maxDistance - Boxes entered past this distance along the ray are ignored
+ * @distance    - Optional pointer populated with the distance at which the ray enters the picked item's box
+ */
+struct kmr_gltf_loader_bvh_pick_info {
+	struct kmr_gltf_loader_bvh *bvh;
+	vec3                       origin;
+	vec3                       direction;
+	float                      maxDistance;
+	float                      *distance;
+};
+
+
+/*
+ * kmr_gltf_loader_bvh_pick: Finds the item whose world space box the ray enters first. Children are visited near
+ *                           to far and subtrees further away than the current closest hit are skipped. Rays starting
+ *                           inside of a box hit it at distance 0.
+ *
+ * parameters:
+ * @pickInfo - Must pass a pointer to a struct kmr_gltf_loader_bvh_pick_info
+ * returns:
+ *	Flattened index in struct kmr_gltf_loader_scene_graph of the picked node,
+ *	UINT32_MAX if the ray misses every item.
+ */
+uint32_t
+kmr_gltf_loader_bvh_pick (struct kmr_gltf_loader_bvh_pick_info *pickInfo);
+
+
+/*
+ * kmr_gltf_loader_bvh_destroy: Frees any allocated memory created after kmr_gltf_loader_bvh_create() call.
+ *
+ * parameters:
+ * @bvh - Pointer to a valid struct kmr_gltf_loader_bvh
+ *
+ *        Free'd members
+ *        struct kmr_gltf_loader_bvh {
+ *            struct kmr_gltf_loader_bvh_node *bvhNodes; // Single allocation backing every array
+ *        }
+ */
+void
+kmr_gltf_loader_bvh_destroy (struct kmr_gltf_loader_bvh *bvh);
+
+#endif /* KMR_GLTF_BVH_H */
@@ -0,0 +1,118 @@
+#ifndef KMR_GLTF_CACHE_H
+#define KMR_GLTF_CACHE_H
+
+#include "gltf-loader.h"
+
+
+/*
+ * struct kmr_gltf_loader_cache_write_info (kmsroots GLTF Loader Cache Write Information)
+ *
+ * members:
+ * @gltfFile       - Must pass a valid pointer to a struct kmr_gltf_loader_file. Used to find the
+ *                   external buffer and image files the cache depends on.
+ * @sourceFileName - Path to the .gltf/.glb file @gltfFile was created from
+ * @cacheFileName  - Path of the .kmrcache file to write. Written to a temporary file first
+ *                   and renamed, so a power loss never leaves a partially written cache.
+ * @mesh           - Optional pointer to a struct kmr_gltf_loader_mesh to store. NULL to skip.
+ * @material       - Optional pointer to a struct kmr_gltf_loader_material to store. NULL to skip.
+ * @node           - Optional pointer to a struct kmr_gltf_loader_node to store. NULL to skip.
+ * @textureImage   - Optional pointer to a struct kmr_gltf_loader_texture_image to store. NULL to skip.
+ */
+struct kmr_gltf_loader_cache_write_info {
+	struct kmr_gltf_loader_file          *gltfFile;
+	const char                           *sourceFileName;
+	const char                           *cacheFileName;
+	struct kmr_gltf_loader_mesh          *mesh;
+	struct kmr_gltf_loader_material      *material;
+	struct kmr_gltf_loader_node          *node;
+	struct kmr_gltf_loader_texture_image *textureImage;
+};
+
+
+/*
+ * kmr_gltf_loader_cache_write: Serializes already processed meshes, materials, node transforms and decoded
+ *                              texels into a versioned binary blob (.kmrcache) that kmr_gltf_loader_cache_create()
+ *                              maps back into memory. A 64-bit FNV-1a hash over the source file and every external
+ *                              buffer/image file it references is stored alongside the data.
+ *
+ * parameters:
+ * @cacheWriteInfo - Must pass a pointer to a struct kmr_gltf_loader_cache_write_info
+ * returns:
+ *	on success 0
+ *	on failure -1
+ */
+int
+kmr_gltf_loader_cache_write (struct kmr_gltf_loader_cache_write_info *cacheWriteInfo);
+
+
+/*
+ * struct kmr_gltf_loader_cache (kmsroots GLTF Loader Cache)
+ *
+ * Objects point directly into the mapped cache file and must not be passed to their
+ * respective destroy functions. The mapping is private, modifying data (i.e. with
+ * kmr_gltf_loader_mesh_optimize()) never changes the file.
+ *
+ * members:
+ * @cacheFile    - Memory mapping of the .kmrcache file
+ * @mesh         - Pointer to cached struct kmr_gltf_loader_mesh. NULL if not stored.
+ * @material     - Pointer to cached struct kmr_gltf_loader_material. NULL if not stored.
+ * @node         - Pointer to cached struct kmr_gltf_loader_node. NULL if not stored.
+ * @textureImage - Pointer to cached struct kmr_gltf_loader_texture_image. NULL if not stored.
+ */
+struct kmr_gltf_loader_cache {
+	struct kmr_utils_file                cacheFile;
+	struct kmr_gltf_loader_mesh          *mesh;
+	struct kmr_gltf_loader_material      *material;
+	struct kmr_gltf_loader_node          *node;
+	struct kmr_gltf_loader_texture_image *textureImage;
+};
+
+
+/*
+ * struct kmr_gltf_loader_cache_create_info (kmsroots GLTF Loader Cache Create Information)
+ *
+ * members:
+ * @cacheFileName  - Path to a .kmrcache file written by kmr_gltf_loader_cache_write()
+ * @sourceFileName - Path to the .gltf/.glb file the cache was baked from. The source file and
+ *                   its dependencies are hashed and compared against the hash stored in the cache.
+ *                   NULL skips validation and trusts the cache.
+ */
+struct kmr_gltf_loader_cache_create_info {
+	const char *cacheFileName;
+	const char *sourceFileName;
+};
+
+
+/*
+ * kmr_gltf_loader_cache_create: Maps a .kmrcache file into memory, validates its version and content hash
+ *                               then fixes up pointers so the cached objects can be used the same way
+ *                               as objects returned by their kmr_gltf_loader_*_create() functions.
+ *                               A missing, stale or incompatible cache isn't an error worth aborting for,
+ *                               callers should fall back to loading the source file.
+ *
+ * parameters:
+ * @cacheInfo - Must pass a pointer to a struct kmr_gltf_loader_cache_create_info
+ * returns:
+ *	on success pointer to a struct kmr_gltf_loader_cache
+ *	on failure NULL
+ */
+struct kmr_gltf_loader_cache *
+kmr_gltf_loader_cache_create (struct kmr_gltf_loader_cache_create_info *cacheInfo);
+
+
+/*
+ * kmr_gltf_loader_cache_destroy: Frees any allocated memory and unmaps the file created after
+ *                                kmr_gltf_loader_cache_create() call.
+ *
+ * parameters:
+ * @cache - Pointer to a valid struct kmr_gltf_loader_cache
+ *
+ *          Free'd members with fd's closed
+ *          struct kmr_gltf_loader_cache {
+ *              struct kmr_utils_file cacheFile;
+ *          }
+ */
+void
+kmr_gltf_loader_cache_destroy (struct kmr_gltf_loader_cache *cache);
+
+#endif /* KMR_GLTF_CACHE_H */
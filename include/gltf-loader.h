@@ -3,20 +3,37 @@
 
 #include "utils.h"
 
-#define CGLTF_IMPLEMENTATION
 #include "cgltf.h"
 
 #include <cglm/cglm.h>
+#include <vulkan/vulkan.h>
+
+
+/*
+ * enum kmr_gltf_loader_file_create_flags (kmsroots GLTF Loader File Create Flags)
+ *
+ * @KMR_GLTF_LOADER_FILE_CREATE_MMAP - Map the .gltf/.glb file and all external buffer files into memory
+ *                                     with kmr_utils_file_map() instead of reading them into heap memory.
+ *                                     cgltf_data buffers then point directly into the file mappings.
+ */
+enum kmr_gltf_loader_file_create_flags {
+	KMR_GLTF_LOADER_FILE_CREATE_MMAP = (1 << 0),
+};
 
 
 /*
  * struct kmr_gltf_loader_file (kmsroots GLTF Loader File)
  *
  * members:
- * @gltfData - Buffer that stores a given gltf file's content
+ * @gltfData     - Buffer that stores a given gltf file's content
+ * @fileMaps     - Pointer to an array of files mapped into memory if KMR_GLTF_LOADER_FILE_CREATE_MMAP
+ *                 flag set. Released when cgltf no longer requires them.
+ * @fileMapCount - Amount of elements in @fileMaps array.
  */
 struct kmr_gltf_loader_file {
-	cgltf_data *gltfData;
+	cgltf_data            *gltfData;
+	struct kmr_utils_file *fileMaps;
+	uint32_t              fileMapCount;
 };
 
 
@@ -25,14 +42,21 @@ struct kmr_gltf_loader_file {
  *
  * members:
  * @fileName - Must pass the path to the gltf file to load.
+ * @flags    - Bitmask of enum kmr_gltf_loader_file_create_flags. May be 0.
  */
 struct kmr_gltf_loader_file_create_info {
-	const char *fileName;
+	const char                             *fileName;
+	enum kmr_gltf_loader_file_create_flags flags;
 };
 
 
 /*
  * kmr_gltf_loader_file_load: This function is used to parse and load gltf files content into memory.
+ *                            Every external buffer (.bin file or data URI) is read, or mapped with
+ *                            KMR_GLTF_LOADER_FILE_CREATE_MMAP, on its own worker thread so assets
+ *                            split across many buffers don't load one file after the other.
+ *                            Buffer views compressed with EXT_meshopt_compression are decoded
+ *                            concurrently before returning, so accessors read them like any other.
  *
  * parameters:
  * @gltfFileInfo - Must pass a pointer to a struct kmr_gltf_loader_file_create_info
@@ -54,6 +78,7 @@ kmr_gltf_loader_file_create (struct kmr_gltf_loader_file_create_info *gltfFileIn
  *             Free'd members with fd's closed
  *             struct kmr_gltf_loader_file {
  *                 cgltf_data *gltfData;
+ *                 struct kmr_utils_file *fileMaps;
  *             }
  */
 void
@@ -79,30 +104,168 @@ struct kmr_gltf_loader_mesh_vertex_data {
 };
 
 
+/*
+ * struct kmr_gltf_loader_mesh_vertex_packed (kmsroots GLTF Loader Mesh Vertex Packed)
+ *
+ * Compact 20 byte vertex used by KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_PACKED.
+ * See kmr_gltf_loader_mesh_vertex_input_description_get() for matching VkFormat's.
+ *
+ * @position - Snorm16 position (VK_FORMAT_R16G16B16A16_SNORM). Dequantize with
+ *             struct kmr_gltf_loader_mesh_data { @positionScale, @positionOffset }:
+ *             position.xyz * positionScale + positionOffset. w is always 0.
+ *             Meshes whose positions are all (KHR_mesh_quantization) 8-bit or signed
+ *             16-bit integers keep those integers as is with a zero offset.
+ * @normal   - Octahedral encoded unit normal stored as two snorm16 (VK_FORMAT_R16G16_SNORM)
+ * @texCoord - Half-float texture coordinate (VK_FORMAT_R16G16_SFLOAT)
+ * @color    - Unorm8 RGBA color (VK_FORMAT_R8G8B8A8_UNORM). Alpha is always 255.
+ */
+struct kmr_gltf_loader_mesh_vertex_packed {
+	int16_t  position[4];
+	int16_t  normal[2];
+	uint16_t texCoord[2];
+	uint8_t  color[4];
+};
+
+
+/*
+ * enum kmr_gltf_loader_mesh_vertex_layout (kmsroots GLTF Loader Mesh Vertex Layout)
+ *
+ * @KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_INTERLEAVED - Array of struct kmr_gltf_loader_mesh_vertex_data
+ * @KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_PACKED      - Array of struct kmr_gltf_loader_mesh_vertex_packed
+ * @KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_SOA         - Separate position, normal, texture coordinate and color arrays.
+ *                                                  See struct kmr_gltf_loader_mesh_vertex_streams.
+ */
+enum kmr_gltf_loader_mesh_vertex_layout {
+	KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_INTERLEAVED = 0,
+	KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_PACKED      = 1,
+	KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_SOA         = 2,
+};
+
+
+/*
+ * struct kmr_gltf_loader_mesh_vertex_streams (kmsroots GLTF Loader Mesh Vertex Streams)
+ *
+ * Structure of arrays vertex data used by KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_SOA. All streams
+ * reside back to back in a single allocation starting at @position, so the whole block may be
+ * uploaded with one copy. The byte offset of a stream inside of the block (for vkCmdBindVertexBuffers)
+ * is (uint8_t *) stream - (uint8_t *) @position.
+ *
+ * @position - Array of vertex position coordinates
+ * @normal   - Array of vertex normals
+ * @texCoord - Array of texture coordinates
+ * @color    - Array of colors
+ */
+struct kmr_gltf_loader_mesh_vertex_streams {
+	vec3 *position;
+	vec3 *normal;
+	vec2 *texCoord;
+	vec3 *color;
+};
+
+
+/*
+ * struct kmr_gltf_loader_mesh_primitive (kmsroots GLTF Loader Mesh Primitive)
+ *
+ * Location of a single GLTF mesh primitive inside of the vertex/index arrays
+ * of the struct kmr_gltf_loader_mesh_data it belongs to.
+ *
+ * members:
+ * @type          - Primitive topology. Only cgltf_primitive_type_triangles primitives
+ *                  are touched by kmr_gltf_loader_mesh_optimize().
+ * @firstIndex    - Array index of the primitive's first index within the mesh index buffer
+ * @indexCount    - Amount of indices belonging to the primitive
+ * @firstVertex   - Array index of the primitive's first vertex within the mesh vertex buffer
+ * @vertexCount   - Amount of vertices belonging to the primitive
+ * @aabbMin       - Minimum corner of the axis aligned box bounding the primitive's positions (mesh space)
+ * @aabbMax       - Maximum corner of the axis aligned box bounding the primitive's positions (mesh space)
+ * @sphereCenter  - Center of the sphere bounding the primitive's positions (mesh space). Taken from the
+ *                  POSITION accessor min/max when present, otherwise the center of @aabbMin/@aabbMax.
+ * @sphereRadius  - Radius of the sphere bounding the primitive's positions
+ * @materialIndex - Index in "materials" (json key) GLTF file array, which is also the index of the
+ *                  primitive's material in struct kmr_gltf_loader_material { @materialData }.
+ *                  UINT32_MAX if the primitive has no material.
+ */
+struct kmr_gltf_loader_mesh_primitive {
+	cgltf_primitive_type type;
+	uint32_t             firstIndex;
+	uint32_t             indexCount;
+	uint32_t             firstVertex;
+	uint32_t             vertexCount;
+	vec3                 aabbMin;
+	vec3                 aabbMax;
+	vec3                 sphereCenter;
+	float                sphereRadius;
+	uint32_t             materialIndex;
+};
+
+
 /*
  * struct kmr_gltf_loader_mesh_data (kmsroots GLTF Loader Mesh Data)
  *
  * @firstIndex            - Array index within the index buffer. Calculated in kmr_gltf_loader_mesh_create()
  *                          firstIndex = firstIndex + bufferElementCount (GLTF file accessor[index].count).
  *                          Can be used by the application to fill in vkCmdDrawIndexed(3) function.
- * @indexBufferData       - Buffer of index data belonging to mesh populated from GLTF file buffer at
- *                          struct kmr_gltf_loader_mesh { @bufferIndex }.
- * @indexBufferDataCount  - Amount of elements in @indexBufferData array.
- * @indexBufferDataSize   - The total size in bytes of the @indexBufferData array.
+ * @indexType             - VK_INDEX_TYPE_UINT32 if @indexBufferData is populated. VK_INDEX_TYPE_UINT16 if
+ *                          @indexBufferData16 is populated. Can be passed directly to vkCmdBindIndexBuffer(3).
+ * @indexBufferData       - Buffer of index data belonging to mesh populated from the GLTF file
+ *                          buffer(s) referenced by the mesh index accessors.
+ * @indexBufferData16     - Same as @indexBufferData, but 16-bit. Only populated if mesh was created with
+ *                          KMR_GLTF_LOADER_MESH_CREATE_INDEX_DOWNSIZE and has fewer than 65536 vertices.
+ * @indexBufferDataCount  - Amount of elements in @indexBufferData/@indexBufferData16 array.
+ * @indexBufferDataSize   - The total size in bytes of the @indexBufferData/@indexBufferData16 array.
+ * @indexBufferDataOffset - Byte offset of @indexBufferData/@indexBufferData16 within
+ *                          struct kmr_gltf_loader_mesh { @arena }.
  * @vertexBufferData      - Pointer to a buffer containing position vertices, normal,
- *                          texture coordinates, and color populated from GLTF file buffer at
- *                          @bufferIndex.
- * @vertexBufferDataCount - Amount of elements in @vertexBufferData array.
- * @vertexBufferDataSize  - The total size in bytes of the @vertexBufferData array.
+ *                          texture coordinates, and color populated from the GLTF file buffer(s)
+ *                          referenced by the mesh attribute accessors. Integer and normalized
+ *                          integer attributes are converted to float.
+ *                          Populated with KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_INTERLEAVED.
+ * @vertexBufferDataPacked - Same vertices as @vertexBufferData in compact form.
+ *                           Populated with KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_PACKED.
+ * @vertexStreams         - Same vertices as @vertexBufferData stored as separate arrays.
+ *                          Populated with KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_SOA.
+ * @vertexBufferDataCount - Amount of vertices in @vertexBufferData/@vertexBufferDataPacked/@vertexStreams.
+ * @vertexBufferDataSize  - The total size in bytes of the @vertexBufferData/@vertexBufferDataPacked array
+ *                          or all @vertexStreams.
+ * @vertexBufferDataOffset - Byte offset of @vertexBufferData/@vertexBufferDataPacked/@vertexStreams
+ *                           within struct kmr_gltf_loader_mesh { @arena }.
+ * @positionScale         - Per axis scale used to dequantize packed positions (1.0 otherwise)
+ * @positionOffset        - Per axis offset used to dequantize packed positions (0.0 otherwise)
+ * @aabbMin               - Minimum corner of the axis aligned box bounding every primitive (mesh space)
+ * @aabbMax               - Maximum corner of the axis aligned box bounding every primitive (mesh space)
+ * @sphereCenter          - Center of the sphere bounding every primitive's bounding sphere (mesh space)
+ * @sphereRadius          - Radius of the sphere bounding every primitive's bounding sphere
+ * @primitives            - Pointer to an array of struct kmr_gltf_loader_mesh_primitive
+ *                          describing where each GLTF primitive resides in @indexBufferData
+ *                          and @vertexBufferData.
+ * @primitiveCount        - Amount of elements in @primitives array.
  */
 struct kmr_gltf_loader_mesh_data {
 	uint32_t                                firstIndex;
-	uint32_t                                *indexBufferData;
+	VkIndexType                             indexType;
+	union {
+		uint32_t                        *indexBufferData;
+		uint16_t                        *indexBufferData16;
+	};
 	uint32_t                                indexBufferDataCount;
 	uint32_t                                indexBufferDataSize;
-	struct kmr_gltf_loader_mesh_vertex_data *vertexBufferData;
+	uint32_t                                indexBufferDataOffset;
+	union {
+		struct kmr_gltf_loader_mesh_vertex_data   *vertexBufferData;
+		struct kmr_gltf_loader_mesh_vertex_packed *vertexBufferDataPacked;
+		struct kmr_gltf_loader_mesh_vertex_streams vertexStreams;
+	};
 	uint32_t                                vertexBufferDataCount;
 	uint32_t                                vertexBufferDataSize;
+	uint32_t                                vertexBufferDataOffset;
+	vec3                                    positionScale;
+	vec3                                    positionOffset;
+	vec3                                    aabbMin;
+	vec3                                    aabbMax;
+	vec3                                    sphereCenter;
+	float                                   sphereRadius;
+	struct kmr_gltf_loader_mesh_primitive   *primitives;
+	uint32_t                                primitiveCount;
 };
 
 
@@ -113,13 +276,42 @@ struct kmr_gltf_loader_mesh_data {
  * @bufferIndex   - The index in the "buffers" (json key) array of give GLTF file.
  * @meshData      - Pointer to an array of struct kmr_gltf_loader_mesh_data
  *                  storing all important data related to each mesh.
- * @meshDataCount - Amount of meshes associated with a @bufferIndex.
+ * @meshDataCount - Amount of meshes in the GLTF file, whichever buffers they are stored in.
  *                  The array size of @meshData array.
+ * @vertexLayout  - Layout vertices of every mesh are stored in.
+ * @arena         - Single block of memory holding the vertices of every mesh back to back followed
+ *                  by the indices of every mesh. Index arrays start at 4 byte aligned offsets. The
+ *                  whole block may be uploaded to a staging buffer with one copy.
+ * @arenaSize     - Amount of bytes of @arena in use. Arena offsets are 32-bit, meshes needing more
+ *                  than UINT32_MAX bytes fail to create.
+ * @arenaExternal - true if @arena was provided by the caller. Memory is then not free'd
+ *                  by kmr_gltf_loader_mesh_destroy().
+ * @optimized     - true once kmr_gltf_loader_mesh_optimize() reordered vertices. They then no longer
+ *                  follow the GLTF file's vertex order struct kmr_gltf_loader_skin is built in.
  */
 struct kmr_gltf_loader_mesh {
-	uint16_t                         bufferIndex;
-	struct kmr_gltf_loader_mesh_data *meshData;
-	uint16_t                         meshDataCount;
+	uint16_t                                bufferIndex;
+	struct kmr_gltf_loader_mesh_data        *meshData;
+	uint16_t                                meshDataCount;
+	enum kmr_gltf_loader_mesh_vertex_layout vertexLayout;
+	void                                    *arena;
+	uint32_t                                arenaSize;
+	bool                                    arenaExternal;
+	bool                                    optimized;
+};
+
+
+/*
+ * enum kmr_gltf_loader_mesh_create_flags (kmsroots GLTF Loader Mesh Create Flags)
+ *
+ * @KMR_GLTF_LOADER_MESH_CREATE_WELD           - Deduplicate bit-identical vertices within each indexed primitive
+ *                                              and rewrite indices to reference the remaining unique vertex.
+ * @KMR_GLTF_LOADER_MESH_CREATE_INDEX_DOWNSIZE - Store indices of meshes with fewer than 65536 vertices as uint16_t.
+ *                                              See struct kmr_gltf_loader_mesh_data { @indexType }.
+ */
+enum kmr_gltf_loader_mesh_create_flags {
+	KMR_GLTF_LOADER_MESH_CREATE_WELD           = (1 << 0),
+	KMR_GLTF_LOADER_MESH_CREATE_INDEX_DOWNSIZE = (1 << 1),
 };
 
 
@@ -129,23 +321,48 @@ struct kmr_gltf_loader_mesh {
  * members:
  * @gltfFile    - Must pass a valid pointer to a struct kmr_gltf_loader_file
  *                for cgltf_data @gltfData member
- * @bufferIndex - Index of buffer in GLTF file "buffers" (json key) array
+ * @bufferIndex - Index of buffer in GLTF file "buffers" (json key) array. Only stored in
+ *                struct kmr_gltf_loader_mesh { @bufferIndex }, accessors are read from
+ *                whichever buffer they reference.
+ * @threadCount - Amount of threads used to decode primitives. 0 uses the amount of
+ *                online CPU's. 1 decodes everything on the calling thread.
+ * @flags        - Bitmask of enum kmr_gltf_loader_mesh_create_flags
+ * @vertexLayout - Layout to store vertices in. Conversion happens after welding.
+ * @arena        - Optional caller owned memory (i.e. an already mapped staging buffer) all vertices
+ *                 and indices are written to. Must stay valid for the lifetime of the created mesh.
+ *                 NULL to let the loader allocate the arena.
+ * @arenaSize    - Size in bytes of @arena. kmr_gltf_loader_mesh_arena_size_get() returns the amount
+ *                 of bytes that is always sufficient.
  */
 struct kmr_gltf_loader_mesh_create_info {
-	struct kmr_gltf_loader_file *gltfFile;
-	uint16_t                    bufferIndex;
+	struct kmr_gltf_loader_file             *gltfFile;
+	uint16_t                                bufferIndex;
+	uint32_t                                threadCount;
+	enum kmr_gltf_loader_mesh_create_flags  flags;
+	enum kmr_gltf_loader_mesh_vertex_layout vertexLayout;
+	void                                    *arena;
+	uint32_t                                arenaSize;
 };
 
 
 /*
  * kmr_gltf_loader_mesh_create: Function loops through all meshes and finds the associated accessor->buffer view
- *                              for a given buffer at @bufferIndex. After retrieves all information required to
+ *                              for each primitive attribute. After retrieves all information required to
  *                              understand the contents of the multiple sections in the buffer. The function then
  *                              creates multiple meshes with appropriate data (struct kmr_gltf_loader_mesh_data)
  *                              so the application only need to call function and create their vertex buffer + index
  *                              buffer array's based upon what's already populated. Converts GLTF buffer to a buffer
  *                              that Vulkan can understand seperating each buffer, by their mesh index in GLTF file
- *                              "meshes" (json key) array.
+ *                              "meshes" (json key) array. All primitives of a mesh are stored back to back in the
+ *                              mesh vertex/index arrays with indices rebased accordingly. Output offsets of every
+ *                              primitive are calculated up front, decoding then happens on a worker pool.
+ *                              Accessor byte offsets, interleaved buffer views (byteStride), sparse accessors
+ *                              and normalized integer components are accounted for. Optionally welds duplicate
+ *                              vertices and downsizes indices to 16-bit (see enum kmr_gltf_loader_mesh_create_flags).
+ *                              Vertex and index data of all meshes is placed into one arena
+ *                              (see struct kmr_gltf_loader_mesh { @arena }). Bounding boxes and spheres of every
+ *                              primitive and mesh are computed while decoding, POSITION accessor min/max are
+ *                              used as starting point when present.
  *
  * parameters:
  * @meshInfo - Must pass a pointer to a struct kmr_gltf_loader_mesh_create_info
@@ -157,6 +374,61 @@ struct kmr_gltf_loader_mesh *
 kmr_gltf_loader_mesh_create (struct kmr_gltf_loader_mesh_create_info *meshInfo);
 
 
+/*
+ * kmr_gltf_loader_mesh_arena_size_get: Calculates the amount of bytes a caller provided arena must have for
+ *                                      kmr_gltf_loader_mesh_create() to succeed with the given create info.
+ *                                      Welding may leave part of the arena unused.
+ *
+ * parameters:
+ * @meshInfo - Must pass a pointer to a struct kmr_gltf_loader_mesh_create_info. @arena and @arenaSize are ignored.
+ * returns:
+ *	Upper bound size in bytes of struct kmr_gltf_loader_mesh { @arena }. Values above UINT32_MAX
+ *	can't be satisfied, kmr_gltf_loader_mesh_create() fails for such meshes.
+ */
+uint64_t
+kmr_gltf_loader_mesh_arena_size_get (struct kmr_gltf_loader_mesh_create_info *meshInfo);
+
+
+/*
+ * struct kmr_gltf_loader_mesh_emit_info (kmsroots GLTF Loader Mesh Emit Information)
+ *
+ * members:
+ * @mesh        - Must pass a pointer to a struct kmr_gltf_loader_mesh whose @meshData (allocated with the
+ *                @primitives arrays of every mesh trailing it), @meshDataCount and @vertexLayout are populated.
+ *                Every mesh's @vertexBufferData and 32-bit @indexBufferData must point to interleaved vertices
+ *                and indices owned by the caller. Every primitive needs @aabbMin/@aabbMax bounding its
+ *                positions and a negative @sphereRadius. @arena must be NULL.
+ * @threadCount - Amount of threads used to weld and write meshes. 0 uses the amount of
+ *                online CPU's. 1 does everything on the calling thread.
+ * @flags       - Bitmask of enum kmr_gltf_loader_mesh_create_flags
+ * @arena       - Same as struct kmr_gltf_loader_mesh_create_info { @arena }
+ * @arenaSize   - Size in bytes of @arena
+ */
+struct kmr_gltf_loader_mesh_emit_info {
+	struct kmr_gltf_loader_mesh            *mesh;
+	uint32_t                               threadCount;
+	enum kmr_gltf_loader_mesh_create_flags flags;
+	void                                   *arena;
+	uint32_t                               arenaSize;
+};
+
+
+/*
+ * kmr_gltf_loader_mesh_emit: Back end of kmr_gltf_loader_mesh_create() for meshes decoded by other loaders
+ *                            (i.e. kmr_obj_loader_create()). Finishes bounding spheres, optionally welds and
+ *                            downsizes indices, then writes every mesh into one arena in the requested vertex
+ *                            layout. Caller owned vertex/index memory may be free'd once the function returns.
+ *
+ * parameters:
+ * @emitInfo - Must pass a pointer to a struct kmr_gltf_loader_mesh_emit_info
+ * returns:
+ *	on success: 0
+ *	on failure: -1
+ */
+int
+kmr_gltf_loader_mesh_emit (struct kmr_gltf_loader_mesh_emit_info *emitInfo);
+
+
 /*
  * kmr_gltf_loader_mesh_destroy: Frees any allocated memory and closes FD's (if open) created after
  *                               kmr_gltf_loader_mesh_create() call.
@@ -167,23 +439,145 @@ kmr_gltf_loader_mesh_create (struct kmr_gltf_loader_mesh_create_info *meshInfo);
  *         Free'd members with fd's closed
  *         struct kmr_gltf_loader_mesh {
  *             struct kmr_gltf_loader_mesh_data {
- *                 uint32_t *indexBufferData;
- *                 struct kmr_gltf_loader_mesh_vertex_data *vertexBufferData;
+ *                 struct kmr_gltf_loader_mesh_primitive *primitives;
  *             }
  *             struct kmr_gltf_loader_mesh_data *meshData;
+ *             void *arena; (if not @arenaExternal)
  *         }
  */
 void
 kmr_gltf_loader_mesh_destroy (struct kmr_gltf_loader_mesh *mesh);
 
 
+/*
+ * struct kmr_gltf_loader_mesh_optimize_info (kmsroots GLTF Loader Mesh Optimize Information)
+ *
+ * members:
+ * @mesh        - Must pass a valid pointer to a struct kmr_gltf_loader_mesh
+ *                returned by kmr_gltf_loader_mesh_create()
+ * @cacheSize   - Size of the post-transform vertex cache (FIFO) the index buffer is optimized for.
+ *                0 defaults to 16 which works well across desktop and embedded GPUs.
+ * @threadCount - Amount of threads used to optimize meshes. 0 uses the amount of
+ *                online CPU's. 1 optimizes everything on the calling thread.
+ */
+struct kmr_gltf_loader_mesh_optimize_info {
+	struct kmr_gltf_loader_mesh *mesh;
+	uint32_t                    cacheSize;
+	uint32_t                    threadCount;
+};
+
+
+/*
+ * kmr_gltf_loader_mesh_optimize: Optional post-process stage after kmr_gltf_loader_mesh_create(). Reorders the
+ *                                triangles of each triangle list primitive for post-transform vertex cache locality
+ *                                (Tipsify, Sander et al. 2007) then reorders the primitive's vertices in order of
+ *                                first use for vertex fetch locality. Primitive ranges stay where they are.
+ *                                Use kmr_gltf_loader_mesh_acmr_get() before/after to measure the gain.
+ *
+ * parameters:
+ * @optimizeInfo - Must pass a pointer to a struct kmr_gltf_loader_mesh_optimize_info
+ * returns:
+ *	on success: 0
+ *	on failure: -1
+ */
+int
+kmr_gltf_loader_mesh_optimize (struct kmr_gltf_loader_mesh_optimize_info *optimizeInfo);
+
+
+/*
+ * kmr_gltf_loader_mesh_acmr_get: Simulates a FIFO post-transform vertex cache of @cacheSize entries over all
+ *                                triangle list primitives of a mesh. Returns the average cache miss ratio
+ *                                (vertex shader invocations per triangle). 3.0 being worst, 0.5 the best
+ *                                a large regular grid can achieve.
+ *
+ * parameters:
+ * @meshData  - Pointer to a struct kmr_gltf_loader_mesh_data
+ * @cacheSize - Amount of entries in simulated cache. 0 defaults to 16.
+ * returns:
+ *	ACMR of mesh, 0.0 if mesh has no triangles
+ */
+float
+kmr_gltf_loader_mesh_acmr_get (struct kmr_gltf_loader_mesh_data *meshData, uint32_t cacheSize);
+
+
+/*
+ * enum kmr_gltf_loader_mesh_vertex_attribute_flags (kmsroots GLTF Loader Mesh Vertex Attribute Flags)
+ *
+ * Vertex attributes a pipeline consumes. Shader locations are assigned in flag order.
+ */
+enum kmr_gltf_loader_mesh_vertex_attribute_flags {
+	KMR_GLTF_LOADER_MESH_VERTEX_ATTRIBUTE_POSITION = (1 << 0),
+	KMR_GLTF_LOADER_MESH_VERTEX_ATTRIBUTE_NORMAL   = (1 << 1),
+	KMR_GLTF_LOADER_MESH_VERTEX_ATTRIBUTE_TEXCOORD = (1 << 2),
+	KMR_GLTF_LOADER_MESH_VERTEX_ATTRIBUTE_COLOR    = (1 << 3),
+	KMR_GLTF_LOADER_MESH_VERTEX_ATTRIBUTE_ALL      = 0x0000000F,
+};
+
+
+#define KMR_GLTF_LOADER_MESH_VERTEX_ATTRIBUTE_COUNT 4
+
+
+/*
+ * struct kmr_gltf_loader_mesh_vertex_input_description_info (kmsroots GLTF Loader Mesh Vertex Input Description Information)
+ *
+ * members:
+ * @vertexLayout  - Layout of vertex data. See struct kmr_gltf_loader_mesh { @vertexLayout }.
+ * @attributes    - Bitmask of enum kmr_gltf_loader_mesh_vertex_attribute_flags the pipeline consumes.
+ *                  Leaving out KMR_GLTF_LOADER_MESH_VERTEX_ATTRIBUTE_COLOR makes packed color optional.
+ * @firstBinding  - Binding number of the first (or only) vertex buffer binding. With
+ *                  KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_SOA every enabled attribute gets
+ *                  its own binding numbered consecutively from @firstBinding.
+ * @firstLocation - Shader location of the first enabled attribute
+ */
+struct kmr_gltf_loader_mesh_vertex_input_description_info {
+	enum kmr_gltf_loader_mesh_vertex_layout          vertexLayout;
+	enum kmr_gltf_loader_mesh_vertex_attribute_flags attributes;
+	uint32_t                                         firstBinding;
+	uint32_t                                         firstLocation;
+};
+
+
+/*
+ * struct kmr_gltf_loader_mesh_vertex_input_description (kmsroots GLTF Loader Mesh Vertex Input Description)
+ *
+ * members:
+ * @bindingDescriptionCount   - Amount of elements populated in @bindingDescriptions
+ * @bindingDescriptions       - May be passed to VkPipelineVertexInputStateCreateInfo { pVertexBindingDescriptions }
+ * @attributeDescriptionCount - Amount of elements populated in @attributeDescriptions
+ * @attributeDescriptions     - May be passed to VkPipelineVertexInputStateCreateInfo { pVertexAttributeDescriptions }
+ */
+struct kmr_gltf_loader_mesh_vertex_input_description {
+	uint32_t                          bindingDescriptionCount;
+	VkVertexInputBindingDescription   bindingDescriptions[KMR_GLTF_LOADER_MESH_VERTEX_ATTRIBUTE_COUNT];
+	uint32_t                          attributeDescriptionCount;
+	VkVertexInputAttributeDescription attributeDescriptions[KMR_GLTF_LOADER_MESH_VERTEX_ATTRIBUTE_COUNT];
+};
+
+
+/*
+ * kmr_gltf_loader_mesh_vertex_input_description_get: Populates Vulkan vertex input binding/attribute descriptions
+ *                                                    matching a given vertex layout.
+ *
+ * parameters:
+ * @descriptionInfo - Must pass a pointer to a struct kmr_gltf_loader_mesh_vertex_input_description_info
+ * @description     - Must pass a pointer to a struct kmr_gltf_loader_mesh_vertex_input_description
+ * returns:
+ *	on success: 0
+ *	on failure: -1
+ */
+int
+kmr_gltf_loader_mesh_vertex_input_description_get (struct kmr_gltf_loader_mesh_vertex_input_description_info *descriptionInfo,
+                                                   struct kmr_gltf_loader_mesh_vertex_input_description *description);
+
+
 /*
  * struct kmr_gltf_loader_texture_image (kmsroots GLTF Loader Texture Image)
  *
  * members:
  * @imageCount      - Amount of images associated with a given GLTF file
  * @totalBufferSize - Collective size of each image associated with a given GLTF file.
- *                    Best utilized when creating single VkBuffer.
+ *                    Best utilized when creating single VkBuffer. Each image starts
+ *                    at a 16 byte aligned offset, so sizes include padding.
  * @imageData       - Pointer to an array of image metadata and pixel buffer.
  */
 struct kmr_gltf_loader_texture_image {
@@ -197,20 +591,34 @@ struct kmr_gltf_loader_texture_image {
  * struct kmr_gltf_loader_texture_image_create_info (kmsroots GLTF Loader Texture Image Create Information)
  *
  * members:
- * @gltfFile  - Must pass a valid pointer to struct kmr_gltf_loader_file for
- *              cgltf_data @gltfData member
- * @directory - Must pass a pointer to a string detailing the directory of
- *              where all images are stored. Absolute path to a file that resides
- *              in the same directory as the images will work too.
+ * @gltfFile    - Must pass a valid pointer to struct kmr_gltf_loader_file for
+ *                cgltf_data @gltfData member
+ * @directory   - Must pass a pointer to a string detailing the directory of
+ *                where all images are stored. Absolute path to a file that resides
+ *                in the same directory as the images will work too. Only used by
+ *                images referenced by a file uri.
+ * @threadCount - Amount of threads used to decode images. 0 uses the amount of
+ *                online CPU's. 1 decodes everything on the calling thread.
+ * @mipFilter   - Generate a full mip chain for every RGBA8/RGBA16 image right after it's
+ *                decoded, on the same worker thread. Images a material samples as color
+ *                (base color, emissive, specular-glossiness) are filtered in linear space.
+ *                KMR_UTILS_IMAGE_BUFFER_MIP_FILTER_NONE keeps a single level.
  */
 struct kmr_gltf_loader_texture_image_create_info {
-	struct kmr_gltf_loader_file *gltfFile;
-	const char                  *directory;
+	struct kmr_gltf_loader_file            *gltfFile;
+	const char                             *directory;
+	uint32_t                               threadCount;
+	enum kmr_utils_image_buffer_mip_filter mipFilter;
 };
 
 
 /*
  * kmr_gltf_loader_texture_image_create: Function Loads all images associated with gltf file into memory.
+ *                                       Images stored in a buffer view (i.e the binary chunk of a .glb)
+ *                                       are decoded in place from the loaded buffer without opening files.
+ *                                       Base64 data URIs are supported as well. KTX2/DDS images are
+ *                                       not decoded, their block compressed mip chain is passed through
+ *                                       with struct kmr_utils_image_buffer { @vkFormat } set.
  *
  * parameters:
  * @textureImageInfo - Must pass a pointer to a struct kmr_gltf_loader_texture_image_create_info
@@ -265,9 +673,10 @@ struct kmr_gltf_loader_cgltf_texture_transform {
  * struct kmr_gltf_loader_cgltf_texture_view (kmsroots GLTF Loader CGLTF Texture View)
  *
  * members:
- * @textureIndex     - Index in "textures" (json key) GLTF file array
+ * @textureIndex     - Index in "textures" (json key) GLTF file array. UINT32_MAX if the material
+ *                     doesn't use the texture.
  * @imageIndex       - Index in "images" (json key) GTLF file array that belongs
- *                     to the texture at @textureIndex.
+ *                     to the texture at @textureIndex. UINT32_MAX if there's no image.
  * @scale            - The scalar parameter applied to each vector of the texture.
  * @textureTransform - Contains data regarding texture coordinate scale factor, rotation in
  *                     radians, & offset from origin.
@@ -314,8 +723,9 @@ struct kmr_gltf_loader_cgltf_pbr_metallic_roughness {
  * More information can be found at https://www.khronos.org/files/gltf20-reference-guide.pdf
  *
  * members:
- * @meshIndex            - Index in "meshes" (json key) array of GLTF file that material belongs to.
- * @materialName         - Name given to material block contained in GLTF file.
+ * @materialName         - Name given to material block contained in GLTF file. Points into
+ *                         struct kmr_gltf_loader_material { @stringPool }, materials with the
+ *                         same name share the string. NULL if the material has no name.
  * @pbrMetallicRoughness - "Physically-Based Rendering Metallic Roughness Model" - Allows renderers to
  *                         display objects with a realistic appearance under different lighting conditions.
  *                         Stores required data for PBR.
@@ -325,7 +735,6 @@ struct kmr_gltf_loader_cgltf_pbr_metallic_roughness {
  *                         and thus rendered darker.
  */
 struct kmr_gltf_loader_material_data {
-	uint32_t                                            meshIndex;
 	char                                                *materialName;
 	struct kmr_gltf_loader_cgltf_pbr_metallic_roughness pbrMetallicRoughness;
 	struct kmr_gltf_loader_cgltf_texture_view           normalTexture;
@@ -336,13 +745,24 @@ struct kmr_gltf_loader_material_data {
 /*
  * struct kmr_gltf_loader_material (kmsroots GLTF Loader Material)
  *
+ * Materials are stored once each, in "materials" (json key) GLTF file array order. Primitives
+ * reference them through struct kmr_gltf_loader_mesh_primitive { @materialIndex }, so sorting
+ * draws by material only requires sorting by that index.
+ *
  * members:
  * @materialData      - Pointer to an array of struct kmr_gltf_loader_material_data
  * @materialDataCount - Amount of elements in @materialData array
+ * @stringPool        - Every unique material name, NUL terminated and back to back.
+ *                      For materials returned by kmr_gltf_loader_cache_create() points into the cache's
+ *                      mapping instead, freed by kmr_gltf_loader_cache_destroy(). Such materials must not
+ *                      be passed to kmr_gltf_loader_material_destroy().
+ * @stringPoolSize    - Byte size of @stringPool
  */
 struct kmr_gltf_loader_material {
 	struct kmr_gltf_loader_material_data *materialData;
-	uint16_t                             materialDataCount;
+	uint32_t                             materialDataCount;
+	char                                 *stringPool;
+	uint32_t                             stringPoolSize;
 };
 
 
@@ -380,10 +800,8 @@ kmr_gltf_loader_material_create (struct kmr_gltf_loader_material_create_info *ma
  *
  *             Free'd members with fd's closed
  *             struct kmr_gltf_loader_material {
- *                 struct kmr_gltf_loader_material_data {
- *                     char *materialName;
- *                 }
  *                 struct kmr_gltf_loader_material_data *materialData;
+ *                 char                                 *stringPool;
  *             }
  */
 void
@@ -410,11 +828,12 @@ enum kmr_gltf_loader_gltf_object_type {
  *                    mesh this index is the index in the GLTF file "meshes" (json key) array.
  * @nodeIndex       - Index in the GLTF file "nodes" (json key) array for child node.
  * @parentNodeIndex - Index in the GLTF file "nodes" (json key) array for parent node.
+ *                    UINT32_MAX for scene root nodes.
  * @matrixTransform - If matrix property not already defined. Value is T * R * S.
  *                    T - translation
  *                    R - Rotation
  *                    S - scale
- *                    Final matrix transform is (identity matrix * TRS parent matrix) * (identity matrix * TRS child matrix)
+ *                    Final matrix transform is (TRS root matrix) * ... * (TRS parent matrix) * (TRS child matrix)
  */
 struct kmr_gltf_loader_node_data {
 	enum kmr_gltf_loader_gltf_object_type objectType;
@@ -456,7 +875,8 @@ struct kmr_gltf_loader_node_create_info {
  * kmr_gltf_loader_node_create: Calculates final translation * rotatation * scale matrix for all nodes associated with a scene.
  *                              Along with final matrix transform data, function also returns the parent and child index in the
  *                              GLTF file object "nodes" array, the type of node/object (i.e "mesh,skin,camera,etc..."), and
- *                              the index of that object in the GLTF file "Insert Object Name" array.
+ *                              the index of that object in the GLTF file "Insert Object Name" array. Hierarchies of any depth
+ *                              are supported, nodes are returned in the order of struct kmr_gltf_loader_scene_graph.
  *
  * parameters:
  * @nodeInfo - Must pass a pointer to a struct kmr_gltf_loader_node_create_info
@@ -0,0 +1,194 @@
+#ifndef KMR_GLTF_MESH_LOD_H
+#define KMR_GLTF_MESH_LOD_H
+
+#include "gltf-loader.h"
+
+
+#define KMR_GLTF_LOADER_MESH_LOD_LEVEL_MAX 4
+
+
+/*
+ * struct kmr_gltf_loader_mesh_lod_range (kmsroots GLTF Loader Mesh LOD Range)
+ *
+ * members:
+ * @firstIndex - Array index of the range's first index within
+ *               struct kmr_gltf_loader_mesh_lod_data { @indexBufferData }
+ * @indexCount - Amount of indices belonging to the range
+ */
+struct kmr_gltf_loader_mesh_lod_range {
+	uint32_t firstIndex;
+	uint32_t indexCount;
+};
+
+
+/*
+ * struct kmr_gltf_loader_mesh_lod_level (kmsroots GLTF Loader Mesh LOD Level)
+ *
+ * Simplified version of every primitive of a mesh. Primitives of a level are stored back to back
+ * so the whole mesh may be drawn with one vkCmdDrawIndexed(3) call, same as
+ * struct kmr_gltf_loader_mesh_data { @firstIndex, @indexBufferDataCount }.
+ *
+ * members:
+ * @firstIndex - Array index of the level's first index within struct kmr_gltf_loader_mesh_lod_data { @indexBufferData }
+ * @indexCount - Amount of indices belonging to the level
+ * @error      - Estimated distance (mesh space) the level's surface deviates from the original
+ *               mesh. Never smaller than the error of the previous level.
+ * @primitives - Pointer to an array of struct kmr_gltf_loader_mesh_lod_range. One element for each
+ *               struct kmr_gltf_loader_mesh_data { @primitives } element. Primitives that aren't triangle
+ *               lists are copied as is.
+ */
+struct kmr_gltf_loader_mesh_lod_level {
+	uint32_t                              firstIndex;
+	uint32_t                              indexCount;
+	float                                 error;
+	struct kmr_gltf_loader_mesh_lod_range *primitives;
+};
+
+
+/*
+ * struct kmr_gltf_loader_mesh_lod_data (kmsroots GLTF Loader Mesh LOD Data)
+ *
+ * members:
+ * @indexType             - Same as struct kmr_gltf_loader_mesh_data { @indexType } of the mesh
+ * @indexBufferData       - Indices of every level of the mesh. Index values reference the mesh's own
+ *                          vertex buffer, no vertices are added or moved.
+ * @indexBufferData16     - Same as @indexBufferData, but 16-bit
+ * @indexBufferDataCount  - Amount of elements in @indexBufferData/@indexBufferData16 array
+ * @indexBufferDataSize   - The total size in bytes of the @indexBufferData/@indexBufferData16 array
+ * @indexBufferDataOffset - Byte offset of @indexBufferData/@indexBufferData16 within
+ *                          struct kmr_gltf_loader_mesh_lod { @indexBuffer }
+ * @levels                - Level 1 (@levels[0]) to struct kmr_gltf_loader_mesh_lod { @levelCount } of the mesh.
+ *                          Level 0 is the mesh itself.
+ */
+struct kmr_gltf_loader_mesh_lod_data {
+	VkIndexType                           indexType;
+	union {
+		uint32_t                      *indexBufferData;
+		uint16_t                      *indexBufferData16;
+	};
+	uint32_t                              indexBufferDataCount;
+	uint32_t                              indexBufferDataSize;
+	uint32_t                              indexBufferDataOffset;
+	struct kmr_gltf_loader_mesh_lod_level levels[KMR_GLTF_LOADER_MESH_LOD_LEVEL_MAX];
+};
+
+
+/*
+ * struct kmr_gltf_loader_mesh_lod (kmsroots GLTF Loader Mesh LOD)
+ *
+ * members:
+ * @lodData         - Pointer to an array of struct kmr_gltf_loader_mesh_lod_data. One element
+ *                    for each struct kmr_gltf_loader_mesh { @meshData } element.
+ * @lodDataCount    - Amount of elements in @lodData array
+ * @levelCount      - Amount of simplified levels generated for every mesh
+ * @indexBuffer     - Single block of memory holding the indices of every level of every mesh. Index arrays
+ *                    start at 4 byte aligned offsets. The whole block may be uploaded with one copy.
+ * @indexBufferSize - Amount of bytes of @indexBuffer in use
+ * @ranges          - Memory backing every struct kmr_gltf_loader_mesh_lod_level { @primitives }
+ */
+struct kmr_gltf_loader_mesh_lod {
+	struct kmr_gltf_loader_mesh_lod_data  *lodData;
+	uint16_t                              lodDataCount;
+	uint32_t                              levelCount;
+	void                                  *indexBuffer;
+	uint32_t                              indexBufferSize;
+	struct kmr_gltf_loader_mesh_lod_range *ranges;
+};
+
+
+/*
+ * struct kmr_gltf_loader_mesh_lod_create_info (kmsroots GLTF Loader Mesh LOD Create Information)
+ *
+ * members:
+ * @mesh        - Must pass a valid pointer to a struct kmr_gltf_loader_mesh returned by kmr_gltf_loader_mesh_create().
+ *                Run kmr_gltf_loader_mesh_optimize() first if wanted, LOD indices aren't touched by it.
+ * @levelCount  - Amount of simplified levels to generate (at most KMR_GLTF_LOADER_MESH_LOD_LEVEL_MAX).
+ *                0 defaults to 3.
+ * @ratios      - Per level target fraction of the original triangle count (i.e. 0.5, 0.25, 0.125).
+ *                A ratio of 0 defaults to half of the previous level. Levels stop early if
+ *                simplifying further would break the mesh's borders or UV/normal seams.
+ * @threadCount - Amount of threads used to simplify meshes. 0 uses the amount of
+ *                online CPU's. 1 simplifies everything on the calling thread.
+ */
+struct kmr_gltf_loader_mesh_lod_create_info {
+	struct kmr_gltf_loader_mesh *mesh;
+	uint32_t                    levelCount;
+	float                       ratios[KMR_GLTF_LOADER_MESH_LOD_LEVEL_MAX];
+	uint32_t                    threadCount;
+};
+
+
+/*
+ * kmr_gltf_loader_mesh_lod_create: Optional post-process stage after kmr_gltf_loader_mesh_create(). Generates
+ *                                  progressively simplified index buffers for every triangle list primitive by
+ *                                  collapsing edges in order of quadric error (Garland & Heckbert 1997). Each
+ *                                  level continues from the previous one. Vertices only collapse onto other
+ *                                  existing vertices so all levels share the mesh vertex buffer. Open borders
+ *                                  only collapse along themselves, vertices on UV/normal seams are kept, and
+ *                                  collapses that flip a triangle are rejected.
+ *
+ * parameters:
+ * @lodInfo - Must pass a pointer to a struct kmr_gltf_loader_mesh_lod_create_info
+ * returns:
+ *	on success: pointer to a struct kmr_gltf_loader_mesh_lod
+ *	on failure: NULL
+ */
+struct kmr_gltf_loader_mesh_lod *
+kmr_gltf_loader_mesh_lod_create (struct kmr_gltf_loader_mesh_lod_create_info *lodInfo);
+
+
+/*
+ * struct kmr_gltf_loader_mesh_lod_select_info (kmsroots GLTF Loader Mesh LOD Select Information)
+ *
+ * members:
+ * @lod             - Must pass a valid pointer to a struct kmr_gltf_loader_mesh_lod
+ * @mesh            - Must pass a valid pointer to the struct kmr_gltf_loader_mesh @lod was created from
+ * @meshIndex       - Index of mesh in struct kmr_gltf_loader_mesh { @meshData }
+ * @modelView       - View * world matrix of the node drawing the mesh
+ * @projectionScale - Pixels covered by one unit at a view space distance of one. For a perspective
+ *                    projection: fabsf(projection[1][1]) * viewport height * 0.5.
+ * @pixelError      - Largest on screen deviation in pixels a level may have to be selected. 0 defaults to 1.
+ */
+struct kmr_gltf_loader_mesh_lod_select_info {
+	struct kmr_gltf_loader_mesh_lod *lod;
+	struct kmr_gltf_loader_mesh     *mesh;
+	uint32_t                        meshIndex;
+	mat4                            modelView;
+	float                           projectionScale;
+	float                           pixelError;
+};
+
+
+/*
+ * kmr_gltf_loader_mesh_lod_select: Picks the coarsest level of a mesh whose error, projected to the screen at the
+ *                                  distance of the closest point of the mesh's bounding sphere, stays within
+ *                                  @pixelError. Level 0 (the mesh itself) is picked if the camera is inside of
+ *                                  the bounding sphere.
+ *
+ * parameters:
+ * @selectInfo - Must pass a pointer to a struct kmr_gltf_loader_mesh_lod_select_info
+ * returns:
+ *	Level to draw. 0 for struct kmr_gltf_loader_mesh_data, otherwise
+ *	struct kmr_gltf_loader_mesh_lod_data { @levels[level - 1] }.
+ */
+uint32_t
+kmr_gltf_loader_mesh_lod_select (struct kmr_gltf_loader_mesh_lod_select_info *selectInfo);
+
+
+/*
+ * kmr_gltf_loader_mesh_lod_destroy: Frees any allocated memory created after kmr_gltf_loader_mesh_lod_create() call.
+ *
+ * parameters:
+ * @lod - Pointer to a valid struct kmr_gltf_loader_mesh_lod
+ *
+ *        Free'd members
+ *        struct kmr_gltf_loader_mesh_lod {
+ *            struct kmr_gltf_loader_mesh_lod_data *lodData;
+ *            void *indexBuffer;
+ *            struct kmr_gltf_loader_mesh_lod_range *ranges;
+ *        }
+ */
+void
+kmr_gltf_loader_mesh_lod_destroy (struct kmr_gltf_loader_mesh_lod *lod);
+
+#endif /* KMR_GLTF_MESH_LOD_H */
@@ -0,0 +1,156 @@
+#ifndef KMR_GLTF_SCENE_GRAPH_H
+#define KMR_GLTF_SCENE_GRAPH_H
+
+#include "gltf-loader.h"
+
+
+/* Defined in gltf-skin.h, which depends on this header */
+struct kmr_gltf_loader_skin;
+
+
+/*
+ * struct kmr_gltf_loader_scene_graph (kmsroots GLTF Loader Scene Graph)
+ *
+ * Node hierarchy of a scene flattened into a structure of arrays. Nodes are stored in depth-first
+ * pre-order, a parent always comes before its children and the subtree of node n occupies the
+ * range [n, n + @subtreeSize[n]). Unless stated otherwise arrays are of size @nodeCount and
+ * indexed by flattened node index.
+ *
+ * members:
+ * @nodeCount     - Amount of nodes reachable from the scene's root nodes
+ * @nodeIndex     - Index in the GLTF file "nodes" (json key) array of each node
+ * @parent        - Flattened index of the parent node. UINT32_MAX for scene root nodes.
+ * @subtreeSize   - Amount of nodes in the subtree rooted at a node, including the node itself
+ * @objectType    - Type of GLTF object attached to node
+ * @objectIndex   - The index in GLTF file "Insert Object Name" array. If @objectType is a
+ *                  mesh this index is the index in the GLTF file "meshes" (json key) array.
+ * @meshIndex     - Index in the GLTF file "meshes" (json key) array of the mesh attached to a node,
+ *                  UINT32_MAX if none. Also set for skinned nodes whose @objectIndex is the skin.
+ * @translation   - Local translation
+ * @rotation      - Local unit quaternion rotation in the order (x, y, z, w)
+ * @scale         - Local scale
+ * @localMatrix   - T * R * S of the local transform. Node matrices defined in the GLTF file are
+ *                  used as is and decomposed into @translation, @rotation and @scale.
+ * @worldMatrix   - (world matrix of @parent) * @localMatrix
+ * @dirty         - Set a node's entry to true after modifying its @translation, @rotation or @scale.
+ *                  kmr_gltf_loader_scene_graph_update() recomputes the node's subtree and clears it.
+ * @gltfNodeCount - Amount of elements in @gltfNodeMap array
+ * @gltfNodeMap   - Maps an index in the GLTF file "nodes" (json key) array to a flattened index.
+ *                  UINT32_MAX for nodes not part of the scene.
+ */
+struct kmr_gltf_loader_scene_graph {
+	uint32_t                              nodeCount;
+	uint32_t                              *nodeIndex;
+	uint32_t                              *parent;
+	uint32_t                              *subtreeSize;
+	enum kmr_gltf_loader_gltf_object_type *objectType;
+	uint32_t                              *objectIndex;
+	uint32_t                              *meshIndex;
+	vec3                                  *translation;
+	versor                                *rotation;
+	vec3                                  *scale;
+	mat4                                  *localMatrix;
+	mat4                                  *worldMatrix;
+	bool                                  *dirty;
+	uint32_t                              gltfNodeCount;
+	uint32_t                              *gltfNodeMap;
+};
+
+
+/*
+ * struct kmr_gltf_loader_scene_graph_create_info (kmsroots GLTF Loader Scene Graph Create Information)
+ *
+ * members:
+ * @gltfFile   - Must pass a valid pointer to a struct kmr_gltf_loader_file
+ *               for cgltf_data @gltfData member.
+ * @sceneIndex - Index in GLTF file "scenes" (json key) array.
+ */
+struct kmr_gltf_loader_scene_graph_create_info {
+	struct kmr_gltf_loader_file *gltfFile;
+	uint32_t                    sceneIndex;
+};
+
+
+/*
+ * kmr_gltf_loader_scene_graph_create: Flattens the node hierarchy of a scene (any depth) into a struct kmr_gltf_loader_scene_graph
+ *                                     and computes the world matrix of every node. Nodes reachable through more than one
+ *                                     parent violate the GLTF spec and are only added the first time they're reached.
+ *
+ * parameters:
+ * @sceneGraphInfo - Must pass a pointer to a struct kmr_gltf_loader_scene_graph_create_info
+ * returns:
+ *	on success pointer to a struct kmr_gltf_loader_scene_graph
+ *	on failure NULL
+ */
+struct kmr_gltf_loader_scene_graph *
+kmr_gltf_loader_scene_graph_create (struct kmr_gltf_loader_scene_graph_create_info *sceneGraphInfo);
+
+
+/*
+ * kmr_gltf_loader_scene_graph_update: Recomputes the local matrix of every dirty node and the world matrices of the
+ *                                     subtrees rooted at them. Clean subtrees are skipped. World matrices are
+ *                                     computed with batched SIMD (SSE/AVX, picked at runtime) matrix multiplies.
+ *
+ * parameters:
+ * @sceneGraph - Must pass a pointer to a struct kmr_gltf_loader_scene_graph
+ * returns:
+ *	Amount of nodes with an updated world matrix
+ */
+uint32_t
+kmr_gltf_loader_scene_graph_update (struct kmr_gltf_loader_scene_graph *sceneGraph);
+
+
+/*
+ * kmr_gltf_loader_scene_graph_destroy: Frees any allocated memory created after kmr_gltf_loader_scene_graph_create() call.
+ *
+ * parameters:
+ * @sceneGraph - Pointer to a valid struct kmr_gltf_loader_scene_graph
+ *
+ *               Free'd members
+ *               struct kmr_gltf_loader_scene_graph {
+ *                   mat4 *localMatrix; // Single allocation backing every array
+ *               }
+ */
+void
+kmr_gltf_loader_scene_graph_destroy (struct kmr_gltf_loader_scene_graph *sceneGraph);
+
+
+/*
+ * struct kmr_gltf_loader_scene_graph_cull_info (kmsroots GLTF Loader Scene Graph Cull Information)
+ *
+ * members:
+ * @mesh           - Must pass a valid pointer to a struct kmr_gltf_loader_mesh holding the
+ *                   bounding spheres of every mesh referenced by the scene graph
+ * @sceneGraph     - Must pass a valid pointer to a struct kmr_gltf_loader_scene_graph with up to date world matrices
+ * @skin           - Pointer to a struct kmr_gltf_loader_skin with an up to date @palette. May be NULL
+ *                   in which case skinned nodes are tested like mesh nodes, with their bind pose
+ *                   sphere moved by the node's world matrix.
+ * @viewProjection - Projection * view matrix of the camera. Vulkan clip space (depth in [0, w]) is assumed.
+ * @drawList       - Must pass a pointer to an array of at least struct kmr_gltf_loader_scene_graph { @nodeCount }
+ *                   elements. Populated with the flattened index of every visible mesh or skinned
+ *                   node, in scene graph order.
+ */
+struct kmr_gltf_loader_scene_graph_cull_info {
+	struct kmr_gltf_loader_mesh        *mesh;
+	struct kmr_gltf_loader_scene_graph *sceneGraph;
+	struct kmr_gltf_loader_skin        *skin;
+	mat4                               viewProjection;
+	uint32_t                           *drawList;
+};
+
+
+/*
+ * kmr_gltf_loader_scene_graph_cull: Frustum culls every mesh node of a scene graph on the CPU. Mesh bounding spheres are moved
+ *                                   into world space then tested against the six frustum planes in batches of 4 (SSE2) or
+ *                                   8 (AVX) spheres. Skinned meshes are tested with a sphere enclosing their bind pose
+ *                                   sphere moved by every joint matrix of their skin.
+ *
+ * parameters:
+ * @cullInfo - Must pass a pointer to a struct kmr_gltf_loader_scene_graph_cull_info
+ * returns:
+ *	Amount of visible nodes written to @drawList
+ */
+uint32_t
+kmr_gltf_loader_scene_graph_cull (struct kmr_gltf_loader_scene_graph_cull_info *cullInfo);
+
+#endif /* KMR_GLTF_SCENE_GRAPH_H */
@@ -0,0 +1,179 @@
+#ifndef KMR_GLTF_SKIN_H
+#define KMR_GLTF_SKIN_H
+
+#include "gltf-scene-graph.h"
+
+
+/*
+ * struct kmr_gltf_loader_skin_data (kmsroots GLTF Loader Skin Data)
+ *
+ * members:
+ * @firstJoint - Index of the skin's first joint in struct kmr_gltf_loader_skin { @joints, @inverseBindMatrices, @palette }
+ * @jointCount - Amount of joints belonging to the skin
+ */
+struct kmr_gltf_loader_skin_data {
+	uint32_t firstJoint;
+	uint32_t jointCount;
+};
+
+
+/*
+ * struct kmr_gltf_loader_skin_instance (kmsroots GLTF Loader Skin Instance)
+ *
+ * Scene node with both a mesh and a skin attached.
+ *
+ * members:
+ * @node        - Flattened index of node in struct kmr_gltf_loader_scene_graph
+ * @skinIndex   - Index in GLTF file "skins" (json key) array and struct kmr_gltf_loader_skin { @skinData }
+ * @meshIndex   - Index in GLTF file "meshes" (json key) array and struct kmr_gltf_loader_mesh { @meshData }
+ * @firstVertex - Index of the mesh's first vertex in struct kmr_gltf_loader_skin { @vertexJoints, @vertexWeights }.
+ *                Vertices are in the same order as the mesh's unwelded vertices.
+ * @vertexCount - Amount of vertices in mesh
+ */
+struct kmr_gltf_loader_skin_instance {
+	uint32_t node;
+	uint32_t skinIndex;
+	uint32_t meshIndex;
+	uint32_t firstVertex;
+	uint32_t vertexCount;
+};
+
+
+/*
+ * struct kmr_gltf_loader_skin (kmsroots GLTF Loader Skin)
+ *
+ * members:
+ * @skinDataCount       - Amount of elements in @skinData array
+ * @skinData            - Pointer to an array of struct kmr_gltf_loader_skin_data
+ * @jointCount          - Amount of elements in @joints, @inverseBindMatrices and @palette arrays
+ * @joints              - Flattened index in struct kmr_gltf_loader_scene_graph of each joint node.
+ *                        UINT32_MAX if the joint isn't part of the scene, its joint matrix is then
+ *                        the inverse bind matrix alone.
+ * @inverseBindMatrices - Inverse bind matrix of each joint. Identity if the skin doesn't define any.
+ * @palette             - Joint matrices (world matrix of joint * inverse bind matrix) computed by
+ *                        kmr_gltf_loader_skin_palette_update(). 64 byte aligned column major matrices,
+ *                        may be copied as is into a std430 storage buffer. Skinned vertices land in
+ *                        world space, skinned meshes are drawn without their node's matrix.
+ * @instanceCount       - Amount of elements in @instances array
+ * @instances           - Pointer to an array of struct kmr_gltf_loader_skin_instance
+ * @vertexCount         - Amount of elements in @vertexJoints and @vertexWeights arrays
+ * @vertexJoints        - JOINTS_0 of every skinned mesh vertex. Indices are relative to
+ *                        struct kmr_gltf_loader_skin_data { @firstJoint } of the skin. May be
+ *                        uploaded as a VK_FORMAT_R16G16B16A16_UINT vertex attribute.
+ * @vertexWeights       - WEIGHTS_0 of every skinned mesh vertex, normalized to sum to one. May be
+ *                        uploaded as a VK_FORMAT_R32G32B32A32_SFLOAT vertex attribute.
+ */
+struct kmr_gltf_loader_skin {
+	uint32_t                             skinDataCount;
+	struct kmr_gltf_loader_skin_data     *skinData;
+	uint32_t                             jointCount;
+	uint32_t                             *joints;
+	mat4                                 *inverseBindMatrices;
+	mat4                                 *palette;
+	uint32_t                             instanceCount;
+	struct kmr_gltf_loader_skin_instance *instances;
+	uint32_t                             vertexCount;
+	uint16_t                             (*vertexJoints)[4];
+	vec4                                 *vertexWeights;
+};
+
+
+/*
+ * struct kmr_gltf_loader_skin_create_info (kmsroots GLTF Loader Skin Create Information)
+ *
+ * members:
+ * @gltfFile   - Must pass a valid pointer to a struct kmr_gltf_loader_file
+ *               for cgltf_data @gltfData member.
+ * @sceneGraph - Must pass a valid pointer to the struct kmr_gltf_loader_scene_graph joints are
+ *               animated in. Only skinned mesh nodes part of the scene are instanced.
+ */
+struct kmr_gltf_loader_skin_create_info {
+	struct kmr_gltf_loader_file        *gltfFile;
+	struct kmr_gltf_loader_scene_graph *sceneGraph;
+};
+
+
+/*
+ * kmr_gltf_loader_skin_create: Loads inverse bind matrices of every skin and JOINTS_0/WEIGHTS_0 of every mesh instanced
+ *                              by a skinned scene node. Palettes are computed from the scene graph's current world matrices.
+ *
+ * parameters:
+ * @skinInfo - Must pass a pointer to a struct kmr_gltf_loader_skin_create_info
+ * returns:
+ *	on success pointer to a struct kmr_gltf_loader_skin
+ *	on failure NULL
+ */
+struct kmr_gltf_loader_skin *
+kmr_gltf_loader_skin_create (struct kmr_gltf_loader_skin_create_info *skinInfo);
+
+
+/*
+ * kmr_gltf_loader_skin_palette_update: Recomputes every joint matrix in struct kmr_gltf_loader_skin { @palette } from the
+ *                                      scene graph's world matrices. Call after kmr_gltf_loader_scene_graph_update().
+ *
+ * parameters:
+ * @skin       - Must pass a pointer to a struct kmr_gltf_loader_skin
+ * @sceneGraph - Must pass a pointer to the struct kmr_gltf_loader_scene_graph passed to kmr_gltf_loader_skin_create()
+ */
+void
+kmr_gltf_loader_skin_palette_update (struct kmr_gltf_loader_skin *skin, struct kmr_gltf_loader_scene_graph *sceneGraph);
+
+
+/*
+ * struct kmr_gltf_loader_skin_apply_info (kmsroots GLTF Loader Skin Apply Information)
+ *
+ * members:
+ * @skin        - Must pass a valid pointer to a struct kmr_gltf_loader_skin with an up to date @palette
+ * @mesh        - Must pass a valid pointer to a struct kmr_gltf_loader_mesh holding bind pose vertices.
+ *                Must be created without KMR_GLTF_LOADER_MESH_CREATE_WELD and with either the interleaved
+ *                or structure of arrays vertex layout. Must not have been passed to kmr_gltf_loader_mesh_optimize()
+ *                (see struct kmr_gltf_loader_mesh { @optimized }), it reorders vertices away from the order of
+ *                @vertexJoints and @vertexWeights. The same applies when skinning on the GPU.
+ * @dst         - Memory laid out like struct kmr_gltf_loader_mesh { @arena } (i.e. a mapped vertex buffer
+ *                the arena was copied into). Positions and normals of skinned meshes are overwritten,
+ *                everything else is left untouched. Must not be @mesh->arena.
+ * @threadCount - Amount of threads used to skin vertices. 0 uses the amount of online CPU's.
+ *                1 skins everything on the calling thread.
+ */
+struct kmr_gltf_loader_skin_apply_info {
+	struct kmr_gltf_loader_skin *skin;
+	struct kmr_gltf_loader_mesh *mesh;
+	void                        *dst;
+	uint32_t                    threadCount;
+};
+
+
+/*
+ * kmr_gltf_loader_skin_apply: CPU skinning for devices where skinning in the vertex shader is the bottleneck. Blends the
+ *                             joint matrices of every vertex with SIMD (SSE) and transforms its position and normal.
+ *                             Meshes are split into chunks ran across a worker pool. Skinned meshes instanced by more
+ *                             than one node are written once per node, the last node wins.
+ *
+ * parameters:
+ * @skinApplyInfo - Must pass a pointer to a struct kmr_gltf_loader_skin_apply_info
+ * returns:
+ *	on success 0
+ *	on failure -1
+ */
+int
+kmr_gltf_loader_skin_apply (struct kmr_gltf_loader_skin_apply_info *skinApplyInfo);
+
+
+/*
+ * kmr_gltf_loader_skin_destroy: Frees any allocated memory created after kmr_gltf_loader_skin_create() call.
+ *
+ * parameters:
+ * @skin - Pointer to a valid struct kmr_gltf_loader_skin
+ *
+ *         Free'd members
+ *         struct kmr_gltf_loader_skin {
+ *             struct kmr_gltf_loader_skin_data     *skinData;
+ *             mat4                                 *palette; (shared with @inverseBindMatrices and @joints)
+ *             struct kmr_gltf_loader_skin_instance *instances;
+ *             vec4                                 *vertexWeights; (shared with @vertexJoints)
+ *         }
+ */
+void
+kmr_gltf_loader_skin_destroy (struct kmr_gltf_loader_skin *skin);
+
+#endif /* KMR_GLTF_SKIN_H */
@@ -0,0 +1,136 @@
+#ifndef KMR_OBJ_LOADER_H
+#define KMR_OBJ_LOADER_H
+
+#include "gltf-loader.h"
+
+
+/*
+ * struct kmr_obj_loader_material_data (kmsroots OBJ Loader Material Data)
+ *
+ * Material parsed from the .mtl libraries referenced by "mtllib". Materials only named
+ * by "usemtl" without a library definition keep the default values.
+ *
+ * members:
+ * @materialName       - Name given to "newmtl"/"usemtl"
+ * @ambient            - Ambient color (Ka)
+ * @diffuse            - Diffuse color (Kd)
+ * @specular           - Specular color (Ks)
+ * @emission           - Emissive color (Ke)
+ * @shininess          - Specular exponent (Ns)
+ * @dissolve           - Opacity, 1.0 being fully opaque (d)
+ * @diffuseTexturePath - Path to diffuse texture (map_Kd) resolved relative to the .obj file directory.
+ *                       NULL if the material has no diffuse texture.
+ * @normalTexturePath  - Path to bump/normal texture (map_bump) resolved the same way. NULL if not present.
+ */
+struct kmr_obj_loader_material_data {
+	char  *materialName;
+	vec3  ambient;
+	vec3  diffuse;
+	vec3  specular;
+	vec3  emission;
+	float shininess;
+	float dissolve;
+	char  *diffuseTexturePath;
+	char  *normalTexturePath;
+};
+
+
+/*
+ * struct kmr_obj_loader (kmsroots OBJ Loader)
+ *
+ * members:
+ * @mesh              - Every group ("g" lines) of the OBJ file converted to the same layout
+ *                      kmr_gltf_loader_mesh_create() produces. One struct kmr_gltf_loader_mesh_data
+ *                      per group and one primitive per material used by the group. A primitive's
+ *                      @materialIndex is the index of its material in @materialData.
+ * @materialData      - Pointer to an array of struct kmr_obj_loader_material_data
+ * @materialDataCount - Amount of elements in @materialData array
+ * @stringPool        - Every material name and texture path, NUL terminated and back to back
+ * @stringPoolSize    - Byte size of @stringPool
+ */
+struct kmr_obj_loader {
+	struct kmr_gltf_loader_mesh         *mesh;
+	struct kmr_obj_loader_material_data *materialData;
+	uint32_t                            materialDataCount;
+	char                                *stringPool;
+	uint32_t                            stringPoolSize;
+};
+
+
+/*
+ * enum kmr_obj_loader_create_flags (kmsroots OBJ Loader Create Flags)
+ *
+ * @KMR_OBJ_LOADER_CREATE_WELD           - Face corners referencing the same position, texture coordinate
+ *                                         and normal within a primitive share one vertex.
+ * @KMR_OBJ_LOADER_CREATE_INDEX_DOWNSIZE - Same as KMR_GLTF_LOADER_MESH_CREATE_INDEX_DOWNSIZE
+ * @KMR_OBJ_LOADER_CREATE_OPTIMIZE       - Run kmr_gltf_loader_mesh_optimize() on the created mesh.
+ */
+enum kmr_obj_loader_create_flags {
+	KMR_OBJ_LOADER_CREATE_WELD           = (1 << 0),
+	KMR_OBJ_LOADER_CREATE_INDEX_DOWNSIZE = (1 << 1),
+	KMR_OBJ_LOADER_CREATE_OPTIMIZE       = (1 << 2),
+};
+
+
+/*
+ * struct kmr_obj_loader_create_info (kmsroots OBJ Loader Create Information)
+ *
+ * members:
+ * @fileName     - Path to Wavefront OBJ file to load
+ * @threadCount  - Amount of threads used to parse and convert the file. 0 uses the amount of
+ *                 online CPU's. 1 does everything on the calling thread.
+ * @chunkSize    - Minimum amount of bytes each thread parses. Files are split at line boundaries
+ *                 into at most @threadCount chunks of at least @chunkSize bytes. 0 defaults to 4MiB.
+ * @flags        - Bitmask of enum kmr_obj_loader_create_flags
+ * @vertexLayout - Layout to store vertices in
+ * @arena        - Same as struct kmr_gltf_loader_mesh_create_info { @arena }
+ * @arenaSize    - Size in bytes of @arena
+ */
+struct kmr_obj_loader_create_info {
+	const char                              *fileName;
+	uint32_t                                threadCount;
+	uint32_t                                chunkSize;
+	enum kmr_obj_loader_create_flags        flags;
+	enum kmr_gltf_loader_mesh_vertex_layout vertexLayout;
+	void                                    *arena;
+	uint32_t                                arenaSize;
+};
+
+
+/*
+ * kmr_obj_loader_create: Parses a Wavefront OBJ file (and its .mtl libraries) with fast_obj. Large files are split
+ *                        at line boundaries and chunks are parsed concurrently on a worker pool, then merged in file
+ *                        order. Files using relative (negative) face indices past the first chunk are parsed by one
+ *                        thread as those can only be resolved in order. Faces are triangulated as fans, texture
+ *                        coordinates are flipped to a top left origin and vertices without a normal get (0, 0, 1).
+ *                        Groups and materials of the same name are merged. Vertices and indices of every group end
+ *                        up in one arena (see kmr_gltf_loader_mesh_emit()).
+ *
+ * parameters:
+ * @objInfo - Must pass a pointer to a struct kmr_obj_loader_create_info
+ * returns:
+ *	on success: pointer to a struct kmr_obj_loader
+ *	on failure: NULL
+ */
+struct kmr_obj_loader *
+kmr_obj_loader_create (struct kmr_obj_loader_create_info *objInfo);
+
+
+/*
+ * kmr_obj_loader_destroy: Frees any allocated memory created after kmr_obj_loader_create() call.
+ *
+ * parameters:
+ * @obj - Pointer to a valid struct kmr_obj_loader
+ *
+ *        Free'd members
+ *        struct kmr_obj_loader {
+ *            struct kmr_gltf_loader_mesh         *mesh;
+ *            struct kmr_obj_loader_material_data *materialData;
+ *            char                                *stringPool;
+ *        }
+ */
+void
+kmr_obj_loader_destroy (struct kmr_obj_loader *obj);
+
+
+#endif /* KMR_OBJ_LOADER_H */
@@ -2,6 +2,7 @@
 #define KMR_UTILS_H
 
 #include <stdio.h>
+#include <stdbool.h>
 #include <inttypes.h>
 
 #define UNUSED __attribute__((unused))
@@ -56,33 +57,61 @@ struct kmr_utils_aligned_buffer_create_info {
 struct kmr_utils_aligned_buffer kmr_utils_aligned_buffer_create(struct kmr_utils_aligned_buffer_create_info *kmsutils);
 
 
+#define KMR_UTILS_IMAGE_BUFFER_MIP_LEVEL_MAX 16
+
+
+/*
+ * struct kmr_utils_image_buffer_mip_level (kmsroots Utils Image Buffer Mip Level)
+ *
+ * members:
+ * @offset - Byte offset of the mip level from the start of struct kmr_utils_image_buffer { @pixels }
+ * @size   - Byte size of the mip level
+ * @width  - Width of the mip level in pixels/texels
+ * @height - Height of the mip level in pixels/texels
+ */
+struct kmr_utils_image_buffer_mip_level {
+	size_t   offset;
+	size_t   size;
+	uint32_t width;
+	uint32_t height;
+};
+
+
 /*
  * struct kmr_utils_image_buffer (kmsroots Utils Image Buffer)
  *
  * members:
- * @pixels            - Pointer to actual pixel data
- * @bitsPerPixel      - Stores information about amount of bits per pixel
+ * @pixels            - Pointer to actual pixel data. For KTX2/DDS images the unmodified (block compressed)
+ *                      payload of every mip level, largest level first.
+ * @bitsPerPixel      - Stores information about amount of bits per pixel. 0 for KTX2/DDS images.
  * @imageWidth        - Width of image in pixels/texels
  * @imageHeight       - Height of image in pixels/texels
  * @imageChannels     - Amount of color channels image has { RGBA(4): all images get converted to RGBA }
  *                      NOTE: Some images may have an @imageChannels value of 3, but when calculating @imageSize
  *                      the value of 4 is utilized.
- * @imageSize         - Byte size of the image (@imageWidth * @imageHeight) * @imageChannels
+ * @imageSize         - Byte size of the image (@imageWidth * @imageHeight) * 4 * (@bitsPerPixel / 8)
  * @imageBufferOffset - Special member used by kmr_gltf_loader_texture_image_create(3) to keep track of byte
  *                      offset in larger VkBuffer->VkDeviceMemory. Image assets and metadata of image assets
  *                      associated with GLTF file are loaded into an array of type struct kmr_utils_image_buffer.
  *                      This array can then be cycled through by the application to populate section of VkBuffer->VkDeviceMemory.
  *                      In order to save the application a bit of clock cycles (i.e by removing duplicate offset additions) compute
  *                      offset once and store value in @imageBufferOffset.
+ * @vkFormat          - VkFormat stored in a KTX2/DDS container. VK_FORMAT_UNDEFINED for images decoded
+ *                      to RGBA by stb_image, the application picks between UNORM and SRGB for those.
+ * @mipLevelCount     - Amount of elements in @mipLevels array. 1 for images decoded by stb_image.
+ * @mipLevels         - Byte offset, size and dimensions of each mip level in @pixels
  */
 struct kmr_utils_image_buffer {
-	uint8_t  *pixels;
-	uint8_t  bitsPerPixel;
-	uint32_t imageWidth;
-	uint32_t imageHeight;
-	uint32_t imageChannels;
-	size_t   imageSize;
-	size_t   imageBufferOffset;
+	uint8_t                                 *pixels;
+	uint8_t                                 bitsPerPixel;
+	uint32_t                                imageWidth;
+	uint32_t                                imageHeight;
+	uint32_t                                imageChannels;
+	size_t                                  imageSize;
+	size_t                                  imageBufferOffset;
+	uint32_t                                vkFormat;
+	uint32_t                                mipLevelCount;
+	struct kmr_utils_image_buffer_mip_level mipLevels[KMR_UTILS_IMAGE_BUFFER_MIP_LEVEL_MAX];
 };
 
 
@@ -106,7 +135,10 @@ struct kmr_utils_image_buffer_create_info {
  * kmr_utils_image_buffer_create: Create pixel buffer for any given image and return its size, width, height,
  *                                color channel count, actual pixel buffer, and amount of bits per pixel.
  *                                Function converts RGB-only images to RGBA, as most devices don't support
- *                                RGB-formats in Vulkan.
+ *                                RGB-formats in Vulkan. KTX2 and DDS files aren't decoded, their block
+ *                                compressed (BCn/ETC2/ASTC) or RGBA8 payload and mip chain are passed
+ *                                through with the matching VkFormat. Supercompressed KTX2 files, other
+ *                                formats, cube maps, arrays and volume textures aren't supported.
  *
  * parameters:
  * @kmsutils - pointer to a struct kmr_utils_image_buffer_create_info
@@ -117,6 +149,87 @@ struct kmr_utils_image_buffer_create_info {
 struct kmr_utils_image_buffer kmr_utils_image_buffer_create(struct kmr_utils_image_buffer_create_info *kmsutils);
 
 
+/*
+ * struct kmr_utils_image_buffer_memory_create_info (kmsroots Utils Image Buffer Memory Create Information)
+ *
+ * members:
+ * @bytes    - Pointer to an encoded image (PNG, JPEG, ...) already in memory. Only read from.
+ * @byteSize - Byte size of @bytes
+ * @name     - Optional string printed if decoding fails. May be NULL.
+ */
+struct kmr_utils_image_buffer_memory_create_info {
+	const uint8_t *bytes;
+	size_t        byteSize;
+	const char    *name;
+};
+
+
+/*
+ * kmr_utils_image_buffer_memory_create: Same as kmr_utils_image_buffer_create(), but decodes an image that's
+ *                                       already in memory (i.e a GLB binary chunk) instead of opening a file.
+ *
+ * parameters:
+ * @kmsutils - pointer to a struct kmr_utils_image_buffer_memory_create_info
+ * returns:
+ *	on success struct kmr_utils_image_buffer
+ *	on failure struct kmr_utils_image_buffer { with member nulled }
+ */
+struct kmr_utils_image_buffer kmr_utils_image_buffer_memory_create(struct kmr_utils_image_buffer_memory_create_info *kmsutils);
+
+
+/*
+ * enum kmr_utils_image_buffer_mip_filter (kmsroots Utils Image Buffer Mip Filter)
+ *
+ * @KMR_UTILS_IMAGE_BUFFER_MIP_FILTER_NONE   - Don't generate mip levels
+ * @KMR_UTILS_IMAGE_BUFFER_MIP_FILTER_BOX    - Average each 2x2 texel footprint. Fastest.
+ * @KMR_UTILS_IMAGE_BUFFER_MIP_FILTER_KAISER - Separable 6x6 Kaiser windowed sinc. Keeps smaller levels
+ *                                             sharper than the box filter for roughly 3x the cost.
+ */
+enum kmr_utils_image_buffer_mip_filter {
+	KMR_UTILS_IMAGE_BUFFER_MIP_FILTER_NONE = 0,
+	KMR_UTILS_IMAGE_BUFFER_MIP_FILTER_BOX = 1,
+	KMR_UTILS_IMAGE_BUFFER_MIP_FILTER_KAISER = 2,
+};
+
+
+/*
+ * struct kmr_utils_image_buffer_mip_chain_create_info (kmsroots Utils Image Buffer Mip Chain Create Information)
+ *
+ * members:
+ * @imageBuffer - Pointer to an image returned by kmr_utils_image_buffer_create() or
+ *                kmr_utils_image_buffer_memory_create(). Only RGBA8/RGBA16 images with
+ *                a single mip level get a mip chain, others are left untouched.
+ * @filter      - Filter used to compute each level from the one above it
+ * @srgb        - Filter color channels in linear space, the image being sRGB encoded.
+ *                Alpha is always treated as linear.
+ * @threadCount - Amount of threads each level's rows are split between. 0 uses the
+ *                amount of online CPU's. 1 runs on the calling thread.
+ */
+struct kmr_utils_image_buffer_mip_chain_create_info {
+	struct kmr_utils_image_buffer          *imageBuffer;
+	enum kmr_utils_image_buffer_mip_filter filter;
+	bool                                   srgb;
+	uint32_t                               threadCount;
+};
+
+
+/*
+ * kmr_utils_image_buffer_mip_chain_create: Generates every mip level down to 1x1 (at most KMR_UTILS_IMAGE_BUFFER_MIP_LEVEL_MAX)
+ *                                          on the CPU. Levels are stored contiguously, largest first, in a reallocated
+ *                                          struct kmr_utils_image_buffer { @pixels } and @imageSize, @mipLevelCount and
+ *                                          @mipLevels are updated so the whole chain uploads with one vkCmdCopyBufferToImage
+ *                                          using a VkBufferImageCopy region per level. Meant for devices where
+ *                                          vkCmdBlitImage based mip generation is unavailable or slow.
+ *
+ * parameters:
+ * @kmsutils - pointer to a struct kmr_utils_image_buffer_mip_chain_create_info
+ * returns:
+ *	on success 0
+ *	on failure -1 { @imageBuffer left as is }
+ */
+int kmr_utils_image_buffer_mip_chain_create(struct kmr_utils_image_buffer_mip_chain_create_info *kmsutils);
+
+
 /*
  * struct kmr_utils_file (kmsroots Utils File)
  *
@@ -143,6 +256,78 @@ struct kmr_utils_file {
 struct kmr_utils_file kmr_utils_file_load(const char *filename);
 
 
+/*
+ * kmr_utils_file_map: Maps a file's contents into the calling process address space with mmap(2) instead of
+ *                     copying them into a heap buffer. Pages are mapped private (copy-on-write) so writes never
+ *                     reach the file on disk. Application's must call kmr_utils_file_unmap() on the returned struct.
+ *
+ * parameters:
+ * @filename - Must pass path to file to map
+ * @populate - If true pre-fault every page (MAP_POPULATE) and let the kernel know the whole
+ *             range will be accessed soon (MADV_WILLNEED). Best used when the entire file
+ *             is about to be read.
+ * returns:
+ *	on success struct kmr_utils_file
+ *	on failure struct kmr_utils_file { with member nulled }
+ */
+struct kmr_utils_file kmr_utils_file_map(const char *filename, bool populate);
+
+
+/*
+ * kmr_utils_file_unmap: Unmaps memory mapped in by kmr_utils_file_map() and nulls struct members.
+ *
+ * parameters:
+ * @file - Pointer to a struct kmr_utils_file populated by kmr_utils_file_map()
+ */
+void kmr_utils_file_unmap(struct kmr_utils_file *file);
+
+
+/*
+ * kmr_utils_worker_pool_job: Function pointer prototype for a job ran by kmr_utils_worker_pool_run().
+ *                            Jobs may be ran concurrently and in any order.
+ *
+ * parameters:
+ * @userData - Pointer to data shared by all jobs. Passed via struct kmr_utils_worker_pool_run_info { @userData }.
+ * @jobIndex - Index of the job to run in range [0, @jobCount).
+ * returns:
+ *	on success 0
+ *	on failure -1
+ */
+typedef int (*kmr_utils_worker_pool_job)(void *userData, uint32_t jobIndex);
+
+
+/*
+ * struct kmr_utils_worker_pool_run_info (kmsroots Utils Worker Pool Run Information)
+ *
+ * members:
+ * @threadCount - Maximum amount of threads (including the calling thread) used to run jobs.
+ *                0 uses the amount of online CPU's. 1 runs every job on the calling thread.
+ * @jobCount    - Amount of jobs to run.
+ * @job         - Function called once per job index.
+ * @userData    - Pointer passed to every @job call.
+ */
+struct kmr_utils_worker_pool_run_info {
+	uint32_t                  threadCount;
+	uint32_t                  jobCount;
+	kmr_utils_worker_pool_job job;
+	void                      *userData;
+};
+
+
+/*
+ * kmr_utils_worker_pool_run: Spawns a pool of worker threads that claim job indices from a shared atomic counter
+ *                            until all jobs are ran. The calling thread participates and the function only returns
+ *                            once every worker has been joined. If any job fails no new jobs are claimed.
+ *
+ * parameters:
+ * @kmsutils - pointer to a struct kmr_utils_worker_pool_run_info
+ * returns:
+ *	on success 0
+ *	on failure -1
+ */
+int kmr_utils_worker_pool_run(struct kmr_utils_worker_pool_run_info *kmsutils);
+
+
 /*
  * kmr_utils_nanosecond: Function returns the current time in nanosecond
  *
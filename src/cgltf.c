@@ -0,0 +1,2 @@
+#define CGLTF_IMPLEMENTATION
+#include <cgltf.h>
@@ -0,0 +1,2 @@
+#define FAST_OBJ_IMPLEMENTATION
+#include <fast_obj.h>
@@ -0,0 +1,512 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "gltf-animation.h"
+#include "gltf-loader-private.h"
+
+
+/************************************************************************
+ * START OF kmr_gltf_loader_animation_{create,sample,destroy} FUNCTIONS *
+ ************************************************************************/
+
+/* Keys linearly stepped over before falling back to a binary search */
+#define ANIMATION_KEY_LINEAR_STEPS 4
+
+/* Linear rotations collected before running the SIMD interpolation kernel */
+#define ANIMATION_ROTATION_BATCH_SIZE 64
+
+
+struct animation_rotation_batch {
+	uint32_t    count;
+	const float *q0[ANIMATION_ROTATION_BATCH_SIZE];
+	const float *q1[ANIMATION_ROTATION_BATCH_SIZE];
+	float       *dst[ANIMATION_ROTATION_BATCH_SIZE];
+	float       u[ANIMATION_ROTATION_BATCH_SIZE];
+};
+
+
+/*
+ * Rotation kernels: Interpolate @batch->count quaternion pairs along the shortest arc.
+ * Slerp is approximated by a nlerp with a corrected interpolation factor, see
+ * https://zeux.io/2015/07/23/approximating-slerp/. Unlike slerp there's no
+ * acos/sin and no branch, so quaternions are processed four at a time.
+ */
+struct animation_kernels {
+	void (*rotation_interpolate)(struct animation_rotation_batch *batch, uint32_t start);
+};
+
+
+static void
+rotation_interpolate_scalar (struct animation_rotation_batch *batch, uint32_t start)
+{
+	uint32_t n, c;
+	float d, a, b, k, t, sign, len, q[4];
+
+	for (n = start; n < batch->count; n++) {
+		const float *q0 = batch->q0[n], *q1 = batch->q1[n];
+
+		d = q0[0] * q1[0] + q0[1] * q1[1] + q0[2] * q1[2] + q0[3] * q1[3];
+		sign = (d < 0.0f) ? -1.0f : 1.0f;
+		d = fabsf(d);
+
+		t = batch->u[n];
+		a = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+		b = 0.848013f + d * (-1.06021f + d * 0.215638f);
+		k = a * (t - 0.5f) * (t - 0.5f) + b;
+		t = t + t * (t - 0.5f) * (t - 1.0f) * k;
+
+		for (c = 0; c < 4; c++)
+			q[c] = q0[c] + (q1[c] * sign - q0[c]) * t;
+
+		len = 1.0f / sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+		for (c = 0; c < 4; c++)
+			batch->dst[n][c] = q[c] * len;
+	}
+}
+
+
+#ifdef HAVE_X86_SIMD
+
+__attribute__((target("sse2")))
+static void
+rotation_interpolate_sse2 (struct animation_rotation_batch *batch, uint32_t start)
+{
+	uint32_t n;
+	__m128 x0, y0, z0, w0, x1, y1, z1, w1;
+	__m128 d, sign, a, b, k, t, th, len;
+
+	const __m128 half = _mm_set1_ps(0.5f), one = _mm_set1_ps(1.0f);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	for (n = start; n + 4 <= batch->count; n += 4) {
+		/* Four quaternions in, transposed to one register per component */
+		x0 = _mm_loadu_ps(batch->q0[n+0]); y0 = _mm_loadu_ps(batch->q0[n+1]);
+		z0 = _mm_loadu_ps(batch->q0[n+2]); w0 = _mm_loadu_ps(batch->q0[n+3]);
+		_MM_TRANSPOSE4_PS(x0, y0, z0, w0);
+
+		x1 = _mm_loadu_ps(batch->q1[n+0]); y1 = _mm_loadu_ps(batch->q1[n+1]);
+		z1 = _mm_loadu_ps(batch->q1[n+2]); w1 = _mm_loadu_ps(batch->q1[n+3]);
+		_MM_TRANSPOSE4_PS(x1, y1, z1, w1);
+
+		d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x0, x1), _mm_mul_ps(y0, y1)),
+		               _mm_add_ps(_mm_mul_ps(z0, z1), _mm_mul_ps(w0, w1)));
+
+		/* Flip q1 onto the same hemisphere as q0 */
+		sign = _mm_and_ps(d, signMask);
+		d = _mm_xor_ps(d, sign);
+		x1 = _mm_xor_ps(x1, sign); y1 = _mm_xor_ps(y1, sign);
+		z1 = _mm_xor_ps(z1, sign); w1 = _mm_xor_ps(w1, sign);
+
+		t = _mm_loadu_ps(&batch->u[n]);
+		a = _mm_add_ps(_mm_set1_ps(3.55645f), _mm_mul_ps(d, _mm_set1_ps(-1.43519f)));
+		a = _mm_add_ps(_mm_set1_ps(-3.2452f), _mm_mul_ps(d, a));
+		a = _mm_add_ps(_mm_set1_ps(1.0904f), _mm_mul_ps(d, a));
+		b = _mm_add_ps(_mm_set1_ps(-1.06021f), _mm_mul_ps(d, _mm_set1_ps(0.215638f)));
+		b = _mm_add_ps(_mm_set1_ps(0.848013f), _mm_mul_ps(d, b));
+		th = _mm_sub_ps(t, half);
+		k = _mm_add_ps(_mm_mul_ps(a, _mm_mul_ps(th, th)), b);
+		t = _mm_add_ps(t, _mm_mul_ps(_mm_mul_ps(t, th), _mm_mul_ps(_mm_sub_ps(t, one), k)));
+
+		x0 = _mm_add_ps(x0, _mm_mul_ps(_mm_sub_ps(x1, x0), t));
+		y0 = _mm_add_ps(y0, _mm_mul_ps(_mm_sub_ps(y1, y0), t));
+		z0 = _mm_add_ps(z0, _mm_mul_ps(_mm_sub_ps(z1, z0), t));
+		w0 = _mm_add_ps(w0, _mm_mul_ps(_mm_sub_ps(w1, w0), t));
+
+		len = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x0, x0), _mm_mul_ps(y0, y0)),
+		                 _mm_add_ps(_mm_mul_ps(z0, z0), _mm_mul_ps(w0, w0)));
+		len = _mm_div_ps(one, _mm_sqrt_ps(len));
+
+		x0 = _mm_mul_ps(x0, len); y0 = _mm_mul_ps(y0, len);
+		z0 = _mm_mul_ps(z0, len); w0 = _mm_mul_ps(w0, len);
+		_MM_TRANSPOSE4_PS(x0, y0, z0, w0);
+
+		_mm_storeu_ps(batch->dst[n+0], x0); _mm_storeu_ps(batch->dst[n+1], y0);
+		_mm_storeu_ps(batch->dst[n+2], z0); _mm_storeu_ps(batch->dst[n+3], w0);
+	}
+
+	rotation_interpolate_scalar(batch, n);
+}
+
+#endif /* HAVE_X86_SIMD */
+
+
+static struct animation_kernels animation_kernels;
+static pthread_once_t animation_kernels_once = PTHREAD_ONCE_INIT;
+
+
+static void
+animation_kernels_init (void)
+{
+	animation_kernels.rotation_interpolate = rotation_interpolate_scalar;
+
+#ifdef HAVE_X86_SIMD
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("sse2"))
+		animation_kernels.rotation_interpolate = rotation_interpolate_sse2;
+#endif
+}
+
+
+static uint32_t
+animation_path_components (enum kmr_gltf_loader_animation_path path)
+{
+	return (path == KMR_GLTF_LOADER_ANIMATION_PATH_ROTATION) ? 4 : 3;
+}
+
+
+/*
+ * Returns true if channel can be played on the scene graph. Morph target weights
+ * and nodes outside of the scene are skipped without a warning, both are expected.
+ */
+static bool
+animation_channel_get (cgltf_data *gltfData,
+                       struct kmr_gltf_loader_scene_graph *sceneGraph,
+                       cgltf_animation_channel *gltfChannel,
+                       struct kmr_gltf_loader_animation_channel *channel)
+{
+	uint32_t nodeIndex, components;
+	cgltf_animation_sampler *sampler = gltfChannel->sampler;
+
+	if (!gltfChannel->target_node || !sampler || !sampler->input || !sampler->output)
+		return false;
+
+	switch (gltfChannel->target_path) {
+		case cgltf_animation_path_type_translation:
+			channel->path = KMR_GLTF_LOADER_ANIMATION_PATH_TRANSLATION;
+			break;
+		case cgltf_animation_path_type_rotation:
+			channel->path = KMR_GLTF_LOADER_ANIMATION_PATH_ROTATION;
+			break;
+		case cgltf_animation_path_type_scale:
+			channel->path = KMR_GLTF_LOADER_ANIMATION_PATH_SCALE;
+			break;
+		default:
+			return false;
+	}
+
+	switch (sampler->interpolation) {
+		case cgltf_interpolation_type_step:
+			channel->interpolation = KMR_GLTF_LOADER_ANIMATION_INTERPOLATION_STEP;
+			break;
+		case cgltf_interpolation_type_cubic_spline:
+			channel->interpolation = KMR_GLTF_LOADER_ANIMATION_INTERPOLATION_CUBICSPLINE;
+			break;
+		default:
+			channel->interpolation = KMR_GLTF_LOADER_ANIMATION_INTERPOLATION_LINEAR;
+			break;
+	}
+
+	nodeIndex = cgltf_node_index(gltfData, gltfChannel->target_node);
+	if (sceneGraph->gltfNodeMap[nodeIndex] == UINT32_MAX)
+		return false;
+
+	components = animation_path_components(channel->path);
+	if (!sampler->input->count || cgltf_num_components(sampler->output->type) != components ||
+	    sampler->output->count != sampler->input->count *
+	    ((channel->interpolation == KMR_GLTF_LOADER_ANIMATION_INTERPOLATION_CUBICSPLINE) ? 3 : 1))
+	{
+		kmr_utils_log(KMR_WARNING, "[!] kmr_gltf_loader_animation_create: channel of node %u has mismatched sampler accessors, skipping", nodeIndex);
+		return false;
+	}
+
+	channel->node = sceneGraph->gltfNodeMap[nodeIndex];
+	channel->keyCount = sampler->input->count;
+	channel->lastKey = 0;
+	return true;
+}
+
+
+struct kmr_gltf_loader_animation *
+kmr_gltf_loader_animation_create (struct kmr_gltf_loader_animation_create_info *animationInfo)
+{
+	uint32_t a, c, inputIndex, channelCount = 0, timeCount = 0, valueCount = 0, floatCount;
+	uint32_t *timeOffsets = NULL;
+
+	cgltf_data *gltfData = animationInfo->gltfFile->gltfData;
+	cgltf_animation *gltfAnimation = NULL;
+	cgltf_animation_sampler *sampler = NULL;
+
+	struct kmr_gltf_loader_animation *animation = NULL;
+	struct kmr_gltf_loader_animation_data *animationData = NULL;
+	struct kmr_gltf_loader_animation_channel channel;
+
+	animation = calloc(1, sizeof(struct kmr_gltf_loader_animation));
+	if (!animation) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(animation): %s", strerror(errno));
+		return NULL;
+	}
+
+	/* Samplers commonly share input accessors, store their key times once */
+	timeOffsets = malloc((gltfData->accessors_count + 1) * sizeof(uint32_t));
+	if (!timeOffsets) {
+		kmr_utils_log(KMR_DANGER, "[x] malloc(timeOffsets): %s", strerror(errno));
+		goto exit_error_kmr_gltf_loader_animation_create;
+	}
+
+	memset(timeOffsets, 0xff, (gltfData->accessors_count + 1) * sizeof(uint32_t));
+
+	/* First pass acquire sizes */
+	for (a = 0; a < gltfData->animations_count; a++) {
+		gltfAnimation = &gltfData->animations[a];
+		for (c = 0; c < gltfAnimation->channels_count; c++) {
+			if (!animation_channel_get(gltfData, animationInfo->sceneGraph, &gltfAnimation->channels[c], &channel))
+				continue;
+
+			sampler = gltfAnimation->channels[c].sampler;
+			inputIndex = cgltf_accessor_index(gltfData, sampler->input);
+			if (timeOffsets[inputIndex] == UINT32_MAX) {
+				timeOffsets[inputIndex] = timeCount;
+				timeCount += sampler->input->count;
+			}
+
+			valueCount += sampler->output->count * animation_path_components(channel.path);
+			channelCount++;
+		}
+	}
+
+	animation->animationData = calloc(gltfData->animations_count + 1, sizeof(struct kmr_gltf_loader_animation_data));
+	animation->channels = calloc(channelCount + 1, sizeof(struct kmr_gltf_loader_animation_channel));
+	animation->times = calloc(timeCount + 1, sizeof(float));
+	animation->values = calloc(valueCount + 1, sizeof(float));
+	if (!animation->animationData || !animation->channels || !animation->times || !animation->values) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc: %s", strerror(errno));
+		goto exit_error_kmr_gltf_loader_animation_create;
+	}
+
+	animation->animationDataCount = gltfData->animations_count;
+	animation->timeCount = timeCount;
+	animation->valueCount = valueCount;
+
+	/* Second pass bake key times and values */
+	memset(timeOffsets, 0xff, (gltfData->accessors_count + 1) * sizeof(uint32_t));
+	channelCount = timeCount = valueCount = 0;
+	for (a = 0; a < gltfData->animations_count; a++) {
+		gltfAnimation = &gltfData->animations[a];
+		animationData = &animation->animationData[a];
+		animationData->firstChannel = channelCount;
+
+		for (c = 0; c < gltfAnimation->channels_count; c++) {
+			if (!animation_channel_get(gltfData, animationInfo->sceneGraph, &gltfAnimation->channels[c], &channel))
+				continue;
+
+			sampler = gltfAnimation->channels[c].sampler;
+			inputIndex = cgltf_accessor_index(gltfData, sampler->input);
+			if (timeOffsets[inputIndex] == UINT32_MAX) {
+				if (cgltf_accessor_unpack_floats(sampler->input, animation->times + timeCount, sampler->input->count) != sampler->input->count) {
+					kmr_utils_log(KMR_DANGER, "[x] cgltf_accessor_unpack_floats: failed to read accessor %u", inputIndex);
+					goto exit_error_kmr_gltf_loader_animation_create;
+				}
+
+				timeOffsets[inputIndex] = timeCount;
+				timeCount += sampler->input->count;
+			}
+
+			floatCount = sampler->output->count * animation_path_components(channel.path);
+			if (cgltf_accessor_unpack_floats(sampler->output, animation->values + valueCount, floatCount) != floatCount) {
+				kmr_utils_log(KMR_DANGER, "[x] cgltf_accessor_unpack_floats: failed to read accessor %zu",
+				              cgltf_accessor_index(gltfData, sampler->output));
+				goto exit_error_kmr_gltf_loader_animation_create;
+			}
+
+			channel.timeOffset = timeOffsets[inputIndex];
+			channel.valueOffset = valueCount;
+			valueCount += floatCount;
+
+			if (animation->times[channel.timeOffset + channel.keyCount - 1] > animationData->duration)
+				animationData->duration = animation->times[channel.timeOffset + channel.keyCount - 1];
+
+			animation->channels[channelCount++] = channel;
+		}
+
+		animationData->channelCount = channelCount - animationData->firstChannel;
+	}
+
+	animation->channelCount = channelCount;
+
+	/* CPU features are only checked once, sampling reuses the same kernels */
+	pthread_once(&animation_kernels_once, animation_kernels_init);
+
+	free(timeOffsets);
+	return animation;
+
+exit_error_kmr_gltf_loader_animation_create:
+	free(timeOffsets);
+	kmr_gltf_loader_animation_destroy(animation);
+	return NULL;
+}
+
+
+/*
+ * Returns key k where @times[k] <= @time < @times[k+1]. @time must be inside
+ * [@times[0], @times[@keyCount-1]) and @keyCount at least 2.
+ */
+static uint32_t
+animation_key_find (const float *times, uint32_t keyCount, uint32_t lastKey, float time)
+{
+	uint32_t lo, hi, mid, step;
+
+	if (lastKey > keyCount - 2)
+		lastKey = 0;
+
+	if (times[lastKey] <= time) {
+		for (step = 0; step < ANIMATION_KEY_LINEAR_STEPS; step++) {
+			if (time < times[lastKey + 1])
+				return lastKey;
+			lastKey++;
+		}
+
+		lo = lastKey;
+		hi = keyCount - 1;
+	} else {
+		lo = 0;
+		hi = lastKey;
+	}
+
+	while (hi - lo > 1) {
+		mid = lo + ((hi - lo) >> 1);
+		if (times[mid] <= time)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+
+int
+kmr_gltf_loader_animation_sample (struct kmr_gltf_loader_animation_sample_info *sampleInfo)
+{
+	uint32_t c, i, k, components, stride, keyCount;
+	float u, dt, u2, u3, h00, h10, h01, h11, len;
+	float *dst = NULL;
+	const float *times = NULL, *values = NULL, *v0 = NULL, *v1 = NULL;
+
+	struct kmr_gltf_loader_animation *animation = sampleInfo->animation;
+	struct kmr_gltf_loader_scene_graph *sceneGraph = sampleInfo->sceneGraph;
+	struct kmr_gltf_loader_animation_data *animationData = NULL;
+	struct kmr_gltf_loader_animation_channel *channel = NULL;
+	struct animation_rotation_batch batch;
+
+	if (sampleInfo->animationIndex >= animation->animationDataCount) {
+		kmr_utils_log(KMR_DANGER, "[x] kmr_gltf_loader_animation_sample: animation %u out of range, %u animation(s) loaded",
+		              sampleInfo->animationIndex, animation->animationDataCount);
+		return -1;
+	}
+
+	animationData = &animation->animationData[sampleInfo->animationIndex];
+	batch.count = 0;
+
+	for (c = animationData->firstChannel; c < animationData->firstChannel + animationData->channelCount; c++) {
+		channel = &animation->channels[c];
+		components = animation_path_components(channel->path);
+		keyCount = channel->keyCount;
+		times = animation->times + channel->timeOffset;
+		values = animation->values + channel->valueOffset;
+
+		switch (channel->path) {
+			case KMR_GLTF_LOADER_ANIMATION_PATH_TRANSLATION:
+				dst = sceneGraph->translation[channel->node];
+				break;
+			case KMR_GLTF_LOADER_ANIMATION_PATH_ROTATION:
+				dst = sceneGraph->rotation[channel->node];
+				break;
+			case KMR_GLTF_LOADER_ANIMATION_PATH_SCALE:
+				dst = sceneGraph->scale[channel->node];
+				break;
+		}
+
+		sceneGraph->dirty[channel->node] = true;
+
+		/* Cubic splines store (in-tangent, value, out-tangent) per key */
+		if (channel->interpolation == KMR_GLTF_LOADER_ANIMATION_INTERPOLATION_CUBICSPLINE) {
+			stride = components * 3;
+			values += components;
+		} else {
+			stride = components;
+		}
+
+		if (keyCount == 1 || sampleInfo->time <= times[0]) {
+			memcpy(dst, values, components * sizeof(float));
+			continue;
+		}
+
+		if (sampleInfo->time >= times[keyCount - 1]) {
+			memcpy(dst, values + (keyCount - 1) * stride, components * sizeof(float));
+			continue;
+		}
+
+		k = animation_key_find(times, keyCount, channel->lastKey, sampleInfo->time);
+		channel->lastKey = k;
+
+		dt = times[k+1] - times[k];
+		u = (dt > 0.0f) ? (sampleInfo->time - times[k]) / dt : 0.0f;
+		v0 = values + k * stride;
+		v1 = values + (k + 1) * stride;
+
+		switch (channel->interpolation) {
+			case KMR_GLTF_LOADER_ANIMATION_INTERPOLATION_STEP:
+				memcpy(dst, v0, components * sizeof(float));
+				break;
+			case KMR_GLTF_LOADER_ANIMATION_INTERPOLATION_LINEAR:
+				if (channel->path != KMR_GLTF_LOADER_ANIMATION_PATH_ROTATION) {
+					for (i = 0; i < components; i++)
+						dst[i] = v0[i] + (v1[i] - v0[i]) * u;
+					break;
+				}
+
+				batch.q0[batch.count] = v0;
+				batch.q1[batch.count] = v1;
+				batch.dst[batch.count] = dst;
+				batch.u[batch.count] = u;
+				if (++batch.count == ANIMATION_ROTATION_BATCH_SIZE) {
+					animation_kernels.rotation_interpolate(&batch, 0);
+					batch.count = 0;
+				}
+				break;
+			case KMR_GLTF_LOADER_ANIMATION_INTERPOLATION_CUBICSPLINE:
+				u2 = u * u; u3 = u2 * u;
+				h00 = 2.0f * u3 - 3.0f * u2 + 1.0f;
+				h10 = (u3 - 2.0f * u2 + u) * dt;
+				h01 = -2.0f * u3 + 3.0f * u2;
+				h11 = (u3 - u2) * dt;
+
+				/* value(k), out-tangent(k), value(k+1), in-tangent(k+1) */
+				for (i = 0; i < components; i++)
+					dst[i] = h00 * v0[i] + h10 * (v0 + components)[i] + h01 * v1[i] + h11 * (v1 - components)[i];
+
+				if (channel->path == KMR_GLTF_LOADER_ANIMATION_PATH_ROTATION) {
+					len = sqrtf(dst[0] * dst[0] + dst[1] * dst[1] + dst[2] * dst[2] + dst[3] * dst[3]);
+					len = (len > 0.0f) ? 1.0f / len : 0.0f;
+					for (i = 0; i < components; i++)
+						dst[i] *= len;
+				}
+				break;
+		}
+	}
+
+	animation_kernels.rotation_interpolate(&batch, 0);
+	return 0;
+}
+
+
+void
+kmr_gltf_loader_animation_destroy (struct kmr_gltf_loader_animation *animation)
+{
+	if (!animation)
+		return;
+
+	free(animation->animationData);
+	free(animation->channels);
+	free(animation->times);
+	free(animation->values);
+	free(animation);
+}
+
+/**********************************************************************
+ * END OF kmr_gltf_loader_animation_{create,sample,destroy} FUNCTIONS *
+ **********************************************************************/
@@ -0,0 +1,204 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+
+#include "gltf-async.h"
+
+
+/******************************************************************
+ * START OF kmr_gltf_loader_async_{create,poll,destroy} FUNCTIONS *
+ ******************************************************************/
+
+/*
+ * Application visible struct comes first so the pointer handed
+ * out can be cast back. @pendingStages and @cancel are shared
+ * between the loader thread and the application thread.
+ */
+struct async_storage {
+	struct kmr_gltf_loader_async             async;
+	struct kmr_gltf_loader_async_create_info asyncInfo;
+	pthread_t                                thread;
+	uint64_t                                 startTime;
+	uint32_t                                 pendingStages;
+	int                                      cancel;
+	char                                     fileName[];
+};
+
+
+static void
+async_stage_complete (struct async_storage *storage,
+                      enum kmr_gltf_loader_async_stage stage,
+                      uint64_t *stageTime)
+{
+	uint64_t eventCount = 1;
+
+	if (stageTime)
+		*stageTime = kmr_utils_nanosecond() - storage->startTime;
+
+	if (storage->asyncInfo.callback)
+		storage->asyncInfo.callback(&storage->async, stage, storage->asyncInfo.userData);
+
+	/* Release so members written above are visible once the application sees the stage bit */
+	__atomic_fetch_or(&storage->pendingStages, stage, __ATOMIC_RELEASE);
+
+	if (write(storage->async.eventFd, &eventCount, sizeof(eventCount)) == -1)
+		kmr_utils_log(KMR_WARNING, "[!] write(eventFd): %s", strerror(errno));
+}
+
+
+static void *
+async_load_thread (void *data)
+{
+	struct async_storage *storage = data;
+	struct kmr_gltf_loader_async *async = &storage->async;
+	struct kmr_gltf_loader_async_create_info *asyncInfo = &storage->asyncInfo;
+
+	struct kmr_gltf_loader_file_create_info gltfFileInfo;
+	struct kmr_gltf_loader_mesh_create_info meshInfo;
+	struct kmr_gltf_loader_scene_graph_create_info sceneGraphInfo;
+	struct kmr_gltf_loader_material_create_info materialInfo;
+	struct kmr_gltf_loader_texture_image_create_info textureImageInfo;
+
+	gltfFileInfo.fileName = storage->fileName;
+	gltfFileInfo.flags = asyncInfo->fileFlags;
+	async->gltfFile = kmr_gltf_loader_file_create(&gltfFileInfo);
+	if (!async->gltfFile)
+		goto exit_error_async_load_thread;
+
+	meshInfo.gltfFile = async->gltfFile;
+	meshInfo.bufferIndex = asyncInfo->bufferIndex;
+	meshInfo.threadCount = asyncInfo->threadCount;
+	meshInfo.flags = asyncInfo->meshFlags;
+	meshInfo.vertexLayout = asyncInfo->vertexLayout;
+	meshInfo.arena = NULL;
+	meshInfo.arenaSize = 0;
+	async->mesh = kmr_gltf_loader_mesh_create(&meshInfo);
+	if (!async->mesh)
+		goto exit_error_async_load_thread;
+
+	sceneGraphInfo.gltfFile = async->gltfFile;
+	sceneGraphInfo.sceneIndex = asyncInfo->sceneIndex;
+	async->sceneGraph = kmr_gltf_loader_scene_graph_create(&sceneGraphInfo);
+	if (!async->sceneGraph)
+		goto exit_error_async_load_thread;
+
+	async_stage_complete(storage, KMR_GLTF_LOADER_ASYNC_STAGE_GEOMETRY, &async->geometryTime);
+
+	if (asyncInfo->stages & KMR_GLTF_LOADER_ASYNC_STAGE_MATERIAL) {
+		if (__atomic_load_n(&storage->cancel, __ATOMIC_RELAXED))
+			return NULL;
+
+		materialInfo.gltfFile = async->gltfFile;
+		async->material = kmr_gltf_loader_material_create(&materialInfo);
+		if (!async->material)
+			goto exit_error_async_load_thread;
+
+		async_stage_complete(storage, KMR_GLTF_LOADER_ASYNC_STAGE_MATERIAL, &async->materialTime);
+	}
+
+	/* Decoding images takes the longest, so goes last */
+	if (asyncInfo->stages & KMR_GLTF_LOADER_ASYNC_STAGE_TEXTURE_IMAGE) {
+		if (__atomic_load_n(&storage->cancel, __ATOMIC_RELAXED))
+			return NULL;
+
+		textureImageInfo.gltfFile = async->gltfFile;
+		textureImageInfo.directory = storage->fileName;
+		textureImageInfo.threadCount = asyncInfo->threadCount;
+		textureImageInfo.mipFilter = asyncInfo->mipFilter;
+		async->textureImage = kmr_gltf_loader_texture_image_create(&textureImageInfo);
+		if (!async->textureImage)
+			goto exit_error_async_load_thread;
+
+		async_stage_complete(storage, KMR_GLTF_LOADER_ASYNC_STAGE_TEXTURE_IMAGE, &async->textureImageTime);
+	}
+
+	return NULL;
+
+exit_error_async_load_thread:
+	async_stage_complete(storage, KMR_GLTF_LOADER_ASYNC_STAGE_FAILED, NULL);
+	return NULL;
+}
+
+
+struct kmr_gltf_loader_async *
+kmr_gltf_loader_async_create (struct kmr_gltf_loader_async_create_info *asyncInfo)
+{
+	size_t fileNameSize;
+	struct async_storage *storage = NULL;
+
+	fileNameSize = strlen(asyncInfo->fileName) + 1;
+
+	storage = calloc(1, sizeof(struct async_storage) + fileNameSize);
+	if (!storage) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc: %s", strerror(errno));
+		return NULL;
+	}
+
+	memcpy(storage->fileName, asyncInfo->fileName, fileNameSize);
+	storage->asyncInfo = *asyncInfo;
+	storage->asyncInfo.fileName = storage->fileName;
+	storage->startTime = kmr_utils_nanosecond();
+
+	storage->async.eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (storage->async.eventFd == -1) {
+		kmr_utils_log(KMR_DANGER, "[x] eventfd: %s", strerror(errno));
+		goto exit_error_kmr_gltf_loader_async_create;
+	}
+
+	errno = pthread_create(&storage->thread, NULL, async_load_thread, storage);
+	if (errno) {
+		kmr_utils_log(KMR_DANGER, "[x] pthread_create: %s", strerror(errno));
+		goto exit_error_kmr_gltf_loader_async_create_close;
+	}
+
+	return &storage->async;
+
+exit_error_kmr_gltf_loader_async_create_close:
+	close(storage->async.eventFd);
+exit_error_kmr_gltf_loader_async_create:
+	free(storage);
+	return NULL;
+}
+
+
+uint32_t
+kmr_gltf_loader_async_poll (struct kmr_gltf_loader_async *async)
+{
+	uint64_t eventCount;
+	struct async_storage *storage = (struct async_storage *) async;
+
+	/* Only resets the counter, EAGAIN just means nothing new was signaled */
+	if (read(async->eventFd, &eventCount, sizeof(eventCount)) == -1 && errno != EAGAIN)
+		kmr_utils_log(KMR_WARNING, "[!] read(eventFd): %s", strerror(errno));
+
+	return __atomic_exchange_n(&storage->pendingStages, 0, __ATOMIC_ACQUIRE);
+}
+
+
+void
+kmr_gltf_loader_async_destroy (struct kmr_gltf_loader_async *async)
+{
+	struct async_storage *storage = (struct async_storage *) async;
+
+	if (!async)
+		return;
+
+	/* A stage already running can't be interrupted, the join waits for it */
+	__atomic_store_n(&storage->cancel, 1, __ATOMIC_RELAXED);
+	pthread_join(storage->thread, NULL);
+
+	close(async->eventFd);
+	kmr_gltf_loader_texture_image_destroy(async->textureImage);
+	kmr_gltf_loader_material_destroy(async->material);
+	kmr_gltf_loader_scene_graph_destroy(async->sceneGraph);
+	kmr_gltf_loader_mesh_destroy(async->mesh);
+	kmr_gltf_loader_file_destroy(async->gltfFile);
+	free(storage);
+}
+
+/****************************************************************
+ * END OF kmr_gltf_loader_async_{create,poll,destroy} FUNCTIONS *
+ ****************************************************************/
@@ -0,0 +1,557 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <float.h>
+#include <math.h>
+
+#include "gltf-bvh.h"
+#include "gltf-loader-private.h"
+
+
+/***************************************************************************
+ * START OF kmr_gltf_loader_bvh_{create,refit,cull,pick,destroy} FUNCTIONS *
+ ***************************************************************************/
+
+#define BVH_BIN_COUNT 16
+#define BVH_LEAF_SIZE 4
+#define BVH_STACK_SIZE 64
+/* Past this depth nodes are split at the median, keeps depth below BVH_STACK_SIZE for 2^32 items */
+#define BVH_MEDIAN_DEPTH 24
+
+
+/* Binary search for the skin instance of scene graph node @n. Instances are stored in scene graph order. */
+static uint32_t
+bvh_skin_instance_find (struct kmr_gltf_loader_skin *skin, uint32_t n)
+{
+	uint32_t low = 0, high = skin->instanceCount, middle;
+
+	while (low < high) {
+		middle = low + ((high - low) / 2);
+		if (skin->instances[middle].node < n)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	return (low < skin->instanceCount && skin->instances[low].node == n) ? low : UINT32_MAX;
+}
+
+
+/*
+ * Computes the world space box of scene graph node @n. Returns -1 if
+ * @n isn't a mesh or skinned node with vertices, 0 otherwise.
+ */
+static int
+bvh_item_bounds_get (struct kmr_gltf_loader_bvh_create_info *bvhInfo, uint32_t n, float *aabbMin, float *aabbMax)
+{
+	uint32_t a, k, instance;
+	float center[3], extent[3], worldCenter, worldExtent, radius;
+	const float *world = NULL;
+
+	struct kmr_gltf_loader_mesh_data *meshData = NULL;
+	struct kmr_gltf_loader_scene_graph *sceneGraph = bvhInfo->sceneGraph;
+	struct kmr_gltf_loader_skin *skin = bvhInfo->skin;
+
+	/* Without joint matrices skinned nodes fall back to their bind pose under the node */
+	if (sceneGraph->objectType[n] == KMR_GLTF_LOADER_GLTF_MESH ||
+	    (sceneGraph->objectType[n] == KMR_GLTF_LOADER_GLTF_SKIN && !skin))
+	{
+		if (sceneGraph->meshIndex[n] >= bvhInfo->mesh->meshDataCount)
+			return -1;
+
+		meshData = &bvhInfo->mesh->meshData[sceneGraph->meshIndex[n]];
+		if (!meshData->vertexBufferDataCount)
+			return -1;
+
+		world = (const float *) sceneGraph->worldMatrix[n];
+		for (a = 0; a < 3; a++) {
+			center[a] = (meshData->aabbMin[a] + meshData->aabbMax[a]) * 0.5f;
+			extent[a] = (meshData->aabbMax[a] - meshData->aabbMin[a]) * 0.5f;
+		}
+
+		/* Box center moves with the matrix, extents grow by the absolute value of its rotation/scale */
+		for (a = 0; a < 3; a++) {
+			worldCenter = world[12+a];
+			worldExtent = 0.0f;
+			for (k = 0; k < 3; k++) {
+				worldCenter += world[k*4+a] * center[k];
+				worldExtent += fabsf(world[k*4+a]) * extent[k];
+			}
+
+			aabbMin[a] = worldCenter - worldExtent;
+			aabbMax[a] = worldCenter + worldExtent;
+		}
+
+		return 0;
+	}
+
+	if (sceneGraph->objectType[n] != KMR_GLTF_LOADER_GLTF_SKIN)
+		return -1;
+
+	instance = bvh_skin_instance_find(skin, n);
+	if (instance == UINT32_MAX || skin->instances[instance].meshIndex >= bvhInfo->mesh->meshDataCount)
+		return -1;
+
+	meshData = &bvhInfo->mesh->meshData[skin->instances[instance].meshIndex];
+	if (!meshData->vertexBufferDataCount)
+		return -1;
+
+	cull_skinned_sphere_get(skin, skin->instances[instance].skinIndex, meshData, center, &radius);
+	for (a = 0; a < 3; a++) {
+		aabbMin[a] = center[a] - radius;
+		aabbMax[a] = center[a] + radius;
+	}
+
+	return 0;
+}
+
+
+static float
+bvh_box_area (const float *aabbMin, const float *aabbMax)
+{
+	float x = aabbMax[0] - aabbMin[0], y = aabbMax[1] - aabbMin[1], z = aabbMax[2] - aabbMin[2];
+
+	return (x * y) + (y * z) + (z * x);
+}
+
+
+static void
+bvh_box_reset (float *aabbMin, float *aabbMax)
+{
+	uint32_t a;
+
+	for (a = 0; a < 3; a++) {
+		aabbMin[a] = FLT_MAX;
+		aabbMax[a] = -FLT_MAX;
+	}
+}
+
+
+/* Sets the box of @bvhNode from its items if it's a leaf or from its children otherwise */
+static void
+bvh_node_bounds_set (struct kmr_gltf_loader_bvh *bvh, struct kmr_gltf_loader_bvh_node *bvhNode)
+{
+	uint32_t i;
+	struct kmr_gltf_loader_bvh_node *children = NULL;
+
+	bvh_box_reset(bvhNode->aabbMin, bvhNode->aabbMax);
+
+	if (!bvhNode->count) {
+		children = &bvh->bvhNodes[bvhNode->first];
+		glm_vec3_minv(children[0].aabbMin, children[1].aabbMin, bvhNode->aabbMin);
+		glm_vec3_maxv(children[0].aabbMax, children[1].aabbMax, bvhNode->aabbMax);
+		return;
+	}
+
+	for (i = bvhNode->first; i < bvhNode->first + bvhNode->count; i++) {
+		glm_vec3_minv(bvhNode->aabbMin, bvh->itemAabbMin[i], bvhNode->aabbMin);
+		glm_vec3_maxv(bvhNode->aabbMax, bvh->itemAabbMax[i], bvhNode->aabbMax);
+	}
+}
+
+
+static void
+bvh_item_swap (struct kmr_gltf_loader_bvh *bvh, uint32_t i, uint32_t j)
+{
+	uint32_t item;
+	vec3 box;
+
+	item = bvh->items[i]; bvh->items[i] = bvh->items[j]; bvh->items[j] = item;
+	glm_vec3_copy(bvh->itemAabbMin[i], box);
+	glm_vec3_copy(bvh->itemAabbMin[j], bvh->itemAabbMin[i]);
+	glm_vec3_copy(box, bvh->itemAabbMin[j]);
+	glm_vec3_copy(bvh->itemAabbMax[i], box);
+	glm_vec3_copy(bvh->itemAabbMax[j], bvh->itemAabbMax[i]);
+	glm_vec3_copy(box, bvh->itemAabbMax[j]);
+}
+
+
+/*
+ * Binned surface area heuristic: Item centroids are dropped into BVH_BIN_COUNT bins per
+ * axis, the plane between two bins with the lowest (left area * left count) + (right area *
+ * right count) wins. Items are partitioned in place, returns the amount of items to the left.
+ * Falls back to splitting at the median if centroids can't be told apart or @median is set.
+ */
+static uint32_t
+bvh_split (struct kmr_gltf_loader_bvh *bvh, uint32_t first, uint32_t count, bool median)
+{
+	uint32_t i, j, a, b, axis = UINT32_MAX, split = 0, leftCount, rightCount;
+	float centroid, cost, bestCost = FLT_MAX, scale[3], centroidMin[3], centroidMax[3];
+	float rightArea[BVH_BIN_COUNT];
+	vec3 boxMin, boxMax;
+
+	struct {
+		uint32_t count;
+		vec3     aabbMin;
+		vec3     aabbMax;
+	} bins[3][BVH_BIN_COUNT];
+
+	if (median)
+		return count / 2;
+
+	bvh_box_reset(centroidMin, centroidMax);
+	for (i = first; i < first + count; i++) {
+		for (a = 0; a < 3; a++) {
+			centroid = bvh->itemAabbMin[i][a] + bvh->itemAabbMax[i][a];
+			centroidMin[a] = fminf(centroidMin[a], centroid);
+			centroidMax[a] = fmaxf(centroidMax[a], centroid);
+		}
+	}
+
+	for (a = 0; a < 3; a++) {
+		scale[a] = (centroidMax[a] > centroidMin[a]) ? BVH_BIN_COUNT / (centroidMax[a] - centroidMin[a]) : 0.0f;
+		for (b = 0; b < BVH_BIN_COUNT; b++) {
+			bins[a][b].count = 0;
+			bvh_box_reset(bins[a][b].aabbMin, bins[a][b].aabbMax);
+		}
+	}
+
+	for (i = first; i < first + count; i++) {
+		for (a = 0; a < 3; a++) {
+			centroid = bvh->itemAabbMin[i][a] + bvh->itemAabbMax[i][a];
+			b = (uint32_t) ((centroid - centroidMin[a]) * scale[a]);
+			b = (b < BVH_BIN_COUNT) ? b : BVH_BIN_COUNT - 1;
+			bins[a][b].count++;
+			glm_vec3_minv(bins[a][b].aabbMin, bvh->itemAabbMin[i], bins[a][b].aabbMin);
+			glm_vec3_maxv(bins[a][b].aabbMax, bvh->itemAabbMax[i], bins[a][b].aabbMax);
+		}
+	}
+
+	for (a = 0; a < 3; a++) {
+		if (scale[a] == 0.0f)
+			continue;
+
+		/* Sweep right to left storing areas, then left to right evaluating every plane */
+		bvh_box_reset(boxMin, boxMax);
+		for (b = BVH_BIN_COUNT - 1; b > 0; b--) {
+			glm_vec3_minv(boxMin, bins[a][b].aabbMin, boxMin);
+			glm_vec3_maxv(boxMax, bins[a][b].aabbMax, boxMax);
+			rightArea[b] = (boxMin[0] <= boxMax[0]) ? bvh_box_area(boxMin, boxMax) : 0.0f;
+		}
+
+		leftCount = 0;
+		bvh_box_reset(boxMin, boxMax);
+		for (b = 0; b < BVH_BIN_COUNT - 1; b++) {
+			leftCount += bins[a][b].count;
+			rightCount = count - leftCount;
+			glm_vec3_minv(boxMin, bins[a][b].aabbMin, boxMin);
+			glm_vec3_maxv(boxMax, bins[a][b].aabbMax, boxMax);
+			if (!leftCount || !rightCount)
+				continue;
+
+			cost = (bvh_box_area(boxMin, boxMax) * leftCount) + (rightArea[b+1] * rightCount);
+			if (cost < bestCost) {
+				bestCost = cost;
+				axis = a;
+				split = b;
+			}
+		}
+	}
+
+	if (axis == UINT32_MAX)
+		return count / 2;
+
+	i = first;
+	j = first + count;
+	while (i < j) {
+		centroid = bvh->itemAabbMin[i][axis] + bvh->itemAabbMax[i][axis];
+		b = (uint32_t) ((centroid - centroidMin[axis]) * scale[axis]);
+		b = (b < BVH_BIN_COUNT) ? b : BVH_BIN_COUNT - 1;
+		if (b <= split)
+			i++;
+		else
+			bvh_item_swap(bvh, i, --j);
+	}
+
+	return i - first;
+}
+
+
+struct kmr_gltf_loader_bvh *
+kmr_gltf_loader_bvh_create (struct kmr_gltf_loader_bvh_create_info *bvhInfo)
+{
+	uint32_t n, i, leftCount, itemCount = 0, bvhNodeCount;
+	size_t offset = 0, offsets[4];
+	uint8_t *block = NULL, *depth = NULL;
+	vec3 aabbMin, aabbMax;
+
+	struct kmr_gltf_loader_bvh *bvh = NULL;
+	struct kmr_gltf_loader_bvh_node *bvhNode = NULL, *children = NULL;
+	struct kmr_gltf_loader_scene_graph *sceneGraph = bvhInfo->sceneGraph;
+
+	bvh = calloc(1, sizeof(struct kmr_gltf_loader_bvh));
+	if (!bvh) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(bvh): %s", strerror(errno));
+		return NULL;
+	}
+
+	for (n = 0; n < sceneGraph->nodeCount; n++)
+		itemCount += (bvh_item_bounds_get(bvhInfo, n, aabbMin, aabbMax) == 0);
+
+	if (!itemCount)
+		return bvh;
+
+	/* A binary tree with single item leaves at most has 2n - 1 nodes */
+	bvhNodeCount = (2 * itemCount) - 1;
+	offsets[0] = offset; offset += bvhNodeCount * sizeof(struct kmr_gltf_loader_bvh_node);
+	offsets[1] = offset; offset += itemCount * sizeof(vec3); /* itemAabbMin */
+	offsets[2] = offset; offset += itemCount * sizeof(vec3); /* itemAabbMax */
+	offsets[3] = offset; offset += itemCount * sizeof(uint32_t); /* items */
+
+	block = calloc(1, offset);
+	if (!block) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(bvh->bvhNodes): %s", strerror(errno));
+		goto exit_error_kmr_gltf_loader_bvh_create;
+	}
+
+	depth = calloc(bvhNodeCount, sizeof(uint8_t));
+	if (!depth) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(depth): %s", strerror(errno));
+		goto exit_error_kmr_gltf_loader_bvh_create;
+	}
+
+	bvh->bvhNodes = (struct kmr_gltf_loader_bvh_node *) (block + offsets[0]);
+	bvh->itemAabbMin = (vec3 *) (block + offsets[1]);
+	bvh->itemAabbMax = (vec3 *) (block + offsets[2]);
+	bvh->items = (uint32_t *) (block + offsets[3]);
+
+	for (n = 0; n < sceneGraph->nodeCount; n++) {
+		if (bvh_item_bounds_get(bvhInfo, n, bvh->itemAabbMin[bvh->itemCount], bvh->itemAabbMax[bvh->itemCount]) == -1)
+			continue;
+
+		bvh->items[bvh->itemCount++] = n;
+	}
+
+	/*
+	 * Children are appended after every node already in the array, so walking
+	 * the array in order visits each node after its parent was split.
+	 */
+	bvh->bvhNodes[0].first = 0;
+	bvh->bvhNodes[0].count = bvh->itemCount;
+	bvh->bvhNodeCount = 1;
+
+	for (i = 0; i < bvh->bvhNodeCount; i++) {
+		bvhNode = &bvh->bvhNodes[i];
+		if (bvhNode->count <= BVH_LEAF_SIZE)
+			continue;
+
+		leftCount = bvh_split(bvh, bvhNode->first, bvhNode->count, depth[i] >= BVH_MEDIAN_DEPTH);
+
+		children = &bvh->bvhNodes[bvh->bvhNodeCount];
+		children[0].first = bvhNode->first;
+		children[0].count = leftCount;
+		children[1].first = bvhNode->first + leftCount;
+		children[1].count = bvhNode->count - leftCount;
+		depth[bvh->bvhNodeCount] = depth[bvh->bvhNodeCount + 1] = depth[i] + 1;
+
+		bvhNode->first = bvh->bvhNodeCount;
+		bvhNode->count = 0;
+		bvh->bvhNodeCount += 2;
+	}
+
+	/* Children come after parents, boxes are filled in bottom up */
+	for (i = bvh->bvhNodeCount; i > 0; i--)
+		bvh_node_bounds_set(bvh, &bvh->bvhNodes[i-1]);
+
+	free(depth);
+
+	return bvh;
+
+exit_error_kmr_gltf_loader_bvh_create:
+	free(depth);
+	free(block);
+	free(bvh);
+	return NULL;
+}
+
+
+void
+kmr_gltf_loader_bvh_refit (struct kmr_gltf_loader_bvh *bvh, struct kmr_gltf_loader_bvh_create_info *bvhInfo)
+{
+	uint32_t i;
+
+	for (i = 0; i < bvh->itemCount; i++)
+		bvh_item_bounds_get(bvhInfo, bvh->items[i], bvh->itemAabbMin[i], bvh->itemAabbMax[i]);
+
+	for (i = bvh->bvhNodeCount; i > 0; i--)
+		bvh_node_bounds_set(bvh, &bvh->bvhNodes[i-1]);
+}
+
+
+/*
+ * Tests a box against the planes set in @mask. Returns false if it's entirely behind any
+ * of them. Planes the box is entirely in front of are cleared from @mask.
+ */
+static bool
+bvh_box_planes_test (const float *aabbMin, const float *aabbMax, const vec4 *planes, uint32_t *mask)
+{
+	uint32_t p, a;
+	float nearest, farthest;
+
+	for (p = 0; p < 6; p++) {
+		if (!(*mask & (1u << p)))
+			continue;
+
+		nearest = farthest = planes[p][3];
+		for (a = 0; a < 3; a++) {
+			nearest += planes[p][a] * ((planes[p][a] > 0.0f) ? aabbMin[a] : aabbMax[a]);
+			farthest += planes[p][a] * ((planes[p][a] > 0.0f) ? aabbMax[a] : aabbMin[a]);
+		}
+
+		if (farthest < 0.0f)
+			return false;
+
+		if (nearest >= 0.0f)
+			*mask &= ~(1u << p);
+	}
+
+	return true;
+}
+
+
+uint32_t
+kmr_gltf_loader_bvh_cull (struct kmr_gltf_loader_bvh_cull_info *cullInfo)
+{
+	uint32_t i, top = 0, mask, itemMask, drawCount = 0;
+	uint32_t stack[BVH_STACK_SIZE], stackMask[BVH_STACK_SIZE];
+	vec4 planes[6];
+
+	struct kmr_gltf_loader_bvh *bvh = cullInfo->bvh;
+	struct kmr_gltf_loader_bvh_node *bvhNode = NULL;
+
+	if (!bvh->bvhNodeCount)
+		return 0;
+
+	cull_planes_extract((const float *) cullInfo->viewProjection, planes);
+
+	stack[top] = 0;
+	stackMask[top++] = (1u << 6) - 1;
+
+	while (top) {
+		top--;
+		bvhNode = &bvh->bvhNodes[stack[top]];
+		mask = stackMask[top];
+		if (mask && !bvh_box_planes_test(bvhNode->aabbMin, bvhNode->aabbMax, (const vec4 *) planes, &mask))
+			continue;
+
+		if (bvhNode->count) {
+			for (i = bvhNode->first; i < bvhNode->first + bvhNode->count; i++) {
+				itemMask = mask;
+				if (itemMask && !bvh_box_planes_test(bvh->itemAabbMin[i], bvh->itemAabbMax[i], (const vec4 *) planes, &itemMask))
+					continue;
+
+				cullInfo->drawList[drawCount++] = bvh->items[i];
+			}
+
+			continue;
+		}
+
+		/* Right child first so the left one is popped first and items come out in order */
+		stack[top] = bvhNode->first + 1;
+		stackMask[top++] = mask;
+		stack[top] = bvhNode->first;
+		stackMask[top++] = mask;
+	}
+
+	return drawCount;
+}
+
+
+/* Slab test. Returns the distance at which the ray enters the box, -1 if it misses. */
+static float
+bvh_box_ray_enter (const float *aabbMin, const float *aabbMax, const float *origin,
+                   const float *inverseDirection, float maxDistance)
+{
+	uint32_t a;
+	float near, far, enter = 0.0f, exit = maxDistance;
+
+	for (a = 0; a < 3; a++) {
+		near = (aabbMin[a] - origin[a]) * inverseDirection[a];
+		far = (aabbMax[a] - origin[a]) * inverseDirection[a];
+		enter = fmaxf(enter, fminf(near, far));
+		exit = fminf(exit, fmaxf(near, far));
+	}
+
+	return (enter <= exit) ? enter : -1.0f;
+}
+
+
+uint32_t
+kmr_gltf_loader_bvh_pick (struct kmr_gltf_loader_bvh_pick_info *pickInfo)
+{
+	uint32_t a, i, nearest, top = 0, hit = UINT32_MAX;
+	uint32_t stack[BVH_STACK_SIZE];
+	float distance, closest, enter[2], stackEnter[BVH_STACK_SIZE];
+	vec3 inverseDirection;
+
+	struct kmr_gltf_loader_bvh *bvh = pickInfo->bvh;
+	struct kmr_gltf_loader_bvh_node *bvhNode = NULL, *children = NULL;
+
+	if (!bvh->bvhNodeCount)
+		return UINT32_MAX;
+
+	/* Division by zero yields infinity, the slab test handles it */
+	for (a = 0; a < 3; a++)
+		inverseDirection[a] = 1.0f / pickInfo->direction[a];
+
+	closest = pickInfo->maxDistance;
+	stackEnter[top] = bvh_box_ray_enter(bvh->bvhNodes[0].aabbMin, bvh->bvhNodes[0].aabbMax, pickInfo->origin, inverseDirection, closest);
+	stack[top] = 0;
+	top += (stackEnter[top] >= 0.0f);
+
+	while (top) {
+		top--;
+		if (stackEnter[top] > closest)
+			continue;
+
+		bvhNode = &bvh->bvhNodes[stack[top]];
+		if (bvhNode->count) {
+			for (i = bvhNode->first; i < bvhNode->first + bvhNode->count; i++) {
+				distance = bvh_box_ray_enter(bvh->itemAabbMin[i], bvh->itemAabbMax[i], pickInfo->origin, inverseDirection, closest);
+				if (distance >= 0.0f && (hit == UINT32_MAX || distance < closest)) {
+					closest = distance;
+					hit = bvh->items[i];
+				}
+			}
+
+			continue;
+		}
+
+		/* Push the farther child first so the nearer one is visited first */
+		children = &bvh->bvhNodes[bvhNode->first];
+		enter[0] = bvh_box_ray_enter(children[0].aabbMin, children[0].aabbMax, pickInfo->origin, inverseDirection, closest);
+		enter[1] = bvh_box_ray_enter(children[1].aabbMin, children[1].aabbMax, pickInfo->origin, inverseDirection, closest);
+		nearest = (enter[1] >= 0.0f && (enter[0] < 0.0f || enter[1] < enter[0]));
+
+		if (enter[!nearest] >= 0.0f) {
+			stackEnter[top] = enter[!nearest];
+			stack[top++] = bvhNode->first + !nearest;
+		}
+
+		if (enter[nearest] >= 0.0f) {
+			stackEnter[top] = enter[nearest];
+			stack[top++] = bvhNode->first + nearest;
+		}
+	}
+
+	if (hit != UINT32_MAX && pickInfo->distance)
+		*pickInfo->distance = closest;
+
+	return hit;
+}
+
+
+void
+kmr_gltf_loader_bvh_destroy (struct kmr_gltf_loader_bvh *bvh)
+{
+	if (!bvh)
+		return;
+
+	/* Start of the single allocation backing every array */
+	free(bvh->bvhNodes);
+	free(bvh);
+}
+
+/*************************************************************************
+ * END OF kmr_gltf_loader_bvh_{create,refit,cull,pick,destroy} FUNCTIONS *
+ *************************************************************************/
@@ -0,0 +1,687 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+#include "gltf-cache.h"
+#include "gltf-loader-private.h"
+
+
+/*******************************************************************
+ * START OF kmr_gltf_loader_cache_{write,create,destroy} FUNCTIONS *
+ *******************************************************************/
+
+#define CACHE_MAGIC "KMRCACHE"
+#define CACHE_VERSION 4
+#define CACHE_BYTE_ORDER 0x01020304
+#define CACHE_SECTION_ALIGNMENT 64
+#define CACHE_PATH_MAX_LEN (1<<8)
+
+
+enum cache_section_type {
+	CACHE_SECTION_DEPENDENCIES    = 0,
+	CACHE_SECTION_STRINGS         = 1,
+	CACHE_SECTION_MESH_DATA       = 2,
+	CACHE_SECTION_MESH_PRIMITIVES = 3,
+	CACHE_SECTION_MESH_ARENA      = 4,
+	CACHE_SECTION_MATERIAL_DATA   = 5,
+	CACHE_SECTION_NODE_DATA       = 6,
+	CACHE_SECTION_IMAGE_DATA      = 7,
+	CACHE_SECTION_IMAGE_PIXELS    = 8,
+	CACHE_SECTION_COUNT           = 9,
+};
+
+
+enum cache_record_type {
+	CACHE_RECORD_MESH_DATA      = 0,
+	CACHE_RECORD_MESH_PRIMITIVE = 1,
+	CACHE_RECORD_MATERIAL_DATA  = 2,
+	CACHE_RECORD_NODE_DATA      = 3,
+	CACHE_RECORD_IMAGE_DATA     = 4,
+	CACHE_RECORD_COUNT          = 5,
+};
+
+
+/*
+ * Records are the public structs themselves with pointers replaced by offsets, so
+ * the cache is only valid for the ABI it was written with. Record sizes are stored
+ * to catch caches written by a differently built library.
+ */
+static const uint32_t cache_record_sizes[CACHE_RECORD_COUNT] = {
+	[CACHE_RECORD_MESH_DATA] = sizeof(struct kmr_gltf_loader_mesh_data),
+	[CACHE_RECORD_MESH_PRIMITIVE] = sizeof(struct kmr_gltf_loader_mesh_primitive),
+	[CACHE_RECORD_MATERIAL_DATA] = sizeof(struct kmr_gltf_loader_material_data),
+	[CACHE_RECORD_NODE_DATA] = sizeof(struct kmr_gltf_loader_node_data),
+	[CACHE_RECORD_IMAGE_DATA] = sizeof(struct kmr_utils_image_buffer),
+};
+
+
+/* @present is set if the object a section belongs to was stored, even if @count is 0 */
+struct cache_section {
+	uint64_t offset;
+	uint64_t size;
+	uint32_t count;
+	uint32_t present;
+};
+
+
+struct cache_header {
+	char                 magic[8];
+	uint32_t             version;
+	uint32_t             byteOrder;
+	uint64_t             sourceHash;
+	uint64_t             fileSize;
+	uint32_t             recordSizes[CACHE_RECORD_COUNT];
+	uint32_t             vertexLayout;
+	uint32_t             bufferIndex;
+	uint32_t             meshOptimized;
+	uint32_t             textureTotalBufferSize;
+	struct cache_section sections[CACHE_SECTION_COUNT];
+};
+
+
+struct cache_strings {
+	char     *data;
+	uint64_t size;
+	uint32_t count;
+};
+
+
+/* Cache returned to the caller with storage for the objects it points to */
+struct cache_storage {
+	struct kmr_gltf_loader_cache         cache;
+	struct kmr_gltf_loader_mesh          mesh;
+	struct kmr_gltf_loader_material      material;
+	struct kmr_gltf_loader_node          node;
+	struct kmr_gltf_loader_texture_image textureImage;
+};
+
+
+/* FNV-1a 64-bit over 64-bit words, remaining tail bytes are hashed one at a time */
+static uint64_t
+cache_hash (uint64_t hash, const uint8_t *bytes, uint64_t size)
+{
+	uint64_t i, word;
+
+	for (i = 0; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+		memcpy(&word, bytes + i, sizeof(uint64_t));
+		hash = (hash ^ word) * 1099511628211ull;
+	}
+
+	for (; i < size; i++)
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+
+	return hash;
+}
+
+
+static int
+cache_file_hash (const char *fileName, uint64_t *hash)
+{
+	struct kmr_utils_file file;
+
+	file = kmr_utils_file_map(fileName, true);
+	if (!file.bytes)
+		return -1;
+
+	*hash = cache_hash(*hash, (const uint8_t *) &file.byteSize, sizeof(file.byteSize));
+	*hash = cache_hash(*hash, file.bytes, file.byteSize);
+	kmr_utils_file_unmap(&file);
+
+	return 0;
+}
+
+
+/*
+ * Hashes the source file followed by every dependency. Dependencies are
+ * NUL-terminated paths relative to the directory of the source file.
+ */
+static int
+cache_source_hash (const char *sourceFileName, const char *dependencies, uint32_t dependencyCount, uint64_t *hash)
+{
+	uint32_t d;
+	int ret = 0;
+	char *fileName = NULL;
+
+	*hash = 14695981039346656037ull;
+	if (cache_file_hash(sourceFileName, hash) == -1)
+		return -1;
+
+	for (d = 0; d < dependencyCount; d++, dependencies += strlen(dependencies) + 1) {
+		fileName = kmr_utils_concat_file_to_dir(sourceFileName, dependencies, CACHE_PATH_MAX_LEN);
+		if (!fileName)
+			return -1;
+
+		ret = cache_file_hash(fileName, hash);
+		free(fileName);
+		if (ret == -1)
+			return -1;
+	}
+
+	return 0;
+}
+
+
+static int64_t
+cache_strings_append (struct cache_strings *strings, const char *string)
+{
+	uint64_t offset = strings->size, length = strlen(string) + 1;
+	char *data = NULL;
+
+	data = realloc(strings->data, strings->size + length);
+	if (!data) {
+		kmr_utils_log(KMR_DANGER, "[x] realloc(strings): %s", strerror(errno));
+		return -1;
+	}
+
+	memcpy(data + offset, string, length);
+	strings->data = data;
+	strings->size += length;
+	strings->count++;
+
+	return offset;
+}
+
+
+/* External buffer and image files, embedded (data:) URIs are covered by the source file hash */
+static int
+cache_dependencies_get (cgltf_data *gltfData, struct cache_strings *dependencies)
+{
+	cgltf_size i;
+	int64_t offset;
+
+	for (i = 0; i < gltfData->buffers_count; i++) {
+		if (!gltfData->buffers[i].uri || !strncmp(gltfData->buffers[i].uri, "data:", 5))
+			continue;
+
+		/* cgltf loads buffers by their percent-decoded URI */
+		offset = cache_strings_append(dependencies, gltfData->buffers[i].uri);
+		if (offset == -1)
+			return -1;
+
+		cgltf_decode_uri(dependencies->data + offset);
+		dependencies->size = offset + strlen(dependencies->data + offset) + 1;
+	}
+
+	for (i = 0; i < gltfData->images_count; i++) {
+		if (!gltfData->images[i].uri || !strncmp(gltfData->images[i].uri, "data:", 5))
+			continue;
+
+		if (cache_strings_append(dependencies, gltfData->images[i].uri) == -1)
+			return -1;
+	}
+
+	return 0;
+}
+
+
+static void
+cache_section_set (struct cache_header *header, enum cache_section_type type, uint64_t *offset, uint64_t size, uint32_t count)
+{
+	*offset = (*offset + (CACHE_SECTION_ALIGNMENT - 1)) & ~((uint64_t) CACHE_SECTION_ALIGNMENT - 1);
+	header->sections[type].offset = *offset;
+	header->sections[type].size = size;
+	header->sections[type].count = count;
+	header->sections[type].present = 1;
+	*offset += size;
+}
+
+
+/* Writes @size bytes at @offset zero padding the gap since the last write */
+static int
+cache_fwrite (FILE *stream, uint64_t *position, uint64_t offset, const void *data, uint64_t size)
+{
+	static const uint8_t zeros[CACHE_SECTION_ALIGNMENT];
+
+	for (; *position < offset; (*position)++)
+		if (fwrite(zeros, 1, 1, stream) != 1)
+			goto exit_error_cache_fwrite;
+
+	if (size && fwrite(data, size, 1, stream) != 1)
+		goto exit_error_cache_fwrite;
+
+	*position += size;
+	return 0;
+
+exit_error_cache_fwrite:
+	kmr_utils_log(KMR_DANGER, "[x] fwrite: %s", strerror(errno));
+	return -1;
+}
+
+
+int
+kmr_gltf_loader_cache_write (struct kmr_gltf_loader_cache_write_info *cacheWriteInfo)
+{
+	uint32_t i, meshDataCount = 0, materialDataCount = 0, nodeDataCount = 0, imageCount = 0, primitiveCount = 0;
+	uint64_t offset, position = 0;
+	int64_t nameOffset;
+	int ret = -1;
+	FILE *stream = NULL;
+	char *tmpFileName = NULL;
+
+	struct cache_header header;
+	struct cache_strings dependencies;
+	struct kmr_gltf_loader_mesh_data *meshData = NULL;
+	struct kmr_gltf_loader_material_data *materialData = NULL;
+	struct kmr_utils_image_buffer *imageData = NULL;
+
+	struct kmr_gltf_loader_mesh *mesh = cacheWriteInfo->mesh;
+	struct kmr_gltf_loader_material *material = cacheWriteInfo->material;
+	struct kmr_gltf_loader_node *node = cacheWriteInfo->node;
+	struct kmr_gltf_loader_texture_image *textureImage = cacheWriteInfo->textureImage;
+
+	memset(&header, 0, sizeof(header));
+	memset(&dependencies, 0, sizeof(dependencies));
+
+	if (cache_dependencies_get(cacheWriteInfo->gltfFile->gltfData, &dependencies) == -1)
+		goto exit_kmr_gltf_loader_cache_write;
+
+	if (cache_source_hash(cacheWriteInfo->sourceFileName, dependencies.data, dependencies.count, &header.sourceHash) == -1)
+		goto exit_kmr_gltf_loader_cache_write;
+
+	/* Copy out records replacing pointers, with offsets where they can't be recomputed on load */
+	if (mesh) {
+		meshDataCount = mesh->meshDataCount;
+		meshData = calloc(meshDataCount + 1, sizeof(struct kmr_gltf_loader_mesh_data));
+		if (!meshData) {
+			kmr_utils_log(KMR_DANGER, "[x] calloc(meshData): %s", strerror(errno));
+			goto exit_kmr_gltf_loader_cache_write;
+		}
+
+		for (i = 0; i < meshDataCount; i++) {
+			meshData[i] = mesh->meshData[i];
+			memset(&meshData[i].vertexStreams, 0, sizeof(meshData[i].vertexStreams));
+			meshData[i].indexBufferData = NULL;
+			meshData[i].primitives = NULL;
+			primitiveCount += meshData[i].primitiveCount;
+		}
+	}
+
+	if (material) {
+		materialDataCount = material->materialDataCount;
+		materialData = calloc(materialDataCount + 1, sizeof(struct kmr_gltf_loader_material_data));
+		if (!materialData) {
+			kmr_utils_log(KMR_DANGER, "[x] calloc(materialData): %s", strerror(errno));
+			goto exit_kmr_gltf_loader_cache_write;
+		}
+
+		/*
+		 * The string section is the material string pool as is, names store their
+		 * offset in it plus one so interned names stay shared. NULL stays NULL.
+		 */
+		for (i = 0; i < materialDataCount; i++) {
+			materialData[i] = material->materialData[i];
+			if (!materialData[i].materialName)
+				continue;
+
+			nameOffset = materialData[i].materialName - material->stringPool;
+			materialData[i].materialName = (char *) (uintptr_t) (nameOffset + 1);
+		}
+	}
+
+	if (node)
+		nodeDataCount = node->nodeDataCount;
+
+	if (textureImage) {
+		imageCount = textureImage->imageCount;
+		imageData = calloc(imageCount + 1, sizeof(struct kmr_utils_image_buffer));
+		if (!imageData) {
+			kmr_utils_log(KMR_DANGER, "[x] calloc(imageData): %s", strerror(errno));
+			goto exit_kmr_gltf_loader_cache_write;
+		}
+
+		/* Pixels are recomputed from @imageBufferOffset */
+		for (i = 0; i < imageCount; i++) {
+			imageData[i] = textureImage->imageData[i];
+			imageData[i].pixels = NULL;
+		}
+	}
+
+	memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+	header.version = CACHE_VERSION;
+	header.byteOrder = CACHE_BYTE_ORDER;
+	memcpy(header.recordSizes, cache_record_sizes, sizeof(header.recordSizes));
+
+	offset = sizeof(struct cache_header);
+	cache_section_set(&header, CACHE_SECTION_DEPENDENCIES, &offset, dependencies.size, dependencies.count);
+	cache_section_set(&header, CACHE_SECTION_STRINGS, &offset, (material) ? material->stringPoolSize : 0, 0);
+
+	if (mesh) {
+		header.vertexLayout = mesh->vertexLayout;
+		header.bufferIndex = mesh->bufferIndex;
+		header.meshOptimized = mesh->optimized;
+		cache_section_set(&header, CACHE_SECTION_MESH_DATA, &offset, meshDataCount * sizeof(struct kmr_gltf_loader_mesh_data), meshDataCount);
+		cache_section_set(&header, CACHE_SECTION_MESH_PRIMITIVES, &offset, primitiveCount * sizeof(struct kmr_gltf_loader_mesh_primitive), primitiveCount);
+		cache_section_set(&header, CACHE_SECTION_MESH_ARENA, &offset, mesh->arenaSize, 0);
+	}
+
+	if (material)
+		cache_section_set(&header, CACHE_SECTION_MATERIAL_DATA, &offset, materialDataCount * sizeof(struct kmr_gltf_loader_material_data), materialDataCount);
+
+	if (node)
+		cache_section_set(&header, CACHE_SECTION_NODE_DATA, &offset, nodeDataCount * sizeof(struct kmr_gltf_loader_node_data), nodeDataCount);
+
+	if (textureImage) {
+		header.textureTotalBufferSize = textureImage->totalBufferSize;
+		cache_section_set(&header, CACHE_SECTION_IMAGE_DATA, &offset, imageCount * sizeof(struct kmr_utils_image_buffer), imageCount);
+		cache_section_set(&header, CACHE_SECTION_IMAGE_PIXELS, &offset, textureImage->totalBufferSize, 0);
+	}
+
+	header.fileSize = offset;
+
+	/* Write next to the cache then rename(2) so readers never see a partial cache */
+	tmpFileName = calloc(strlen(cacheWriteInfo->cacheFileName) + 5, sizeof(char));
+	if (!tmpFileName) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(tmpFileName): %s", strerror(errno));
+		goto exit_kmr_gltf_loader_cache_write;
+	}
+
+	strcpy(tmpFileName, cacheWriteInfo->cacheFileName);
+	strcat(tmpFileName, ".tmp");
+
+	stream = fopen(tmpFileName, "wb");
+	if (!stream) {
+		kmr_utils_log(KMR_DANGER, "[x] fopen(%s): %s", tmpFileName, strerror(errno));
+		goto exit_kmr_gltf_loader_cache_write;
+	}
+
+	if (cache_fwrite(stream, &position, 0, &header, sizeof(header)) == -1 ||
+	    cache_fwrite(stream, &position, header.sections[CACHE_SECTION_DEPENDENCIES].offset, dependencies.data, dependencies.size) == -1 ||
+	    cache_fwrite(stream, &position, header.sections[CACHE_SECTION_STRINGS].offset, (material) ? material->stringPool : NULL, header.sections[CACHE_SECTION_STRINGS].size) == -1)
+		goto exit_kmr_gltf_loader_cache_write_unlink;
+
+	if (mesh) {
+		if (cache_fwrite(stream, &position, header.sections[CACHE_SECTION_MESH_DATA].offset, meshData,
+		                 header.sections[CACHE_SECTION_MESH_DATA].size) == -1)
+			goto exit_kmr_gltf_loader_cache_write_unlink;
+
+		offset = header.sections[CACHE_SECTION_MESH_PRIMITIVES].offset;
+		for (i = 0; i < meshDataCount; i++) {
+			if (cache_fwrite(stream, &position, offset, mesh->meshData[i].primitives,
+			                 mesh->meshData[i].primitiveCount * sizeof(struct kmr_gltf_loader_mesh_primitive)) == -1)
+				goto exit_kmr_gltf_loader_cache_write_unlink;
+			offset = position;
+		}
+
+		if (cache_fwrite(stream, &position, header.sections[CACHE_SECTION_MESH_ARENA].offset, mesh->arena, mesh->arenaSize) == -1)
+			goto exit_kmr_gltf_loader_cache_write_unlink;
+	}
+
+	if (material && cache_fwrite(stream, &position, header.sections[CACHE_SECTION_MATERIAL_DATA].offset, materialData,
+	                             header.sections[CACHE_SECTION_MATERIAL_DATA].size) == -1)
+		goto exit_kmr_gltf_loader_cache_write_unlink;
+
+	if (node && cache_fwrite(stream, &position, header.sections[CACHE_SECTION_NODE_DATA].offset, node->nodeData,
+	                         header.sections[CACHE_SECTION_NODE_DATA].size) == -1)
+		goto exit_kmr_gltf_loader_cache_write_unlink;
+
+	if (textureImage) {
+		if (cache_fwrite(stream, &position, header.sections[CACHE_SECTION_IMAGE_DATA].offset, imageData,
+		                 header.sections[CACHE_SECTION_IMAGE_DATA].size) == -1)
+			goto exit_kmr_gltf_loader_cache_write_unlink;
+
+		for (i = 0; i < imageCount; i++) {
+			offset = header.sections[CACHE_SECTION_IMAGE_PIXELS].offset + textureImage->imageData[i].imageBufferOffset;
+			if (cache_fwrite(stream, &position, offset, textureImage->imageData[i].pixels, textureImage->imageData[i].imageSize) == -1)
+				goto exit_kmr_gltf_loader_cache_write_unlink;
+		}
+	}
+
+	if (cache_fwrite(stream, &position, header.fileSize, NULL, 0) == -1)
+		goto exit_kmr_gltf_loader_cache_write_unlink;
+
+	if (fflush(stream) == EOF || fsync(fileno(stream)) == -1) {
+		kmr_utils_log(KMR_DANGER, "[x] fsync(%s): %s", tmpFileName, strerror(errno));
+		goto exit_kmr_gltf_loader_cache_write_unlink;
+	}
+
+	fclose(stream); stream = NULL;
+	if (rename(tmpFileName, cacheWriteInfo->cacheFileName) == -1) {
+		kmr_utils_log(KMR_DANGER, "[x] rename(%s): %s", cacheWriteInfo->cacheFileName, strerror(errno));
+		goto exit_kmr_gltf_loader_cache_write_unlink;
+	}
+
+	ret = 0;
+	goto exit_kmr_gltf_loader_cache_write;
+
+exit_kmr_gltf_loader_cache_write_unlink:
+	if (stream)
+		fclose(stream);
+	stream = NULL;
+	unlink(tmpFileName);
+exit_kmr_gltf_loader_cache_write:
+	free(tmpFileName);
+	free(dependencies.data);
+	free(meshData);
+	free(materialData);
+	free(imageData);
+	return ret;
+}
+
+
+static bool
+cache_section_valid (const struct cache_header *header, enum cache_section_type type, uint32_t recordSize)
+{
+	const struct cache_section *section = &header->sections[type];
+
+	if (!section->present)
+		return true;
+
+	if (section->offset > header->fileSize || section->size > header->fileSize - section->offset)
+		return false;
+
+	return !recordSize || (uint64_t) section->count * recordSize == section->size;
+}
+
+
+static bool
+cache_header_valid (const struct cache_header *header, uint64_t fileSize)
+{
+	uint32_t s;
+
+	if (memcmp(header->magic, CACHE_MAGIC, sizeof(header->magic)) || header->version != CACHE_VERSION ||
+	    header->byteOrder != CACHE_BYTE_ORDER || header->fileSize != fileSize ||
+	    memcmp(header->recordSizes, cache_record_sizes, sizeof(header->recordSizes)))
+		return false;
+
+	for (s = 0; s < CACHE_SECTION_COUNT; s++)
+		if (!cache_section_valid(header, s, 0))
+			return false;
+
+	return cache_section_valid(header, CACHE_SECTION_MESH_DATA, cache_record_sizes[CACHE_RECORD_MESH_DATA]) &&
+	       cache_section_valid(header, CACHE_SECTION_MESH_PRIMITIVES, cache_record_sizes[CACHE_RECORD_MESH_PRIMITIVE]) &&
+	       cache_section_valid(header, CACHE_SECTION_MATERIAL_DATA, cache_record_sizes[CACHE_RECORD_MATERIAL_DATA]) &&
+	       cache_section_valid(header, CACHE_SECTION_NODE_DATA, cache_record_sizes[CACHE_RECORD_NODE_DATA]) &&
+	       cache_section_valid(header, CACHE_SECTION_IMAGE_DATA, cache_record_sizes[CACHE_RECORD_IMAGE_DATA]);
+}
+
+
+/* Points mesh arrays into the mapped arena, rejecting offsets outside of it */
+static int
+cache_mesh_fixup (struct kmr_gltf_loader_mesh *mesh, struct kmr_gltf_loader_mesh_primitive *primitives, uint32_t primitiveCount)
+{
+	uint32_t i;
+	uint8_t *arena = mesh->arena;
+	struct kmr_gltf_loader_mesh_data *meshData = NULL;
+
+	for (i = 0; i < mesh->meshDataCount; i++) {
+		meshData = &mesh->meshData[i];
+
+		if (meshData->primitiveCount > primitiveCount ||
+		    (uint64_t) meshData->vertexBufferDataOffset + meshData->vertexBufferDataSize > mesh->arenaSize ||
+		    (uint64_t) meshData->indexBufferDataOffset + meshData->indexBufferDataSize > mesh->arenaSize)
+			return -1;
+
+		meshData->primitives = (meshData->primitiveCount) ? primitives : NULL;
+		primitives += meshData->primitiveCount;
+		primitiveCount -= meshData->primitiveCount;
+
+		meshData->indexBufferData = (meshData->indexBufferDataCount) ? (uint32_t *) (arena + meshData->indexBufferDataOffset) : NULL;
+		if (!meshData->vertexBufferDataCount)
+			continue;
+
+		switch (mesh->vertexLayout) {
+			case KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_PACKED:
+				meshData->vertexBufferDataPacked = (struct kmr_gltf_loader_mesh_vertex_packed *) (arena + meshData->vertexBufferDataOffset);
+				break;
+			case KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_SOA:
+				meshData->vertexStreams = mesh_vertex_streams_carve(arena + meshData->vertexBufferDataOffset, meshData->vertexBufferDataCount);
+				break;
+			default:
+				meshData->vertexBufferData = (struct kmr_gltf_loader_mesh_vertex_data *) (arena + meshData->vertexBufferDataOffset);
+				break;
+		}
+	}
+
+	return 0;
+}
+
+
+struct kmr_gltf_loader_cache *
+kmr_gltf_loader_cache_create (struct kmr_gltf_loader_cache_create_info *cacheInfo)
+{
+	uint32_t i;
+	uint64_t sourceHash;
+	uintptr_t nameOffset;
+	uint8_t *bytes = NULL;
+	const char *dependencies = NULL, *names = NULL;
+
+	struct kmr_utils_file cacheFile;
+	struct cache_header *header = NULL;
+	const struct cache_section *sections = NULL;
+	struct cache_storage *storage = NULL;
+	struct kmr_gltf_loader_material_data *materialData = NULL;
+	struct kmr_utils_image_buffer *imageData = NULL;
+
+	/* Missing cache is expected on first launch */
+	if (access(cacheInfo->cacheFileName, R_OK) == -1) {
+		kmr_utils_log(KMR_INFO, "kmr_gltf_loader_cache_create: No cache at %s", cacheInfo->cacheFileName);
+		return NULL;
+	}
+
+	cacheFile = kmr_utils_file_map(cacheInfo->cacheFileName, true);
+	if (!cacheFile.bytes)
+		return NULL;
+
+	bytes = cacheFile.bytes;
+	header = (struct cache_header *) bytes;
+	sections = header->sections;
+
+	if (cacheFile.byteSize < sizeof(struct cache_header) || !cache_header_valid(header, cacheFile.byteSize) ||
+	    sections[CACHE_SECTION_MESH_ARENA].size > UINT32_MAX)
+	{
+		kmr_utils_log(KMR_WARNING, "[!] kmr_gltf_loader_cache_create: %s is not a compatible cache", cacheInfo->cacheFileName);
+		goto exit_error_kmr_gltf_loader_cache_create;
+	}
+
+	dependencies = (const char *) bytes + sections[CACHE_SECTION_DEPENDENCIES].offset;
+	names = (const char *) bytes + sections[CACHE_SECTION_STRINGS].offset;
+
+	/* Strings must be NUL-terminated within their section */
+	if ((sections[CACHE_SECTION_DEPENDENCIES].size && dependencies[sections[CACHE_SECTION_DEPENDENCIES].size - 1]) ||
+	    (sections[CACHE_SECTION_STRINGS].size && names[sections[CACHE_SECTION_STRINGS].size - 1]))
+	{
+		kmr_utils_log(KMR_WARNING, "[!] kmr_gltf_loader_cache_create: %s has corrupt strings", cacheInfo->cacheFileName);
+		goto exit_error_kmr_gltf_loader_cache_create;
+	}
+
+	if (cacheInfo->sourceFileName) {
+		if (cache_source_hash(cacheInfo->sourceFileName, dependencies, sections[CACHE_SECTION_DEPENDENCIES].count, &sourceHash) == -1)
+			goto exit_error_kmr_gltf_loader_cache_create;
+
+		if (sourceHash != header->sourceHash) {
+			kmr_utils_log(KMR_WARNING, "[!] kmr_gltf_loader_cache_create: %s is stale", cacheInfo->cacheFileName);
+			goto exit_error_kmr_gltf_loader_cache_create;
+		}
+	}
+
+	storage = calloc(1, sizeof(struct cache_storage));
+	if (!storage) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(storage): %s", strerror(errno));
+		goto exit_error_kmr_gltf_loader_cache_create;
+	}
+
+	if (sections[CACHE_SECTION_MESH_DATA].present) {
+		storage->mesh.bufferIndex = header->bufferIndex;
+		storage->mesh.meshData = (struct kmr_gltf_loader_mesh_data *) (bytes + sections[CACHE_SECTION_MESH_DATA].offset);
+		storage->mesh.meshDataCount = sections[CACHE_SECTION_MESH_DATA].count;
+		storage->mesh.vertexLayout = header->vertexLayout;
+		storage->mesh.arena = bytes + sections[CACHE_SECTION_MESH_ARENA].offset;
+		storage->mesh.arenaSize = sections[CACHE_SECTION_MESH_ARENA].size;
+		storage->mesh.arenaExternal = true;
+		storage->mesh.optimized = !!header->meshOptimized;
+
+		if (cache_mesh_fixup(&storage->mesh, (struct kmr_gltf_loader_mesh_primitive *) (bytes + sections[CACHE_SECTION_MESH_PRIMITIVES].offset),
+		                     sections[CACHE_SECTION_MESH_PRIMITIVES].count) == -1)
+			goto exit_error_kmr_gltf_loader_cache_create_corrupt;
+
+		storage->cache.mesh = &storage->mesh;
+	}
+
+	if (sections[CACHE_SECTION_MATERIAL_DATA].present) {
+		materialData = (struct kmr_gltf_loader_material_data *) (bytes + sections[CACHE_SECTION_MATERIAL_DATA].offset);
+		for (i = 0; i < sections[CACHE_SECTION_MATERIAL_DATA].count; i++) {
+			nameOffset = (uintptr_t) materialData[i].materialName;
+			if (nameOffset > sections[CACHE_SECTION_STRINGS].size)
+				goto exit_error_kmr_gltf_loader_cache_create_corrupt;
+
+			materialData[i].materialName = (nameOffset) ? (char *) names + nameOffset - 1 : NULL;
+		}
+
+		storage->material.materialData = materialData;
+		storage->material.materialDataCount = sections[CACHE_SECTION_MATERIAL_DATA].count;
+		storage->material.stringPool = (char *) names;
+		storage->material.stringPoolSize = sections[CACHE_SECTION_STRINGS].size;
+		storage->cache.material = &storage->material;
+	}
+
+	if (sections[CACHE_SECTION_NODE_DATA].present) {
+		storage->node.nodeData = (struct kmr_gltf_loader_node_data *) (bytes + sections[CACHE_SECTION_NODE_DATA].offset);
+		storage->node.nodeDataCount = sections[CACHE_SECTION_NODE_DATA].count;
+		storage->cache.node = &storage->node;
+	}
+
+	if (sections[CACHE_SECTION_IMAGE_DATA].present) {
+		imageData = (struct kmr_utils_image_buffer *) (bytes + sections[CACHE_SECTION_IMAGE_DATA].offset);
+		for (i = 0; i < sections[CACHE_SECTION_IMAGE_DATA].count; i++) {
+			if (imageData[i].imageBufferOffset > sections[CACHE_SECTION_IMAGE_PIXELS].size ||
+			    imageData[i].imageSize > sections[CACHE_SECTION_IMAGE_PIXELS].size - imageData[i].imageBufferOffset)
+				goto exit_error_kmr_gltf_loader_cache_create_corrupt;
+
+			imageData[i].pixels = bytes + sections[CACHE_SECTION_IMAGE_PIXELS].offset + imageData[i].imageBufferOffset;
+		}
+
+		storage->textureImage.imageCount = sections[CACHE_SECTION_IMAGE_DATA].count;
+		storage->textureImage.totalBufferSize = header->textureTotalBufferSize;
+		storage->textureImage.imageData = imageData;
+		storage->cache.textureImage = &storage->textureImage;
+	}
+
+	storage->cache.cacheFile = cacheFile;
+	return &storage->cache;
+
+exit_error_kmr_gltf_loader_cache_create_corrupt:
+	kmr_utils_log(KMR_WARNING, "[!] kmr_gltf_loader_cache_create: %s has out of range offsets", cacheInfo->cacheFileName);
+exit_error_kmr_gltf_loader_cache_create:
+	kmr_utils_file_unmap(&cacheFile);
+	free(storage);
+	return NULL;
+}
+
+
+void
+kmr_gltf_loader_cache_destroy (struct kmr_gltf_loader_cache *cache)
+{
+	if (!cache)
+		return;
+
+	kmr_utils_file_unmap(&cache->cacheFile);
+	free(cache);
+}
+
+/*****************************************************************
+ * END OF kmr_gltf_loader_cache_{write,create,destroy} FUNCTIONS *
+ *****************************************************************/
@@ -0,0 +1,218 @@
+#ifndef KMR_GLTF_LOADER_PRIVATE_H
+#define KMR_GLTF_LOADER_PRIVATE_H
+
+/*
+ * Internal helpers shared by the gltf-*.c source files. Not installed,
+ * nothing declared here is part of the kmsroots API.
+ */
+
+#include <float.h>
+#include <math.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#include "gltf-loader.h"
+#include "gltf-skin.h"
+
+
+/* Mesh helpers */
+
+#define MESH_ARENA_ALIGNMENT sizeof(uint32_t)
+#define MESH_ARENA_ALIGN(size) (((size) + (MESH_ARENA_ALIGNMENT - 1)) & ~((uint64_t) MESH_ARENA_ALIGNMENT - 1))
+
+
+static inline uint32_t
+primitive_vertex_count_get (cgltf_primitive *primitive)
+{
+	cgltf_size k;
+
+	for (k = 0; k < primitive->attributes_count; k++)
+		if (primitive->attributes[k].type == cgltf_attribute_type_position)
+			return primitive->attributes[k].data->count;
+
+	return (primitive->attributes_count) ? primitive->attributes[0].data->count : 0;
+}
+
+
+/* Streams are carved out of @block back to back so the block starts with the position stream */
+static inline struct kmr_gltf_loader_mesh_vertex_streams
+mesh_vertex_streams_carve (uint8_t *block, uint32_t count)
+{
+	struct kmr_gltf_loader_mesh_vertex_streams streams;
+
+	streams.position = (vec3 *) block;
+	streams.normal = (vec3 *) (block + (count * sizeof(vec3)));
+	streams.texCoord = (vec2 *) (block + (count * sizeof(vec3) * 2));
+	streams.color = (vec3 *) (block + (count * ((sizeof(vec3) * 2) + sizeof(vec2))));
+
+	return streams;
+}
+
+
+static inline uint32_t
+mesh_index_get (struct kmr_gltf_loader_mesh_data *meshData, uint32_t i)
+{
+	return (meshData->indexType == VK_INDEX_TYPE_UINT16) ? meshData->indexBufferData16[i] : meshData->indexBufferData[i];
+}
+
+
+/* Per vertex arrays a mesh stores for a given vertex layout */
+struct mesh_vertex_stream {
+	uint8_t  *data;
+	uint32_t stride;
+};
+
+
+static inline uint32_t
+mesh_vertex_streams_get (struct kmr_gltf_loader_mesh_data *meshData,
+                         enum kmr_gltf_loader_mesh_vertex_layout vertexLayout,
+                         struct mesh_vertex_stream *streams)
+{
+	switch (vertexLayout) {
+		case KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_PACKED:
+			streams[0].data = (uint8_t *) meshData->vertexBufferDataPacked;
+			streams[0].stride = sizeof(struct kmr_gltf_loader_mesh_vertex_packed);
+			return 1;
+		case KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_SOA:
+			streams[0].data = (uint8_t *) meshData->vertexStreams.position;
+			streams[0].stride = sizeof(vec3);
+			streams[1].data = (uint8_t *) meshData->vertexStreams.normal;
+			streams[1].stride = sizeof(vec3);
+			streams[2].data = (uint8_t *) meshData->vertexStreams.texCoord;
+			streams[2].stride = sizeof(vec2);
+			streams[3].data = (uint8_t *) meshData->vertexStreams.color;
+			streams[3].stride = sizeof(vec3);
+			return 4;
+		default:
+			streams[0].data = (uint8_t *) meshData->vertexBufferData;
+			streams[0].stride = sizeof(struct kmr_gltf_loader_mesh_vertex_data);
+			return 1;
+	}
+}
+
+
+/* Scene graph helpers */
+
+#define SCENE_GRAPH_NO_PARENT UINT32_MAX
+
+
+/*
+ * Matrix kernels: Compute @dst[n] = @a[@aIndex[n]] * @b[n] for n in [@start, @end),
+ * @b[n] is copied if @aIndex[n] is SCENE_GRAPH_NO_PARENT. World matrices are updated
+ * with @dst = @a = world, @aIndex = parent and @b = local. Nodes are in pre-order so
+ * a parent's world matrix is always final before any of its children are reached.
+ * Matrices are loaded unaligned, cglm's own functions expect aligned memory.
+ */
+struct scene_graph_kernels {
+	void (*matrix_multiply)(mat4 *dst, const mat4 *a, const uint32_t *aIndex, const mat4 *b, uint32_t start, uint32_t end);
+};
+
+
+/*
+ * Fastest matrix kernels the CPU supports, defined in gltf-scene-graph.c. CPU
+ * features are only checked by the first call, later calls return the same kernels.
+ */
+const struct scene_graph_kernels *
+kmr_gltf_loader_scene_graph_kernels_get (void);
+
+
+/* Cull helpers */
+
+/*
+ * Extracts the six frustum planes (left, right, bottom, top, near, far) from
+ * rows of @m. Vulkan clip space has depth in [0, w] so near is simply row 2.
+ * Planes are normalized so plane distances are comparable to sphere radii.
+ */
+static inline void
+cull_planes_extract (const float *m, vec4 *planes)
+{
+	uint32_t p, a;
+	float length, row[4][4];
+
+	for (p = 0; p < 4; p++)
+		for (a = 0; a < 4; a++)
+			row[p][a] = m[a*4+p];
+
+	for (a = 0; a < 4; a++) {
+		planes[0][a] = row[3][a] + row[0][a];
+		planes[1][a] = row[3][a] - row[0][a];
+		planes[2][a] = row[3][a] + row[1][a];
+		planes[3][a] = row[3][a] - row[1][a];
+		planes[4][a] = row[2][a];
+		planes[5][a] = row[3][a] - row[2][a];
+	}
+
+	for (p = 0; p < 6; p++) {
+		length = sqrtf(planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1] + planes[p][2] * planes[p][2]);
+		if (length > 0.0f)
+			for (a = 0; a < 4; a++)
+				planes[p][a] /= length;
+	}
+}
+
+
+/* Moves a bounding sphere by @m, radius grows with the largest axis scale of @m */
+static inline void
+cull_sphere_transform (const float *m, const float *center, float radius, float *dstCenter, float *dstRadius)
+{
+	uint32_t a;
+	float scale = 0.0f;
+
+	for (a = 0; a < 3; a++) {
+		dstCenter[a] = m[0*4+a] * center[0] + m[1*4+a] * center[1] + m[2*4+a] * center[2] + m[3*4+a];
+		scale = fmaxf(scale, m[a*4+0] * m[a*4+0] + m[a*4+1] * m[a*4+1] + m[a*4+2] * m[a*4+2]);
+	}
+
+	*dstRadius = radius * sqrtf(scale);
+}
+
+
+/*
+ * Skinned vertices are weighted averages of the vertex moved by each joint matrix. The
+ * mesh sphere moved by every joint of the skin thus bounds them, enclose all of those.
+ */
+static inline void
+cull_skinned_sphere_get (struct kmr_gltf_loader_skin *skin, uint32_t skinIndex,
+                         struct kmr_gltf_loader_mesh_data *meshData, float *center, float *radius)
+{
+	uint32_t j, a;
+	float jointRadius, d, distance;
+	vec3 jointCenter, aabbMin, aabbMax;
+
+	struct kmr_gltf_loader_skin_data *skinData = &skin->skinData[skinIndex];
+
+	for (a = 0; a < 3; a++) {
+		aabbMin[a] = FLT_MAX;
+		aabbMax[a] = -FLT_MAX;
+	}
+
+	for (j = skinData->firstJoint; j < skinData->firstJoint + skinData->jointCount; j++) {
+		cull_sphere_transform((const float *) skin->palette[j], meshData->sphereCenter,
+		                      meshData->sphereRadius, jointCenter, &jointRadius);
+		glm_vec3_minv(aabbMin, jointCenter, aabbMin);
+		glm_vec3_maxv(aabbMax, jointCenter, aabbMax);
+	}
+
+	for (a = 0; a < 3; a++)
+		center[a] = (aabbMin[a] + aabbMax[a]) * 0.5f;
+
+	*radius = 0.0f;
+	for (j = skinData->firstJoint; j < skinData->firstJoint + skinData->jointCount; j++) {
+		cull_sphere_transform((const float *) skin->palette[j], meshData->sphereCenter,
+		                      meshData->sphereRadius, jointCenter, &jointRadius);
+
+		distance = 0.0f;
+		for (a = 0; a < 3; a++) {
+			d = jointCenter[a] - center[a];
+			distance += d * d;
+		}
+
+		*radius = fmaxf(*radius, sqrtf(distance) + jointRadius);
+	}
+}
+
+
+#endif /* KMR_GLTF_LOADER_PRIVATE_H */
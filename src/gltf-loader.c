@@ -1,251 +1,3247 @@
+#include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <errno.h>
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
 
 #include "gltf-loader.h"
+#include "gltf-scene-graph.h"
+#include "gltf-loader-private.h"
 
 
 /************************************************************
  * START OF kmr_gltf_loader_file_{create,destroy} FUNCTIONS *
  ************************************************************/
 
+/*
+ * Maps @path checking it holds at least the @size (0 when unknown) bytes
+ * the glTF declares. cgltf_validate(3) checks accessors against the declared
+ * byteLength, reading past a shorter mapping raises SIGBUS.
+ */
+static cgltf_result
+file_map_sized (const char *path, cgltf_size *size, struct kmr_utils_file *fileMap)
+{
+	*fileMap = kmr_utils_file_map(path, true);
+	if (!fileMap->bytes)
+		return cgltf_result_file_not_found;
+
+	if (size && *size && fileMap->byteSize < *size) {
+		kmr_utils_log(KMR_DANGER, "[x] %s: %lu bytes, buffer declares %zu", path, fileMap->byteSize, (size_t) *size);
+		kmr_utils_file_unmap(fileMap);
+		return cgltf_result_data_too_short;
+	}
+
+	if (size)
+		*size = fileMap->byteSize;
+
+	return cgltf_result_success;
+}
+
+
+/*
+ * cgltf file read callback. Instead of reading file contents into heap memory
+ * map the file into memory. Keeps track of the mapping size, as it's required
+ * by munmap(2) and cgltf only hands back the data pointer on release.
+ */
+static cgltf_result
+file_map_read (const struct cgltf_memory_options UNUSED *memoryOptions,
+               const struct cgltf_file_options *fileOptions,
+               const char *path,
+               cgltf_size *size,
+               void **data)
+{
+	cgltf_result res;
+	struct kmr_utils_file fileMap;
+	struct kmr_utils_file *fileMaps = NULL;
+	struct kmr_gltf_loader_file *gltfFile = fileOptions->user_data;
+
+	res = file_map_sized(path, size, &fileMap);
+	if (res != cgltf_result_success)
+		return res;
+
+	fileMaps = realloc(gltfFile->fileMaps, (gltfFile->fileMapCount + 1) * sizeof(struct kmr_utils_file));
+	if (!fileMaps) {
+		kmr_utils_log(KMR_DANGER, "[x] realloc(fileMaps): %s", strerror(errno));
+		kmr_utils_file_unmap(&fileMap);
+		return cgltf_result_out_of_memory;
+	}
+
+	gltfFile->fileMaps = fileMaps;
+	gltfFile->fileMaps[gltfFile->fileMapCount++] = fileMap;
+
+	*data = fileMap.bytes;
+
+	return cgltf_result_success;
+}
+
+
+/*
+ * Same as file_map_read(), used while buffers load concurrently. Each buffer
+ * gets its own slot (@fileOptions->user_data) so workers never share state.
+ * Slots are attached to struct kmr_gltf_loader_file { @fileMaps } after the
+ * worker pool joins.
+ */
+static cgltf_result
+buffer_map_read (const struct cgltf_memory_options UNUSED *memoryOptions,
+                 const struct cgltf_file_options *fileOptions,
+                 const char *path,
+                 cgltf_size *size,
+                 void **data)
+{
+	cgltf_result res;
+	struct kmr_utils_file *fileMap = fileOptions->user_data;
+
+	res = file_map_sized(path, size, fileMap);
+	if (res != cgltf_result_success)
+		return res;
+
+	*data = fileMap->bytes;
+
+	return cgltf_result_success;
+}
+
+
+static void
+file_map_release (const struct cgltf_memory_options UNUSED *memoryOptions,
+                  const struct cgltf_file_options *fileOptions,
+                  void *data)
+{
+	uint32_t i;
+	struct kmr_gltf_loader_file *gltfFile = fileOptions->user_data;
+
+	for (i = 0; i < gltfFile->fileMapCount; i++) {
+		if (gltfFile->fileMaps[i].bytes != data)
+			continue;
+
+		kmr_utils_file_unmap(&gltfFile->fileMaps[i]);
+		break;
+	}
+}
+
+
+/*
+ * EXT_meshopt_compression: Buffer views compressed with the meshoptimizer vertex/index
+ * codecs are decoded once at load time into cgltf_buffer_view { data }. cgltf_buffer_view_data()
+ * prefers it over the (fallback) buffer and cgltf_free() releases it, so every accessor reader
+ * afterwards sees plain buffer view data. Byte group decoding and the delta/zigzag pass have
+ * SSSE3/SSE2 variants picked at runtime by meshopt_kernels_get().
+ */
+#define MESHOPT_VERTEX_HEADER 0xa0
+#define MESHOPT_INDEX_HEADER 0xe0
+#define MESHOPT_SEQUENCE_HEADER 0xd0
+#define MESHOPT_BYTE_GROUP_SIZE 16
+#define MESHOPT_BYTE_GROUP_DECODE_LIMIT 24
+#define MESHOPT_VERTEX_BLOCK_SIZE_BYTES 8192
+#define MESHOPT_VERTEX_BLOCK_MAX_SIZE 256
+#define MESHOPT_TAIL_MAX_SIZE 32
+
+
+/*
+ * @bytes_group_decode - Expands one group of 16 bytes stored with 0, 2, 4 or 8 bits (@bitsLog2 0-3)
+ *                       per byte into @buffer. Returns the address after the group.
+ * @delta_decode       - Undoes zigzag and delta encoding of @count bytes of @buffer writing them
+ *                       every @dstStride bytes to @dst. @last holds the previous vertex byte.
+ */
+struct meshopt_kernels {
+	const uint8_t *(*bytes_group_decode)(const uint8_t *data, uint8_t *buffer, uint32_t bitsLog2);
+	void (*delta_decode)(uint8_t *dst, uint32_t dstStride, const uint8_t *buffer, uint32_t count, uint8_t *last);
+};
+
+
+static const uint8_t *
+meshopt_bytes_group_decode_scalar (const uint8_t *data, uint8_t *buffer, uint32_t bitsLog2)
+{
+	uint32_t i, bits, selector;
+	const uint8_t *extra = NULL;
+
+	if (bitsLog2 == 0) {
+		memset(buffer, 0, MESHOPT_BYTE_GROUP_SIZE);
+		return data;
+	}
+
+	if (bitsLog2 == 3) {
+		memcpy(buffer, data, MESHOPT_BYTE_GROUP_SIZE);
+		return data + MESHOPT_BYTE_GROUP_SIZE;
+	}
+
+	/* Selectors are packed most significant bits first, all ones selects the next trailing byte */
+	bits = 1u << bitsLog2;
+	extra = data + ((MESHOPT_BYTE_GROUP_SIZE * bits) / 8);
+	for (i = 0; i < MESHOPT_BYTE_GROUP_SIZE; i++) {
+		selector = (data[(i * bits) / 8] >> (8 - bits - ((i * bits) % 8))) & ((1u << bits) - 1);
+		buffer[i] = (selector == (1u << bits) - 1) ? *extra++ : selector;
+	}
+
+	return extra;
+}
+
+
+static void
+meshopt_delta_decode_scalar (uint8_t *dst, uint32_t dstStride, const uint8_t *buffer, uint32_t count, uint8_t *last)
+{
+	uint32_t i;
+	uint8_t value = *last;
+
+	for (i = 0; i < count; i++) {
+		value += (uint8_t) (-(buffer[i] & 1) ^ (buffer[i] >> 1));
+		dst[i * dstStride] = value;
+	}
+
+	*last = value;
+}
+
+
+#ifdef HAVE_X86_SIMD
+
+/*
+ * @shuffle - pshufb control moving the next trailing byte into every lane whose
+ *            bit is set in the 8 bit selector mask, zeroing the others
+ * @count   - Amount of bits set in the 8 bit selector mask
+ */
+struct meshopt_tables {
+	uint8_t shuffle[256][8];
+	uint8_t count[256];
+};
+
+
+static struct meshopt_tables meshopt_tables;
+static pthread_once_t meshopt_tables_once = PTHREAD_ONCE_INIT;
+
+
+static void
+meshopt_tables_init (void)
+{
+	uint32_t mask, bit, count;
+
+	for (mask = 0; mask < 256; mask++) {
+		count = 0;
+		for (bit = 0; bit < 8; bit++)
+			meshopt_tables.shuffle[mask][bit] = (mask & (1u << bit)) ? count++ : 0x80;
+		meshopt_tables.count[mask] = count;
+	}
+}
+
+
+__attribute__((target("ssse3")))
+static const uint8_t *
+meshopt_bytes_group_decode_ssse3 (const uint8_t *data, uint8_t *buffer, uint32_t bitsLog2)
+{
+	int32_t selectorBytes;
+	uint32_t selectorSize, mask, mask0, mask1;
+	__m128i selectors, selected, overflow, rest, shuffle;
+
+	switch (bitsLog2) {
+		case 0:
+			_mm_storeu_si128((__m128i *) buffer, _mm_setzero_si128());
+			return data;
+		case 1:
+			/* Spread the 2 bit selectors of 4 bytes out to one byte each, most significant first */
+			memcpy(&selectorBytes, data, sizeof(int32_t));
+			selectors = _mm_cvtsi32_si128(selectorBytes);
+			selectors = _mm_unpacklo_epi8(_mm_srli_epi16(selectors, 4), selectors);
+			selectors = _mm_unpacklo_epi8(_mm_srli_epi16(selectors, 2), selectors);
+			selected = _mm_and_si128(selectors, _mm_set1_epi8(3));
+			overflow = _mm_cmpeq_epi8(selected, _mm_set1_epi8(3));
+			selectorSize = 4;
+			break;
+		case 2:
+			selectors = _mm_loadl_epi64((const __m128i *) data);
+			selectors = _mm_unpacklo_epi8(_mm_srli_epi16(selectors, 4), selectors);
+			selected = _mm_and_si128(selectors, _mm_set1_epi8(15));
+			overflow = _mm_cmpeq_epi8(selected, _mm_set1_epi8(15));
+			selectorSize = 8;
+			break;
+		default:
+			_mm_storeu_si128((__m128i *) buffer, _mm_loadu_si128((const __m128i *) data));
+			return data + MESHOPT_BYTE_GROUP_SIZE;
+	}
+
+	/* Stream guarantees MESHOPT_BYTE_GROUP_DECODE_LIMIT readable bytes, so loading 16 trailing bytes is safe */
+	rest = _mm_loadu_si128((const __m128i *) (data + selectorSize));
+	mask = _mm_movemask_epi8(overflow);
+	mask0 = mask & 0xff;
+	mask1 = mask >> 8;
+
+	shuffle = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *) meshopt_tables.shuffle[mask0]),
+	                             _mm_add_epi8(_mm_loadl_epi64((const __m128i *) meshopt_tables.shuffle[mask1]),
+	                                          _mm_set1_epi8(meshopt_tables.count[mask0])));
+
+	_mm_storeu_si128((__m128i *) buffer, _mm_or_si128(_mm_shuffle_epi8(rest, shuffle), _mm_andnot_si128(overflow, selected)));
+
+	return data + selectorSize + meshopt_tables.count[mask0] + meshopt_tables.count[mask1];
+}
+
+
+/* Prefix sums 16 vertices at a time with log2(16) shifted adds */
+__attribute__((target("sse2")))
+static void
+meshopt_delta_decode_sse2 (uint8_t *dst, uint32_t dstStride, const uint8_t *buffer, uint32_t count, uint8_t *last)
+{
+	uint32_t i = 0, l;
+	uint8_t decoded[MESHOPT_BYTE_GROUP_SIZE];
+	__m128i value;
+
+	for (; i + MESHOPT_BYTE_GROUP_SIZE <= count; i += MESHOPT_BYTE_GROUP_SIZE) {
+		value = _mm_loadu_si128((const __m128i *) (buffer + i));
+		value = _mm_xor_si128(_mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(value, _mm_set1_epi8(1))),
+		                      _mm_and_si128(_mm_srli_epi16(value, 1), _mm_set1_epi8(0x7f)));
+
+		value = _mm_add_epi8(value, _mm_slli_si128(value, 1));
+		value = _mm_add_epi8(value, _mm_slli_si128(value, 2));
+		value = _mm_add_epi8(value, _mm_slli_si128(value, 4));
+		value = _mm_add_epi8(value, _mm_slli_si128(value, 8));
+		value = _mm_add_epi8(value, _mm_set1_epi8((char) *last));
+
+		_mm_storeu_si128((__m128i *) decoded, value);
+		for (l = 0; l < MESHOPT_BYTE_GROUP_SIZE; l++)
+			dst[(i + l) * dstStride] = decoded[l];
+
+		*last = decoded[MESHOPT_BYTE_GROUP_SIZE - 1];
+	}
+
+	meshopt_delta_decode_scalar(dst + (i * dstStride), dstStride, buffer + i, count - i, last);
+}
+
+#endif /* HAVE_X86_SIMD */
+
+
+static void
+meshopt_kernels_get (struct meshopt_kernels *kernels)
+{
+	kernels->bytes_group_decode = meshopt_bytes_group_decode_scalar;
+	kernels->delta_decode = meshopt_delta_decode_scalar;
+
+#ifdef HAVE_X86_SIMD
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("sse2"))
+		kernels->delta_decode = meshopt_delta_decode_sse2;
+
+	if (__builtin_cpu_supports("ssse3")) {
+		pthread_once(&meshopt_tables_once, meshopt_tables_init);
+		kernels->bytes_group_decode = meshopt_bytes_group_decode_ssse3;
+	}
+#endif
+}
+
+
+static const uint8_t *
+meshopt_bytes_decode (const struct meshopt_kernels *kernels, const uint8_t *data, const uint8_t *dataEnd,
+                      uint8_t *buffer, uint32_t bufferSize)
+{
+	uint32_t i, group;
+	const uint8_t *header = data;
+
+	/* Two header bits per group giving its bits per byte, least significant first */
+	data += ((bufferSize / MESHOPT_BYTE_GROUP_SIZE) + 3) / 4;
+	if (data > dataEnd)
+		return NULL;
+
+	for (i = 0; i < bufferSize; i += MESHOPT_BYTE_GROUP_SIZE) {
+		if ((size_t) (dataEnd - data) < MESHOPT_BYTE_GROUP_DECODE_LIMIT)
+			return NULL;
+
+		group = i / MESHOPT_BYTE_GROUP_SIZE;
+		data = kernels->bytes_group_decode(data, buffer + i, (header[group / 4] >> ((group % 4) * 2)) & 3);
+	}
+
+	return data;
+}
+
+
+/*
+ * Vertices are encoded in blocks, every byte of the vertex stored as its own
+ * byte stream of deltas to the same byte of the previous vertex. The stream
+ * ends with the first vertex (the seed of the deltas) padded to 32 bytes.
+ */
+static int
+meshopt_vertex_buffer_decode (const struct meshopt_kernels *kernels, uint8_t *dst, size_t count, uint32_t vertexSize,
+                              const uint8_t *src, size_t srcSize)
+{
+	uint32_t k, blockSize, blockCount;
+	size_t offset;
+	uint8_t last[MESHOPT_VERTEX_BLOCK_MAX_SIZE], buffer[MESHOPT_VERTEX_BLOCK_MAX_SIZE];
+	const uint8_t *data = src, *dataEnd = src + srcSize;
+
+	if (srcSize < 1 + vertexSize || *data++ != MESHOPT_VERTEX_HEADER)
+		return -1;
+
+	memcpy(last, dataEnd - vertexSize, vertexSize);
+
+	blockSize = (MESHOPT_VERTEX_BLOCK_SIZE_BYTES / vertexSize) & ~(MESHOPT_BYTE_GROUP_SIZE - 1);
+	if (blockSize > MESHOPT_VERTEX_BLOCK_MAX_SIZE)
+		blockSize = MESHOPT_VERTEX_BLOCK_MAX_SIZE;
+
+	for (offset = 0; offset < count; offset += blockCount) {
+		blockCount = (count - offset < blockSize) ? count - offset : blockSize;
+		for (k = 0; k < vertexSize; k++) {
+			data = meshopt_bytes_decode(kernels, data, dataEnd, buffer,
+			                            (blockCount + MESHOPT_BYTE_GROUP_SIZE - 1) & ~(MESHOPT_BYTE_GROUP_SIZE - 1));
+			if (!data)
+				return -1;
+
+			kernels->delta_decode(dst + (offset * vertexSize) + k, vertexSize, buffer, blockCount, &last[k]);
+		}
+	}
+
+	return ((size_t) (dataEnd - data) == ((vertexSize < MESHOPT_TAIL_MAX_SIZE) ? MESHOPT_TAIL_MAX_SIZE : vertexSize)) ? 0 : -1;
+}
+
+
+static inline uint32_t
+meshopt_vbyte_decode (const uint8_t **data)
+{
+	uint32_t i, group, result = *(*data)++, shift = 7;
+
+	if (result < 128)
+		return result;
+
+	result &= 127;
+	for (i = 0; i < 4; i++) {
+		group = *(*data)++;
+		result |= (group & 127) << shift;
+		shift += 7;
+		if (group < 128)
+			break;
+	}
+
+	return result;
+}
+
+
+static inline uint32_t
+meshopt_index_delta_decode (const uint8_t **data, uint32_t last)
+{
+	uint32_t value = meshopt_vbyte_decode(data);
+	return last + ((value >> 1) ^ -(value & 1));
+}
+
+
+static inline void
+meshopt_index_write (uint8_t *dst, size_t i, uint32_t indexSize, uint32_t index)
+{
+	if (indexSize == sizeof(uint16_t))
+		((uint16_t *) dst)[i] = (uint16_t) index;
+	else
+		((uint32_t *) dst)[i] = index;
+}
+
+
+#define MESHOPT_FIFO_PUSH_EDGE(fifo, offset, a, b) \
+	do { (fifo)[offset][0] = (a); (fifo)[offset][1] = (b); (offset) = ((offset) + 1) & 15; } while (0)
+#define MESHOPT_FIFO_PUSH_VERTEX(fifo, offset, v, cond) \
+	do { (fifo)[offset] = (v); (offset) = ((offset) + (cond)) & 15; } while (0)
+
+
+/*
+ * Triangle codec: Every triangle is one code byte either reusing an edge and/or vertex
+ * from the 16 entry edge/vertex FIFO's, introducing the next sequential vertex, or
+ * referencing free indices stored as zigzag varint deltas. The stream ends with a
+ * 16 byte table of common code byte pairs.
+ */
+static int
+meshopt_index_buffer_decode (uint8_t *dst, size_t count, uint32_t indexSize, const uint8_t *src, size_t srcSize)
+{
+	size_t i;
+	uint32_t edgeFifo[16][2], vertexFifo[16], edgeOffset = 0, vertexOffset = 0;
+	uint32_t a, b, c, next = 0, last = 0, fe, fea, feb, fec, fecMax, version;
+	uint8_t code, codeAux;
+
+	const uint8_t *codes = NULL, *data = NULL, *dataSafeEnd = NULL, *codeAuxTable = NULL;
+
+	if (srcSize < 1 + (count / 3) + 16 || (src[0] & 0xf0) != MESHOPT_INDEX_HEADER || (src[0] & 0x0f) > 1)
+		return -1;
+
+	version = src[0] & 0x0f;
+	fecMax = (version >= 1) ? 13 : 15;
+
+	memset(edgeFifo, 0xff, sizeof(edgeFifo));
+	memset(vertexFifo, 0xff, sizeof(vertexFifo));
+
+	codes = src + 1;
+	data = codes + (count / 3);
+	dataSafeEnd = codeAuxTable = src + srcSize - 16;
+
+	for (i = 0; i < count; i += 3) {
+		/* A triangle reads at most 16 bytes, which the code aux table guarantees */
+		if (data > dataSafeEnd)
+			return -1;
+
+		code = *codes++;
+		if (code < 0xf0) {
+			/* Edge from the FIFO, third vertex either new, from the FIFO or free */
+			fe = code >> 4;
+			a = edgeFifo[(edgeOffset - 1 - fe) & 15][0];
+			b = edgeFifo[(edgeOffset - 1 - fe) & 15][1];
+			fec = code & 15;
+
+			if (fec < fecMax) {
+				c = (fec == 0) ? next++ : vertexFifo[(vertexOffset - 1 - fec) & 15];
+				MESHOPT_FIFO_PUSH_VERTEX(vertexFifo, vertexOffset, c, fec == 0);
+			} else {
+				/* 13 and 14 are +-1 of the last free index (version 1 only) */
+				c = last = (fec != 15) ? last + (fec - (fec ^ 3)) : meshopt_index_delta_decode(&data, last);
+				MESHOPT_FIFO_PUSH_VERTEX(vertexFifo, vertexOffset, c, 1);
+			}
+
+			meshopt_index_write(dst, i + 0, indexSize, a);
+			meshopt_index_write(dst, i + 1, indexSize, b);
+			meshopt_index_write(dst, i + 2, indexSize, c);
+			MESHOPT_FIFO_PUSH_EDGE(edgeFifo, edgeOffset, c, b);
+			MESHOPT_FIFO_PUSH_EDGE(edgeFifo, edgeOffset, a, c);
+			continue;
+		}
+
+		if (code < 0xfe) {
+			/* No edge reuse, vertex FIFO references come from the code aux table */
+			codeAux = codeAuxTable[code & 15];
+			feb = codeAux >> 4;
+			fec = codeAux & 15;
+
+			a = next++;
+			b = (feb == 0) ? next++ : vertexFifo[(vertexOffset - feb) & 15];
+			c = (fec == 0) ? next++ : vertexFifo[(vertexOffset - fec) & 15];
+
+			MESHOPT_FIFO_PUSH_VERTEX(vertexFifo, vertexOffset, a, 1);
+			MESHOPT_FIFO_PUSH_VERTEX(vertexFifo, vertexOffset, b, feb == 0);
+			MESHOPT_FIFO_PUSH_VERTEX(vertexFifo, vertexOffset, c, fec == 0);
+		} else {
+			/* Same with the code aux byte stored inline, 15 marks a free index */
+			codeAux = *data++;
+			fea = (code == 0xfe) ? 0 : 15;
+			feb = codeAux >> 4;
+			fec = codeAux & 15;
+
+			if (codeAux == 0)
+				next = 0;
+
+			a = (fea == 0) ? next++ : 0;
+			b = (feb == 0) ? next++ : vertexFifo[(vertexOffset - feb) & 15];
+			c = (fec == 0) ? next++ : vertexFifo[(vertexOffset - fec) & 15];
+
+			if (fea == 15)
+				last = a = meshopt_index_delta_decode(&data, last);
+			if (feb == 15)
+				last = b = meshopt_index_delta_decode(&data, last);
+			if (fec == 15)
+				last = c = meshopt_index_delta_decode(&data, last);
+
+			MESHOPT_FIFO_PUSH_VERTEX(vertexFifo, vertexOffset, a, 1);
+			MESHOPT_FIFO_PUSH_VERTEX(vertexFifo, vertexOffset, b, (feb == 0) | (feb == 15));
+			MESHOPT_FIFO_PUSH_VERTEX(vertexFifo, vertexOffset, c, (fec == 0) | (fec == 15));
+		}
+
+		meshopt_index_write(dst, i + 0, indexSize, a);
+		meshopt_index_write(dst, i + 1, indexSize, b);
+		meshopt_index_write(dst, i + 2, indexSize, c);
+		MESHOPT_FIFO_PUSH_EDGE(edgeFifo, edgeOffset, b, a);
+		MESHOPT_FIFO_PUSH_EDGE(edgeFifo, edgeOffset, c, b);
+		MESHOPT_FIFO_PUSH_EDGE(edgeFifo, edgeOffset, a, c);
+	}
+
+	return (data == dataSafeEnd) ? 0 : -1;
+}
+
+
+/* Index sequence codec: zigzag varint deltas against one of two previous indices */
+static int
+meshopt_index_sequence_decode (uint8_t *dst, size_t count, uint32_t indexSize, const uint8_t *src, size_t srcSize)
+{
+	size_t i;
+	uint32_t value, baseline, last[2] = { 0, 0 };
+	const uint8_t *data = NULL, *dataSafeEnd = NULL;
+
+	if (srcSize < 1 + count + 4 || (src[0] & 0xf0) != MESHOPT_SEQUENCE_HEADER || (src[0] & 0x0f) > 1)
+		return -1;
+
+	data = src + 1;
+	dataSafeEnd = src + srcSize - 4;
+
+	for (i = 0; i < count; i++) {
+		/* An index reads at most 5 bytes, which the 4 byte tail guarantees */
+		if (data >= dataSafeEnd)
+			return -1;
+
+		value = meshopt_vbyte_decode(&data);
+		baseline = value & 1;
+		value >>= 1;
+
+		last[baseline] += (value >> 1) ^ -(value & 1);
+		meshopt_index_write(dst, i, indexSize, last[baseline]);
+	}
+
+	return (data == dataSafeEnd) ? 0 : -1;
+}
+
+
+/* Rounded signed float to integer conversion used by the filters */
+#define MESHOPT_ROUND(value) ((int32_t) ((value) + (((value) >= 0.0f) ? 0.5f : -0.5f)))
+
+#define MESHOPT_FILTER_OCTAHEDRAL(name, type) \
+	static void \
+	name (type *data, size_t count) \
+	{ \
+		size_t i; \
+		float x, y, z, t, scale; \
+		const float max = (float) ((1 << ((sizeof(type) * 8) - 1)) - 1); \
+		for (i = 0; i < count; i++) { \
+			x = (float) data[(i * 4) + 0]; \
+			y = (float) data[(i * 4) + 1]; \
+			z = (float) data[(i * 4) + 2] - fabsf(x) - fabsf(y); \
+			t = (z < 0.0f) ? z : 0.0f; \
+			x += (x >= 0.0f) ? t : -t; \
+			y += (y >= 0.0f) ? t : -t; \
+			scale = max / sqrtf((x * x) + (y * y) + (z * z)); \
+			data[(i * 4) + 0] = (type) MESHOPT_ROUND(x * scale); \
+			data[(i * 4) + 1] = (type) MESHOPT_ROUND(y * scale); \
+			data[(i * 4) + 2] = (type) MESHOPT_ROUND(z * scale); \
+		} \
+	}
+
+MESHOPT_FILTER_OCTAHEDRAL(meshopt_filter_octahedral_s8, int8_t)
+MESHOPT_FILTER_OCTAHEDRAL(meshopt_filter_octahedral_s16, int16_t)
+
+
+/* Quaternion with the largest component dropped, its index in the low 2 bits of w */
+static void
+meshopt_filter_quaternion (int16_t *data, size_t count)
+{
+	size_t i;
+	int32_t component;
+	float x, y, z, w, ww, scale;
+
+	for (i = 0; i < count; i++) {
+		scale = (1.0f / sqrtf(2.0f)) / (float) (data[(i * 4) + 3] | 3);
+		x = (float) data[(i * 4) + 0] * scale;
+		y = (float) data[(i * 4) + 1] * scale;
+		z = (float) data[(i * 4) + 2] * scale;
+		ww = 1.0f - (x * x) - (y * y) - (z * z);
+		w = sqrtf((ww >= 0.0f) ? ww : 0.0f);
+
+		component = data[(i * 4) + 3] & 3;
+		data[(i * 4) + ((component + 1) & 3)] = (int16_t) MESHOPT_ROUND(x * 32767.0f);
+		data[(i * 4) + ((component + 2) & 3)] = (int16_t) MESHOPT_ROUND(y * 32767.0f);
+		data[(i * 4) + ((component + 3) & 3)] = (int16_t) MESHOPT_ROUND(z * 32767.0f);
+		data[(i * 4) + ((component + 0) & 3)] = (int16_t) ((w * 32767.0f) + 0.5f);
+	}
+}
+
+
+/* 24 bit signed mantissa with 8 bit signed exponent, mantissa * 2^exponent */
+static void
+meshopt_filter_exponential (uint32_t *data, size_t count)
+{
+	size_t i;
+	uint32_t bits;
+	int32_t mantissa, exponent;
+	float value;
+
+	for (i = 0; i < count; i++) {
+		mantissa = (int32_t) (data[i] << 8) >> 8;
+		exponent = (int32_t) data[i] >> 24;
+
+		/* Builds 2^exponent directly, same as the reference decoder */
+		bits = (uint32_t) (exponent + 127) << 23;
+		memcpy(&value, &bits, sizeof(float));
+		value *= (float) mantissa;
+		memcpy(&data[i], &value, sizeof(uint32_t));
+	}
+}
+
+
+struct meshopt_decode {
+	cgltf_data             *gltfData;
+	cgltf_buffer_view      **views;
+	struct meshopt_kernels kernels;
+};
+
+
+static int
+meshopt_decode_job_run (void *userData, uint32_t jobIndex)
+{
+	int ret = -1;
+	struct meshopt_decode *decode = userData;
+	cgltf_buffer_view *view = decode->views[jobIndex];
+	cgltf_meshopt_compression *compression = &view->meshopt_compression;
+	const uint8_t *src = (const uint8_t *) compression->buffer->data + compression->offset;
+
+	/* Released by cgltf_free(3) along with the rest of cgltf_data */
+	view->data = malloc(compression->count * compression->stride + 1);
+	if (!view->data) {
+		kmr_utils_log(KMR_DANGER, "[x] malloc(view->data): %s", strerror(errno));
+		return -1;
+	}
+
+	switch (compression->mode) {
+		case cgltf_meshopt_compression_mode_attributes:
+			ret = meshopt_vertex_buffer_decode(&decode->kernels, view->data, compression->count,
+			                                   compression->stride, src, compression->size);
+			break;
+		case cgltf_meshopt_compression_mode_triangles:
+			ret = meshopt_index_buffer_decode(view->data, compression->count, compression->stride, src, compression->size);
+			break;
+		case cgltf_meshopt_compression_mode_indices:
+			ret = meshopt_index_sequence_decode(view->data, compression->count, compression->stride, src, compression->size);
+			break;
+		default:
+			break;
+	}
+
+	if (ret == -1) {
+		kmr_utils_log(KMR_DANGER, "[x] EXT_meshopt_compression: Failed to decode buffer view %zu",
+		              cgltf_buffer_view_index(decode->gltfData, view));
+		return -1;
+	}
+
+	switch (compression->filter) {
+		case cgltf_meshopt_compression_filter_octahedral:
+			if (compression->stride == 4)
+				meshopt_filter_octahedral_s8(view->data, compression->count);
+			else
+				meshopt_filter_octahedral_s16(view->data, compression->count);
+			break;
+		case cgltf_meshopt_compression_filter_quaternion:
+			meshopt_filter_quaternion(view->data, compression->count);
+			break;
+		case cgltf_meshopt_compression_filter_exponential:
+			meshopt_filter_exponential(view->data, (compression->count * compression->stride) / sizeof(uint32_t));
+			break;
+		default:
+			break;
+	}
+
+	return 0;
+}
+
+
+/*
+ * Decodes every compressed buffer view concurrently, one job per view. Views whose
+ * fallback buffer was loaded already hold uncompressed data and are left alone.
+ */
+static int
+meshopt_buffer_views_decode (cgltf_data *gltfData)
+{
+	int ret = -1;
+	cgltf_size i;
+	uint32_t viewCount = 0;
+
+	struct meshopt_decode decode;
+	struct kmr_utils_worker_pool_run_info workerPoolRunInfo;
+
+	decode.gltfData = gltfData;
+	decode.views = calloc(gltfData->buffer_views_count + 1, sizeof(cgltf_buffer_view *));
+	if (!decode.views) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(views): %s", strerror(errno));
+		return -1;
+	}
+
+	for (i = 0; i < gltfData->buffer_views_count; i++) {
+		if (!gltfData->buffer_views[i].has_meshopt_compression || gltfData->buffer_views[i].data ||
+		    gltfData->buffer_views[i].buffer->data)
+		{
+			continue;
+		}
+
+		if (!gltfData->buffer_views[i].meshopt_compression.buffer->data) {
+			kmr_utils_log(KMR_DANGER, "[x] EXT_meshopt_compression: Buffer holding compressed buffer view %zu not loaded", i);
+			goto exit_meshopt_buffer_views_decode;
+		}
+
+		decode.views[viewCount++] = &gltfData->buffer_views[i];
+	}
+
+	meshopt_kernels_get(&decode.kernels);
+
+	workerPoolRunInfo.threadCount = 0;
+	workerPoolRunInfo.jobCount = viewCount;
+	workerPoolRunInfo.job = meshopt_decode_job_run;
+	workerPoolRunInfo.userData = &decode;
+
+	ret = kmr_utils_worker_pool_run(&workerPoolRunInfo);
+
+exit_meshopt_buffer_views_decode:
+	free(decode.views);
+	return ret;
+}
+
+
+/*
+ * struct buffers_load
+ *
+ * @options  - cgltf options buffers are read with. Shared read only by every job.
+ * @gltfData - cgltf data whose buffers get loaded.
+ * @fileName - Path to the glTF file external buffer URIs are relative to.
+ * @fileMaps - One slot per buffer filled by buffer_map_read() if options map files.
+ *             NULL otherwise.
+ */
+struct buffers_load {
+	const cgltf_options   *options;
+	cgltf_data            *gltfData;
+	const char            *fileName;
+	struct kmr_utils_file *fileMaps;
+};
+
+
+static int
+buffers_load_job_run (void *userData, uint32_t jobIndex)
+{
+	cgltf_data buffer;
+	cgltf_result res;
+	cgltf_options options;
+	struct buffers_load *load = userData;
+	cgltf_buffer *gltfBuffer = &load->gltfData->buffers[jobIndex];
+
+	options = *load->options;
+	if (load->fileMaps) {
+		options.file.read = buffer_map_read;
+		options.file.user_data = &load->fileMaps[jobIndex];
+	}
+
+	/*
+	 * cgltf_load_buffers(3) only touches @buffers, @buffers_count
+	 * and @bin. Hand it a view holding just this job's buffer so
+	 * URI decoding, path resolution, base64 and the free method
+	 * stay exactly as cgltf does them.
+	 */
+	memset(&buffer, 0, sizeof(buffer));
+	buffer.buffers = gltfBuffer;
+	buffer.buffers_count = 1;
+
+	res = cgltf_load_buffers(&options, &buffer, load->fileName);
+	if (res != cgltf_result_success) {
+		kmr_utils_log(KMR_DANGER, "[x] cgltf_load_buffers: Could not load buffer %u (%s) in %s",
+		              jobIndex, (gltfBuffer->uri) ? gltfBuffer->uri : "GLB BIN", load->fileName);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/*
+ * Large exports split geometry across many .bin files. Instead of
+ * cgltf_load_buffers(3) opening them one after the other, read (or map)
+ * every external buffer on its own worker so startup isn't serialized
+ * on file I/O. Accessors already resolve whichever buffer they reference.
+ */
+static int
+buffers_load (const cgltf_options *options, struct kmr_gltf_loader_file *gltfFile, const char *fileName)
+{
+	int ret = -1;
+	uint32_t i;
+	struct buffers_load load;
+	struct kmr_utils_file *fileMaps = NULL;
+	cgltf_data *gltfData = gltfFile->gltfData;
+	struct kmr_utils_worker_pool_run_info workerPoolRunInfo;
+
+	/* GLB BIN chunk lives inside of the already loaded file */
+	if (gltfData->buffers_count && !gltfData->buffers[0].data && !gltfData->buffers[0].uri && gltfData->bin) {
+		if (gltfData->bin_size < gltfData->buffers[0].size) {
+			kmr_utils_log(KMR_DANGER, "[x] cgltf_load_buffers: GLB BIN chunk smaller than buffer 0 in %s", fileName);
+			return -1;
+		}
+
+		gltfData->buffers[0].data = (void *) gltfData->bin;
+		gltfData->buffers[0].data_free_method = cgltf_data_free_method_none;
+	}
+
+	if (!gltfData->buffers_count)
+		return 0;
+
+	load.options = options;
+	load.gltfData = gltfData;
+	load.fileName = fileName;
+	load.fileMaps = NULL;
+
+	if (options->file.read == file_map_read) {
+		fileMaps = realloc(gltfFile->fileMaps, (gltfFile->fileMapCount + gltfData->buffers_count) * sizeof(struct kmr_utils_file));
+		if (!fileMaps) {
+			kmr_utils_log(KMR_DANGER, "[x] realloc(fileMaps): %s", strerror(errno));
+			return -1;
+		}
+
+		gltfFile->fileMaps = fileMaps;
+		load.fileMaps = &fileMaps[gltfFile->fileMapCount];
+		memset(load.fileMaps, 0, gltfData->buffers_count * sizeof(struct kmr_utils_file));
+	}
+
+	workerPoolRunInfo.threadCount = 0;
+	workerPoolRunInfo.jobCount = gltfData->buffers_count;
+	workerPoolRunInfo.job = buffers_load_job_run;
+	workerPoolRunInfo.userData = &load;
+
+	ret = kmr_utils_worker_pool_run(&workerPoolRunInfo);
+
+	/*
+	 * Attach whatever got mapped even on failure, cgltf_free(3)
+	 * releases buffers through file_map_release() either way.
+	 */
+	if (load.fileMaps) {
+		for (i = 0; i < gltfData->buffers_count; i++) {
+			if (load.fileMaps[i].bytes)
+				gltfFile->fileMaps[gltfFile->fileMapCount++] = load.fileMaps[i];
+		}
+	}
+
+	return ret;
+}
+
+
 struct kmr_gltf_loader_file *
 kmr_gltf_loader_file_create (struct kmr_gltf_loader_file_create_info *gltfFileInfo)
 {
 	cgltf_options options;
 	cgltf_result res = cgltf_result_max_enum;
 
-	struct kmr_gltf_loader_file *gltfFile = NULL;
+	struct kmr_gltf_loader_file *gltfFile = NULL;
+
+	gltfFile = calloc(1, sizeof(struct kmr_gltf_loader_file));
+	if (!gltfFile) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc: %s", strerror(errno));
+		return NULL;
+	}
+
+	memset(&options, 0, sizeof(cgltf_options));
+
+	/*
+	 * cgltf copies @options.file into cgltf_data so the
+	 * same callbacks are used for external buffers and
+	 * again on cgltf_free(3).
+	 */
+	if (gltfFileInfo->flags & KMR_GLTF_LOADER_FILE_CREATE_MMAP) {
+		options.file.read = file_map_read;
+		options.file.release = file_map_release;
+		options.file.user_data = gltfFile;
+	}
+
+	res = cgltf_parse_file(&options, gltfFileInfo->fileName, &gltfFile->gltfData);
+	if (res != cgltf_result_success) {
+		kmr_utils_log(KMR_DANGER, "[x] cgltf_parse_file: Could not load %s", gltfFileInfo->fileName);
+		goto exit_error_kmr_gltf_loader_file_load;
+	}
+
+	if (buffers_load(&options, gltfFile, gltfFileInfo->fileName) == -1)
+		goto exit_error_kmr_gltf_loader_file_load;
+
+	res = cgltf_validate(gltfFile->gltfData);
+	if (res != cgltf_result_success) {
+		kmr_utils_log(KMR_DANGER, "[x] cgltf_validate: Failed to load content in %s", gltfFileInfo->fileName);
+		goto exit_error_kmr_gltf_loader_file_load;
+	}
+
+	if (meshopt_buffer_views_decode(gltfFile->gltfData) == -1)
+		goto exit_error_kmr_gltf_loader_file_load;
+
+	return gltfFile;
+
+exit_error_kmr_gltf_loader_file_load:
+	kmr_gltf_loader_file_destroy(gltfFile);
+	return NULL;
+}
+
+
+void
+kmr_gltf_loader_file_destroy (struct kmr_gltf_loader_file *gltfFile)
+{
+	uint32_t i;
+
+	if (!gltfFile)
+		return;
+
+	cgltf_free(gltfFile->gltfData);
+
+	/* Catch mappings cgltf never got ownership of */
+	for (i = 0; i < gltfFile->fileMapCount; i++)
+		kmr_utils_file_unmap(&gltfFile->fileMaps[i]);
+
+	free(gltfFile->fileMaps);
+	free(gltfFile);
+}
+
+/**********************************************************
+ * END OF kmr_gltf_loader_file_{create,destroy} FUNCTIONS *
+ **********************************************************/
+
+
+/************************************************************
+ * START OF kmr_gltf_loader_mesh_{create,destroy} FUNCTIONS *
+ ************************************************************/
+
+/*
+ * Primitives with more vertices or indices than this are split into
+ * multiple decode jobs so a single large primitive can't serialize
+ * the whole worker pool.
+ */
+#define MESH_DECODE_JOB_ELEMENT_COUNT (1 << 16)
+
+
+/*
+ * Batch conversion kernels used to decode a whole attribute/index stream at once.
+ * Every kernel has a scalar fallback. Kernels that perform arithmetic also have
+ * SSE2 and AVX2 variants picked at runtime by mesh_decode_kernels_get(). Plain
+ * attribute copies/conversions go through the accessor readers below.
+ *
+ * @dst       - First vertex to write
+ * @src       - Address of first element in GLTF buffer
+ * @srcStride - Byte distance between two elements in @src
+ * @count     - Amount of elements to convert
+ */
+struct mesh_decode_kernels {
+	void (*normal_normalize)(struct kmr_gltf_loader_mesh_vertex_data *dst, const uint8_t *src, uint32_t srcStride, uint32_t count);
+	void (*index_widen_u8)(uint32_t *dst, const uint8_t *src, uint32_t count, uint32_t offset);
+	void (*index_widen_u16)(uint32_t *dst, const uint16_t *src, uint32_t count, uint32_t offset);
+	void (*index_widen_u32)(uint32_t *dst, const uint32_t *src, uint32_t count, uint32_t offset);
+};
+
+
+/*
+ * Accessor streaming: Reads @count elements of an accessor that may be interleaved/strided,
+ * reside in any buffer, and store float or (normalized) integer components. Converts each
+ * component to float and writes @components floats every @dstStride bytes.
+ *
+ * Readers are generated per (component type, output component count) with a "packed" variant
+ * that hard codes the source stride for tightly packed elements and a "strided" variant.
+ * The tightly packed float variants compile down to plain copy loops.
+ */
+enum accessor_format {
+	ACCESSOR_FORMAT_F32 = 0,
+	ACCESSOR_FORMAT_S8,
+	ACCESSOR_FORMAT_S8_NORM,
+	ACCESSOR_FORMAT_U8,
+	ACCESSOR_FORMAT_U8_NORM,
+	ACCESSOR_FORMAT_S16,
+	ACCESSOR_FORMAT_S16_NORM,
+	ACCESSOR_FORMAT_U16,
+	ACCESSOR_FORMAT_U16_NORM,
+	ACCESSOR_FORMAT_U32,
+	ACCESSOR_FORMAT_COUNT,
+	ACCESSOR_FORMAT_INVALID = ACCESSOR_FORMAT_COUNT,
+};
+
+
+typedef void (*accessor_reader)(uint8_t *dst, uint32_t dstStride, const uint8_t *src, uint32_t srcStride, uint32_t count);
+
+
+/* GLTF 2.0 specification normalized integer to float conversion */
+#define ACCESSOR_CONVERT_NONE(c)    ((float) (c))
+#define ACCESSOR_CONVERT_SNORM8(c)  (((c) / 127.0f < -1.0f) ? -1.0f : (c) / 127.0f)
+#define ACCESSOR_CONVERT_UNORM8(c)  ((c) / 255.0f)
+#define ACCESSOR_CONVERT_SNORM16(c) (((c) / 32767.0f < -1.0f) ? -1.0f : (c) / 32767.0f)
+#define ACCESSOR_CONVERT_UNORM16(c) ((c) / 65535.0f)
+
+#define ACCESSOR_READER(name, type, convert, components) \
+	static inline __attribute__((always_inline)) void \
+	name##_body (uint8_t *dst, uint32_t dstStride, const uint8_t *src, uint32_t srcStride, uint32_t count) \
+	{ \
+		uint32_t v, c; \
+		type element[components]; \
+		float *out = NULL; \
+		for (v = 0; v < count; v++) { \
+			memcpy(element, src + (v * srcStride), sizeof(element)); \
+			out = (float *) (dst + (v * dstStride)); \
+			for (c = 0; c < components; c++) \
+				out[c] = convert(element[c]); \
+		} \
+	} \
+	static void \
+	name##_packed (uint8_t *dst, uint32_t dstStride, const uint8_t *src, uint32_t UNUSED srcStride, uint32_t count) \
+	{ \
+		name##_body(dst, dstStride, src, sizeof(type) * components, count); \
+	} \
+	static void \
+	name##_strided (uint8_t *dst, uint32_t dstStride, const uint8_t *src, uint32_t srcStride, uint32_t count) \
+	{ \
+		name##_body(dst, dstStride, src, srcStride, count); \
+	}
+
+#define ACCESSOR_READERS(name, type, convert) \
+	ACCESSOR_READER(name##_vec2, type, convert, 2) \
+	ACCESSOR_READER(name##_vec3, type, convert, 3) \
+	ACCESSOR_READER(name##_vec4, type, convert, 4)
+
+ACCESSOR_READERS(accessor_read_f32, float, ACCESSOR_CONVERT_NONE)
+ACCESSOR_READERS(accessor_read_s8, int8_t, ACCESSOR_CONVERT_NONE)
+ACCESSOR_READERS(accessor_read_s8_norm, int8_t, ACCESSOR_CONVERT_SNORM8)
+ACCESSOR_READERS(accessor_read_u8, uint8_t, ACCESSOR_CONVERT_NONE)
+ACCESSOR_READERS(accessor_read_u8_norm, uint8_t, ACCESSOR_CONVERT_UNORM8)
+ACCESSOR_READERS(accessor_read_s16, int16_t, ACCESSOR_CONVERT_NONE)
+ACCESSOR_READERS(accessor_read_s16_norm, int16_t, ACCESSOR_CONVERT_SNORM16)
+ACCESSOR_READERS(accessor_read_u16, uint16_t, ACCESSOR_CONVERT_NONE)
+ACCESSOR_READERS(accessor_read_u16_norm, uint16_t, ACCESSOR_CONVERT_UNORM16)
+ACCESSOR_READERS(accessor_read_u32, uint32_t, ACCESSOR_CONVERT_NONE)
+
+#define ACCESSOR_READER_ENTRY(name) \
+	{ \
+		{ name##_vec2_packed, name##_vec2_strided }, \
+		{ name##_vec3_packed, name##_vec3_strided }, \
+		{ name##_vec4_packed, name##_vec4_strided }, \
+	}
+
+/* [format][components - 2][packed=0/strided=1] */
+static const accessor_reader accessor_readers[ACCESSOR_FORMAT_COUNT][3][2] = {
+	[ACCESSOR_FORMAT_F32]      = ACCESSOR_READER_ENTRY(accessor_read_f32),
+	[ACCESSOR_FORMAT_S8]       = ACCESSOR_READER_ENTRY(accessor_read_s8),
+	[ACCESSOR_FORMAT_S8_NORM]  = ACCESSOR_READER_ENTRY(accessor_read_s8_norm),
+	[ACCESSOR_FORMAT_U8]       = ACCESSOR_READER_ENTRY(accessor_read_u8),
+	[ACCESSOR_FORMAT_U8_NORM]  = ACCESSOR_READER_ENTRY(accessor_read_u8_norm),
+	[ACCESSOR_FORMAT_S16]      = ACCESSOR_READER_ENTRY(accessor_read_s16),
+	[ACCESSOR_FORMAT_S16_NORM] = ACCESSOR_READER_ENTRY(accessor_read_s16_norm),
+	[ACCESSOR_FORMAT_U16]      = ACCESSOR_READER_ENTRY(accessor_read_u16),
+	[ACCESSOR_FORMAT_U16_NORM] = ACCESSOR_READER_ENTRY(accessor_read_u16_norm),
+	[ACCESSOR_FORMAT_U32]      = ACCESSOR_READER_ENTRY(accessor_read_u32),
+};
+
+
+/*
+ * struct accessor_stream
+ *
+ * @data       - Address of the first element of the accessor. Already accounts for
+ *               buffer->data + bufferView->offset + accessor->offset.
+ * @stride     - Byte distance between two elements (bufferView->byteStride or element size).
+ * @count      - Amount of elements in accessor.
+ * @format     - enum accessor_format describing component type.
+ * @components - Amount of components per element.
+ */
+struct accessor_stream {
+	const uint8_t        *data;
+	uint32_t             stride;
+	uint32_t             count;
+	enum accessor_format format;
+	uint32_t             components;
+};
+
+
+static enum accessor_format
+accessor_format_get (cgltf_component_type componentType, cgltf_bool normalized)
+{
+	switch (componentType) {
+		case cgltf_component_type_r_32f:
+			return ACCESSOR_FORMAT_F32;
+		case cgltf_component_type_r_8:
+			return (normalized) ? ACCESSOR_FORMAT_S8_NORM : ACCESSOR_FORMAT_S8;
+		case cgltf_component_type_r_8u:
+			return (normalized) ? ACCESSOR_FORMAT_U8_NORM : ACCESSOR_FORMAT_U8;
+		case cgltf_component_type_r_16:
+			return (normalized) ? ACCESSOR_FORMAT_S16_NORM : ACCESSOR_FORMAT_S16;
+		case cgltf_component_type_r_16u:
+			return (normalized) ? ACCESSOR_FORMAT_U16_NORM : ACCESSOR_FORMAT_U16;
+		case cgltf_component_type_r_32u:
+			return ACCESSOR_FORMAT_U32;
+		default:
+			return ACCESSOR_FORMAT_INVALID;
+	}
+}
+
+
+/*
+ * Sparse accessors and accessors without a buffer view can't be streamed from
+ * the GLTF buffer directly. Those are expanded once to tightly packed floats
+ * by cgltf and @unpacked is used as the stream source instead.
+ */
+static int
+accessor_stream_get (cgltf_accessor *accessor, const float *unpacked, struct accessor_stream *stream)
+{
+	stream->count = accessor->count;
+	stream->components = cgltf_num_components(accessor->type);
+
+	if (unpacked) {
+		stream->data = (const uint8_t *) unpacked;
+		stream->stride = stream->components * sizeof(float);
+		stream->format = ACCESSOR_FORMAT_F32;
+		return 0;
+	}
+
+	stream->data = cgltf_buffer_view_data(accessor->buffer_view);
+	if (!stream->data) {
+		kmr_utils_log(KMR_DANGER, "[x] cgltf_buffer_view_data: Buffer belonging to accessor not loaded");
+		return -1;
+	}
+
+	stream->data += accessor->offset;
+	stream->stride = accessor->stride;
+	stream->format = accessor_format_get(accessor->component_type, accessor->normalized);
+	if (stream->format == ACCESSOR_FORMAT_INVALID) {
+		kmr_utils_log(KMR_DANGER, "[x] Accessor component type %u not supported", accessor->component_type);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+static const uint8_t accessor_format_size[ACCESSOR_FORMAT_COUNT] = {
+	[ACCESSOR_FORMAT_F32]      = sizeof(float),
+	[ACCESSOR_FORMAT_S8]       = sizeof(int8_t),
+	[ACCESSOR_FORMAT_S8_NORM]  = sizeof(int8_t),
+	[ACCESSOR_FORMAT_U8]       = sizeof(uint8_t),
+	[ACCESSOR_FORMAT_U8_NORM]  = sizeof(uint8_t),
+	[ACCESSOR_FORMAT_S16]      = sizeof(int16_t),
+	[ACCESSOR_FORMAT_S16_NORM] = sizeof(int16_t),
+	[ACCESSOR_FORMAT_U16]      = sizeof(uint16_t),
+	[ACCESSOR_FORMAT_U16_NORM] = sizeof(uint16_t),
+	[ACCESSOR_FORMAT_U32]      = sizeof(uint32_t),
+};
+
+
+static inline bool
+accessor_stream_is_packed (struct accessor_stream *stream, uint32_t components)
+{
+	return stream->stride == (accessor_format_size[stream->format] * components);
+}
+
+
+/*
+ * Converts elements [@first, @first + @count) of @stream writing
+ * @components floats (2-4) to @dst every @dstStride bytes.
+ */
+static void
+accessor_stream_read_float (struct accessor_stream *stream, uint32_t first, uint32_t count,
+                            void *dst, uint32_t dstStride, uint32_t components)
+{
+	accessor_reader reader = NULL;
+
+	reader = accessor_readers[stream->format][components - 2][!accessor_stream_is_packed(stream, components)];
+	reader(dst, dstStride, stream->data + (first * stream->stride), stream->stride, count);
+}
+
+
+static void
+normal_normalize_scalar (struct kmr_gltf_loader_mesh_vertex_data *dst, const uint8_t *src, uint32_t srcStride, uint32_t count)
+{
+	uint32_t v;
+	vec3 normal;
+
+	for (v = 0; v < count; v++) {
+		memcpy(normal, src + (v * srcStride), sizeof(vec3));
+		glm_vec3_normalize_to(normal, dst[v].normal);
+	}
+}
+
+
+#define INDEX_WIDEN_SCALAR(name, type) \
+	static void \
+	name (uint32_t *dst, const type *src, uint32_t count, uint32_t offset) \
+	{ \
+		uint32_t i; \
+		for (i = 0; i < count; i++) \
+			dst[i] = src[i] + offset; \
+	}
+
+INDEX_WIDEN_SCALAR(index_widen_u8_scalar, uint8_t)
+INDEX_WIDEN_SCALAR(index_widen_u16_scalar, uint16_t)
+INDEX_WIDEN_SCALAR(index_widen_u32_scalar, uint32_t)
+
+
+#ifdef HAVE_X86_SIMD
+
+/*
+ * Transposed back out of registers one vertex at a time as
+ * struct kmr_gltf_loader_mesh_vertex_data has a 44 byte stride.
+ */
+__attribute__((target("sse2")))
+static void
+normal_normalize_sse2 (struct kmr_gltf_loader_mesh_vertex_data *dst, const uint8_t *src, uint32_t srcStride, uint32_t count)
+{
+	uint32_t v = 0, l;
+	const float *n0, *n1, *n2, *n3;
+	float x[4], y[4], z[4];
+	__m128 vx, vy, vz, norm, scale;
+
+	for (; v + 4 <= count; v += 4) {
+		n0 = (const float *) (src + ((v + 0) * srcStride));
+		n1 = (const float *) (src + ((v + 1) * srcStride));
+		n2 = (const float *) (src + ((v + 2) * srcStride));
+		n3 = (const float *) (src + ((v + 3) * srcStride));
+
+		vx = _mm_setr_ps(n0[0], n1[0], n2[0], n3[0]);
+		vy = _mm_setr_ps(n0[1], n1[1], n2[1], n3[1]);
+		vz = _mm_setr_ps(n0[2], n1[2], n2[2], n3[2]);
+
+		norm = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+		norm = _mm_sqrt_ps(norm);
+
+		/* Same as glm_vec3_normalize_to(3): zero vector if norm < FLT_EPSILON */
+		scale = _mm_div_ps(_mm_set1_ps(1.0f), norm);
+		scale = _mm_and_ps(scale, _mm_cmpge_ps(norm, _mm_set1_ps(FLT_EPSILON)));
+
+		_mm_storeu_ps(x, _mm_mul_ps(vx, scale));
+		_mm_storeu_ps(y, _mm_mul_ps(vy, scale));
+		_mm_storeu_ps(z, _mm_mul_ps(vz, scale));
+
+		for (l = 0; l < 4; l++) {
+			dst[v + l].normal[0] = x[l];
+			dst[v + l].normal[1] = y[l];
+			dst[v + l].normal[2] = z[l];
+		}
+	}
+
+	normal_normalize_scalar(dst + v, src + (v * srcStride), srcStride, count - v);
+}
+
+
+__attribute__((target("avx2")))
+static void
+normal_normalize_avx2 (struct kmr_gltf_loader_mesh_vertex_data *dst, const uint8_t *src, uint32_t srcStride, uint32_t count)
+{
+	uint32_t v = 0, l;
+	const float *base = NULL;
+	float x[8], y[8], z[8];
+	__m256 vx, vy, vz, norm, scale;
+
+	/* GLTF requires vertex attribute strides to be a multiple of 4 bytes */
+	__m256i gatherIndex = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+	                                         _mm256_set1_epi32(srcStride / sizeof(float)));
+
+	for (; v + 8 <= count; v += 8) {
+		base = (const float *) (src + (v * srcStride));
+
+		vx = _mm256_i32gather_ps(base + 0, gatherIndex, sizeof(float));
+		vy = _mm256_i32gather_ps(base + 1, gatherIndex, sizeof(float));
+		vz = _mm256_i32gather_ps(base + 2, gatherIndex, sizeof(float));
+
+		norm = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz));
+		norm = _mm256_sqrt_ps(norm);
+
+		scale = _mm256_div_ps(_mm256_set1_ps(1.0f), norm);
+		scale = _mm256_and_ps(scale, _mm256_cmp_ps(norm, _mm256_set1_ps(FLT_EPSILON), _CMP_GE_OQ));
+
+		_mm256_storeu_ps(x, _mm256_mul_ps(vx, scale));
+		_mm256_storeu_ps(y, _mm256_mul_ps(vy, scale));
+		_mm256_storeu_ps(z, _mm256_mul_ps(vz, scale));
+
+		for (l = 0; l < 8; l++) {
+			dst[v + l].normal[0] = x[l];
+			dst[v + l].normal[1] = y[l];
+			dst[v + l].normal[2] = z[l];
+		}
+	}
+
+	normal_normalize_sse2(dst + v, src + (v * srcStride), srcStride, count - v);
+}
+
+
+__attribute__((target("sse2")))
+static void
+index_widen_u8_sse2 (uint32_t *dst, const uint8_t *src, uint32_t count, uint32_t offset)
+{
+	uint32_t i = 0;
+	__m128i zero = _mm_setzero_si128(), voffset = _mm_set1_epi32(offset);
+	__m128i bytes, lo, hi;
+
+	for (; i + 16 <= count; i += 16) {
+		bytes = _mm_loadu_si128((const __m128i *) (src + i));
+		lo = _mm_unpacklo_epi8(bytes, zero);
+		hi = _mm_unpackhi_epi8(bytes, zero);
+		_mm_storeu_si128((__m128i *) (dst + i + 0), _mm_add_epi32(_mm_unpacklo_epi16(lo, zero), voffset));
+		_mm_storeu_si128((__m128i *) (dst + i + 4), _mm_add_epi32(_mm_unpackhi_epi16(lo, zero), voffset));
+		_mm_storeu_si128((__m128i *) (dst + i + 8), _mm_add_epi32(_mm_unpacklo_epi16(hi, zero), voffset));
+		_mm_storeu_si128((__m128i *) (dst + i + 12), _mm_add_epi32(_mm_unpackhi_epi16(hi, zero), voffset));
+	}
+
+	index_widen_u8_scalar(dst + i, src + i, count - i, offset);
+}
+
+
+__attribute__((target("sse2")))
+static void
+index_widen_u16_sse2 (uint32_t *dst, const uint16_t *src, uint32_t count, uint32_t offset)
+{
+	uint32_t i = 0;
+	__m128i zero = _mm_setzero_si128(), voffset = _mm_set1_epi32(offset);
+	__m128i shorts;
+
+	for (; i + 8 <= count; i += 8) {
+		shorts = _mm_loadu_si128((const __m128i *) (src + i));
+		_mm_storeu_si128((__m128i *) (dst + i + 0), _mm_add_epi32(_mm_unpacklo_epi16(shorts, zero), voffset));
+		_mm_storeu_si128((__m128i *) (dst + i + 4), _mm_add_epi32(_mm_unpackhi_epi16(shorts, zero), voffset));
+	}
+
+	index_widen_u16_scalar(dst + i, src + i, count - i, offset);
+}
+
+
+__attribute__((target("sse2")))
+static void
+index_widen_u32_sse2 (uint32_t *dst, const uint32_t *src, uint32_t count, uint32_t offset)
+{
+	uint32_t i = 0;
+	__m128i voffset = _mm_set1_epi32(offset);
+
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_si128((__m128i *) (dst + i), _mm_add_epi32(_mm_loadu_si128((const __m128i *) (src + i)), voffset));
+
+	index_widen_u32_scalar(dst + i, src + i, count - i, offset);
+}
+
+
+__attribute__((target("avx2")))
+static void
+index_widen_u8_avx2 (uint32_t *dst, const uint8_t *src, uint32_t count, uint32_t offset)
+{
+	uint32_t i = 0;
+	__m256i voffset = _mm256_set1_epi32(offset);
+
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_si256((__m256i *) (dst + i),
+		                    _mm256_add_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) (src + i))), voffset));
+
+	index_widen_u8_scalar(dst + i, src + i, count - i, offset);
+}
+
+
+__attribute__((target("avx2")))
+static void
+index_widen_u16_avx2 (uint32_t *dst, const uint16_t *src, uint32_t count, uint32_t offset)
+{
+	uint32_t i = 0;
+	__m256i voffset = _mm256_set1_epi32(offset);
+
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_si256((__m256i *) (dst + i),
+		                    _mm256_add_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) (src + i))), voffset));
+
+	index_widen_u16_scalar(dst + i, src + i, count - i, offset);
+}
+
+
+__attribute__((target("avx2")))
+static void
+index_widen_u32_avx2 (uint32_t *dst, const uint32_t *src, uint32_t count, uint32_t offset)
+{
+	uint32_t i = 0;
+	__m256i voffset = _mm256_set1_epi32(offset);
+
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_si256((__m256i *) (dst + i),
+		                    _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) (src + i)), voffset));
+
+	index_widen_u32_scalar(dst + i, src + i, count - i, offset);
+}
+
+#endif /* HAVE_X86_SIMD */
+
+
+static void
+mesh_decode_kernels_get (struct mesh_decode_kernels *kernels)
+{
+	kernels->normal_normalize = normal_normalize_scalar;
+	kernels->index_widen_u8 = index_widen_u8_scalar;
+	kernels->index_widen_u16 = index_widen_u16_scalar;
+	kernels->index_widen_u32 = index_widen_u32_scalar;
+
+#ifdef HAVE_X86_SIMD
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("sse2")) {
+		kernels->normal_normalize = normal_normalize_sse2;
+		kernels->index_widen_u8 = index_widen_u8_sse2;
+		kernels->index_widen_u16 = index_widen_u16_sse2;
+		kernels->index_widen_u32 = index_widen_u32_sse2;
+	}
+
+	if (__builtin_cpu_supports("avx2")) {
+		kernels->normal_normalize = normal_normalize_avx2;
+		kernels->index_widen_u8 = index_widen_u8_avx2;
+		kernels->index_widen_u16 = index_widen_u16_avx2;
+		kernels->index_widen_u32 = index_widen_u32_avx2;
+	}
+#endif
+}
+
+
+/*
+ * @center        - Bounding sphere center of the primitive if known before decoding
+ *                  (from POSITION accessor min/max), NULL otherwise.
+ * @aabbMin       - Bounds of the chunk's positions, merged per primitive after decoding
+ * @aabbMax       - Bounds of the chunk's positions, merged per primitive after decoding
+ * @radiusSquared - Largest squared distance of the chunk's positions to @center
+ */
+struct mesh_decode_job {
+	uint32_t        meshIndex;
+	uint32_t        primitiveIndex;
+	cgltf_primitive *primitive;
+	uint32_t        vertexOffset;
+	uint32_t        vertexCount;
+	uint32_t        indexOffset;
+	uint32_t        indexCount;
+	uint32_t        chunk;
+	uint32_t        chunkCount;
+	const float     *center;
+	vec3            aabbMin;
+	vec3            aabbMax;
+	float           radiusSquared;
+};
+
+
+/*
+ * @unpacked - Array of size gltfData->accessors_count. Entries are only set for
+ *             accessors that can't be streamed (sparse or without buffer view)
+ *             and hold either tightly packed floats or uint32_t indices.
+ */
+struct mesh_decode {
+	cgltf_data                       *gltfData;
+	void                             **unpacked;
+	struct kmr_gltf_loader_mesh_data *meshData;
+	struct mesh_decode_job           *jobs;
+	struct mesh_decode_kernels       kernels;
+};
+
+
+/*
+ * Grows @aabbMin/@aabbMax to contain @count positions. If @center is given
+ * also grows @radiusSquared to the largest squared distance to it.
+ */
+static void
+mesh_bounds_accumulate (const struct kmr_gltf_loader_mesh_vertex_data *vertices, uint32_t count,
+                        const float *center, float *aabbMin, float *aabbMax, float *radiusSquared)
+{
+	uint32_t v, a;
+	float d, distance;
+
+	for (v = 0; v < count; v++) {
+		distance = 0.0f;
+		for (a = 0; a < 3; a++) {
+			aabbMin[a] = fminf(aabbMin[a], vertices[v].position[a]);
+			aabbMax[a] = fmaxf(aabbMax[a], vertices[v].position[a]);
+			if (center) {
+				d = vertices[v].position[a] - center[a];
+				distance += d * d;
+			}
+		}
+
+		*radiusSquared = fmaxf(*radiusSquared, distance);
+	}
+}
+
+
+/*
+ * Decodes a chunk of a single primitive into the vertex/index arrays of
+ * the mesh it belongs to. Chunks never overlap so jobs may run concurrently.
+ */
+static int
+mesh_decode_job_run (void *userData, uint32_t jobIndex)
+{
+	cgltf_size k;
+	uint32_t vertexIndex, vertexStart, vertexEnd, indexStart, indexEnd, elementCount;
+
+	const uint8_t *indexAddress = NULL;
+	cgltf_accessor *accessor = NULL;
+	struct accessor_stream stream;
+
+	struct mesh_decode *decode = userData;
+	struct mesh_decode_job *job = &decode->jobs[jobIndex];
+	struct mesh_decode_kernels *kernels = &decode->kernels;
+	struct kmr_gltf_loader_mesh_vertex_data *vertexBufferData = NULL;
+	uint32_t *indexBufferData = NULL;
+
+	/* Each chunk decodes an equal share of the primitive's vertices and indices */
+	vertexStart = ((uint64_t) job->vertexCount * job->chunk) / job->chunkCount;
+	vertexEnd = ((uint64_t) job->vertexCount * (job->chunk + 1)) / job->chunkCount;
+	indexStart = ((uint64_t) job->indexCount * job->chunk) / job->chunkCount;
+	indexEnd = ((uint64_t) job->indexCount * (job->chunk + 1)) / job->chunkCount;
+
+	vertexBufferData = decode->meshData[job->meshIndex].vertexBufferData + job->vertexOffset + vertexStart;
+	indexBufferData = decode->meshData[job->meshIndex].indexBufferData + job->indexOffset + indexStart;
+
+	// color buffer (want values all set to 1.0f). if not defined in meshes->primitive->attribute
+	for (vertexIndex = 0; vertexIndex < (vertexEnd - vertexStart); vertexIndex++)
+		glm_vec3_one(vertexBufferData[vertexIndex].color);
+
+	/*
+	 * Stream elements of each accessor associated with the primitive.
+	 * Mesh->primitive->attribute->accessor->bufferView->buffer
+	 * Mesh->primitive->indices->accessor->bufferView->buffer
+	 * Accessors may live in any buffer, start at any offset inside
+	 * their buffer view and be interleaved with other attributes.
+	 */
+	for (k = 0; k < job->primitive->attributes_count; k++) {
+		// Only first set of TEXCOORD_n/COLOR_n/etc... fit into struct kmr_gltf_loader_mesh_vertex_data
+		if (job->primitive->attributes[k].index != 0)
+			continue;
+
+		accessor = job->primitive->attributes[k].data;
+		if (accessor->count <= vertexStart)
+			continue;
+
+		if (accessor_stream_get(accessor, decode->unpacked[accessor - decode->gltfData->accessors], &stream) == -1)
+			return -1;
+
+		elementCount = ((accessor->count < vertexEnd) ? accessor->count : vertexEnd) - vertexStart;
+
+		switch (job->primitive->attributes[k].type) {
+			case cgltf_attribute_type_texcoord: // Texture Coordinate Buffer
+				if (stream.components < 2)
+					break;
+				accessor_stream_read_float(&stream, vertexStart, elementCount, vertexBufferData->texCoord,
+				                           sizeof(struct kmr_gltf_loader_mesh_vertex_data), 2);
+				break;
+			case cgltf_attribute_type_normal: // Normal buffer
+				if (stream.components < 3)
+					break;
+				if (stream.format == ACCESSOR_FORMAT_F32) {
+					kernels->normal_normalize(vertexBufferData, stream.data + (vertexStart * stream.stride), stream.stride, elementCount);
+				} else {
+					/* Quantized normals: convert in place then normalize */
+					accessor_stream_read_float(&stream, vertexStart, elementCount, vertexBufferData->normal,
+					                           sizeof(struct kmr_gltf_loader_mesh_vertex_data), 3);
+					kernels->normal_normalize(vertexBufferData, (const uint8_t *) vertexBufferData->normal,
+					                          sizeof(struct kmr_gltf_loader_mesh_vertex_data), elementCount);
+				}
+				break;
+			case cgltf_attribute_type_position: // position buffer
+				if (stream.components < 3)
+					break;
+				accessor_stream_read_float(&stream, vertexStart, elementCount, vertexBufferData->position,
+				                           sizeof(struct kmr_gltf_loader_mesh_vertex_data), 3);
+				break;
+			case cgltf_attribute_type_color: // color buffer (alpha of VEC4 colors dropped)
+				if (stream.components < 3)
+					break;
+				accessor_stream_read_float(&stream, vertexStart, elementCount, vertexBufferData->color,
+				                           sizeof(struct kmr_gltf_loader_mesh_vertex_data), 3);
+				break;
+			default:
+				break;
+		}
+	}
+
+	/* Bounds of the chunk, merged per primitive once every chunk is decoded */
+	mesh_bounds_accumulate(vertexBufferData, vertexEnd - vertexStart, job->center,
+	                       job->aabbMin, job->aabbMax, &job->radiusSquared);
+
+	// Store index buffer data
+	if (!job->indexCount)
+		return 0;
+
+	accessor = job->primitive->indices;
+	indexAddress = decode->unpacked[accessor - decode->gltfData->accessors];
+
+	/*
+	 * Index values are rebased by @vertexOffset as every primitive
+	 * of a mesh shares the same vertex array.
+	 */
+	if (indexAddress) {
+		kernels->index_widen_u32(indexBufferData, ((const uint32_t *) indexAddress) + indexStart, indexEnd - indexStart, job->vertexOffset);
+		return 0;
+	}
+
+	indexAddress = cgltf_buffer_view_data(accessor->buffer_view);
+	if (!indexAddress) {
+		kmr_utils_log(KMR_DANGER, "[x] cgltf_buffer_view_data: Buffer belonging to indices accessor not loaded");
+		return -1;
+	}
+
+	indexAddress += accessor->offset + (indexStart * accessor->stride);
+
+	switch (accessor->component_type) {
+		case cgltf_component_type_r_8u:
+			kernels->index_widen_u8(indexBufferData, indexAddress, indexEnd - indexStart, job->vertexOffset);
+			break;
+		case cgltf_component_type_r_16u:
+			kernels->index_widen_u16(indexBufferData, (const uint16_t *) indexAddress, indexEnd - indexStart, job->vertexOffset);
+			break;
+		case cgltf_component_type_r_32u:
+			kernels->index_widen_u32(indexBufferData, (const uint32_t *) indexAddress, indexEnd - indexStart, job->vertexOffset);
+			break;
+		default:
+			kmr_utils_log(KMR_DANGER, "[x] Somethings gone horribly wrong here. GLTF buffer indices section doesn't have correct data type");
+			return -1;
+	}
+
+	return 0;
+}
+
+
+/*
+ * Accessor min/max are given in the accessor's component type (i.e. KHR_mesh_quantization
+ * integers). Apply the same normalization the accessor readers apply.
+ */
+static float
+accessor_bound_convert (cgltf_accessor *accessor, float value)
+{
+	switch (accessor_format_get(accessor->component_type, accessor->normalized)) {
+		case ACCESSOR_FORMAT_S8_NORM:
+			return ACCESSOR_CONVERT_SNORM8(value);
+		case ACCESSOR_FORMAT_U8_NORM:
+			return ACCESSOR_CONVERT_UNORM8(value);
+		case ACCESSOR_FORMAT_S16_NORM:
+			return ACCESSOR_CONVERT_SNORM16(value);
+		case ACCESSOR_FORMAT_U16_NORM:
+			return ACCESSOR_CONVERT_UNORM16(value);
+		default:
+			return value;
+	}
+}
+
+
+/*
+ * Seeds primitive bounds from the POSITION accessor min/max, converted like the positions
+ * themselves. A negative radius marks the bounding sphere center as still unknown.
+ */
+static void
+mesh_primitive_bounds_init (struct kmr_gltf_loader_mesh_primitive *primitive, cgltf_primitive *gltfPrimitive)
+{
+	cgltf_size k;
+	uint32_t a;
+	cgltf_accessor *accessor = NULL;
+
+	for (a = 0; a < 3; a++) {
+		primitive->aabbMin[a] = FLT_MAX;
+		primitive->aabbMax[a] = -FLT_MAX;
+	}
+
+	glm_vec3_zero(primitive->sphereCenter);
+	primitive->sphereRadius = -1.0f;
+
+	for (k = 0; k < gltfPrimitive->attributes_count; k++)
+		if (gltfPrimitive->attributes[k].type == cgltf_attribute_type_position && gltfPrimitive->attributes[k].index == 0)
+			accessor = gltfPrimitive->attributes[k].data;
+
+	if (!accessor || !accessor->has_min || !accessor->has_max || accessor->type != cgltf_type_vec3 ||
+	    accessor_format_get(accessor->component_type, accessor->normalized) == ACCESSOR_FORMAT_INVALID)
+		return;
+
+	for (a = 0; a < 3; a++) {
+		primitive->aabbMin[a] = accessor_bound_convert(accessor, accessor->min[a]);
+		primitive->aabbMax[a] = accessor_bound_convert(accessor, accessor->max[a]);
+		primitive->sphereCenter[a] = (primitive->aabbMin[a] + primitive->aabbMax[a]) * 0.5f;
+	}
+
+	primitive->sphereRadius = 0.0f;
+}
+
+
+/*
+ * Finalizes primitive bounds once every chunk is merged and bounds the whole mesh.
+ * Primitives without accessor min/max only now know their sphere center, measure
+ * the radius with a second pass over their decoded positions.
+ */
+static void
+mesh_bounds_finish (struct kmr_gltf_loader_mesh_data *meshData)
+{
+	uint32_t p, a;
+	float d, distance, radiusSquared;
+	struct kmr_gltf_loader_mesh_primitive *primitive = NULL;
+
+	for (a = 0; a < 3; a++) {
+		meshData->aabbMin[a] = FLT_MAX;
+		meshData->aabbMax[a] = -FLT_MAX;
+	}
+
+	for (p = 0; p < meshData->primitiveCount; p++) {
+		primitive = &meshData->primitives[p];
+		if (!primitive->vertexCount) {
+			glm_vec3_zero(primitive->aabbMin);
+			glm_vec3_zero(primitive->aabbMax);
+			glm_vec3_zero(primitive->sphereCenter);
+			primitive->sphereRadius = 0.0f;
+			continue;
+		}
+
+		if (primitive->sphereRadius < 0.0f) {
+			for (a = 0; a < 3; a++)
+				primitive->sphereCenter[a] = (primitive->aabbMin[a] + primitive->aabbMax[a]) * 0.5f;
+
+			radiusSquared = 0.0f;
+			mesh_bounds_accumulate(meshData->vertexBufferData + primitive->firstVertex, primitive->vertexCount,
+			                       primitive->sphereCenter, primitive->aabbMin, primitive->aabbMax, &radiusSquared);
+			primitive->sphereRadius = sqrtf(radiusSquared);
+		}
+
+		glm_vec3_minv(meshData->aabbMin, primitive->aabbMin, meshData->aabbMin);
+		glm_vec3_maxv(meshData->aabbMax, primitive->aabbMax, meshData->aabbMax);
+	}
+
+	if (meshData->aabbMin[0] > meshData->aabbMax[0]) {
+		glm_vec3_zero(meshData->aabbMin);
+		glm_vec3_zero(meshData->aabbMax);
+	}
+
+	/* Mesh sphere encloses every primitive sphere around the center of the mesh box */
+	for (a = 0; a < 3; a++)
+		meshData->sphereCenter[a] = (meshData->aabbMin[a] + meshData->aabbMax[a]) * 0.5f;
+
+	meshData->sphereRadius = 0.0f;
+	for (p = 0; p < meshData->primitiveCount; p++) {
+		primitive = &meshData->primitives[p];
+		if (!primitive->vertexCount)
+			continue;
+
+		distance = 0.0f;
+		for (a = 0; a < 3; a++) {
+			d = primitive->sphereCenter[a] - meshData->sphereCenter[a];
+			distance += d * d;
+		}
+
+		meshData->sphereRadius = fmaxf(meshData->sphereRadius, sqrtf(distance) + primitive->sphereRadius);
+	}
+}
+
+
+/*
+ * Expand accessors that can't be streamed straight out of a GLTF
+ * buffer (sparse or without buffer view) before decode jobs run.
+ */
+static int
+accessor_unpack (cgltf_accessor *accessor, bool indices, void **unpacked)
+{
+	cgltf_size count;
+
+	if (*unpacked || (accessor->buffer_view && !accessor->is_sparse))
+		return 0;
+
+	if (indices) {
+		*unpacked = calloc(accessor->count, sizeof(uint32_t));
+		if (!*unpacked) {
+			kmr_utils_log(KMR_DANGER, "[x] calloc(unpacked): %s", strerror(errno));
+			return -1;
+		}
+
+		for (count = 0; count < accessor->count; count++)
+			((uint32_t *) *unpacked)[count] = cgltf_accessor_read_index(accessor, count);
+	} else {
+		count = cgltf_num_components(accessor->type) * accessor->count;
+		*unpacked = calloc(count, sizeof(float));
+		if (!*unpacked) {
+			kmr_utils_log(KMR_DANGER, "[x] calloc(unpacked): %s", strerror(errno));
+			return -1;
+		}
+
+		count = cgltf_accessor_unpack_floats(accessor, *unpacked, count);
+	}
+
+	if (!count && accessor->count) {
+		kmr_utils_log(KMR_DANGER, "[x] cgltf_accessor_unpack: Failed to unpack sparse accessor");
+		return -1;
+	}
+
+	return 0;
+}
+
+
+static void
+accessor_unpack_free (void **unpacked, cgltf_size count)
+{
+	cgltf_size i;
+
+	if (!unpacked)
+		return;
+
+	for (i = 0; i < count; i++)
+		free(unpacked[i]);
+	free(unpacked);
+}
+
+
+static uint32_t
+mesh_vertex_hash (const struct kmr_gltf_loader_mesh_vertex_data *vertex)
+{
+	uint32_t i, word, hash = 2166136261u;
+	const uint8_t *bytes = (const uint8_t *) vertex;
+
+	/* FNV-1a over 32-bit words of the vertex */
+	for (i = 0; i < sizeof(struct kmr_gltf_loader_mesh_vertex_data); i += sizeof(uint32_t)) {
+		memcpy(&word, bytes + i, sizeof(uint32_t));
+		hash = (hash ^ word) * 16777619u;
+	}
+
+	return hash ^ (hash >> 16);
+}
+
+
+/*
+ * Welds bit-identical vertices within each indexed primitive of a mesh using an
+ * open addressing hash table. Unique vertices are compacted in place, primitives
+ * stay back to back in the vertex array and their ranges/indices are updated.
+ * Primitives without indices or with out of range indices are only moved.
+ */
+static int
+mesh_weld (struct kmr_gltf_loader_mesh_data *meshData)
+{
+	uint32_t p, i, v, hash, slot, unique, tableSize = 16, maxVertexCount = 0, vertexCount = 0;
+	uint32_t *table = NULL, *remap = NULL, *indices = NULL;
+	bool weld;
+
+	struct kmr_gltf_loader_mesh_vertex_data *vertices = meshData->vertexBufferData, *vertex = NULL;
+	struct kmr_gltf_loader_mesh_primitive *primitive = NULL;
+
+	for (p = 0; p < meshData->primitiveCount; p++)
+		if (meshData->primitives[p].vertexCount > maxVertexCount)
+			maxVertexCount = meshData->primitives[p].vertexCount;
+
+	while (tableSize < (uint64_t) maxVertexCount * 2)
+		tableSize <<= 1;
+
+	table = calloc(tableSize, sizeof(uint32_t));
+	remap = calloc(maxVertexCount + 1, sizeof(uint32_t));
+	if (!table || !remap) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(table): %s", strerror(errno));
+		free(table); free(remap);
+		return -1;
+	}
+
+	for (p = 0; p < meshData->primitiveCount; p++) {
+		primitive = &meshData->primitives[p];
+		indices = meshData->indexBufferData + primitive->firstIndex;
+
+		weld = primitive->indexCount > 0;
+		for (i = 0; weld && i < primitive->indexCount; i++)
+			weld = (indices[i] - primitive->firstVertex) < primitive->vertexCount;
+
+		if (!weld) {
+			memmove(vertices + vertexCount, vertices + primitive->firstVertex,
+			        primitive->vertexCount * sizeof(struct kmr_gltf_loader_mesh_vertex_data));
+			for (i = 0; i < primitive->indexCount; i++)
+				indices[i] = indices[i] - primitive->firstVertex + vertexCount;
+			primitive->firstVertex = vertexCount;
+			vertexCount += primitive->vertexCount;
+			continue;
+		}
+
+		/*
+		 * Unique vertices get written to vertexCount + unique which never
+		 * passes the vertex currently being read. So compaction is safe in place.
+		 */
+		unique = 0;
+		memset(table, 0xff, tableSize * sizeof(uint32_t));
+		for (v = 0; v < primitive->vertexCount; v++) {
+			vertex = &vertices[primitive->firstVertex + v];
+			hash = mesh_vertex_hash(vertex) & (tableSize - 1);
+
+			while ((slot = table[hash]) != UINT32_MAX) {
+				if (!memcmp(&vertices[vertexCount + slot], vertex, sizeof(struct kmr_gltf_loader_mesh_vertex_data)))
+					break;
+				hash = (hash + 1) & (tableSize - 1);
+			}
+
+			if (slot == UINT32_MAX) {
+				slot = table[hash] = unique++;
+				if (vertexCount + slot != primitive->firstVertex + v)
+					vertices[vertexCount + slot] = *vertex;
+			}
+
+			remap[v] = slot;
+		}
+
+		for (i = 0; i < primitive->indexCount; i++)
+			indices[i] = remap[indices[i] - primitive->firstVertex] + vertexCount;
+
+		primitive->firstVertex = vertexCount;
+		primitive->vertexCount = unique;
+		vertexCount += unique;
+	}
+
+	free(table);
+	free(remap);
+
+	meshData->vertexBufferDataCount = vertexCount;
+	meshData->vertexBufferDataSize = vertexCount * sizeof(struct kmr_gltf_loader_mesh_vertex_data);
+
+	return 0;
+}
+
+
+/* Writes decoded 32-bit indices to @dst in struct kmr_gltf_loader_mesh_data { @indexType } */
+static void
+mesh_index_emit (struct kmr_gltf_loader_mesh_data *meshData, void *dst)
+{
+	uint32_t i;
+	uint16_t *indexBufferData16 = dst;
+
+	if (meshData->indexType == VK_INDEX_TYPE_UINT32) {
+		memcpy(dst, meshData->indexBufferData, meshData->indexBufferDataCount * sizeof(uint32_t));
+		return;
+	}
+
+	for (i = 0; i < meshData->indexBufferDataCount; i++)
+		indexBufferData16[i] = (uint16_t) meshData->indexBufferData[i];
+}
+
+
+/* IEEE 754 binary32 to binary16 with round to nearest even */
+static inline uint16_t
+half_from_float (float value)
+{
+	int32_t exponent;
+	uint32_t bits, sign, mantissa, half, shift, remainder;
+
+	memcpy(&bits, &value, sizeof(uint32_t));
+	sign = (bits >> 16) & 0x8000;
+	exponent = (int32_t) ((bits >> 23) & 0xff) - 127 + 15;
+	mantissa = bits & 0x7fffff;
+
+	if (((bits >> 23) & 0xff) == 0xff)
+		return sign | 0x7c00 | ((mantissa) ? 0x200 : 0);
+
+	if (exponent >= 31)
+		return sign | 0x7c00;
+
+	if (exponent <= 0) {
+		if (exponent < -10)
+			return sign;
+
+		mantissa |= 0x800000;
+		shift = 14 - exponent;
+		half = mantissa >> shift;
+		remainder = mantissa & ((1u << shift) - 1);
+		if (remainder > (1u << (shift - 1)) || (remainder == (1u << (shift - 1)) && (half & 1)))
+			half++;
+		return sign | half;
+	}
+
+	half = ((uint32_t) exponent << 10) | (mantissa >> 13);
+	remainder = mantissa & 0x1fff;
+	if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+		half++;
+
+	return sign | half;
+}
+
+
+static inline int16_t
+snorm16_from_float (float value)
+{
+	value = (value > 1.0f) ? 1.0f : (value < -1.0f) ? -1.0f : value;
+	return (int16_t) lroundf(value * 32767.0f);
+}
+
+
+/* Project unit normal onto octahedron then unfold lower hemisphere onto the square */
+static inline void
+octahedral_encode (const float *normal, int16_t *encoded)
+{
+	float x, y, unfoldX, unfoldY;
+	float l1 = fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]);
+
+	if (l1 < FLT_EPSILON) {
+		encoded[0] = encoded[1] = 0;
+		return;
+	}
+
+	x = normal[0] / l1;
+	y = normal[1] / l1;
+	if (normal[2] < 0.0f) {
+		unfoldX = (1.0f - fabsf(y)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+		unfoldY = (1.0f - fabsf(x)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+		x = unfoldX;
+		y = unfoldY;
+	}
+
+	encoded[0] = snorm16_from_float(x);
+	encoded[1] = snorm16_from_float(y);
+}
+
+
+/*
+ * KHR_mesh_quantization: Positions of a mesh whose POSITION accessors all share one integer
+ * component type lie on a grid with 1/grid spacing. Returns the grid (1 for plain integers,
+ * the normalization divisor for normalized ones) if those integers fit snorm16, 0 otherwise.
+ */
+static float
+mesh_position_grid_get (cgltf_mesh *gltfMesh)
+{
+	cgltf_size j, k;
+	enum accessor_format format = ACCESSOR_FORMAT_INVALID, primitiveFormat;
+	cgltf_accessor *accessor = NULL;
+
+	for (j = 0; j < gltfMesh->primitives_count; j++) {
+		for (k = 0; k < gltfMesh->primitives[j].attributes_count; k++) {
+			if (gltfMesh->primitives[j].attributes[k].type != cgltf_attribute_type_position ||
+			    gltfMesh->primitives[j].attributes[k].index != 0)
+				continue;
+
+			accessor = gltfMesh->primitives[j].attributes[k].data;
+			primitiveFormat = accessor_format_get(accessor->component_type, accessor->normalized);
+			if (format != ACCESSOR_FORMAT_INVALID && primitiveFormat != format)
+				return 0.0f;
+
+			format = primitiveFormat;
+		}
+	}
+
+	switch (format) {
+		case ACCESSOR_FORMAT_S8:
+		case ACCESSOR_FORMAT_U8:
+		case ACCESSOR_FORMAT_S16:
+			return 1.0f;
+		case ACCESSOR_FORMAT_S8_NORM:
+			return 127.0f;
+		case ACCESSOR_FORMAT_U8_NORM:
+			return 255.0f;
+		case ACCESSOR_FORMAT_S16_NORM:
+			return 32767.0f;
+		default:
+			return 0.0f;
+	}
+}
+
+
+/*
+ * Writes mesh vertices to @dst as struct kmr_gltf_loader_mesh_vertex_packed. Positions are
+ * quantized relative to the mesh bounding box so the full snorm16 range is used. Positions
+ * already quantized on a @positionGrid (see mesh_position_grid_get()) are passed through as
+ * their original integers instead, which is lossless.
+ */
+static void
+mesh_vertex_pack (struct kmr_gltf_loader_mesh_data *meshData, float positionGrid, void *dst)
+{
+	uint32_t v, c;
+	vec3 min, max;
+
+	struct kmr_gltf_loader_mesh_vertex_data *vertex = NULL;
+	struct kmr_gltf_loader_mesh_vertex_packed *packed = dst;
+
+	if (!meshData->vertexBufferDataCount)
+		return;
+
+	glm_vec3_copy(meshData->vertexBufferData[0].position, min);
+	glm_vec3_copy(meshData->vertexBufferData[0].position, max);
+	for (v = 1; v < meshData->vertexBufferDataCount; v++) {
+		glm_vec3_minv(min, meshData->vertexBufferData[v].position, min);
+		glm_vec3_maxv(max, meshData->vertexBufferData[v].position, max);
+	}
+
+	for (c = 0; c < 3; c++) {
+		if (min[c] * positionGrid < -32767.0f || max[c] * positionGrid > 32767.0f)
+			positionGrid = 0.0f;
+	}
+
+	for (c = 0; c < 3; c++) {
+		if (positionGrid > 0.0f) {
+			meshData->positionOffset[c] = 0.0f;
+			meshData->positionScale[c] = 32767.0f / positionGrid;
+			continue;
+		}
+
+		meshData->positionOffset[c] = (min[c] + max[c]) * 0.5f;
+		meshData->positionScale[c] = (max[c] - min[c]) * 0.5f;
+		if (meshData->positionScale[c] < FLT_MIN)
+			meshData->positionScale[c] = 1.0f;
+	}
+
+	for (v = 0; v < meshData->vertexBufferDataCount; v++) {
+		vertex = &meshData->vertexBufferData[v];
+
+		for (c = 0; c < 3; c++) {
+			if (positionGrid > 0.0f)
+				packed[v].position[c] = (int16_t) lroundf(vertex->position[c] * positionGrid);
+			else
+				packed[v].position[c] = snorm16_from_float((vertex->position[c] - meshData->positionOffset[c]) / meshData->positionScale[c]);
+			packed[v].color[c] = (uint8_t) lroundf(((vertex->color[c] > 1.0f) ? 1.0f : (vertex->color[c] < 0.0f) ? 0.0f : vertex->color[c]) * 255.0f);
+		}
+
+		octahedral_encode(vertex->normal, packed[v].normal);
+		packed[v].texCoord[0] = half_from_float(vertex->texCoord[0]);
+		packed[v].texCoord[1] = half_from_float(vertex->texCoord[1]);
+		packed[v].color[3] = 255;
+	}
+}
+
+
+/* Splits mesh vertices into struct kmr_gltf_loader_mesh_vertex_streams written to @dst */
+static struct kmr_gltf_loader_mesh_vertex_streams
+mesh_vertex_soa (struct kmr_gltf_loader_mesh_data *meshData, void *dst)
+{
+	uint32_t v, count = meshData->vertexBufferDataCount;
+
+	struct kmr_gltf_loader_mesh_vertex_data *vertices = meshData->vertexBufferData;
+	struct kmr_gltf_loader_mesh_vertex_streams streams = mesh_vertex_streams_carve(dst, count);
+
+	for (v = 0; v < count; v++) {
+		glm_vec3_copy(vertices[v].position, streams.position[v]);
+		glm_vec3_copy(vertices[v].normal, streams.normal[v]);
+		glm_vec2_copy(vertices[v].texCoord, streams.texCoord[v]);
+		glm_vec3_copy(vertices[v].color, streams.color[v]);
+	}
+
+	return streams;
+}
+
+
+/*
+ * Assigns every mesh its byte offsets within the arena from the current vertex/index sizes.
+ * Vertices of all meshes come first followed by all indices. Returns the arena size.
+ */
+static uint64_t
+mesh_arena_offsets_set (struct kmr_gltf_loader_mesh_data *meshData, uint32_t meshDataCount)
+{
+	uint32_t i;
+	uint64_t offset = 0;
+
+	for (i = 0; i < meshDataCount; i++) {
+		meshData[i].vertexBufferDataOffset = offset;
+		offset += meshData[i].vertexBufferDataSize;
+	}
+
+	offset = MESH_ARENA_ALIGN(offset);
+	for (i = 0; i < meshDataCount; i++) {
+		meshData[i].indexBufferDataOffset = offset;
+		offset += MESH_ARENA_ALIGN(meshData[i].indexBufferDataSize);
+	}
+
+	return offset;
+}
+
+
+/* Points interleaved vertex and 32-bit index arrays of every mesh into @arena */
+static void
+mesh_arena_pointers_set (struct kmr_gltf_loader_mesh_data *meshData, uint32_t meshDataCount, uint8_t *arena)
+{
+	uint32_t i;
+
+	for (i = 0; i < meshDataCount; i++) {
+		if (meshData[i].vertexBufferDataCount)
+			meshData[i].vertexBufferData = (struct kmr_gltf_loader_mesh_vertex_data *) (arena + meshData[i].vertexBufferDataOffset);
+		if (meshData[i].indexBufferDataCount)
+			meshData[i].indexBufferData = (uint32_t *) (arena + meshData[i].indexBufferDataOffset);
+	}
+}
+
+
+static inline uint32_t
+mesh_vertex_layout_size_get (enum kmr_gltf_loader_mesh_vertex_layout vertexLayout)
+{
+	return (vertexLayout == KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_PACKED) ?
+		sizeof(struct kmr_gltf_loader_mesh_vertex_packed) : sizeof(struct kmr_gltf_loader_mesh_vertex_data);
+}
+
+
+struct mesh_postprocess {
+	cgltf_data                              *gltfData;
+	struct kmr_gltf_loader_mesh_data        *meshData;
+	enum kmr_gltf_loader_mesh_vertex_layout vertexLayout;
+	uint8_t                                 *arena;
+};
+
+
+/* Post-process steps that change the size of a mesh run once all of its primitives are decoded */
+static int
+mesh_weld_job_run (void *userData, uint32_t jobIndex)
+{
+	struct mesh_postprocess *postprocess = userData;
+	return mesh_weld(&postprocess->meshData[jobIndex]);
+}
+
+
+/*
+ * Writes a mesh from the decode arena into its final place within the mesh arena
+ * converting vertices to the requested layout and indices to the chosen index type.
+ */
+static int
+mesh_emit_job_run (void *userData, uint32_t jobIndex)
+{
+	struct mesh_postprocess *postprocess = userData;
+	struct kmr_gltf_loader_mesh_data *meshData = &postprocess->meshData[jobIndex];
+	uint8_t *vertexDst = postprocess->arena + meshData->vertexBufferDataOffset;
+	uint8_t *indexDst = postprocess->arena + meshData->indexBufferDataOffset;
+
+	if (meshData->indexBufferDataCount) {
+		mesh_index_emit(meshData, indexDst);
+		meshData->indexBufferData = (uint32_t *) indexDst;
+	}
+
+	if (!meshData->vertexBufferDataCount)
+		return 0;
+
+	switch (postprocess->vertexLayout) {
+		case KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_PACKED:
+			mesh_vertex_pack(meshData, (postprocess->gltfData) ? mesh_position_grid_get(&postprocess->gltfData->meshes[jobIndex]) : 0.0f,
+			                 vertexDst);
+			meshData->vertexBufferDataPacked = (struct kmr_gltf_loader_mesh_vertex_packed *) vertexDst;
+			break;
+		case KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_SOA:
+			meshData->vertexStreams = mesh_vertex_soa(meshData, vertexDst);
+			break;
+		default:
+			memcpy(vertexDst, meshData->vertexBufferData, meshData->vertexBufferDataSize);
+			meshData->vertexBufferData = (struct kmr_gltf_loader_mesh_vertex_data *) vertexDst;
+			break;
+	}
+
+	return 0;
+}
+
+
+/*
+ * Welds, lays out the mesh arena then writes every mesh from the decode arena @meshData
+ * currently points into to its final place within the mesh arena. Bounds must be final.
+ */
+static int
+mesh_postprocess_run (struct kmr_gltf_loader_mesh *mesh, cgltf_data *gltfData, uint32_t threadCount,
+                      enum kmr_gltf_loader_mesh_create_flags flags, void *externalArena, uint32_t externalArenaSize)
+{
+	uint32_t i;
+	uint64_t arenaSize;
+	uint8_t *arena = NULL;
+
+	struct kmr_gltf_loader_mesh_data *meshData = mesh->meshData;
+	struct mesh_postprocess postprocess;
+	struct kmr_utils_worker_pool_run_info workerPoolRunInfo;
+
+	postprocess.gltfData = gltfData;
+	postprocess.meshData = meshData;
+	postprocess.vertexLayout = mesh->vertexLayout;
+	workerPoolRunInfo.threadCount = threadCount;
+	workerPoolRunInfo.jobCount = mesh->meshDataCount;
+	workerPoolRunInfo.userData = &postprocess;
+
+	if (flags & KMR_GLTF_LOADER_MESH_CREATE_WELD) {
+		workerPoolRunInfo.job = mesh_weld_job_run;
+		if (kmr_utils_worker_pool_run(&workerPoolRunInfo) == -1)
+			return -1;
+	}
+
+	/* Sizes are final once welded, lay out the mesh arena */
+	for (i = 0; i < mesh->meshDataCount; i++) {
+		if ((flags & KMR_GLTF_LOADER_MESH_CREATE_INDEX_DOWNSIZE) &&
+		    meshData[i].indexBufferDataCount && meshData[i].vertexBufferDataCount <= UINT16_MAX)
+		{
+			meshData[i].indexType = VK_INDEX_TYPE_UINT16;
+			meshData[i].indexBufferDataSize = meshData[i].indexBufferDataCount * sizeof(uint16_t);
+		}
+
+		meshData[i].vertexBufferDataSize = meshData[i].vertexBufferDataCount * mesh_vertex_layout_size_get(mesh->vertexLayout);
+	}
+
+	/* Offsets within the arena are 32-bit */
+	arenaSize = mesh_arena_offsets_set(meshData, mesh->meshDataCount);
+	if (arenaSize > UINT32_MAX) {
+		kmr_utils_log(KMR_DANGER, "[x] mesh_postprocess_run: Mesh data exceeds %" PRIu32 " bytes", UINT32_MAX);
+		return -1;
+	}
+
+	if (externalArena) {
+		if (externalArenaSize < arenaSize) {
+			kmr_utils_log(KMR_DANGER, "[x] mesh_postprocess_run: arena of %u bytes too small, %" PRIu64 " bytes required",
+			              externalArenaSize, arenaSize);
+			return -1;
+		}
+
+		arena = externalArena;
+	} else if (arenaSize) {
+		arena = malloc(arenaSize);
+		if (!arena) {
+			kmr_utils_log(KMR_DANGER, "[x] malloc(arena): %s", strerror(errno));
+			return -1;
+		}
+	}
+
+	mesh->arena = arena;
+	mesh->arenaSize = arenaSize;
+	mesh->arenaExternal = !!externalArena;
+
+	postprocess.arena = arena;
+	workerPoolRunInfo.job = mesh_emit_job_run;
+	if (kmr_utils_worker_pool_run(&workerPoolRunInfo) == -1)
+		return -1;
+
+	return 0;
+}
+
+
+struct kmr_gltf_loader_mesh *
+kmr_gltf_loader_mesh_create (struct kmr_gltf_loader_mesh_create_info *meshInfo)
+{
+	cgltf_size i, j, k;
+	uint32_t c, chunkCount, primitiveCount = 0, jobCount = 0, firstIndex = 0;
+	uint32_t vertexCount, indexCount, vertexOffset, indexOffset;
+	uint64_t decodeArenaSize;
+	uint8_t *decodeArena = NULL;
+	bool direct;
+
+	cgltf_data *gltfData = NULL;
+	cgltf_primitive *primitive = NULL;
+	cgltf_accessor *accessor = NULL;
+
+	struct mesh_decode decode;
+	struct mesh_decode_job *jobs = NULL;
+	void **unpacked = NULL;
+	struct kmr_utils_worker_pool_run_info workerPoolRunInfo;
+
+	struct kmr_gltf_loader_mesh *mesh = NULL;
+	struct kmr_gltf_loader_mesh_data *meshData = NULL;
+	struct kmr_gltf_loader_mesh_primitive *primitives = NULL;
+
+	mesh = calloc(1, sizeof(struct kmr_gltf_loader_mesh));
+	if (!mesh) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(mesh): %s", strerror(errno));
+		return NULL;
+	}
+
+	gltfData = meshInfo->gltfFile->gltfData;
+	for (i = 0; i < gltfData->meshes_count; i++)
+		primitiveCount += gltfData->meshes[i].primitives_count;
+
+	/*
+	 * Allocate large enough buffer to store all mesh data in array.
+	 * Primitive arrays of every mesh trail the mesh data array.
+	 */
+	meshData = calloc(1, (gltfData->meshes_count * sizeof(struct kmr_gltf_loader_mesh_data)) +
+	                     (primitiveCount * sizeof(struct kmr_gltf_loader_mesh_primitive)));
+	if (!meshData) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(meshData): %s", strerror(errno));
+		goto exit_error_kmr_gltf_loader_mesh_create;
+	}
+
+	unpacked = calloc(gltfData->accessors_count + 1, sizeof(void *));
+	if (!unpacked) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(unpacked): %s", strerror(errno));
+		goto exit_error_kmr_gltf_loader_mesh_create;
+	}
+
+	mesh->bufferIndex = meshInfo->bufferIndex;
+	mesh->meshData = meshData;
+	mesh->meshDataCount = gltfData->meshes_count;
+	mesh->vertexLayout = meshInfo->vertexLayout;
+	primitives = (struct kmr_gltf_loader_mesh_primitive *) (meshData + gltfData->meshes_count);
+
+	/*
+	 * First pass: Acquire the amount of vertices and indices belonging
+	 * to each mesh. All primitives of a mesh are stored back to back
+	 * in the same vertex and index array.
+	 */
+	for (i = 0; i < gltfData->meshes_count; i++) {
+		for (j = 0; j < gltfData->meshes[i].primitives_count; j++) {
+			primitive = &gltfData->meshes[i].primitives[j];
+			vertexCount = primitive_vertex_count_get(primitive);
+			indexCount = (primitive->indices) ? primitive->indices->count : 0;
+
+			for (k = 0; k < primitive->attributes_count; k++) {
+				accessor = primitive->attributes[k].data;
+				if (accessor_unpack(accessor, false, &unpacked[accessor - gltfData->accessors]) == -1)
+					goto exit_error_kmr_gltf_loader_mesh_create;
+			}
+
+			if (indexCount && accessor_unpack(primitive->indices, true, &unpacked[primitive->indices - gltfData->accessors]) == -1)
+				goto exit_error_kmr_gltf_loader_mesh_create;
+
+			meshData[i].vertexBufferDataCount += vertexCount;
+			meshData[i].indexBufferDataCount += indexCount;
+			jobCount += (((vertexCount > indexCount) ? vertexCount : indexCount) / MESH_DECODE_JOB_ELEMENT_COUNT) + 1;
+		}
+
+		meshData[i].vertexBufferDataSize = meshData[i].vertexBufferDataCount * sizeof(struct kmr_gltf_loader_mesh_vertex_data);
+		meshData[i].indexBufferDataSize = meshData[i].indexBufferDataCount * sizeof(uint32_t);
+
+		if (gltfData->meshes[i].primitives_count) {
+			meshData[i].primitives = primitives;
+			meshData[i].primitiveCount = gltfData->meshes[i].primitives_count;
+			primitives += meshData[i].primitiveCount;
+		}
+
+		meshData[i].firstIndex = firstIndex;
+		meshData[i].indexType = VK_INDEX_TYPE_UINT32;
+		glm_vec3_one(meshData[i].positionScale);
+		glm_vec3_zero(meshData[i].positionOffset);
+		firstIndex += meshData[i].indexBufferDataCount;
+	}
+
+	decodeArenaSize = mesh_arena_offsets_set(meshData, gltfData->meshes_count);
+	if (decodeArenaSize > UINT32_MAX) {
+		kmr_utils_log(KMR_DANGER, "[x] kmr_gltf_loader_mesh_create: Mesh data exceeds %" PRIu32 " bytes", UINT32_MAX);
+		goto exit_error_kmr_gltf_loader_mesh_create;
+	}
+
+	/*
+	 * Meshes that aren't welded, downsized or converted are decoded directly into
+	 * their final place. Otherwise decode into a temporary arena and emit later.
+	 */
+	direct = !meshInfo->flags && meshInfo->vertexLayout == KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_INTERLEAVED;
+	if (direct && meshInfo->arena) {
+		if (meshInfo->arenaSize < decodeArenaSize) {
+			kmr_utils_log(KMR_DANGER, "[x] kmr_gltf_loader_mesh_create: arena of %u bytes too small, %" PRIu64 " bytes required",
+			              meshInfo->arenaSize, decodeArenaSize);
+			goto exit_error_kmr_gltf_loader_mesh_create;
+		}
+
+		decodeArena = meshInfo->arena;
+		memset(decodeArena, 0, decodeArenaSize);
+	} else if (decodeArenaSize) {
+		decodeArena = calloc(1, decodeArenaSize);
+		if (!decodeArena) {
+			kmr_utils_log(KMR_DANGER, "[x] calloc(decodeArena): %s", strerror(errno));
+			goto exit_error_kmr_gltf_loader_mesh_create;
+		}
+	}
+
+	mesh_arena_pointers_set(meshData, gltfData->meshes_count, decodeArena);
+	if (direct) {
+		mesh->arena = decodeArena;
+		mesh->arenaSize = decodeArenaSize;
+		mesh->arenaExternal = !!meshInfo->arena;
+	}
+
+	jobs = calloc(jobCount, sizeof(struct mesh_decode_job));
+	if (!jobs) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(jobs): %s", strerror(errno));
+		goto exit_error_kmr_gltf_loader_mesh_create;
+	}
+
+	/* Second pass: Calculate where each primitive lands in the mesh arrays */
+	jobCount = 0;
+	for (i = 0; i < gltfData->meshes_count; i++) {
+		vertexOffset = indexOffset = 0;
+		for (j = 0; j < gltfData->meshes[i].primitives_count; j++) {
+			primitive = &gltfData->meshes[i].primitives[j];
+			vertexCount = primitive_vertex_count_get(primitive);
+			indexCount = (primitive->indices) ? primitive->indices->count : 0;
+			chunkCount = (((vertexCount > indexCount) ? vertexCount : indexCount) / MESH_DECODE_JOB_ELEMENT_COUNT) + 1;
+
+			meshData[i].primitives[j].type = primitive->type;
+			meshData[i].primitives[j].materialIndex = (primitive->material) ? cgltf_material_index(gltfData, primitive->material) : UINT32_MAX;
+			meshData[i].primitives[j].firstIndex = indexOffset;
+			meshData[i].primitives[j].indexCount = indexCount;
+			meshData[i].primitives[j].firstVertex = vertexOffset;
+			meshData[i].primitives[j].vertexCount = vertexCount;
+			mesh_primitive_bounds_init(&meshData[i].primitives[j], primitive);
+
+			for (c = 0; c < chunkCount; c++) {
+				jobs[jobCount].meshIndex = i;
+				jobs[jobCount].primitiveIndex = j;
+				jobs[jobCount].primitive = primitive;
+				jobs[jobCount].vertexOffset = vertexOffset;
+				jobs[jobCount].vertexCount = vertexCount;
+				jobs[jobCount].indexOffset = indexOffset;
+				jobs[jobCount].indexCount = indexCount;
+				jobs[jobCount].chunk = c;
+				jobs[jobCount].chunkCount = chunkCount;
+				jobs[jobCount].center = (meshData[i].primitives[j].sphereRadius < 0.0f) ? NULL : meshData[i].primitives[j].sphereCenter;
+				memcpy(jobs[jobCount].aabbMin, meshData[i].primitives[j].aabbMin, sizeof(vec3));
+				memcpy(jobs[jobCount].aabbMax, meshData[i].primitives[j].aabbMax, sizeof(vec3));
+				jobs[jobCount].radiusSquared = 0.0f;
+				jobCount++;
+			}
+
+			vertexOffset += vertexCount;
+			indexOffset += indexCount;
+		}
+	}
+
+	decode.gltfData = gltfData;
+	decode.unpacked = unpacked;
+	decode.meshData = meshData;
+	decode.jobs = jobs;
+	mesh_decode_kernels_get(&decode.kernels);
+
+	workerPoolRunInfo.threadCount = meshInfo->threadCount;
+	workerPoolRunInfo.jobCount = jobCount;
+	workerPoolRunInfo.job = mesh_decode_job_run;
+	workerPoolRunInfo.userData = &decode;
+
+	if (kmr_utils_worker_pool_run(&workerPoolRunInfo) == -1)
+		goto exit_error_kmr_gltf_loader_mesh_create;
+
+	/* Merge chunk bounds into their primitive, welding and layout conversion don't move positions */
+	for (c = 0; c < jobCount; c++) {
+		primitives = &meshData[jobs[c].meshIndex].primitives[jobs[c].primitiveIndex];
+		glm_vec3_minv(primitives->aabbMin, jobs[c].aabbMin, primitives->aabbMin);
+		glm_vec3_maxv(primitives->aabbMax, jobs[c].aabbMax, primitives->aabbMax);
+		if (jobs[c].center)
+			primitives->sphereRadius = fmaxf(primitives->sphereRadius, sqrtf(jobs[c].radiusSquared));
+	}
+
+	for (i = 0; i < gltfData->meshes_count; i++)
+		mesh_bounds_finish(&meshData[i]);
+
+	if (direct)
+		goto exit_kmr_gltf_loader_mesh_create;
+
+	if (mesh_postprocess_run(mesh, gltfData, meshInfo->threadCount, meshInfo->flags, meshInfo->arena, meshInfo->arenaSize) == -1)
+		goto exit_error_kmr_gltf_loader_mesh_create;
+
+	free(decodeArena);
+
+exit_kmr_gltf_loader_mesh_create:
+	accessor_unpack_free(unpacked, gltfData->accessors_count);
+	free(jobs);
+	return mesh;
+
+exit_error_kmr_gltf_loader_mesh_create:
+	if (decodeArena != mesh->arena && decodeArena != meshInfo->arena)
+		free(decodeArena);
+	accessor_unpack_free(unpacked, gltfData->accessors_count);
+	free(jobs);
+	kmr_gltf_loader_mesh_destroy(mesh);
+	return NULL;
+}
+
+
+uint64_t
+kmr_gltf_loader_mesh_arena_size_get (struct kmr_gltf_loader_mesh_create_info *meshInfo)
+{
+	cgltf_size i, j;
+	uint32_t vertexCount, indexCount, indexSize;
+	uint64_t vertexArenaSize = 0, indexArenaSize = 0;
+
+	cgltf_data *gltfData = meshInfo->gltfFile->gltfData;
+
+	/* Welding only ever shrinks a mesh, so sizes before welding are an upper bound */
+	for (i = 0; i < gltfData->meshes_count; i++) {
+		vertexCount = indexCount = 0;
+		for (j = 0; j < gltfData->meshes[i].primitives_count; j++) {
+			vertexCount += primitive_vertex_count_get(&gltfData->meshes[i].primitives[j]);
+			indexCount += (gltfData->meshes[i].primitives[j].indices) ? gltfData->meshes[i].primitives[j].indices->count : 0;
+		}
+
+		indexSize = ((meshInfo->flags & KMR_GLTF_LOADER_MESH_CREATE_INDEX_DOWNSIZE) && vertexCount <= UINT16_MAX) ?
+		            sizeof(uint16_t) : sizeof(uint32_t);
+
+		vertexArenaSize += (uint64_t) vertexCount * mesh_vertex_layout_size_get(meshInfo->vertexLayout);
+		indexArenaSize += MESH_ARENA_ALIGN((uint64_t) indexCount * indexSize);
+	}
+
+	return MESH_ARENA_ALIGN(vertexArenaSize) + indexArenaSize;
+}
+
+
+int
+kmr_gltf_loader_mesh_emit (struct kmr_gltf_loader_mesh_emit_info *emitInfo)
+{
+	uint32_t i;
+
+	struct kmr_gltf_loader_mesh *mesh = emitInfo->mesh;
+
+	for (i = 0; i < mesh->meshDataCount; i++)
+		mesh_bounds_finish(&mesh->meshData[i]);
+
+	return mesh_postprocess_run(mesh, NULL, emitInfo->threadCount, emitInfo->flags, emitInfo->arena, emitInfo->arenaSize);
+}
+
+
+void
+kmr_gltf_loader_mesh_destroy (struct kmr_gltf_loader_mesh *mesh)
+{
+	if (!mesh)
+		return;
+
+	if (!mesh->arenaExternal)
+		free(mesh->arena);
+
+	free(mesh->meshData);
+	free(mesh);
+}
+
+/**********************************************************
+ * END OF kmr_gltf_loader_mesh_{create,destroy} FUNCTIONS *
+ **********************************************************/
+
+
+/****************************************************
+ * START OF kmr_gltf_loader_mesh_optimize FUNCTIONS *
+ ****************************************************/
+
+#define MESH_OPTIMIZE_CACHE_SIZE_DEFAULT 16
+
+
+static inline void
+mesh_index_set (struct kmr_gltf_loader_mesh_data *meshData, uint32_t i, uint32_t index)
+{
+	if (meshData->indexType == VK_INDEX_TYPE_UINT16)
+		meshData->indexBufferData16[i] = (uint16_t) index;
+	else
+		meshData->indexBufferData[i] = index;
+}
+
+
+/*
+ * Scratch memory used while optimizing a single primitive. Sized
+ * for the largest primitive of a mesh so it's only allocated once
+ * per mesh.
+ *
+ * @adjacencyOffsets - Per vertex offset into @adjacency (vertexCount + 1)
+ * @adjacency        - Triangles using each vertex (indexCount)
+ * @liveCount        - Per vertex amount of triangles not yet emitted (vertexCount)
+ * @cacheTime        - Per vertex time stamp of when it entered the cache (vertexCount)
+ * @deadEnd          - Stack of recently referenced vertices (indexCount)
+ * @emitted          - Per triangle flag (indexCount / 3)
+ * @source           - Primitive local 32-bit copy of mesh indices (indexCount)
+ * @indices          - Reordered indices (indexCount)
+ * @remap            - Per vertex new location (vertexCount)
+ * @vertices         - Reordered vertices of one vertex stream (vertexCount * largest vertex stride)
+ */
+struct mesh_optimize_scratch {
+	uint32_t                                *adjacencyOffsets;
+	uint32_t                                *adjacency;
+	uint32_t                                *liveCount;
+	uint32_t                                *cacheTime;
+	uint32_t                                *deadEnd;
+	uint8_t                                 *emitted;
+	uint32_t                                *source;
+	uint32_t                                *indices;
+	uint32_t                                *remap;
+	uint8_t                                 *vertices;
+};
+
+
+struct mesh_optimize {
+	struct kmr_gltf_loader_mesh *mesh;
+	uint32_t                    cacheSize;
+};
+
+
+static void
+mesh_optimize_scratch_free (struct mesh_optimize_scratch *scratch)
+{
+	free(scratch->adjacencyOffsets);
+	free(scratch->adjacency);
+	free(scratch->liveCount);
+	free(scratch->cacheTime);
+	free(scratch->deadEnd);
+	free(scratch->emitted);
+	free(scratch->source);
+	free(scratch->indices);
+	free(scratch->remap);
+	free(scratch->vertices);
+}
+
+
+static int
+mesh_optimize_scratch_alloc (struct mesh_optimize_scratch *scratch, uint32_t vertexCount, uint32_t indexCount)
+{
+	memset(scratch, 0, sizeof(struct mesh_optimize_scratch));
+
+	scratch->adjacencyOffsets = calloc(vertexCount + 1, sizeof(uint32_t));
+	scratch->adjacency = calloc(indexCount, sizeof(uint32_t));
+	scratch->liveCount = calloc(vertexCount, sizeof(uint32_t));
+	scratch->cacheTime = calloc(vertexCount, sizeof(uint32_t));
+	scratch->deadEnd = calloc(indexCount, sizeof(uint32_t));
+	scratch->emitted = calloc(indexCount / 3 + 1, sizeof(uint8_t));
+	scratch->source = calloc(indexCount, sizeof(uint32_t));
+	scratch->indices = calloc(indexCount, sizeof(uint32_t));
+	scratch->remap = calloc(vertexCount, sizeof(uint32_t));
+	scratch->vertices = calloc(vertexCount, sizeof(struct kmr_gltf_loader_mesh_vertex_data));
+
+	if (!scratch->adjacencyOffsets || !scratch->adjacency || !scratch->liveCount ||
+	    !scratch->cacheTime || !scratch->deadEnd || !scratch->emitted || !scratch->source ||
+	    !scratch->indices || !scratch->remap || !scratch->vertices)
+	{
+		kmr_utils_log(KMR_DANGER, "[x] calloc(scratch): %s", strerror(errno));
+		mesh_optimize_scratch_free(scratch);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/*
+ * Tipsify: Fans around the most recently cached vertex emitting all of its
+ * remaining triangles. The next fanning vertex is the one referenced by the
+ * last fan that will still be in the cache after its triangles are emitted.
+ * On a dead end, fall back to the most recently referenced vertex with live
+ * triangles, then to the next vertex in input order.
+ *
+ * @indices are local to the primitive (0 <= index < @vertexCount).
+ */
+static void
+mesh_optimize_tipsify (struct mesh_optimize_scratch *scratch, const uint32_t *indices,
+                       uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+{
+	uint32_t i, a, v, t, fanning, best, priority, candidates;
+	uint32_t time = cacheSize + 1, cursor = 0, deadEndCount = 0, out = 0;
+	uint32_t triangleCount = indexCount / 3;
+	int64_t bestPriority;
+
+	uint32_t *adjacencyOffsets = scratch->adjacencyOffsets;
+	uint32_t *adjacency = scratch->adjacency;
+	uint32_t *liveCount = scratch->liveCount;
+	uint32_t *cacheTime = scratch->cacheTime;
+	uint32_t *deadEnd = scratch->deadEnd;
+
+	/* Build vertex -> triangle adjacency */
+	memset(liveCount, 0, vertexCount * sizeof(uint32_t));
+	for (i = 0; i < triangleCount * 3; i++)
+		liveCount[indices[i]]++;
+
+	adjacencyOffsets[0] = 0;
+	for (v = 0; v < vertexCount; v++) {
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveCount[v];
+		cacheTime[v] = adjacencyOffsets[v];
+	}
+
+	for (i = 0; i < triangleCount * 3; i++)
+		adjacency[cacheTime[indices[i]]++] = i / 3;
 
-	gltfFile = calloc(1, sizeof(struct kmr_gltf_loader_file));
-	if (!gltfFile) {
-		kmr_utils_log(KMR_DANGER, "[x] calloc: %s", strerror(errno));
-		return NULL;
+	memset(cacheTime, 0, vertexCount * sizeof(uint32_t));
+	memset(scratch->emitted, 0, triangleCount);
+
+	fanning = 0;
+	while (fanning != UINT32_MAX) {
+		candidates = deadEndCount;
+
+		for (a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; a++) {
+			t = adjacency[a];
+			if (scratch->emitted[t])
+				continue;
+
+			for (i = 0; i < 3; i++) {
+				v = indices[(t * 3) + i];
+				scratch->indices[out++] = v;
+				deadEnd[deadEndCount++] = v;
+				liveCount[v]--;
+				if (time - cacheTime[v] > cacheSize)
+					cacheTime[v] = time++;
+			}
+
+			scratch->emitted[t] = 1;
+		}
+
+		/* Pick vertex from last fan that stays in cache after emitting its remaining triangles */
+		best = UINT32_MAX; bestPriority = -1;
+		for (a = candidates; a < deadEndCount; a++) {
+			v = deadEnd[a];
+			if (!liveCount[v])
+				continue;
+
+			priority = 0;
+			if ((time - cacheTime[v]) + (2 * liveCount[v]) <= cacheSize)
+				priority = time - cacheTime[v];
+
+			if ((int64_t) priority > bestPriority) {
+				bestPriority = priority;
+				best = v;
+			}
+		}
+
+		while (best == UINT32_MAX && deadEndCount) {
+			v = deadEnd[--deadEndCount];
+			if (liveCount[v])
+				best = v;
+		}
+
+		while (best == UINT32_MAX && cursor < vertexCount) {
+			if (liveCount[cursor])
+				best = cursor;
+			cursor++;
+		}
+
+		fanning = best;
 	}
+}
 
-	memset(&options, 0, sizeof(cgltf_options));
-	res = cgltf_parse_file(&options, gltfFileInfo->fileName, &gltfFile->gltfData);
-	if (res != cgltf_result_success) {
-		kmr_utils_log(KMR_DANGER, "[x] cgltf_parse_file: Could not load %s", gltfFileInfo->fileName);
-		goto exit_error_kmr_gltf_loader_file_load;
+
+/* Misses of a FIFO vertex cache over @indices local to a primitive */
+static uint32_t
+mesh_optimize_cache_misses (uint32_t *cacheTime, const uint32_t *indices, uint32_t indexCount,
+                            uint32_t vertexCount, uint32_t cacheSize)
+{
+	uint32_t i, time = cacheSize + 1, misses = 0;
+
+	memset(cacheTime, 0, vertexCount * sizeof(uint32_t));
+	for (i = 0; i < indexCount; i++) {
+		if (time - cacheTime[indices[i]] > cacheSize) {
+			cacheTime[indices[i]] = time++;
+			misses++;
+		}
 	}
 
-	res = cgltf_load_buffers(&options, gltfFile->gltfData, gltfFileInfo->fileName);
-	if (res != cgltf_result_success) {
-		kmr_utils_log(KMR_DANGER, "[x] cgltf_load_buffers: Could not load buffers in %s", gltfFileInfo->fileName);
-		goto exit_error_kmr_gltf_loader_file_load;
+	return misses;
+}
+
+
+static void
+mesh_optimize_primitive (struct mesh_optimize_scratch *scratch, struct kmr_gltf_loader_mesh_data *meshData,
+                         struct kmr_gltf_loader_mesh_primitive *primitive, uint32_t cacheSize,
+                         struct mesh_vertex_stream *streams, uint32_t streamCount)
+{
+	uint32_t i, v, s, next = 0;
+	uint32_t indexCount = primitive->indexCount - (primitive->indexCount % 3);
+	uint32_t *indices = scratch->source;
+	uint8_t *vertices = NULL;
+
+	/* Index values within primitive were rebased by mesh_decode_job_run() */
+	for (i = 0; i < primitive->indexCount; i++) {
+		indices[i] = mesh_index_get(meshData, primitive->firstIndex + i) - primitive->firstVertex;
+		if (indices[i] >= primitive->vertexCount) {
+			kmr_utils_log(KMR_WARNING, "[!] Primitive index %u out of range, skipping optimization",
+			              indices[i] + primitive->firstVertex);
+			return;
+		}
 	}
 
-	res = cgltf_validate(gltfFile->gltfData);
-	if (res != cgltf_result_success) {
-		kmr_utils_log(KMR_DANGER, "[x] cgltf_validate: Failed to load content in %s", gltfFileInfo->fileName);
-		goto exit_error_kmr_gltf_loader_file_load;
+	/* Small primitives may already be close to optimal, keep authored order if Tipsify doesn't help */
+	mesh_optimize_tipsify(scratch, indices, indexCount, primitive->vertexCount, cacheSize);
+	if (mesh_optimize_cache_misses(scratch->cacheTime, scratch->indices, indexCount, primitive->vertexCount, cacheSize) <
+	    mesh_optimize_cache_misses(scratch->cacheTime, indices, indexCount, primitive->vertexCount, cacheSize))
+	{
+		memcpy(indices, scratch->indices, indexCount * sizeof(uint32_t));
 	}
 
-	return gltfFile;
+	/* Vertex fetch: Lay vertices out in order of first use. Unused vertices go last. */
+	memset(scratch->remap, 0xff, primitive->vertexCount * sizeof(uint32_t));
+	for (i = 0; i < primitive->indexCount; i++)
+		if (scratch->remap[indices[i]] == UINT32_MAX)
+			scratch->remap[indices[i]] = next++;
+
+	for (v = 0; v < primitive->vertexCount; v++)
+		if (scratch->remap[v] == UINT32_MAX)
+			scratch->remap[v] = next++;
+
+	for (s = 0; s < streamCount; s++) {
+		vertices = streams[s].data + (primitive->firstVertex * streams[s].stride);
+		for (v = 0; v < primitive->vertexCount; v++)
+			memcpy(scratch->vertices + (scratch->remap[v] * streams[s].stride), vertices + (v * streams[s].stride), streams[s].stride);
+		memcpy(vertices, scratch->vertices, primitive->vertexCount * streams[s].stride);
+	}
 
-exit_error_kmr_gltf_loader_file_load:
-	kmr_gltf_loader_file_destroy(gltfFile);
-	return NULL;
+	for (i = 0; i < primitive->indexCount; i++)
+		mesh_index_set(meshData, primitive->firstIndex + i, scratch->remap[indices[i]] + primitive->firstVertex);
 }
 
 
-void
-kmr_gltf_loader_file_destroy (struct kmr_gltf_loader_file *gltfFile)
+static int
+mesh_optimize_job_run (void *userData, uint32_t jobIndex)
 {
-	if (!gltfFile)
-		return;
+	uint32_t p, streamCount, vertexCount = 0, indexCount = 0;
+	struct mesh_optimize_scratch scratch;
+	struct mesh_vertex_stream streams[KMR_GLTF_LOADER_MESH_VERTEX_ATTRIBUTE_COUNT];
+	struct mesh_optimize *optimize = userData;
+	struct kmr_gltf_loader_mesh_data *meshData = &optimize->mesh->meshData[jobIndex];
+	struct kmr_gltf_loader_mesh_primitive *primitive = NULL;
+
+	for (p = 0; p < meshData->primitiveCount; p++) {
+		primitive = &meshData->primitives[p];
+		if (primitive->type != cgltf_primitive_type_triangles || primitive->indexCount < 3)
+			continue;
+
+		vertexCount = (primitive->vertexCount > vertexCount) ? primitive->vertexCount : vertexCount;
+		indexCount = (primitive->indexCount > indexCount) ? primitive->indexCount : indexCount;
+	}
 
-	cgltf_free(gltfFile->gltfData);
-	free(gltfFile);
-}
+	if (!indexCount)
+		return 0;
 
-/**********************************************************
- * END OF kmr_gltf_loader_file_{create,destroy} FUNCTIONS *
- **********************************************************/
+	if (mesh_optimize_scratch_alloc(&scratch, vertexCount, indexCount) == -1)
+		return -1;
 
+	streamCount = mesh_vertex_streams_get(meshData, optimize->mesh->vertexLayout, streams);
 
-/************************************************************
- * START OF kmr_gltf_loader_mesh_{create,destroy} FUNCTIONS *
- ************************************************************/
+	for (p = 0; p < meshData->primitiveCount; p++) {
+		primitive = &meshData->primitives[p];
+		if (primitive->type != cgltf_primitive_type_triangles || primitive->indexCount < 3)
+			continue;
 
-struct kmr_gltf_loader_mesh *
-kmr_gltf_loader_mesh_create (struct kmr_gltf_loader_mesh_create_info *meshInfo)
+		mesh_optimize_primitive(&scratch, meshData, primitive, optimize->cacheSize, streams, streamCount);
+	}
+
+	mesh_optimize_scratch_free(&scratch);
+
+	return 0;
+}
+
+
+int
+kmr_gltf_loader_mesh_optimize (struct kmr_gltf_loader_mesh_optimize_info *optimizeInfo)
 {
-	cgltf_size i, j, k;
-	uint32_t bufferOffset, bufferType, bufferViewElementType, bufferViewComponentType;
-	uint32_t bufferElementCount, bufferElementSize, vertexIndex, firstIndex = 0;
+	struct mesh_optimize optimize;
+	struct kmr_utils_worker_pool_run_info workerPoolRunInfo;
 
-	cgltf_data *gltfData = NULL;
-	cgltf_buffer_view *bufferView = NULL;
+	optimize.mesh = optimizeInfo->mesh;
+	optimize.cacheSize = (optimizeInfo->cacheSize) ? optimizeInfo->cacheSize : MESH_OPTIMIZE_CACHE_SIZE_DEFAULT;
 
-	vec4 vec4Dest;
-	void *finalAddress = NULL;
+	workerPoolRunInfo.threadCount = optimizeInfo->threadCount;
+	workerPoolRunInfo.jobCount = optimizeInfo->mesh->meshDataCount;
+	workerPoolRunInfo.job = mesh_optimize_job_run;
+	workerPoolRunInfo.userData = &optimize;
 
-	struct kmr_gltf_loader_mesh *mesh = NULL;
-	struct kmr_gltf_loader_mesh_data *meshData = NULL;
+	/* Vertices may be partially reordered even if a job fails */
+	optimizeInfo->mesh->optimized = true;
 
-	mesh = calloc(1, sizeof(struct kmr_gltf_loader_mesh));
-	if (!mesh) {
-		kmr_utils_log(KMR_DANGER, "[x] calloc(mesh): %s", strerror(errno));
-		return NULL;
-	}
+	return kmr_utils_worker_pool_run(&workerPoolRunInfo);
+}
 
-	/* Allocate large enough buffer to store all mesh data in array */
-	gltfData = meshInfo->gltfFile->gltfData;
-	meshData = calloc(gltfData->meshes_count, sizeof(struct kmr_gltf_loader_mesh_data));
-	if (!meshData) {
-		kmr_utils_log(KMR_DANGER, "[x] calloc(meshData): %s", strerror(errno));
-		goto exit_error_kmr_gltf_loader_mesh_create;
-	}
 
-	mesh->meshData = meshData;
-	mesh->meshDataCount = gltfData->meshes_count;
+float
+kmr_gltf_loader_mesh_acmr_get (struct kmr_gltf_loader_mesh_data *meshData, uint32_t cacheSize)
+{
+	uint32_t p, i, v, time = 0, misses = 0, triangles = 0;
+	uint32_t *cacheTime = NULL;
+	struct kmr_gltf_loader_mesh_primitive *primitive = NULL;
+
+	cacheSize = (cacheSize) ? cacheSize : MESH_OPTIMIZE_CACHE_SIZE_DEFAULT;
+	if (!meshData->vertexBufferDataCount)
+		return 0.0f;
+
+	cacheTime = calloc(meshData->vertexBufferDataCount, sizeof(uint32_t));
+	if (!cacheTime) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(cacheTime): %s", strerror(errno));
+		return 0.0f;
+	}
 
-	// TODO: account for accessor bufferOffset
 	/*
-	 * Retrieve important elements from buffer views/accessors associated with
-	 * each GLTF mesh that's associated with buffers[kmsgltf->bufferIndex].buffer.
-	 * Mesh->primitive->attribute->accessor->bufferView->buffer
-	 * Mesh->primitive->indices->accessor->bufferView->buffer
-	 * Normally would want to avoid, but in this case it's fine
+	 * FIFO cache: A vertex is a hit if fewer than @cacheSize misses
+	 * happened since it was last inserted. Each primitive is a
+	 * separate draw so the cache starts out cold.
 	 */
-	for (i = 0; i < gltfData->meshes_count; i++) {
-		for (j = 0; j < gltfData->meshes[i].primitives_count; j++) {
-			for (k = 0; k < gltfData->meshes[i].primitives[j].attributes_count; k++) {
-
-				// bufferView associated with accessor which is associated with a mesh->primitive->attribute
-				bufferView = gltfData->meshes[i].primitives[j].attributes[k].data->buffer_view;
-
-				bufferOffset = bufferView->offset;
-				bufferViewElementType = gltfData->meshes[i].primitives[j].attributes[k].data->type;
-				bufferViewComponentType = gltfData->meshes[i].primitives[j].attributes[k].data->component_type;
-				bufferElementCount = gltfData->meshes[i].primitives[j].attributes[k].data->count;
-				bufferElementSize = cgltf_calc_size(bufferViewElementType, bufferViewComponentType);
-				bufferType = gltfData->meshes[i].primitives[j].attributes[k].type;
-
-				if (!meshData[i].vertexBufferData) {
-					meshData[i].vertexBufferData = calloc(bufferElementCount, sizeof(struct kmr_gltf_loader_mesh_vertex_data));
-					if (!meshData[i].vertexBufferData) {
-						kmr_utils_log(KMR_DANGER, "[x] calloc(meshData[%u].vertexBufferData): %s", i, strerror(errno));
-					}
-
-					meshData[i].vertexBufferDataCount = bufferElementCount;
-					meshData[i].vertexBufferDataSize = bufferElementCount * sizeof(struct kmr_gltf_loader_mesh_vertex_data);
-				}
+	for (p = 0; p < meshData->primitiveCount; p++) {
+		primitive = &meshData->primitives[p];
+		if (primitive->type != cgltf_primitive_type_triangles)
+			continue;
+
+		time += cacheSize + 1;
+		for (i = 0; i < primitive->indexCount - (primitive->indexCount % 3); i++) {
+			v = mesh_index_get(meshData, primitive->firstIndex + i);
+			if (v >= meshData->vertexBufferDataCount)
+				continue;
 
-				for (vertexIndex = 0; vertexIndex < bufferElementCount; vertexIndex++) {
-					// Base buffer data adress + base byte offset address + (index * bufferElementSize) = address in buffer where data resides
-					finalAddress = gltfData->buffers[meshInfo->bufferIndex].data + bufferOffset + (vertexIndex * bufferElementSize);
-
-					switch (bufferType) {
-						case cgltf_attribute_type_texcoord: // Texture Coordinate Buffer
-							glm_vec2((float*) finalAddress, meshData[i].vertexBufferData[vertexIndex].texCoord);
-							break;
-						case cgltf_attribute_type_normal: // Normal buffer
-							glm_vec3_normalize_to((float*) finalAddress, meshData[i].vertexBufferData[vertexIndex].normal);
-							break;
-						case cgltf_attribute_type_position: // position buffer
-							glm_vec4((float*) finalAddress, 1.0f, vec4Dest);
-							glm_vec3(vec4Dest, meshData[i].vertexBufferData[vertexIndex].position);
-							break;
-						default:
-							// color buffer (want values all set to 1.0f). if not defined in meshes->primitive->attribute
-							glm_vec3_one(meshData[i].vertexBufferData[vertexIndex].color);
-							break;
-					}
-				}
+			if (time - cacheTime[v] > cacheSize) {
+				cacheTime[v] = time++;
+				misses++;
 			}
+		}
 
-			// Store index buffer data
-			if (!gltfData->meshes[i].primitives[j].indices)
-				continue;
+		triangles += primitive->indexCount / 3;
+	}
 
-			bufferView = gltfData->meshes[i].primitives[j].indices->buffer_view;
-	
-			bufferOffset = bufferView->offset;
-			bufferViewElementType = gltfData->meshes[i].primitives[j].indices->type;
-			bufferViewComponentType = gltfData->meshes[i].primitives[j].indices->component_type;
-			bufferElementCount = gltfData->meshes[i].primitives[j].indices->count;
-			bufferElementSize = cgltf_calc_size(bufferViewElementType, bufferViewComponentType);
-
-			if (!meshData[i].indexBufferData) {
-				meshData[i].indexBufferData = calloc(bufferElementCount, sizeof(uint32_t));
-				if (!meshData[i].indexBufferData) {
-					kmr_utils_log(KMR_DANGER, "[x] calloc(meshData[%u].indexBufferData): %s", i, strerror(errno));
-					goto exit_error_kmr_gltf_loader_mesh_create;
-				}
+	free(cacheTime);
 
-				meshData[i].indexBufferDataCount = bufferElementCount;
-				meshData[i].indexBufferDataSize = bufferElementCount * sizeof(uint32_t);
-			}
+	return (triangles) ? (float) misses / (float) triangles : 0.0f;
+}
 
-			for (vertexIndex = 0; vertexIndex < bufferElementCount; vertexIndex++) {
-				// Base buffer data adress + base byte offset address + (index * bufferElementSize) = address in buffer where data resides
-				finalAddress = gltfData->buffers[meshInfo->bufferIndex].data + bufferOffset + (vertexIndex * bufferElementSize);
-				switch (bufferViewComponentType) {
-					case cgltf_component_type_r_8u:
-						meshData[i].indexBufferData[vertexIndex] = *((uint8_t*) finalAddress);
-						break;
-					case cgltf_component_type_r_16u:
-						meshData[i].indexBufferData[vertexIndex] = *((uint16_t*) finalAddress);
-						break;
-					case cgltf_component_type_r_32u:
-						meshData[i].indexBufferData[vertexIndex] = *((uint32_t*) finalAddress);
-						break;
-					default:
-						kmr_utils_log(KMR_DANGER, "[x] Somethings gone horribly wrong here. GLTF buffer indices section doesn't have correct data type");
-						goto exit_error_kmr_gltf_loader_mesh_create;
-				}
-			}
+/**************************************************
+ * END OF kmr_gltf_loader_mesh_optimize FUNCTIONS *
+ **************************************************/
+
+
+/***********************************************************************
+ * START OF kmr_gltf_loader_mesh_vertex_input_description_get FUNCTION *
+ ***********************************************************************/
+
+/*
+ * Attribute formats/offsets of each vertex layout, index by attribute
+ * (position, normal, texCoord, color) in flag order.
+ */
+struct mesh_vertex_attribute_format {
+	VkFormat format;
+	uint32_t offset;
+	uint32_t size;
+};
+
+
+static const struct mesh_vertex_attribute_format mesh_vertex_attribute_formats[][KMR_GLTF_LOADER_MESH_VERTEX_ATTRIBUTE_COUNT] = {
+	[KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_INTERLEAVED] = {
+		{ VK_FORMAT_R32G32B32_SFLOAT, offsetof(struct kmr_gltf_loader_mesh_vertex_data, position), sizeof(vec3) },
+		{ VK_FORMAT_R32G32B32_SFLOAT, offsetof(struct kmr_gltf_loader_mesh_vertex_data, normal), sizeof(vec3) },
+		{ VK_FORMAT_R32G32_SFLOAT, offsetof(struct kmr_gltf_loader_mesh_vertex_data, texCoord), sizeof(vec2) },
+		{ VK_FORMAT_R32G32B32_SFLOAT, offsetof(struct kmr_gltf_loader_mesh_vertex_data, color), sizeof(vec3) },
+	},
+	[KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_PACKED] = {
+		{ VK_FORMAT_R16G16B16A16_SNORM, offsetof(struct kmr_gltf_loader_mesh_vertex_packed, position), sizeof(int16_t) * 4 },
+		{ VK_FORMAT_R16G16_SNORM, offsetof(struct kmr_gltf_loader_mesh_vertex_packed, normal), sizeof(int16_t) * 2 },
+		{ VK_FORMAT_R16G16_SFLOAT, offsetof(struct kmr_gltf_loader_mesh_vertex_packed, texCoord), sizeof(uint16_t) * 2 },
+		{ VK_FORMAT_R8G8B8A8_UNORM, offsetof(struct kmr_gltf_loader_mesh_vertex_packed, color), sizeof(uint8_t) * 4 },
+	},
+	[KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_SOA] = {
+		{ VK_FORMAT_R32G32B32_SFLOAT, 0, sizeof(vec3) },
+		{ VK_FORMAT_R32G32B32_SFLOAT, 0, sizeof(vec3) },
+		{ VK_FORMAT_R32G32_SFLOAT, 0, sizeof(vec2) },
+		{ VK_FORMAT_R32G32B32_SFLOAT, 0, sizeof(vec3) },
+	},
+};
+
+
+static const uint32_t mesh_vertex_layout_strides[] = {
+	[KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_INTERLEAVED] = sizeof(struct kmr_gltf_loader_mesh_vertex_data),
+	[KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_PACKED] = sizeof(struct kmr_gltf_loader_mesh_vertex_packed),
+	[KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_SOA] = 0, /* Per attribute, see mesh_vertex_attribute_formats */
+};
+
+
+int
+kmr_gltf_loader_mesh_vertex_input_description_get (struct kmr_gltf_loader_mesh_vertex_input_description_info *descriptionInfo,
+                                                   struct kmr_gltf_loader_mesh_vertex_input_description *description)
+{
+	uint32_t a;
+	const struct mesh_vertex_attribute_format *formats = NULL;
+	VkVertexInputAttributeDescription *attributeDescription = NULL;
+
+	if (descriptionInfo->vertexLayout >= ARRAY_LEN(mesh_vertex_layout_strides)) {
+		kmr_utils_log(KMR_DANGER, "[x] kmr_gltf_loader_mesh_vertex_input_description_get: Unknown vertex layout %u",
+		              descriptionInfo->vertexLayout);
+		return -1;
+	}
+
+	memset(description, 0, sizeof(struct kmr_gltf_loader_mesh_vertex_input_description));
+	formats = mesh_vertex_attribute_formats[descriptionInfo->vertexLayout];
 
-			meshData[i].firstIndex = firstIndex;
-			firstIndex += bufferElementCount;
+	if (descriptionInfo->vertexLayout != KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_SOA) {
+		description->bindingDescriptions[0].binding = descriptionInfo->firstBinding;
+		description->bindingDescriptions[0].stride = mesh_vertex_layout_strides[descriptionInfo->vertexLayout];
+		description->bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		description->bindingDescriptionCount = 1;
+	}
+
+	for (a = 0; a < KMR_GLTF_LOADER_MESH_VERTEX_ATTRIBUTE_COUNT; a++) {
+		if (!(descriptionInfo->attributes & (1 << a)))
+			continue;
+
+		attributeDescription = &description->attributeDescriptions[description->attributeDescriptionCount];
+		attributeDescription->location = descriptionInfo->firstLocation + description->attributeDescriptionCount;
+		attributeDescription->binding = descriptionInfo->firstBinding;
+		attributeDescription->format = formats[a].format;
+		attributeDescription->offset = formats[a].offset;
+
+		/* Structure of arrays: One tightly packed binding per attribute */
+		if (descriptionInfo->vertexLayout == KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_SOA) {
+			attributeDescription->binding += description->bindingDescriptionCount;
+			description->bindingDescriptions[description->bindingDescriptionCount].binding = attributeDescription->binding;
+			description->bindingDescriptions[description->bindingDescriptionCount].stride = formats[a].size;
+			description->bindingDescriptions[description->bindingDescriptionCount].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+			description->bindingDescriptionCount++;
 		}
+
+		description->attributeDescriptionCount++;
 	}
 
-	return mesh;
+	return 0;
+}
 
-exit_error_kmr_gltf_loader_mesh_create:
-	kmr_gltf_loader_mesh_destroy(mesh);
-	return NULL;
+/*********************************************************************
+ * END OF kmr_gltf_loader_mesh_vertex_input_description_get FUNCTION *
+ *********************************************************************/
+
+
+/*********************************************************************
+ * START OF kmr_gltf_loader_texture_image_{create,destroy} FUNCTIONS *
+ *********************************************************************/
+
+/*
+ * @srgb            - Per image, true if a material samples it as color (sRGB). Only
+ *                    allocated when mip chains get generated.
+ * @mipThreadCount  - Threads each image's mip levels are split between. Images are
+ *                    already spread over the pool so only a lone image gets more than 1.
+ */
+struct texture_image_decode {
+	cgltf_data                             *gltfData;
+	const char                             *directory;
+	struct kmr_utils_image_buffer          *imageData;
+	enum kmr_utils_image_buffer_mip_filter mipFilter;
+	bool                                   *srgb;
+	uint32_t                               mipThreadCount;
+};
+
+
+/* glTF only stores base color, emissive and specular-glossiness colors as sRGB */
+static void
+texture_image_srgb_mark (cgltf_data *gltfData, bool *srgb)
+{
+	cgltf_size m, t;
+	cgltf_material *material = NULL;
+	cgltf_texture_view *textureViews[4];
+
+	for (m = 0; m < gltfData->materials_count; m++) {
+		material = &gltfData->materials[m];
+		textureViews[0] = &material->pbr_metallic_roughness.base_color_texture;
+		textureViews[1] = &material->emissive_texture;
+		textureViews[2] = &material->pbr_specular_glossiness.diffuse_texture;
+		textureViews[3] = &material->pbr_specular_glossiness.specular_glossiness_texture;
+
+		for (t = 0; t < ARRAY_LEN(textureViews); t++) {
+			if (textureViews[t]->texture && textureViews[t]->texture->image)
+				srgb[cgltf_image_index(gltfData, textureViews[t]->texture->image)] = true;
+		}
+	}
 }
 
 
-void
-kmr_gltf_loader_mesh_destroy (struct kmr_gltf_loader_mesh *mesh)
+/*
+ * Images stored in a buffer view (GLB binary chunk or any loaded buffer)
+ * are decoded straight out of the buffer, no file is opened and nothing
+ * is copied. Base64 data URIs get decoded into a temporary buffer first.
+ */
+static int
+texture_image_decode_job_run (void *userData, uint32_t jobIndex)
 {
-	uint32_t i;
+	void *base64Data = NULL;
+	const char *base64 = NULL;
+	cgltf_size base64Size, base64Len;
+	cgltf_options options;
 
-	if (!mesh)
-		return;
+	struct texture_image_decode *decode = userData;
+	cgltf_image *image = &decode->gltfData->images[jobIndex];
+	struct kmr_utils_image_buffer_create_info imageDataCreateInfo;
+	struct kmr_utils_image_buffer_memory_create_info imageDataMemoryCreateInfo;
+	struct kmr_utils_image_buffer_mip_chain_create_info mipChainCreateInfo;
 
-	for (i = 0; i < mesh->meshDataCount; i++) {
-		free(mesh->meshData[i].vertexBufferData);
-		free(mesh->meshData[i].indexBufferData);
+	imageDataMemoryCreateInfo.name = (image->name) ? image->name : image->uri;
+
+	if (image->buffer_view) {
+		imageDataMemoryCreateInfo.bytes = cgltf_buffer_view_data(image->buffer_view);
+		imageDataMemoryCreateInfo.byteSize = image->buffer_view->size;
+		if (!imageDataMemoryCreateInfo.bytes) {
+			kmr_utils_log(KMR_DANGER, "[x] kmr_gltf_loader_texture_image_create: image %u buffer view has no data loaded", jobIndex);
+			return -1;
+		}
+
+		decode->imageData[jobIndex] = kmr_utils_image_buffer_memory_create(&imageDataMemoryCreateInfo);
+	} else if (image->uri && !strncmp(image->uri, "data:", 5)) {
+		base64 = strstr(image->uri, ";base64,");
+		if (!base64) {
+			kmr_utils_log(KMR_DANGER, "[x] kmr_gltf_loader_texture_image_create: image %u data URI isn't base64", jobIndex);
+			return -1;
+		}
+
+		base64 += 8;
+		base64Len = strlen(base64);
+		base64Size = (base64Len / 4) * 3;
+		while (base64Len && base64[--base64Len] == '=')
+			base64Size--;
+
+		memset(&options, 0, sizeof(cgltf_options));
+		if (cgltf_load_buffer_base64(&options, base64Size, base64, &base64Data) != cgltf_result_success) {
+			kmr_utils_log(KMR_DANGER, "[x] cgltf_load_buffer_base64: Failed to decode image %u", jobIndex);
+			return -1;
+		}
+
+		imageDataMemoryCreateInfo.bytes = base64Data;
+		imageDataMemoryCreateInfo.byteSize = base64Size;
+		imageDataMemoryCreateInfo.name = (image->name) ? image->name : "data URI";
+		decode->imageData[jobIndex] = kmr_utils_image_buffer_memory_create(&imageDataMemoryCreateInfo);
+		free(base64Data);
+	} else {
+		if (!image->uri) {
+			kmr_utils_log(KMR_DANGER, "[x] kmr_gltf_loader_texture_image_create: image %u has neither a uri nor buffer view", jobIndex);
+			return -1;
+		}
+
+		imageDataCreateInfo.directory = decode->directory;
+		imageDataCreateInfo.filename = image->uri;
+		imageDataCreateInfo.maxStrLen = (1<<8);
+		decode->imageData[jobIndex] = kmr_utils_image_buffer_create(&imageDataCreateInfo);
 	}
 
-	free(mesh->meshData);
-	free(mesh);
-}
+	if (!decode->imageData[jobIndex].pixels)
+		return -1;
 
-/**********************************************************
- * END OF kmr_gltf_loader_mesh_{create,destroy} FUNCTIONS *
- **********************************************************/
+	if (decode->mipFilter != KMR_UTILS_IMAGE_BUFFER_MIP_FILTER_NONE) {
+		mipChainCreateInfo.imageBuffer = &decode->imageData[jobIndex];
+		mipChainCreateInfo.filter = decode->mipFilter;
+		mipChainCreateInfo.srgb = decode->srgb[jobIndex];
+		mipChainCreateInfo.threadCount = decode->mipThreadCount;
+		if (kmr_utils_image_buffer_mip_chain_create(&mipChainCreateInfo) == -1)
+			return -1;
+	}
 
+	return 0;
+}
 
-/*********************************************************************
- * START OF kmr_gltf_loader_texture_image_{create,destroy} FUNCTIONS *
- *********************************************************************/
+
+#define TEXTURE_IMAGE_ALIGNMENT 16
+#define TEXTURE_IMAGE_ALIGN(size) (((size) + (TEXTURE_IMAGE_ALIGNMENT - 1)) & ~(TEXTURE_IMAGE_ALIGNMENT - 1))
 
 struct kmr_gltf_loader_texture_image *
 kmr_gltf_loader_texture_image_create (struct kmr_gltf_loader_texture_image_create_info *textureImageInfo)
 {
 	cgltf_data *gltfData = NULL;
 	uint32_t curImage = 0, totalBufferSize = 0;
+	bool *srgb = NULL;
 
 	struct kmr_gltf_loader_texture_image *textureImage = NULL;
-	struct kmr_utils_image_buffer_create_info imageDataCreateInfo;
+	struct texture_image_decode decode;
+	struct kmr_utils_worker_pool_run_info workerPoolRunInfo;
 
 	textureImage = calloc(1, sizeof(struct kmr_gltf_loader_texture_image));
 	if (!textureImage) {
@@ -261,26 +3257,55 @@ kmr_gltf_loader_texture_image_create (struct kmr_gltf_loader_texture_image_creat
 		goto exit_error_kmr_gltf_loader_texture_image_create;
 	}
 
-	imageDataCreateInfo.maxStrLen = (1<<8);
-
-	/* Load all images associated with GLTF file into memory */
-	for (curImage = 0; curImage < gltfData->images_count; curImage++) {
-		imageDataCreateInfo.directory = textureImageInfo->directory;
-		imageDataCreateInfo.filename = gltfData->images[curImage].uri;
+	/* Set early so images decoded before a failure get free'd */
+	textureImage->imageCount = gltfData->images_count;
 
-		textureImage->imageData[curImage] = kmr_utils_image_buffer_create(&imageDataCreateInfo);
-		if (!textureImage->imageData[curImage].pixels)
+	/* Load all images associated with GLTF file into memory, one job per image */
+	decode.gltfData = gltfData;
+	decode.directory = textureImageInfo->directory;
+	decode.imageData = textureImage->imageData;
+	decode.mipFilter = textureImageInfo->mipFilter;
+	decode.mipThreadCount = (gltfData->images_count == 1) ? textureImageInfo->threadCount : 1;
+
+	if (decode.mipFilter != KMR_UTILS_IMAGE_BUFFER_MIP_FILTER_NONE) {
+		srgb = calloc(gltfData->images_count + 1, sizeof(bool));
+		if (!srgb) {
+			kmr_utils_log(KMR_DANGER, "[x] calloc: %s", strerror(errno));
 			goto exit_error_kmr_gltf_loader_texture_image_create;
+		}
+
+		texture_image_srgb_mark(gltfData, srgb);
+	}
 
+	decode.srgb = srgb;
+
+	workerPoolRunInfo.threadCount = textureImageInfo->threadCount;
+	workerPoolRunInfo.jobCount = gltfData->images_count;
+	workerPoolRunInfo.job = texture_image_decode_job_run;
+	workerPoolRunInfo.userData = &decode;
+
+	if (kmr_utils_worker_pool_run(&workerPoolRunInfo) == -1)
+		goto exit_error_kmr_gltf_loader_texture_image_create;
+
+	free(srgb);
+
+	/*
+	 * Sizes are only known once every image is decoded. Offsets are kept
+	 * block aligned so KTX2/DDS payloads can be copied straight out of a
+	 * single staging buffer (vkCmdCopyBufferToImage bufferOffset must be
+	 * a multiple of the compressed texel block size).
+	 */
+	for (curImage = 0; curImage < gltfData->images_count; curImage++) {
+		totalBufferSize = TEXTURE_IMAGE_ALIGN(totalBufferSize);
 		textureImage->imageData[curImage].imageBufferOffset = totalBufferSize;
 		totalBufferSize += textureImage->imageData[curImage].imageSize;
 	}
 
 	textureImage->totalBufferSize = totalBufferSize;
-	textureImage->imageCount = gltfData->images_count;
 	return textureImage;
 
 exit_error_kmr_gltf_loader_texture_image_create:
+	free(srgb);
 	kmr_gltf_loader_texture_image_destroy(textureImage);
 	return NULL;
 }
@@ -313,17 +3338,114 @@ kmr_gltf_loader_texture_image_destroy (struct kmr_gltf_loader_texture_image *tex
  * START OF kmr_gltf_loader_material_{create,destroy} FUNCTIONS *
  ****************************************************************/
 
+#define MATERIAL_NAME_MAX (1<<6)
+
+
+static void
+material_texture_view_get (cgltf_data *gltfData, const cgltf_texture_view *textureView,
+                           struct kmr_gltf_loader_cgltf_texture_view *materialTextureView)
+{
+	materialTextureView->scale = textureView->scale;
+	materialTextureView->textureIndex = UINT32_MAX;
+	materialTextureView->imageIndex = UINT32_MAX;
+
+	if (!textureView->texture)
+		return;
+
+	materialTextureView->textureIndex = cgltf_texture_index(gltfData, textureView->texture);
+	if (textureView->texture->image)
+		materialTextureView->imageIndex = cgltf_image_index(gltfData, textureView->texture->image);
+}
+
+
 static uint32_t
-material_count_get (cgltf_data *gltfData)
+material_name_hash (const char *name)
 {
-	uint32_t i, j, materialDataCount = 0;
+	uint32_t i, hash = 2166136261u;
 
-	for (i = 0; i < gltfData->meshes_count; i++)
-		for (j = 0; j < gltfData->meshes[i].primitives_count; j++)
-			if (gltfData->meshes[i].primitives[j].material)
-				materialDataCount++;
+	/* FNV-1a over the (truncated) name */
+	for (i = 0; i < MATERIAL_NAME_MAX && name[i]; i++)
+		hash = (hash ^ (uint8_t) name[i]) * 16777619u;
+
+	return hash;
+}
+
+
+/*
+ * Interns every material name into a single pool. An open addressing
+ * table of material index + 1 finds earlier materials with the same
+ * (truncated) name so the name is only stored once.
+ */
+static int
+material_string_pool_create (cgltf_data *gltfData, struct kmr_gltf_loader_material *material)
+{
+	uint32_t m, slot, match, tableSize = 16, stringPoolSize = 0;
+	uint32_t *table = NULL, *poolOffsets = NULL;
+	size_t length;
+	const char *name = NULL;
+
+	while (tableSize < (uint64_t) gltfData->materials_count * 2)
+		tableSize <<= 1;
+
+	table = calloc(tableSize, sizeof(uint32_t));
+	poolOffsets = calloc(gltfData->materials_count + 1, sizeof(uint32_t));
+	if (!table || !poolOffsets) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(table): %s", strerror(errno));
+		goto exit_error_material_string_pool_create;
+	}
+
+	/* First pass: Assign each unique name its offset in the pool */
+	for (m = 0; m < gltfData->materials_count; m++) {
+		name = gltfData->materials[m].name;
+		poolOffsets[m] = UINT32_MAX;
+		if (!name)
+			continue;
+
+		for (slot = material_name_hash(name) & (tableSize - 1); table[slot]; slot = (slot + 1) & (tableSize - 1)) {
+			match = table[slot] - 1;
+			if (!strncmp(gltfData->materials[match].name, name, MATERIAL_NAME_MAX))
+				break;
+		}
+
+		if (table[slot]) {
+			poolOffsets[m] = poolOffsets[table[slot] - 1];
+			continue;
+		}
+
+		table[slot] = m + 1;
+		poolOffsets[m] = stringPoolSize;
+		stringPoolSize += strnlen(name, MATERIAL_NAME_MAX) + 1;
+	}
+
+	material->stringPool = calloc(stringPoolSize + 1, sizeof(char));
+	if (!material->stringPool) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(stringPool): %s", strerror(errno));
+		goto exit_error_material_string_pool_create;
+	}
+
+	material->stringPoolSize = stringPoolSize;
+
+	/* Second pass: Copy names into the pool, duplicates point at the first copy */
+	for (m = 0; m < gltfData->materials_count; m++) {
+		if (poolOffsets[m] == UINT32_MAX)
+			continue;
+
+		material->materialData[m].materialName = material->stringPool + poolOffsets[m];
+		if (material->materialData[m].materialName[0])
+			continue;
 
-	return materialDataCount;
+		length = strnlen(gltfData->materials[m].name, MATERIAL_NAME_MAX);
+		memcpy(material->materialData[m].materialName, gltfData->materials[m].name, length);
+	}
+
+	free(poolOffsets);
+	free(table);
+	return 0;
+
+exit_error_material_string_pool_create:
+	free(poolOffsets);
+	free(table);
+	return -1;
 }
 
 
@@ -332,7 +3454,7 @@ kmr_gltf_loader_material_create (struct kmr_gltf_loader_material_create_info *ma
 {
 	cgltf_data *gltfData = NULL;
 	cgltf_material *gltfMaterial = NULL;
-	uint32_t i, j, materialDataCount = 0;
+	uint32_t m;
 
 	struct kmr_gltf_loader_material *material = NULL;
 	struct kmr_gltf_loader_material_data *materialData = NULL;
@@ -344,68 +3466,45 @@ kmr_gltf_loader_material_create (struct kmr_gltf_loader_material_create_info *ma
 	}
 
 	gltfData = materialInfo->gltfFile->gltfData;
-	materialDataCount = material_count_get(gltfData);
 
-	materialData = calloc(materialDataCount, sizeof(struct kmr_gltf_loader_material_data));
+	/* One entry per GLTF material no matter how many primitives reference it */
+	materialData = calloc(gltfData->materials_count + 1, sizeof(struct kmr_gltf_loader_material_data));
 	if (!materialData) {
 		kmr_utils_log(KMR_DANGER, "[x] calloc(materialData): %s", strerror(errno));
 		goto exit_error_kmr_gltf_loader_material_create;
 	}
 
 	material->materialData = materialData;
+	material->materialDataCount = gltfData->materials_count;
+
+	if (material_string_pool_create(gltfData, material) == -1)
+		goto exit_error_kmr_gltf_loader_material_create;
 
 	/*
-	 * Mesh->primitive->material->pbr_metallic_roughness->base_color_texture
-	 * Mesh->primitive->material->pbr_metallic_roughness->metallic_roughness_texture
-	 * Mesh->primitive->material->normal_texture
-	 * Mesh->primitive->material->occlusion_texture
+	 * Material->pbr_metallic_roughness->base_color_texture
+	 * Material->pbr_metallic_roughness->metallic_roughness_texture
+	 * Material->normal_texture
+	 * Material->occlusion_texture
 	 */
-	materialDataCount=0;
-	for (i = 0; i < gltfData->meshes_count; i++) {
-		for (j = 0; j < gltfData->meshes[i].primitives_count; j++) {
-			gltfMaterial = gltfData->meshes[i].primitives[j].material;
-			if (!gltfMaterial) continue;
-
-			materialData[materialDataCount].materialName = strndup(gltfMaterial->name, (1<<6));
-
-			/* Physically-Based Rendering Metallic Roughness Model */
-			materialData[materialDataCount].pbrMetallicRoughness.baseColorTexture.textureIndex = \
-				cgltf_texture_index(gltfData, gltfMaterial->pbr_metallic_roughness.base_color_texture.texture);
-			materialData[materialDataCount].pbrMetallicRoughness.baseColorTexture.imageIndex = \
-				cgltf_image_index(gltfData, gltfMaterial->pbr_metallic_roughness.base_color_texture.texture->image);
-			materialData[materialDataCount].pbrMetallicRoughness.baseColorTexture.scale = \
-				gltfMaterial->pbr_metallic_roughness.base_color_texture.scale;
-			materialData[materialDataCount].pbrMetallicRoughness.metallicRoughnessTexture.textureIndex = \
-				cgltf_texture_index(gltfData, gltfMaterial->pbr_metallic_roughness.metallic_roughness_texture.texture);
-			materialData[materialDataCount].pbrMetallicRoughness.metallicRoughnessTexture.imageIndex = \
-				cgltf_image_index(gltfData, gltfMaterial->pbr_metallic_roughness.metallic_roughness_texture.texture->image);
-			materialData[materialDataCount].pbrMetallicRoughness.metallicRoughnessTexture.scale = \
-				gltfMaterial->pbr_metallic_roughness.metallic_roughness_texture.scale;
-
-			materialData[materialDataCount].pbrMetallicRoughness.metallicFactor = gltfMaterial->pbr_metallic_roughness.metallic_factor;
-			materialData[materialDataCount].pbrMetallicRoughness.roughnessFactor = gltfMaterial->pbr_metallic_roughness.roughness_factor;
-			memcpy(materialData[materialDataCount].pbrMetallicRoughness.baseColorFactor,
-			       gltfMaterial->pbr_metallic_roughness.base_color_factor,
-			       STRUCT_MEMBER_SIZE(struct kmr_gltf_loader_cgltf_pbr_metallic_roughness, baseColorFactor));
-
-			materialData[materialDataCount].normalTexture.scale = gltfMaterial->normal_texture.scale;
-			materialData[materialDataCount].normalTexture.textureIndex = \
-				cgltf_texture_index(gltfData, gltfMaterial->normal_texture.texture);
-			materialData[materialDataCount].normalTexture.imageIndex = \
-				cgltf_image_index(gltfData, gltfMaterial->normal_texture.texture->image);
-
-			materialData[materialDataCount].occlusionTexture.scale = gltfMaterial->occlusion_texture.scale;
-			materialData[materialDataCount].occlusionTexture.textureIndex = \
-				cgltf_texture_index(gltfData, gltfMaterial->occlusion_texture.texture);
-			materialData[materialDataCount].occlusionTexture.imageIndex = \
-				cgltf_image_index(gltfData, gltfMaterial->occlusion_texture.texture->image);
-
-			materialData[materialDataCount].meshIndex = i;
-			materialDataCount++;
-		}
-	}
-
-	material->materialDataCount = materialDataCount;
+	for (m = 0; m < gltfData->materials_count; m++) {
+		gltfMaterial = &gltfData->materials[m];
+
+		/* Physically-Based Rendering Metallic Roughness Model */
+		material_texture_view_get(gltfData, &gltfMaterial->pbr_metallic_roughness.base_color_texture,
+		                          &materialData[m].pbrMetallicRoughness.baseColorTexture);
+		material_texture_view_get(gltfData, &gltfMaterial->pbr_metallic_roughness.metallic_roughness_texture,
+		                          &materialData[m].pbrMetallicRoughness.metallicRoughnessTexture);
+
+		materialData[m].pbrMetallicRoughness.metallicFactor = gltfMaterial->pbr_metallic_roughness.metallic_factor;
+		materialData[m].pbrMetallicRoughness.roughnessFactor = gltfMaterial->pbr_metallic_roughness.roughness_factor;
+		memcpy(materialData[m].pbrMetallicRoughness.baseColorFactor,
+		       gltfMaterial->pbr_metallic_roughness.base_color_factor,
+		       STRUCT_MEMBER_SIZE(struct kmr_gltf_loader_cgltf_pbr_metallic_roughness, baseColorFactor));
+
+		material_texture_view_get(gltfData, &gltfMaterial->normal_texture, &materialData[m].normalTexture);
+		material_texture_view_get(gltfData, &gltfMaterial->occlusion_texture, &materialData[m].occlusionTexture);
+	}
+
 	return material;
 
 exit_error_kmr_gltf_loader_material_create:
@@ -417,15 +3516,10 @@ exit_error_kmr_gltf_loader_material_create:
 void
 kmr_gltf_loader_material_destroy (struct kmr_gltf_loader_material *material)
 {
-	uint32_t i;
-
 	if (!material)
 		return;
 
-	for (i=0; i < material->materialDataCount; i++) {
-		free(material->materialData[i].materialName);
-	}
-
+	free(material->stringPool);
 	free(material->materialData);
 	free(material);
 }
@@ -442,147 +3536,45 @@ kmr_gltf_loader_material_destroy (struct kmr_gltf_loader_material *material)
 struct kmr_gltf_loader_node *
 kmr_gltf_loader_node_create (struct kmr_gltf_loader_node_create_info *nodeInfo)
 {
-	uint32_t n, c, nodeDataCount = 0;
-
-	float matrix[16];
-	vec4 rotation; vec3 translation, scale;
-	mat4 parentNodeMatrix, childNodeMatrix, rotationMatrix;
-
-	cgltf_data *gltfData = NULL;
-	cgltf_node *parentNode = NULL;
-	cgltf_node *childNode = NULL;
+	uint32_t n;
 
 	struct kmr_gltf_loader_node *node = NULL;
-	struct kmr_gltf_loader_node_data *nodeData = NULL;
+	struct kmr_gltf_loader_scene_graph *sceneGraph = NULL;
+	struct kmr_gltf_loader_scene_graph_create_info sceneGraphInfo;
+
+	sceneGraphInfo.gltfFile = nodeInfo->gltfFile;
+	sceneGraphInfo.sceneIndex = nodeInfo->sceneIndex;
+	sceneGraph = kmr_gltf_loader_scene_graph_create(&sceneGraphInfo);
+	if (!sceneGraph)
+		return NULL;
 
 	node = calloc(1, sizeof(struct kmr_gltf_loader_node));
 	if (!node) {
 		kmr_utils_log(KMR_DANGER, "[x] calloc(node): %s", strerror(errno));
-		goto exit_error_kmr_gltf_loader_material_create;
-	}
-
-	gltfData = nodeInfo->gltfFile->gltfData;
-
-	/* Acquire amount of nodes associate with scene */
-	for (n = 0; n < gltfData->scenes[nodeInfo->sceneIndex].nodes_count; n++) {
-		parentNode = gltfData->scenes[nodeInfo->sceneIndex].nodes[n];
-		nodeDataCount += parentNode->children_count;
+		goto exit_error_kmr_gltf_loader_node_create;
 	}
 
-	/*
-	 * For whatever odd reason some cglm functions don't appear to like CGLTF allocated heap memory.
-	 * Define stack based variables and use memcpy to copy data from
-	 * stack->heap & heap->stack.
-	 */
-
-	nodeData = calloc(nodeDataCount, sizeof(struct kmr_gltf_loader_node_data));
-	if (!nodeData) {
+	node->nodeData = calloc(sceneGraph->nodeCount + 1, sizeof(struct kmr_gltf_loader_node_data));
+	if (!node->nodeData) {
 		kmr_utils_log(KMR_DANGER, "[x] calloc(nodeData): %s", strerror(errno));
-		goto exit_error_kmr_gltf_loader_material_create;
+		goto exit_error_kmr_gltf_loader_node_create;
 	}
 
-	nodeDataCount = 0;
-	node->nodeData = nodeData;
-	for (n = 0; n < gltfData->scenes[nodeInfo->sceneIndex].nodes_count; n++) {
-		parentNode = gltfData->scenes[nodeInfo->sceneIndex].nodes[n];
-
-		/* Clear stack array */
-		memset(translation, 0, sizeof(translation));
-		memset(rotation, 0, sizeof(rotation));
-		memset(scale, 0, sizeof(scale));
-		memset(matrix, 0, sizeof(matrix));
-		memset(rotationMatrix, 0, sizeof(rotationMatrix));
-		memset(parentNodeMatrix, 0, sizeof(parentNodeMatrix));
-
-		/* Copy from heap to stack */
-		memcpy(translation, parentNode->translation, sizeof(translation));
-		memcpy(rotation, parentNode->rotation, sizeof(rotation));
-		memcpy(scale, parentNode->scale, sizeof(scale));
-		memcpy(matrix, parentNode->matrix, sizeof(matrix));
-
-		glm_mat4_identity(parentNodeMatrix);
-
-		/*
-		 * GLTF: The node's unit quaternion rotation in the order (x, y, z, w), where w is the scalar.
-		 * NOTE: cglm stores quaternion as [x, y, z, w] in memory since v0.4.0 it was [w, x, y, z] before v0.4.0 ( v0.3.5 and earlier )
-		 */
-		if (parentNode->has_translation)
-			glm_translate(parentNodeMatrix, translation);
-
-		if (parentNode->has_rotation) {
-			glm_quat_mat4(rotation, rotationMatrix);
-			glm_mat4_mul(rotationMatrix, parentNodeMatrix, parentNodeMatrix);
-		}
-
-		if (parentNode->has_scale)
-			glm_scale(parentNodeMatrix, scale);
-
-		if (parentNode->has_matrix)
-			glm_mat4_make(matrix, parentNodeMatrix); // Not CGLM function
-
-		/* Start child node's loop */
-		for (c = 0; c < parentNode->children_count; c++) {
-			childNode = parentNode->children[c];
-
-			/* Clear stack array */
-			memset(translation, 0, sizeof(translation));
-			memset(rotation, 0, sizeof(rotation));
-			memset(scale, 0, sizeof(scale));
-			memset(matrix, 0, sizeof(matrix));
-			memset(childNodeMatrix, 0, sizeof(childNodeMatrix));
-			memset(rotationMatrix, 0, sizeof(rotationMatrix));
-
-			/* Copy from heap to stack */
-			memcpy(translation, childNode->translation, sizeof(translation));
-			memcpy(rotation, childNode->rotation, sizeof(rotation));
-			memcpy(scale, childNode->scale, sizeof(scale));
-			memcpy(matrix, childNode->matrix, sizeof(matrix));
-
-			glm_mat4_identity(childNodeMatrix);
-			if (childNode->has_translation)
-				glm_translate(childNodeMatrix, translation);
-
-			if (childNode->has_rotation) {
-				glm_quat_mat4(rotation, rotationMatrix);
-				glm_mat4_mul(rotationMatrix, childNodeMatrix, childNodeMatrix);
-			}
-
-			if (childNode->has_scale)
-				glm_scale(childNodeMatrix, scale);
-
-			if (childNode->has_matrix)
-				glm_mat4_make(matrix, childNodeMatrix); // Not CGLM function
-
-			/* Multiply the parent matrix by the child */
-			glm_mat4_mul(parentNodeMatrix, childNodeMatrix, childNodeMatrix);
-
-			/* copy final stack matrix into heap memory matrix */
-			memcpy(nodeData[nodeDataCount].matrixTransform, childNodeMatrix, sizeof(childNodeMatrix));
-
-			if (childNode->skin) {
-				nodeData[nodeDataCount].objectIndex = cgltf_skin_index(gltfData, childNode->skin);
-				nodeData[nodeDataCount].objectType = KMR_GLTF_LOADER_GLTF_SKIN;
-			} else if (childNode->mesh) {
-				nodeData[nodeDataCount].objectIndex = cgltf_mesh_index(gltfData, childNode->mesh);
-				nodeData[nodeDataCount].objectType = KMR_GLTF_LOADER_GLTF_MESH;
-			} else if (childNode->camera) {
-				nodeData[nodeDataCount].objectIndex = cgltf_camera_index(gltfData, childNode->camera);
-				nodeData[nodeDataCount].objectType = KMR_GLTF_LOADER_GLTF_CAMERA;
-			} else {
-				nodeData[nodeDataCount].objectIndex = cgltf_node_index(gltfData, childNode);
-				nodeData[nodeDataCount].objectType = KMR_GLTF_LOADER_GLTF_NODE;
-			}
-
-			nodeData[nodeDataCount].parentNodeIndex = cgltf_node_index(gltfData, parentNode);
-			nodeData[nodeDataCount].nodeIndex = cgltf_node_index(gltfData, childNode);
-			nodeDataCount++;
-		}
+	for (n = 0; n < sceneGraph->nodeCount; n++) {
+		node->nodeData[n].objectType = sceneGraph->objectType[n];
+		node->nodeData[n].objectIndex = sceneGraph->objectIndex[n];
+		node->nodeData[n].nodeIndex = sceneGraph->nodeIndex[n];
+		node->nodeData[n].parentNodeIndex = (sceneGraph->parent[n] == SCENE_GRAPH_NO_PARENT) ?
+			UINT32_MAX : sceneGraph->nodeIndex[sceneGraph->parent[n]];
+		memcpy(node->nodeData[n].matrixTransform, sceneGraph->worldMatrix[n], sizeof(mat4));
 	}
 
-	node->nodeDataCount = nodeDataCount;
+	node->nodeDataCount = sceneGraph->nodeCount;
+	kmr_gltf_loader_scene_graph_destroy(sceneGraph);
 	return node;
 
-exit_error_kmr_gltf_loader_material_create:
+exit_error_kmr_gltf_loader_node_create:
+	kmr_gltf_loader_scene_graph_destroy(sceneGraph);
 	kmr_gltf_loader_node_destroy(node);
 	return NULL;
 }
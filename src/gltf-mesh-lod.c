@@ -0,0 +1,949 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <float.h>
+#include <math.h>
+
+#include "gltf-mesh-lod.h"
+#include "gltf-loader-private.h"
+
+
+/***********************************************************************
+ * START OF kmr_gltf_loader_mesh_lod_{create,select,destroy} FUNCTIONS *
+ ***********************************************************************/
+
+#define MESH_LOD_LEVEL_COUNT_DEFAULT 3
+
+/* Collapse passes per level before giving up on reaching the target */
+#define MESH_LOD_PASS_MAX 64
+
+/* Weight of the planes holding open borders in place relative to triangle planes */
+#define MESH_LOD_BORDER_WEIGHT 10.0f
+
+/* Smallest cosine allowed between a triangle's normal before and after a collapse */
+#define MESH_LOD_FLIP_COSINE 0.25f
+
+#define MESH_LOD_NONE UINT32_MAX
+
+/* Collapses are bucketed by bits 20-30 of their (positive) float error */
+#define MESH_LOD_SORT_BUCKETS 2048
+
+
+enum mesh_lod_vertex_kind {
+	MESH_LOD_VERTEX_MANIFOLD = 0,
+	MESH_LOD_VERTEX_BORDER   = 1,
+	MESH_LOD_VERTEX_LOCKED   = 2,
+};
+
+
+/* Sum of plane equations (a, b, c, d) stored as a symmetric 4x4 matrix */
+struct mesh_lod_quadric {
+	float a2, b2, c2, d2;
+	float ab, ac, ad;
+	float bc, bd, cd;
+	float weight;
+};
+
+
+struct mesh_lod_collapse {
+	uint32_t v0;
+	uint32_t v1;
+	float    error;
+};
+
+
+/*
+ * Scratch memory used while simplifying a single primitive. Sized
+ * for the largest primitive of a mesh so it's only allocated once
+ * per mesh. Vertices are primitive local.
+ *
+ * @positions        - Positions scaled into a unit cube (vertexCount)
+ * @canonical        - First vertex with bit-identical attributes (vertexCount)
+ * @positionGroup    - First vertex with an identical position (vertexCount)
+ * @kind             - enum mesh_lod_vertex_kind (vertexCount)
+ * @borderNext       - Vertex following along an open border (vertexCount)
+ * @borderPrev       - Vertex preceding along an open border (vertexCount)
+ * @quadrics         - Error quadric of each vertex (vertexCount)
+ * @adjacencyOffsets - Per vertex offset into @adjacency (vertexCount + 1)
+ * @adjacency        - Triangles using each vertex (indexCount)
+ * @collapseRemap    - Vertex each vertex collapsed onto this pass (vertexCount)
+ * @collapseLocked   - Per vertex flag set once it took part in a collapse this pass (vertexCount)
+ * @collapses        - Collapse candidates (indexCount)
+ * @collapseOrder    - @collapses indices sorted by error (indexCount)
+ * @table            - Open addressing hash table (tableSize)
+ * @indices          - Current indices (indexCount)
+ */
+struct mesh_lod_scratch {
+	vec3                     *positions;
+	uint32_t                 *canonical;
+	uint32_t                 *positionGroup;
+	uint8_t                  *kind;
+	uint32_t                 *borderNext;
+	uint32_t                 *borderPrev;
+	struct mesh_lod_quadric  *quadrics;
+	uint32_t                 *adjacencyOffsets;
+	uint32_t                 *adjacency;
+	uint32_t                 *collapseRemap;
+	uint8_t                  *collapseLocked;
+	struct mesh_lod_collapse *collapses;
+	uint32_t                 *collapseOrder;
+	uint32_t                 *table;
+	uint32_t                 tableSize;
+	uint32_t                 *indices;
+};
+
+
+struct mesh_lod {
+	struct kmr_gltf_loader_mesh     *mesh;
+	struct kmr_gltf_loader_mesh_lod *lod;
+	float                           ratios[KMR_GLTF_LOADER_MESH_LOD_LEVEL_MAX];
+};
+
+
+static void
+mesh_lod_scratch_free (struct mesh_lod_scratch *scratch)
+{
+	free(scratch->positions);
+	free(scratch->canonical);
+	free(scratch->positionGroup);
+	free(scratch->kind);
+	free(scratch->borderNext);
+	free(scratch->borderPrev);
+	free(scratch->quadrics);
+	free(scratch->adjacencyOffsets);
+	free(scratch->adjacency);
+	free(scratch->collapseRemap);
+	free(scratch->collapseLocked);
+	free(scratch->collapses);
+	free(scratch->collapseOrder);
+	free(scratch->table);
+	free(scratch->indices);
+}
+
+
+static int
+mesh_lod_scratch_alloc (struct mesh_lod_scratch *scratch, uint32_t vertexCount, uint32_t indexCount)
+{
+	memset(scratch, 0, sizeof(struct mesh_lod_scratch));
+
+	scratch->tableSize = 16;
+	while (scratch->tableSize < (uint64_t) vertexCount * 2)
+		scratch->tableSize <<= 1;
+
+	scratch->positions = calloc(vertexCount, sizeof(vec3));
+	scratch->canonical = calloc(vertexCount, sizeof(uint32_t));
+	scratch->positionGroup = calloc(vertexCount, sizeof(uint32_t));
+	scratch->kind = calloc(vertexCount, sizeof(uint8_t));
+	scratch->borderNext = calloc(vertexCount, sizeof(uint32_t));
+	scratch->borderPrev = calloc(vertexCount, sizeof(uint32_t));
+	scratch->quadrics = calloc(vertexCount, sizeof(struct mesh_lod_quadric));
+	scratch->adjacencyOffsets = calloc(vertexCount + 1, sizeof(uint32_t));
+	scratch->adjacency = calloc(indexCount, sizeof(uint32_t));
+	scratch->collapseRemap = calloc(vertexCount, sizeof(uint32_t));
+	scratch->collapseLocked = calloc(vertexCount, sizeof(uint8_t));
+	scratch->collapses = calloc(indexCount, sizeof(struct mesh_lod_collapse));
+	scratch->collapseOrder = calloc(indexCount, sizeof(uint32_t));
+	scratch->table = calloc(scratch->tableSize, sizeof(uint32_t));
+	scratch->indices = calloc(indexCount, sizeof(uint32_t));
+
+	if (!scratch->positions || !scratch->canonical || !scratch->positionGroup || !scratch->kind ||
+	    !scratch->borderNext || !scratch->borderPrev || !scratch->quadrics || !scratch->adjacencyOffsets ||
+	    !scratch->adjacency || !scratch->collapseRemap || !scratch->collapseLocked || !scratch->collapses ||
+	    !scratch->collapseOrder || !scratch->table || !scratch->indices)
+	{
+		kmr_utils_log(KMR_DANGER, "[x] calloc(scratch): %s", strerror(errno));
+		mesh_lod_scratch_free(scratch);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+static void
+mesh_lod_position_get (struct kmr_gltf_loader_mesh_data *meshData, enum kmr_gltf_loader_mesh_vertex_layout vertexLayout,
+                       uint32_t v, float *position)
+{
+	uint32_t c;
+
+	switch (vertexLayout) {
+		case KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_PACKED:
+			for (c = 0; c < 3; c++) {
+				position[c] = ((float) meshData->vertexBufferDataPacked[v].position[c] / 32767.0f) *
+				              meshData->positionScale[c] + meshData->positionOffset[c];
+			}
+			break;
+		case KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_SOA:
+			glm_vec3_copy(meshData->vertexStreams.position[v], position);
+			break;
+		default:
+			glm_vec3_copy(meshData->vertexBufferData[v].position, position);
+			break;
+	}
+}
+
+
+/* FNV-1a over every vertex stream's bytes of vertex @v */
+static uint32_t
+mesh_lod_vertex_hash (struct mesh_vertex_stream *streams, uint32_t streamCount, uint32_t v)
+{
+	uint32_t s, i, hash = 2166136261u;
+	const uint8_t *bytes = NULL;
+
+	for (s = 0; s < streamCount; s++) {
+		bytes = streams[s].data + (v * streams[s].stride);
+		for (i = 0; i < streams[s].stride; i++)
+			hash = (hash ^ bytes[i]) * 16777619u;
+	}
+
+	return hash ^ (hash >> 16);
+}
+
+
+static bool
+mesh_lod_vertex_equal (struct mesh_vertex_stream *streams, uint32_t streamCount, uint32_t a, uint32_t b)
+{
+	uint32_t s;
+
+	for (s = 0; s < streamCount; s++)
+		if (memcmp(streams[s].data + (a * streams[s].stride), streams[s].data + (b * streams[s].stride), streams[s].stride))
+			return false;
+
+	return true;
+}
+
+
+static uint32_t
+mesh_lod_position_hash (const float *position)
+{
+	uint32_t c, word, hash = 2166136261u;
+
+	for (c = 0; c < 3; c++) {
+		memcpy(&word, &position[c], sizeof(uint32_t));
+		hash = (hash ^ word) * 16777619u;
+	}
+
+	return hash ^ (hash >> 16);
+}
+
+
+static void
+mesh_lod_quadric_add_plane (struct mesh_lod_quadric *q, const float *normal, float d, float weight)
+{
+	q->a2 += weight * normal[0] * normal[0];
+	q->b2 += weight * normal[1] * normal[1];
+	q->c2 += weight * normal[2] * normal[2];
+	q->d2 += weight * d * d;
+	q->ab += weight * normal[0] * normal[1];
+	q->ac += weight * normal[0] * normal[2];
+	q->ad += weight * normal[0] * d;
+	q->bc += weight * normal[1] * normal[2];
+	q->bd += weight * normal[1] * d;
+	q->cd += weight * normal[2] * d;
+	q->weight += weight;
+}
+
+
+static void
+mesh_lod_quadric_add (struct mesh_lod_quadric *dst, const struct mesh_lod_quadric *src)
+{
+	dst->a2 += src->a2; dst->b2 += src->b2; dst->c2 += src->c2; dst->d2 += src->d2;
+	dst->ab += src->ab; dst->ac += src->ac; dst->ad += src->ad;
+	dst->bc += src->bc; dst->bd += src->bd; dst->cd += src->cd;
+	dst->weight += src->weight;
+}
+
+
+/* Weighted sum of squared distances from @p to every plane of @q */
+static float
+mesh_lod_quadric_eval (const struct mesh_lod_quadric *q, const float *p)
+{
+	float x = p[0], y = p[1], z = p[2];
+
+	return fabsf((q->a2 * x * x) + (q->b2 * y * y) + (q->c2 * z * z) + q->d2 +
+	             2.0f * ((q->ab * x * y) + (q->ac * x * z) + (q->bc * y * z) +
+	                     (q->ad * x) + (q->bd * y) + (q->cd * z)));
+}
+
+
+/* Average squared distance a collapse of @v0 onto @v1 moves the surface */
+static float
+mesh_lod_collapse_error (struct mesh_lod_scratch *scratch, uint32_t v0, uint32_t v1)
+{
+	const struct mesh_lod_quadric *q0 = &scratch->quadrics[v0], *q1 = &scratch->quadrics[v1];
+	float weight = q0->weight + q1->weight;
+
+	return (mesh_lod_quadric_eval(q0, scratch->positions[v1]) + mesh_lod_quadric_eval(q1, scratch->positions[v1])) /
+	       ((weight > FLT_MIN) ? weight : 1.0f);
+}
+
+
+static bool
+mesh_lod_collapse_allowed (struct mesh_lod_scratch *scratch, uint32_t v0, uint32_t v1)
+{
+	switch (scratch->kind[v0]) {
+		case MESH_LOD_VERTEX_MANIFOLD:
+			return true;
+		case MESH_LOD_VERTEX_BORDER:
+			return scratch->borderNext[v0] == v1 || scratch->borderPrev[v0] == v1;
+		default:
+			return false;
+	}
+}
+
+
+/*
+ * Counting sort of collapses by error. Positive floats order like their bit patterns,
+ * so bucketing by exponent and top mantissa bits gives a close enough order in one pass.
+ */
+static void
+mesh_lod_collapse_sort (struct mesh_lod_scratch *scratch, uint32_t collapseCount)
+{
+	uint32_t i, key, count, sum = 0;
+	uint32_t histogram[MESH_LOD_SORT_BUCKETS];
+
+	memset(histogram, 0, sizeof(histogram));
+	for (i = 0; i < collapseCount; i++) {
+		memcpy(&key, &scratch->collapses[i].error, sizeof(uint32_t));
+		histogram[(key >> 20) & (MESH_LOD_SORT_BUCKETS - 1)]++;
+	}
+
+	for (i = 0; i < MESH_LOD_SORT_BUCKETS; i++) {
+		count = histogram[i];
+		histogram[i] = sum;
+		sum += count;
+	}
+
+	for (i = 0; i < collapseCount; i++) {
+		memcpy(&key, &scratch->collapses[i].error, sizeof(uint32_t));
+		scratch->collapseOrder[histogram[(key >> 20) & (MESH_LOD_SORT_BUCKETS - 1)]++] = i;
+	}
+}
+
+
+static void
+mesh_lod_adjacency_build (struct mesh_lod_scratch *scratch, uint32_t indexCount, uint32_t vertexCount)
+{
+	uint32_t i, v;
+
+	memset(scratch->adjacencyOffsets, 0, (vertexCount + 1) * sizeof(uint32_t));
+	for (i = 0; i < indexCount; i++)
+		scratch->adjacencyOffsets[scratch->indices[i] + 1]++;
+
+	for (v = 0; v < vertexCount; v++)
+		scratch->adjacencyOffsets[v + 1] += scratch->adjacencyOffsets[v];
+
+	/* Fill using the start offsets then shift them back into place */
+	for (i = 0; i < indexCount; i++)
+		scratch->adjacency[scratch->adjacencyOffsets[scratch->indices[i]]++] = i / 3;
+
+	for (v = vertexCount; v > 0; v--)
+		scratch->adjacencyOffsets[v] = scratch->adjacencyOffsets[v - 1];
+	scratch->adjacencyOffsets[0] = 0;
+}
+
+
+/*
+ * Whether some triangle of @a has an edge going from a vertex at the position
+ * of @b to @a (@reverse true) or from @a to a vertex at the position of @b.
+ */
+static bool
+mesh_lod_edge_find (struct mesh_lod_scratch *scratch, uint32_t a, uint32_t b, bool reverse)
+{
+	uint32_t j, k, t, other;
+
+	for (j = scratch->adjacencyOffsets[a]; j < scratch->adjacencyOffsets[a + 1]; j++) {
+		t = scratch->adjacency[j];
+		for (k = 0; k < 3; k++) {
+			if (scratch->indices[(t * 3) + k] != a)
+				continue;
+
+			other = scratch->indices[(t * 3) + ((k + (reverse ? 2 : 1)) % 3)];
+			if (scratch->positionGroup[other] == scratch->positionGroup[b])
+				return true;
+		}
+	}
+
+	return false;
+}
+
+
+/*
+ * Welds vertices with identical attributes, locks vertices on UV/normal seams
+ * (positions shared by vertices with different attributes) then finds open
+ * borders and accumulates every vertex's quadric from the planes of its
+ * triangles. Border edges add a plane perpendicular to their triangle.
+ */
+static void
+mesh_lod_primitive_init (struct mesh_lod_scratch *scratch, struct mesh_vertex_stream *streams, uint32_t streamCount,
+                         uint32_t indexCount, uint32_t vertexCount)
+{
+	uint32_t i, v, k, a, b, hash, slot, mask = scratch->tableSize - 1;
+	float area, length, d;
+	vec3 edge0, edge1, normal, edgeNormal;
+	bool open;
+
+	memset(scratch->table, 0xff, scratch->tableSize * sizeof(uint32_t));
+	for (v = 0; v < vertexCount; v++) {
+		hash = mesh_lod_vertex_hash(streams, streamCount, v) & mask;
+		while ((slot = scratch->table[hash]) != UINT32_MAX) {
+			if (mesh_lod_vertex_equal(streams, streamCount, slot, v))
+				break;
+			hash = (hash + 1) & mask;
+		}
+
+		if (slot == UINT32_MAX)
+			slot = scratch->table[hash] = v;
+		scratch->canonical[v] = slot;
+	}
+
+	memset(scratch->table, 0xff, scratch->tableSize * sizeof(uint32_t));
+	for (v = 0; v < vertexCount; v++) {
+		hash = mesh_lod_position_hash(scratch->positions[v]) & mask;
+		while ((slot = scratch->table[hash]) != UINT32_MAX) {
+			if (!memcmp(scratch->positions[slot], scratch->positions[v], sizeof(vec3)))
+				break;
+			hash = (hash + 1) & mask;
+		}
+
+		if (slot == UINT32_MAX)
+			slot = scratch->table[hash] = v;
+		scratch->positionGroup[v] = slot;
+	}
+
+	/* Count attribute variants at each position, reusing @collapseRemap */
+	memset(scratch->collapseRemap, 0, vertexCount * sizeof(uint32_t));
+	for (v = 0; v < vertexCount; v++)
+		if (scratch->canonical[v] == v)
+			scratch->collapseRemap[scratch->positionGroup[v]]++;
+
+	for (v = 0; v < vertexCount; v++) {
+		scratch->kind[v] = (scratch->collapseRemap[scratch->positionGroup[v]] > 1) ? MESH_LOD_VERTEX_LOCKED : MESH_LOD_VERTEX_MANIFOLD;
+		scratch->borderNext[v] = scratch->borderPrev[v] = MESH_LOD_NONE;
+	}
+
+	memset(scratch->quadrics, 0, vertexCount * sizeof(struct mesh_lod_quadric));
+	for (i = 0; i < indexCount; i++)
+		scratch->indices[i] = scratch->canonical[scratch->indices[i]];
+
+	mesh_lod_adjacency_build(scratch, indexCount, vertexCount);
+
+	for (i = 0; i < indexCount; i += 3) {
+		glm_vec3_sub(scratch->positions[scratch->indices[i + 1]], scratch->positions[scratch->indices[i]], edge0);
+		glm_vec3_sub(scratch->positions[scratch->indices[i + 2]], scratch->positions[scratch->indices[i]], edge1);
+		glm_vec3_cross(edge0, edge1, normal);
+
+		area = glm_vec3_norm(normal);
+		if (area < FLT_MIN)
+			continue;
+
+		glm_vec3_scale(normal, 1.0f / area, normal);
+		d = -glm_vec3_dot(normal, scratch->positions[scratch->indices[i]]);
+		for (k = 0; k < 3; k++)
+			mesh_lod_quadric_add_plane(&scratch->quadrics[scratch->indices[i + k]], normal, d, area * 0.5f);
+
+		for (k = 0; k < 3; k++) {
+			a = scratch->indices[i + k];
+			b = scratch->indices[i + ((k + 1) % 3)];
+
+			/* Seam vertices share their position with other vertices, search from whichever end doesn't */
+			if (scratch->kind[a] != MESH_LOD_VERTEX_LOCKED)
+				open = !mesh_lod_edge_find(scratch, a, b, true);
+			else if (scratch->kind[b] != MESH_LOD_VERTEX_LOCKED)
+				open = !mesh_lod_edge_find(scratch, b, a, false);
+			else
+				continue;
+
+			if (!open)
+				continue;
+
+			if (scratch->borderNext[a] != MESH_LOD_NONE && scratch->borderNext[a] != b)
+				scratch->kind[a] = MESH_LOD_VERTEX_LOCKED;
+			if (scratch->borderPrev[b] != MESH_LOD_NONE && scratch->borderPrev[b] != a)
+				scratch->kind[b] = MESH_LOD_VERTEX_LOCKED;
+
+			scratch->borderNext[a] = b;
+			scratch->borderPrev[b] = a;
+			scratch->kind[a] = (scratch->kind[a] > MESH_LOD_VERTEX_BORDER) ? scratch->kind[a] : MESH_LOD_VERTEX_BORDER;
+			scratch->kind[b] = (scratch->kind[b] > MESH_LOD_VERTEX_BORDER) ? scratch->kind[b] : MESH_LOD_VERTEX_BORDER;
+
+			glm_vec3_sub(scratch->positions[b], scratch->positions[a], edge0);
+			length = glm_vec3_norm(edge0);
+			if (length < FLT_MIN)
+				continue;
+
+			glm_vec3_cross(edge0, normal, edgeNormal);
+			glm_vec3_scale(edgeNormal, 1.0f / length, edgeNormal);
+			d = -glm_vec3_dot(edgeNormal, scratch->positions[a]);
+			mesh_lod_quadric_add_plane(&scratch->quadrics[a], edgeNormal, d, length * length * MESH_LOD_BORDER_WEIGHT);
+			mesh_lod_quadric_add_plane(&scratch->quadrics[b], edgeNormal, d, length * length * MESH_LOD_BORDER_WEIGHT);
+		}
+	}
+}
+
+
+/*
+ * Checks triangles around @v0 for a collapse onto @v1. Rejects the collapse if a triangle
+ * would flip or if @v0 also touches another attribute variant of @v1's position (moving
+ * onto one variant would smear its attributes across the seam). Returns the amount of
+ * triangles that become degenerate or UINT32_MAX if rejected.
+ */
+static uint32_t
+mesh_lod_collapse_check (struct mesh_lod_scratch *scratch, uint32_t v0, uint32_t v1)
+{
+	uint32_t j, k, t, o1, o2, degenerate = 0;
+	uint32_t *remap = scratch->collapseRemap;
+	vec3 e0, e1, before, after;
+	float *p0 = scratch->positions[v0], *p1 = scratch->positions[v1];
+
+	for (j = scratch->adjacencyOffsets[v0]; j < scratch->adjacencyOffsets[v0 + 1]; j++) {
+		t = scratch->adjacency[j];
+		for (k = 0; k < 3 && scratch->indices[(t * 3) + k] != v0; k++);
+		if (k == 3)
+			continue;
+
+		o1 = remap[scratch->indices[(t * 3) + ((k + 1) % 3)]];
+		o2 = remap[scratch->indices[(t * 3) + ((k + 2) % 3)]];
+		if (o1 == v1 || o2 == v1) {
+			degenerate++;
+			continue;
+		}
+
+		if (o1 == v0 || o2 == v0 || o1 == o2)
+			continue;
+
+		if (scratch->positionGroup[o1] == scratch->positionGroup[v1] ||
+		    scratch->positionGroup[o2] == scratch->positionGroup[v1])
+			return UINT32_MAX;
+
+		glm_vec3_sub(scratch->positions[o1], p0, e0);
+		glm_vec3_sub(scratch->positions[o2], p0, e1);
+		glm_vec3_cross(e0, e1, before);
+
+		glm_vec3_sub(scratch->positions[o1], p1, e0);
+		glm_vec3_sub(scratch->positions[o2], p1, e1);
+		glm_vec3_cross(e0, e1, after);
+
+		if (glm_vec3_dot(before, after) < MESH_LOD_FLIP_COSINE * glm_vec3_norm(before) * glm_vec3_norm(after))
+			return UINT32_MAX;
+	}
+
+	return degenerate;
+}
+
+
+/*
+ * Collapses edges in passes until @targetTriangleCount is reached. Each pass sorts
+ * every allowed collapse by error and performs them cheapest first. A vertex takes
+ * part in at most one collapse per pass so the adjacency stays valid. The pass
+ * stops once errors grow past 1.5x the error of the collapse that would reach the
+ * target if all collapses succeeded, leaving the rest for a pass with updated costs.
+ * Passes where most cheap collapses got rejected carry on past that error instead of
+ * crawling forward one collapse at a time.
+ */
+static uint32_t
+mesh_lod_primitive_simplify (struct mesh_lod_scratch *scratch, uint32_t indexCount, uint32_t vertexCount,
+                             uint32_t targetTriangleCount, float *maxError)
+{
+	uint32_t i, j, k, v, a, b, c, v0, v1, prev, next, degenerate, goal, collapseCount, collapsed;
+	uint32_t triangleCount = indexCount / 3, pass;
+	float errorLimit, errorAB, errorBA;
+	struct mesh_lod_collapse *collapse = NULL;
+
+	for (pass = 0; pass < MESH_LOD_PASS_MAX && triangleCount > targetTriangleCount; pass++) {
+		mesh_lod_adjacency_build(scratch, triangleCount * 3, vertexCount);
+
+		collapseCount = 0;
+		for (i = 0; i < triangleCount * 3; i++) {
+			a = scratch->indices[i];
+			b = scratch->indices[((i / 3) * 3) + ((i + 1) % 3)];
+
+			/* Shared edges are seen from both triangles, only keep one */
+			if (a > b && mesh_lod_edge_find(scratch, b, a, false))
+				continue;
+
+			errorAB = mesh_lod_collapse_allowed(scratch, a, b) ? mesh_lod_collapse_error(scratch, a, b) : FLT_MAX;
+			errorBA = mesh_lod_collapse_allowed(scratch, b, a) ? mesh_lod_collapse_error(scratch, b, a) : FLT_MAX;
+			if (errorAB == FLT_MAX && errorBA == FLT_MAX)
+				continue;
+
+			collapse = &scratch->collapses[collapseCount++];
+			collapse->v0 = (errorAB <= errorBA) ? a : b;
+			collapse->v1 = (errorAB <= errorBA) ? b : a;
+			collapse->error = (errorAB <= errorBA) ? errorAB : errorBA;
+		}
+
+		if (!collapseCount)
+			break;
+
+		mesh_lod_collapse_sort(scratch, collapseCount);
+
+		/* Interior collapses remove two triangles */
+		goal = (triangleCount - targetTriangleCount) / 2;
+		goal = (goal < collapseCount) ? goal : collapseCount - 1;
+		errorLimit = scratch->collapses[scratch->collapseOrder[goal]].error * 1.5f;
+
+		/* Close to the target, finish in this pass instead of trickling on for many more */
+		if ((uint64_t) goal * 32 < triangleCount)
+			errorLimit = FLT_MAX;
+
+		for (v = 0; v < vertexCount; v++)
+			scratch->collapseRemap[v] = v;
+		memset(scratch->collapseLocked, 0, vertexCount);
+
+		for (j = 0, k = triangleCount, collapsed = 0; j < collapseCount && k > targetTriangleCount; j++) {
+			collapse = &scratch->collapses[scratch->collapseOrder[j]];
+			if (collapse->error > errorLimit && collapsed > goal / 4)
+				break;
+
+			v0 = collapse->v0; v1 = collapse->v1;
+			if (scratch->collapseLocked[v0] || scratch->collapseLocked[v1])
+				continue;
+
+			degenerate = mesh_lod_collapse_check(scratch, v0, v1);
+			if (degenerate == UINT32_MAX)
+				continue;
+
+			if (scratch->kind[v0] == MESH_LOD_VERTEX_BORDER) {
+				prev = scratch->borderPrev[v0];
+				next = scratch->borderNext[v0];
+				if (next == v1) {
+					scratch->borderPrev[v1] = prev;
+					if (prev != MESH_LOD_NONE)
+						scratch->borderNext[prev] = v1;
+				} else {
+					scratch->borderNext[v1] = next;
+					if (next != MESH_LOD_NONE)
+						scratch->borderPrev[next] = v1;
+				}
+			}
+
+			mesh_lod_quadric_add(&scratch->quadrics[v1], &scratch->quadrics[v0]);
+			scratch->collapseRemap[v0] = v1;
+			scratch->collapseLocked[v0] = scratch->collapseLocked[v1] = 1;
+			*maxError = (collapse->error > *maxError) ? collapse->error : *maxError;
+			k = (k > degenerate) ? k - degenerate : 0;
+			collapsed++;
+		}
+
+		if (!collapsed)
+			break;
+
+		/* Apply collapses dropping triangles that lost their area */
+		for (i = 0, j = 0; i < triangleCount; i++) {
+			a = scratch->collapseRemap[scratch->indices[(i * 3) + 0]];
+			b = scratch->collapseRemap[scratch->indices[(i * 3) + 1]];
+			c = scratch->collapseRemap[scratch->indices[(i * 3) + 2]];
+			if (a == b || b == c || a == c)
+				continue;
+
+			scratch->indices[(j * 3) + 0] = a;
+			scratch->indices[(j * 3) + 1] = b;
+			scratch->indices[(j * 3) + 2] = c;
+			j++;
+		}
+
+		triangleCount = j;
+	}
+
+	return triangleCount * 3;
+}
+
+
+static void
+mesh_lod_index_write (VkIndexType indexType, void *dst, uint32_t i, uint32_t index)
+{
+	if (indexType == VK_INDEX_TYPE_UINT16)
+		((uint16_t *) dst)[i] = (uint16_t) index;
+	else
+		((uint32_t *) dst)[i] = index;
+}
+
+
+static int
+mesh_lod_job_run (void *userData, uint32_t jobIndex)
+{
+	uint32_t p, l, i, v, c, streamCount, indexCount, triangleCount, originalTriangleCount, vertexCount = 0, maxIndexCount = 0;
+	float extent, maxError, error;
+	vec3 aabbMin, aabbMax;
+	bool simplify;
+
+	struct mesh_lod_scratch scratch;
+	struct mesh_vertex_stream streams[KMR_GLTF_LOADER_MESH_VERTEX_ATTRIBUTE_COUNT];
+	struct mesh_lod *meshLod = userData;
+	struct kmr_gltf_loader_mesh_data *meshData = &meshLod->mesh->meshData[jobIndex];
+	struct kmr_gltf_loader_mesh_lod_data *lodData = &meshLod->lod->lodData[jobIndex];
+	struct kmr_gltf_loader_mesh_lod_level *level = NULL;
+	struct kmr_gltf_loader_mesh_primitive *primitive = NULL;
+
+	for (p = 0; p < meshData->primitiveCount; p++) {
+		primitive = &meshData->primitives[p];
+		vertexCount = (primitive->vertexCount > vertexCount) ? primitive->vertexCount : vertexCount;
+		maxIndexCount = (primitive->indexCount > maxIndexCount) ? primitive->indexCount : maxIndexCount;
+	}
+
+	if (mesh_lod_scratch_alloc(&scratch, vertexCount + 1, maxIndexCount + 1) == -1)
+		return -1;
+
+	streamCount = mesh_vertex_streams_get(meshData, meshLod->mesh->vertexLayout, streams);
+
+	/* Levels are written primitive by primitive at offsets known up front, see kmr_gltf_loader_mesh_lod_create() */
+	for (p = 0; p < meshData->primitiveCount; p++) {
+		primitive = &meshData->primitives[p];
+		indexCount = primitive->indexCount - (primitive->indexCount % 3);
+
+		simplify = primitive->type == cgltf_primitive_type_triangles && indexCount >= 3;
+		for (i = 0; simplify && i < indexCount; i++) {
+			scratch.indices[i] = mesh_index_get(meshData, primitive->firstIndex + i) - primitive->firstVertex;
+			simplify = scratch.indices[i] < primitive->vertexCount;
+		}
+
+		if (!simplify) {
+			for (l = 0; l < meshLod->lod->levelCount; l++) {
+				level = &lodData->levels[l];
+				for (i = 0; i < primitive->indexCount; i++)
+					mesh_lod_index_write(lodData->indexType, lodData->indexBufferData, level->primitives[p].firstIndex + i,
+					                     mesh_index_get(meshData, primitive->firstIndex + i));
+				level->primitives[p].indexCount = primitive->indexCount;
+			}
+			continue;
+		}
+
+		/* Scale positions into a unit cube so error thresholds don't depend on model size */
+		for (v = 0; v < primitive->vertexCount; v++)
+			mesh_lod_position_get(meshData, meshLod->mesh->vertexLayout, primitive->firstVertex + v, scratch.positions[v]);
+
+		glm_vec3_copy(scratch.positions[0], aabbMin);
+		glm_vec3_copy(scratch.positions[0], aabbMax);
+		for (v = 1; v < primitive->vertexCount; v++) {
+			glm_vec3_minv(aabbMin, scratch.positions[v], aabbMin);
+			glm_vec3_maxv(aabbMax, scratch.positions[v], aabbMax);
+		}
+
+		for (extent = 0.0f, c = 0; c < 3; c++)
+			extent = (aabbMax[c] - aabbMin[c] > extent) ? aabbMax[c] - aabbMin[c] : extent;
+		extent = (extent > FLT_MIN) ? extent : 1.0f;
+
+		for (v = 0; v < primitive->vertexCount; v++) {
+			glm_vec3_sub(scratch.positions[v], aabbMin, scratch.positions[v]);
+			glm_vec3_scale(scratch.positions[v], 1.0f / extent, scratch.positions[v]);
+		}
+
+		for (i = 0; i < streamCount; i++)
+			streams[i].data += primitive->firstVertex * streams[i].stride;
+
+		mesh_lod_primitive_init(&scratch, streams, streamCount, indexCount, primitive->vertexCount);
+
+		for (i = 0; i < streamCount; i++)
+			streams[i].data -= primitive->firstVertex * streams[i].stride;
+
+		maxError = 0.0f;
+		originalTriangleCount = indexCount / 3;
+		for (l = 0; l < meshLod->lod->levelCount; l++) {
+			level = &lodData->levels[l];
+			triangleCount = (uint32_t) ((float) originalTriangleCount * meshLod->ratios[l]);
+			indexCount = mesh_lod_primitive_simplify(&scratch, indexCount, primitive->vertexCount,
+			                                         (triangleCount) ? triangleCount : 1, &maxError);
+
+			for (i = 0; i < indexCount; i++)
+				mesh_lod_index_write(lodData->indexType, lodData->indexBufferData, level->primitives[p].firstIndex + i,
+				                     scratch.indices[i] + primitive->firstVertex);
+			level->primitives[p].indexCount = indexCount;
+
+			error = sqrtf(maxError) * extent;
+			level->error = (error > level->error) ? error : level->error;
+		}
+	}
+
+	mesh_lod_scratch_free(&scratch);
+
+	return 0;
+}
+
+
+struct kmr_gltf_loader_mesh_lod *
+kmr_gltf_loader_mesh_lod_create (struct kmr_gltf_loader_mesh_lod_create_info *lodInfo)
+{
+	uint32_t m, p, l, j, rangeCount = 0, indexCount, indexSize, offset = 0;
+	uint64_t boundSize = 0;
+	float ratio = 1.0f;
+
+	struct mesh_lod meshLod;
+	struct kmr_utils_worker_pool_run_info workerPoolRunInfo;
+	struct kmr_gltf_loader_mesh *mesh = lodInfo->mesh;
+	struct kmr_gltf_loader_mesh_data *meshData = NULL;
+	struct kmr_gltf_loader_mesh_lod_data *lodData = NULL;
+	struct kmr_gltf_loader_mesh_lod_level *level = NULL;
+	struct kmr_gltf_loader_mesh_lod *lod = NULL;
+	struct kmr_gltf_loader_mesh_lod_range *ranges = NULL;
+	uint8_t *indexBuffer = NULL;
+	void *shrunk = NULL;
+
+	lod = calloc(1, sizeof(struct kmr_gltf_loader_mesh_lod));
+	if (!lod) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(lod): %s", strerror(errno));
+		return NULL;
+	}
+
+	lod->levelCount = (lodInfo->levelCount) ? lodInfo->levelCount : MESH_LOD_LEVEL_COUNT_DEFAULT;
+	lod->levelCount = (lod->levelCount < KMR_GLTF_LOADER_MESH_LOD_LEVEL_MAX) ? lod->levelCount : KMR_GLTF_LOADER_MESH_LOD_LEVEL_MAX;
+
+	/* Each level must be coarser than the previous one */
+	for (l = 0; l < lod->levelCount; l++) {
+		if (lodInfo->ratios[l] > 0.0f && lodInfo->ratios[l] < ratio)
+			ratio = lodInfo->ratios[l];
+		else
+			ratio *= 0.5f;
+		meshLod.ratios[l] = ratio;
+	}
+
+	lod->lodDataCount = mesh->meshDataCount;
+	lod->lodData = calloc(lod->lodDataCount, sizeof(struct kmr_gltf_loader_mesh_lod_data));
+	if (!lod->lodData) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(lod->lodData): %s", strerror(errno));
+		goto exit_error_kmr_gltf_loader_mesh_lod_create;
+	}
+
+	for (m = 0; m < mesh->meshDataCount; m++) {
+		indexSize = (mesh->meshData[m].indexType == VK_INDEX_TYPE_UINT16) ? sizeof(uint16_t) : sizeof(uint32_t);
+		boundSize += MESH_ARENA_ALIGN((uint64_t) mesh->meshData[m].indexBufferDataCount * indexSize * lod->levelCount);
+		rangeCount += mesh->meshData[m].primitiveCount * lod->levelCount;
+	}
+
+	if (boundSize > UINT32_MAX) {
+		kmr_utils_log(KMR_DANGER, "[x] kmr_gltf_loader_mesh_lod_create: LOD index data exceeds 4GiB");
+		goto exit_error_kmr_gltf_loader_mesh_lod_create;
+	}
+
+	lod->ranges = ranges = calloc(rangeCount + 1, sizeof(struct kmr_gltf_loader_mesh_lod_range));
+	lod->indexBuffer = indexBuffer = calloc(boundSize + 1, sizeof(uint8_t));
+	if (!ranges || !indexBuffer) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(lod->indexBuffer): %s", strerror(errno));
+		goto exit_error_kmr_gltf_loader_mesh_lod_create;
+	}
+
+	/* Reserve room for every level being as large as the mesh itself */
+	for (m = 0; m < mesh->meshDataCount; m++) {
+		meshData = &mesh->meshData[m];
+		lodData = &lod->lodData[m];
+		lodData->indexType = meshData->indexType;
+		lodData->indexBufferData = (uint32_t *) (indexBuffer + offset);
+
+		for (l = 0, j = 0; l < lod->levelCount; l++) {
+			lodData->levels[l].primitives = ranges;
+			for (p = 0; p < meshData->primitiveCount; p++, j += meshData->primitives[p - 1].indexCount)
+				ranges[p].firstIndex = j;
+			ranges += meshData->primitiveCount;
+		}
+
+		indexSize = (meshData->indexType == VK_INDEX_TYPE_UINT16) ? sizeof(uint16_t) : sizeof(uint32_t);
+		offset += MESH_ARENA_ALIGN(j * indexSize);
+	}
+
+	meshLod.mesh = mesh;
+	meshLod.lod = lod;
+
+	workerPoolRunInfo.threadCount = lodInfo->threadCount;
+	workerPoolRunInfo.jobCount = mesh->meshDataCount;
+	workerPoolRunInfo.job = mesh_lod_job_run;
+	workerPoolRunInfo.userData = &meshLod;
+
+	if (kmr_utils_worker_pool_run(&workerPoolRunInfo) == -1)
+		goto exit_error_kmr_gltf_loader_mesh_lod_create;
+
+	/* Squeeze out room levels didn't need. Data only ever moves towards the start of the block. */
+	for (m = 0, offset = 0; m < mesh->meshDataCount; m++) {
+		meshData = &mesh->meshData[m];
+		lodData = &lod->lodData[m];
+		indexSize = (lodData->indexType == VK_INDEX_TYPE_UINT16) ? sizeof(uint16_t) : sizeof(uint32_t);
+		indexCount = 0;
+
+		for (l = 0; l < lod->levelCount; l++) {
+			level = &lodData->levels[l];
+			level->firstIndex = indexCount;
+
+			for (p = 0; p < meshData->primitiveCount; p++) {
+				memmove(indexBuffer + offset + (indexCount * indexSize),
+				        (uint8_t *) lodData->indexBufferData + (level->primitives[p].firstIndex * indexSize),
+				        level->primitives[p].indexCount * indexSize);
+				level->primitives[p].firstIndex = indexCount;
+				indexCount += level->primitives[p].indexCount;
+			}
+
+			level->indexCount = indexCount - level->firstIndex;
+			if (l && level->error < lodData->levels[l - 1].error)
+				level->error = lodData->levels[l - 1].error;
+		}
+
+		lodData->indexBufferDataCount = indexCount;
+		lodData->indexBufferDataSize = indexCount * indexSize;
+		lodData->indexBufferDataOffset = offset;
+		offset += MESH_ARENA_ALIGN(lodData->indexBufferDataSize);
+	}
+
+	lod->indexBufferSize = offset;
+	shrunk = realloc(indexBuffer, offset + 1);
+	if (shrunk)
+		lod->indexBuffer = indexBuffer = shrunk;
+
+	for (m = 0; m < mesh->meshDataCount; m++)
+		lod->lodData[m].indexBufferData = (uint32_t *) (indexBuffer + lod->lodData[m].indexBufferDataOffset);
+
+	return lod;
+
+exit_error_kmr_gltf_loader_mesh_lod_create:
+	kmr_gltf_loader_mesh_lod_destroy(lod);
+	return NULL;
+}
+
+
+uint32_t
+kmr_gltf_loader_mesh_lod_select (struct kmr_gltf_loader_mesh_lod_select_info *selectInfo)
+{
+	uint32_t level, c;
+	float scale = 0.0f, length, distance, pixelError;
+	vec3 center;
+
+	struct kmr_gltf_loader_mesh_data *meshData = &selectInfo->mesh->meshData[selectInfo->meshIndex];
+	struct kmr_gltf_loader_mesh_lod_data *lodData = &selectInfo->lod->lodData[selectInfo->meshIndex];
+	const float *m = (const float *) selectInfo->modelView;
+
+	if (meshData->sphereRadius < 0.0f)
+		return 0;
+
+	for (c = 0; c < 3; c++) {
+		center[c] = m[c] * meshData->sphereCenter[0] + m[4 + c] * meshData->sphereCenter[1] +
+		            m[8 + c] * meshData->sphereCenter[2] + m[12 + c];
+		length = sqrtf(m[c * 4] * m[c * 4] + m[(c * 4) + 1] * m[(c * 4) + 1] + m[(c * 4) + 2] * m[(c * 4) + 2]);
+		scale = (length > scale) ? length : scale;
+	}
+
+	/* Closest point of the bounding sphere to the camera */
+	distance = glm_vec3_norm(center) - (meshData->sphereRadius * scale);
+	if (distance <= 0.0f)
+		return 0;
+
+	pixelError = (selectInfo->pixelError > 0.0f) ? selectInfo->pixelError : 1.0f;
+	for (level = selectInfo->lod->levelCount; level > 0; level--)
+		if (lodData->levels[level - 1].error * scale * selectInfo->projectionScale <= pixelError * distance)
+			return level;
+
+	return 0;
+}
+
+
+void
+kmr_gltf_loader_mesh_lod_destroy (struct kmr_gltf_loader_mesh_lod *lod)
+{
+	if (!lod)
+		return;
+
+	free(lod->lodData);
+	free(lod->indexBuffer);
+	free(lod->ranges);
+	free(lod);
+}
+
+/*********************************************************************
+ * END OF kmr_gltf_loader_mesh_lod_{create,select,destroy} FUNCTIONS *
+ *********************************************************************/
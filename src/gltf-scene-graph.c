@@ -0,0 +1,702 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "gltf-scene-graph.h"
+#include "gltf-loader-private.h"
+
+
+/**************************************************************************
+ * START OF kmr_gltf_loader_scene_graph_{create,update,destroy} FUNCTIONS *
+ **************************************************************************/
+
+#define SCENE_GRAPH_ALIGNMENT 64
+
+
+static void
+matrix_multiply_scalar (mat4 *dst, const mat4 *a, const uint32_t *aIndex, const mat4 *b, uint32_t start, uint32_t end)
+{
+	uint32_t n, c, r;
+	const float *x, *y;
+	float *d;
+
+	for (n = start; n < end; n++) {
+		if (aIndex[n] == SCENE_GRAPH_NO_PARENT) {
+			memcpy(dst[n], b[n], sizeof(mat4));
+			continue;
+		}
+
+		x = (const float *) a[aIndex[n]];
+		y = (const float *) b[n];
+		d = (float *) dst[n];
+
+		for (c = 0; c < 4; c++) {
+			for (r = 0; r < 4; r++) {
+				d[c*4+r] = x[0*4+r] * y[c*4+0] + x[1*4+r] * y[c*4+1] +
+				           x[2*4+r] * y[c*4+2] + x[3*4+r] * y[c*4+3];
+			}
+		}
+	}
+}
+
+
+#ifdef HAVE_X86_SIMD
+
+__attribute__((target("sse2")))
+static void
+matrix_multiply_sse2 (mat4 *dst, const mat4 *a, const uint32_t *aIndex, const mat4 *b, uint32_t start, uint32_t end)
+{
+	uint32_t n, c;
+	const float *x, *y;
+	float *d;
+	__m128 a0, a1, a2, a3, col;
+
+	for (n = start; n < end; n++) {
+		if (aIndex[n] == SCENE_GRAPH_NO_PARENT) {
+			memcpy(dst[n], b[n], sizeof(mat4));
+			continue;
+		}
+
+		x = (const float *) a[aIndex[n]];
+		y = (const float *) b[n];
+		d = (float *) dst[n];
+
+		a0 = _mm_loadu_ps(x + 0);
+		a1 = _mm_loadu_ps(x + 4);
+		a2 = _mm_loadu_ps(x + 8);
+		a3 = _mm_loadu_ps(x + 12);
+
+		/* Each output column is a linear combination of the left matrix columns */
+		for (c = 0; c < 4; c++) {
+			col = _mm_mul_ps(a0, _mm_set1_ps(y[c*4+0]));
+			col = _mm_add_ps(col, _mm_mul_ps(a1, _mm_set1_ps(y[c*4+1])));
+			col = _mm_add_ps(col, _mm_mul_ps(a2, _mm_set1_ps(y[c*4+2])));
+			col = _mm_add_ps(col, _mm_mul_ps(a3, _mm_set1_ps(y[c*4+3])));
+			_mm_storeu_ps(d + c*4, col);
+		}
+	}
+}
+
+
+__attribute__((target("avx")))
+static void
+matrix_multiply_avx (mat4 *dst, const mat4 *a, const uint32_t *aIndex, const mat4 *b, uint32_t start, uint32_t end)
+{
+	uint32_t n;
+	const float *x, *y;
+	float *d;
+	__m256 a0, a1, a2, a3, b01, b23, d01, d23;
+
+	for (n = start; n < end; n++) {
+		if (aIndex[n] == SCENE_GRAPH_NO_PARENT) {
+			memcpy(dst[n], b[n], sizeof(mat4));
+			continue;
+		}
+
+		x = (const float *) a[aIndex[n]];
+		y = (const float *) b[n];
+		d = (float *) dst[n];
+
+		/* Left matrix columns duplicated into both lanes, two output columns per register */
+		a0 = _mm256_broadcast_ps((const __m128 *) (x + 0));
+		a1 = _mm256_broadcast_ps((const __m128 *) (x + 4));
+		a2 = _mm256_broadcast_ps((const __m128 *) (x + 8));
+		a3 = _mm256_broadcast_ps((const __m128 *) (x + 12));
+		b01 = _mm256_loadu_ps(y + 0);
+		b23 = _mm256_loadu_ps(y + 8);
+
+		d01 = _mm256_mul_ps(a0, _mm256_shuffle_ps(b01, b01, 0x00));
+		d01 = _mm256_add_ps(d01, _mm256_mul_ps(a1, _mm256_shuffle_ps(b01, b01, 0x55)));
+		d01 = _mm256_add_ps(d01, _mm256_mul_ps(a2, _mm256_shuffle_ps(b01, b01, 0xAA)));
+		d01 = _mm256_add_ps(d01, _mm256_mul_ps(a3, _mm256_shuffle_ps(b01, b01, 0xFF)));
+
+		d23 = _mm256_mul_ps(a0, _mm256_shuffle_ps(b23, b23, 0x00));
+		d23 = _mm256_add_ps(d23, _mm256_mul_ps(a1, _mm256_shuffle_ps(b23, b23, 0x55)));
+		d23 = _mm256_add_ps(d23, _mm256_mul_ps(a2, _mm256_shuffle_ps(b23, b23, 0xAA)));
+		d23 = _mm256_add_ps(d23, _mm256_mul_ps(a3, _mm256_shuffle_ps(b23, b23, 0xFF)));
+
+		_mm256_storeu_ps(d + 0, d01);
+		_mm256_storeu_ps(d + 8, d23);
+	}
+}
+
+#endif /* HAVE_X86_SIMD */
+
+
+static struct scene_graph_kernels scene_graph_kernels;
+static pthread_once_t scene_graph_kernels_once = PTHREAD_ONCE_INIT;
+
+
+static void
+scene_graph_kernels_init (void)
+{
+	scene_graph_kernels.matrix_multiply = matrix_multiply_scalar;
+
+#ifdef HAVE_X86_SIMD
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("sse2"))
+		scene_graph_kernels.matrix_multiply = matrix_multiply_sse2;
+
+	if (__builtin_cpu_supports("avx"))
+		scene_graph_kernels.matrix_multiply = matrix_multiply_avx;
+#endif
+}
+
+
+const struct scene_graph_kernels *
+kmr_gltf_loader_scene_graph_kernels_get (void)
+{
+	pthread_once(&scene_graph_kernels_once, scene_graph_kernels_init);
+	return &scene_graph_kernels;
+}
+
+
+/* Local matrix = T * R * S */
+static void
+scene_graph_local_compose (const float *t, const float *q, const float *s, float *m)
+{
+	float xx = q[0] * q[0], yy = q[1] * q[1], zz = q[2] * q[2];
+	float xy = q[0] * q[1], xz = q[0] * q[2], yz = q[1] * q[2];
+	float wx = q[3] * q[0], wy = q[3] * q[1], wz = q[3] * q[2];
+
+	m[0]  = (1.0f - 2.0f * (yy + zz)) * s[0];
+	m[1]  = (2.0f * (xy + wz)) * s[0];
+	m[2]  = (2.0f * (xz - wy)) * s[0];
+	m[3]  = 0.0f;
+
+	m[4]  = (2.0f * (xy - wz)) * s[1];
+	m[5]  = (1.0f - 2.0f * (xx + zz)) * s[1];
+	m[6]  = (2.0f * (yz + wx)) * s[1];
+	m[7]  = 0.0f;
+
+	m[8]  = (2.0f * (xz + wy)) * s[2];
+	m[9]  = (2.0f * (yz - wx)) * s[2];
+	m[10] = (1.0f - 2.0f * (xx + yy)) * s[2];
+	m[11] = 0.0f;
+
+	m[12] = t[0];
+	m[13] = t[1];
+	m[14] = t[2];
+	m[15] = 1.0f;
+}
+
+
+/*
+ * Splits a column-major affine matrix into translation, rotation and scale.
+ * GLTF only allows node matrices that are decomposable into TRS.
+ */
+static void
+scene_graph_local_decompose (const float *m, float *t, float *q, float *s)
+{
+	uint32_t c;
+	float r[9], trace, k;
+
+	t[0] = m[12]; t[1] = m[13]; t[2] = m[14];
+
+	for (c = 0; c < 3; c++)
+		s[c] = sqrtf(m[c*4+0] * m[c*4+0] + m[c*4+1] * m[c*4+1] + m[c*4+2] * m[c*4+2]);
+
+	/* Mirrored basis, fold the reflection into the x scale */
+	if (m[0] * (m[5] * m[10] - m[9] * m[6]) -
+	    m[4] * (m[1] * m[10] - m[9] * m[2]) +
+	    m[8] * (m[1] * m[6] - m[5] * m[2]) < 0.0f)
+		s[0] = -s[0];
+
+	for (c = 0; c < 3; c++) {
+		k = (s[c] != 0.0f) ? 1.0f / s[c] : 0.0f;
+		r[c*3+0] = m[c*4+0] * k;
+		r[c*3+1] = m[c*4+1] * k;
+		r[c*3+2] = m[c*4+2] * k;
+	}
+
+	/* r[col*3+row], pick the largest diagonal term to stay numerically stable */
+	trace = r[0] + r[4] + r[8];
+	if (trace > 0.0f) {
+		k = 0.5f / sqrtf(trace + 1.0f);
+		q[3] = 0.25f / k;
+		q[0] = (r[5] - r[7]) * k;
+		q[1] = (r[6] - r[2]) * k;
+		q[2] = (r[1] - r[3]) * k;
+	} else if (r[0] > r[4] && r[0] > r[8]) {
+		k = 2.0f * sqrtf(1.0f + r[0] - r[4] - r[8]);
+		q[3] = (r[5] - r[7]) / k;
+		q[0] = 0.25f * k;
+		q[1] = (r[3] + r[1]) / k;
+		q[2] = (r[6] + r[2]) / k;
+	} else if (r[4] > r[8]) {
+		k = 2.0f * sqrtf(1.0f + r[4] - r[0] - r[8]);
+		q[3] = (r[6] - r[2]) / k;
+		q[0] = (r[3] + r[1]) / k;
+		q[1] = 0.25f * k;
+		q[2] = (r[7] + r[5]) / k;
+	} else {
+		k = 2.0f * sqrtf(1.0f + r[8] - r[0] - r[4]);
+		q[3] = (r[1] - r[3]) / k;
+		q[0] = (r[6] + r[2]) / k;
+		q[1] = (r[7] + r[5]) / k;
+		q[2] = 0.25f * k;
+	}
+}
+
+
+static void
+scene_graph_object_get (cgltf_data *gltfData,
+                        cgltf_node *gltfNode,
+                        enum kmr_gltf_loader_gltf_object_type *objectType,
+                        uint32_t *objectIndex)
+{
+	if (gltfNode->skin) {
+		*objectIndex = cgltf_skin_index(gltfData, gltfNode->skin);
+		*objectType = KMR_GLTF_LOADER_GLTF_SKIN;
+	} else if (gltfNode->mesh) {
+		*objectIndex = cgltf_mesh_index(gltfData, gltfNode->mesh);
+		*objectType = KMR_GLTF_LOADER_GLTF_MESH;
+	} else if (gltfNode->camera) {
+		*objectIndex = cgltf_camera_index(gltfData, gltfNode->camera);
+		*objectType = KMR_GLTF_LOADER_GLTF_CAMERA;
+	} else {
+		*objectIndex = cgltf_node_index(gltfData, gltfNode);
+		*objectType = KMR_GLTF_LOADER_GLTF_NODE;
+	}
+}
+
+
+struct kmr_gltf_loader_scene_graph *
+kmr_gltf_loader_scene_graph_create (struct kmr_gltf_loader_scene_graph_create_info *sceneGraphInfo)
+{
+	uint32_t n, c, gltfNodeCount, nodeCount = 0, stackCount = 0;
+	size_t offset = 0, offsets[13];
+	uint8_t *block = NULL;
+
+	cgltf_data *gltfData = NULL;
+	cgltf_scene *scene = NULL;
+	cgltf_node *gltfNode = NULL;
+
+	struct { uint32_t node, parent; } *stack = NULL;
+	struct kmr_gltf_loader_scene_graph *sceneGraph = NULL;
+
+	gltfData = sceneGraphInfo->gltfFile->gltfData;
+	if (sceneGraphInfo->sceneIndex >= gltfData->scenes_count) {
+		kmr_utils_log(KMR_DANGER, "[x] kmr_gltf_loader_scene_graph_create: scene %u out of range, file has %zu scene(s)",
+		              sceneGraphInfo->sceneIndex, gltfData->scenes_count);
+		return NULL;
+	}
+
+	scene = &gltfData->scenes[sceneGraphInfo->sceneIndex];
+	gltfNodeCount = gltfData->nodes_count;
+
+	sceneGraph = calloc(1, sizeof(struct kmr_gltf_loader_scene_graph));
+	if (!sceneGraph) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(sceneGraph): %s", strerror(errno));
+		goto exit_error_kmr_gltf_loader_scene_graph_create;
+	}
+
+	/*
+	 * Every array is sized for all nodes in the file, a scene can't reference more.
+	 * Single allocation, widest elements first so every array is naturally aligned.
+	 */
+	offsets[0] = offset; offset += gltfNodeCount * sizeof(mat4);     /* localMatrix */
+	offsets[1] = offset; offset += gltfNodeCount * sizeof(mat4);     /* worldMatrix */
+	offsets[2] = offset; offset += gltfNodeCount * sizeof(versor);   /* rotation */
+	offsets[3] = offset; offset += gltfNodeCount * sizeof(vec3);     /* translation */
+	offsets[4] = offset; offset += gltfNodeCount * sizeof(vec3);     /* scale */
+	offsets[5] = offset; offset += gltfNodeCount * sizeof(uint32_t); /* nodeIndex */
+	offsets[6] = offset; offset += gltfNodeCount * sizeof(uint32_t); /* parent */
+	offsets[7] = offset; offset += gltfNodeCount * sizeof(uint32_t); /* subtreeSize */
+	offsets[8] = offset; offset += gltfNodeCount * sizeof(uint32_t); /* objectIndex */
+	offsets[9] = offset; offset += gltfNodeCount * sizeof(enum kmr_gltf_loader_gltf_object_type);
+	offsets[10] = offset; offset += gltfNodeCount * sizeof(uint32_t); /* gltfNodeMap */
+	offsets[11] = offset; offset += gltfNodeCount * sizeof(uint32_t); /* meshIndex */
+	offsets[12] = offset; offset += gltfNodeCount * sizeof(bool);     /* dirty */
+	offset = (offset + SCENE_GRAPH_ALIGNMENT - 1) & ~((size_t) SCENE_GRAPH_ALIGNMENT - 1);
+
+	block = aligned_alloc(SCENE_GRAPH_ALIGNMENT, offset ? offset : SCENE_GRAPH_ALIGNMENT);
+	if (!block) {
+		kmr_utils_log(KMR_DANGER, "[x] aligned_alloc(sceneGraph): %s", strerror(errno));
+		goto exit_error_kmr_gltf_loader_scene_graph_create;
+	}
+
+	memset(block, 0, offset);
+	sceneGraph->localMatrix = (mat4 *) (block + offsets[0]);
+	sceneGraph->worldMatrix = (mat4 *) (block + offsets[1]);
+	sceneGraph->rotation = (versor *) (block + offsets[2]);
+	sceneGraph->translation = (vec3 *) (block + offsets[3]);
+	sceneGraph->scale = (vec3 *) (block + offsets[4]);
+	sceneGraph->nodeIndex = (uint32_t *) (block + offsets[5]);
+	sceneGraph->parent = (uint32_t *) (block + offsets[6]);
+	sceneGraph->subtreeSize = (uint32_t *) (block + offsets[7]);
+	sceneGraph->objectIndex = (uint32_t *) (block + offsets[8]);
+	sceneGraph->objectType = (enum kmr_gltf_loader_gltf_object_type *) (block + offsets[9]);
+	sceneGraph->gltfNodeMap = (uint32_t *) (block + offsets[10]);
+	sceneGraph->meshIndex = (uint32_t *) (block + offsets[11]);
+	sceneGraph->dirty = (bool *) (block + offsets[12]);
+	sceneGraph->gltfNodeCount = gltfNodeCount;
+
+	for (n = 0; n < gltfNodeCount; n++)
+		sceneGraph->gltfNodeMap[n] = SCENE_GRAPH_NO_PARENT;
+
+	stack = calloc(gltfNodeCount + 1, sizeof(*stack));
+	if (!stack) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(stack): %s", strerror(errno));
+		goto exit_error_kmr_gltf_loader_scene_graph_create;
+	}
+
+	/*
+	 * Iterative depth-first traversal. Children are pushed in reverse so they pop in
+	 * file order. A node is claimed (mapped) when pushed, which bounds the stack to
+	 * the amount of nodes and breaks cycles in malformed files.
+	 */
+	for (n = scene->nodes_count; n > 0; n--) {
+		c = cgltf_node_index(gltfData, scene->nodes[n-1]);
+		if (sceneGraph->gltfNodeMap[c] != SCENE_GRAPH_NO_PARENT)
+			continue;
+
+		sceneGraph->gltfNodeMap[c] = 0;
+		stack[stackCount].node = c;
+		stack[stackCount++].parent = SCENE_GRAPH_NO_PARENT;
+	}
+
+	while (stackCount) {
+		stackCount--;
+		gltfNode = &gltfData->nodes[stack[stackCount].node];
+
+		sceneGraph->gltfNodeMap[stack[stackCount].node] = nodeCount;
+		sceneGraph->nodeIndex[nodeCount] = stack[stackCount].node;
+		sceneGraph->parent[nodeCount] = stack[stackCount].parent;
+		sceneGraph->subtreeSize[nodeCount] = 1;
+		scene_graph_object_get(gltfData, gltfNode, &sceneGraph->objectType[nodeCount], &sceneGraph->objectIndex[nodeCount]);
+		sceneGraph->meshIndex[nodeCount] = (gltfNode->mesh) ? cgltf_mesh_index(gltfData, gltfNode->mesh) : UINT32_MAX;
+
+		/* GLTF defaults, cgltf leaves missing properties zeroed */
+		if (gltfNode->has_matrix) {
+			memcpy(sceneGraph->localMatrix[nodeCount], gltfNode->matrix, sizeof(mat4));
+			scene_graph_local_decompose(gltfNode->matrix, sceneGraph->translation[nodeCount],
+			                            sceneGraph->rotation[nodeCount], sceneGraph->scale[nodeCount]);
+		} else {
+			if (gltfNode->has_translation)
+				memcpy(sceneGraph->translation[nodeCount], gltfNode->translation, sizeof(vec3));
+
+			if (gltfNode->has_rotation)
+				memcpy(sceneGraph->rotation[nodeCount], gltfNode->rotation, sizeof(versor));
+			else
+				sceneGraph->rotation[nodeCount][3] = 1.0f;
+
+			if (gltfNode->has_scale) {
+				memcpy(sceneGraph->scale[nodeCount], gltfNode->scale, sizeof(vec3));
+			} else {
+				sceneGraph->scale[nodeCount][0] = 1.0f;
+				sceneGraph->scale[nodeCount][1] = 1.0f;
+				sceneGraph->scale[nodeCount][2] = 1.0f;
+			}
+
+			scene_graph_local_compose(sceneGraph->translation[nodeCount], sceneGraph->rotation[nodeCount],
+			                          sceneGraph->scale[nodeCount], (float *) sceneGraph->localMatrix[nodeCount]);
+		}
+
+		for (c = gltfNode->children_count; c > 0; c--) {
+			n = cgltf_node_index(gltfData, gltfNode->children[c-1]);
+			if (sceneGraph->gltfNodeMap[n] != SCENE_GRAPH_NO_PARENT) {
+				kmr_utils_log(KMR_WARNING, "[!] kmr_gltf_loader_scene_graph_create: node %u reachable more than once, ignoring", n);
+				continue;
+			}
+
+			sceneGraph->gltfNodeMap[n] = 0;
+			stack[stackCount].node = n;
+			stack[stackCount++].parent = nodeCount;
+		}
+
+		nodeCount++;
+	}
+
+	/* Children come after their parent, accumulate subtree sizes back to front */
+	for (n = nodeCount; n > 0; n--) {
+		if (sceneGraph->parent[n-1] != SCENE_GRAPH_NO_PARENT)
+			sceneGraph->subtreeSize[sceneGraph->parent[n-1]] += sceneGraph->subtreeSize[n-1];
+	}
+
+	sceneGraph->nodeCount = nodeCount;
+
+	/* CPU features are only checked once, updates reuse the same kernels */
+	kmr_gltf_loader_scene_graph_kernels_get();
+	scene_graph_kernels.matrix_multiply(sceneGraph->worldMatrix, (const mat4 *) sceneGraph->worldMatrix, sceneGraph->parent,
+	                                    (const mat4 *) sceneGraph->localMatrix, 0, nodeCount);
+
+	free(stack);
+	return sceneGraph;
+
+exit_error_kmr_gltf_loader_scene_graph_create:
+	free(stack);
+	free(block);
+	free(sceneGraph);
+	return NULL;
+}
+
+
+uint32_t
+kmr_gltf_loader_scene_graph_update (struct kmr_gltf_loader_scene_graph *sceneGraph)
+{
+	uint32_t n = 0, i, end, updated = 0;
+
+	while (n < sceneGraph->nodeCount) {
+		if (!sceneGraph->dirty[n]) {
+			n++;
+			continue;
+		}
+
+		/* Whole subtree is contiguous, nested dirty nodes get handled along the way */
+		end = n + sceneGraph->subtreeSize[n];
+		for (i = n; i < end; i++) {
+			if (!sceneGraph->dirty[i])
+				continue;
+
+			scene_graph_local_compose(sceneGraph->translation[i], sceneGraph->rotation[i],
+			                          sceneGraph->scale[i], (float *) sceneGraph->localMatrix[i]);
+			sceneGraph->dirty[i] = false;
+		}
+
+		scene_graph_kernels.matrix_multiply(sceneGraph->worldMatrix, (const mat4 *) sceneGraph->worldMatrix, sceneGraph->parent,
+		                                    (const mat4 *) sceneGraph->localMatrix, n, end);
+		updated += end - n;
+		n = end;
+	}
+
+	return updated;
+}
+
+
+void
+kmr_gltf_loader_scene_graph_destroy (struct kmr_gltf_loader_scene_graph *sceneGraph)
+{
+	if (!sceneGraph)
+		return;
+
+	/* Start of the single allocation backing every array */
+	free(sceneGraph->localMatrix);
+	free(sceneGraph);
+}
+
+/************************************************************************
+ * END OF kmr_gltf_loader_scene_graph_{create,update,destroy} FUNCTIONS *
+ ************************************************************************/
+
+
+/******************************************************
+ * START OF kmr_gltf_loader_scene_graph_cull FUNCTION *
+ ******************************************************/
+
+#define CULL_BATCH_SIZE 8
+
+
+/*
+ * World space bounding spheres gathered in structure of arrays form so a
+ * single plane can be tested against a whole batch of spheres at once.
+ */
+struct cull_batch {
+	float    x[CULL_BATCH_SIZE];
+	float    y[CULL_BATCH_SIZE];
+	float    z[CULL_BATCH_SIZE];
+	float    radius[CULL_BATCH_SIZE];
+	uint32_t node[CULL_BATCH_SIZE];
+	uint32_t count;
+};
+
+
+/*
+ * Cull kernels: Return a bitmask of the spheres in @batch that aren't entirely
+ * behind any of the six normalized @planes. Lanes past @batch->count are masked out.
+ */
+struct cull_kernels {
+	uint32_t (*spheres_test)(const struct cull_batch *batch, const vec4 *planes);
+};
+
+
+static uint32_t
+cull_spheres_test_scalar (const struct cull_batch *batch, const vec4 *planes)
+{
+	uint32_t s, p, mask = 0;
+	float distance;
+
+	for (s = 0; s < batch->count; s++) {
+		for (p = 0; p < 6; p++) {
+			distance = planes[p][0] * batch->x[s] + planes[p][1] * batch->y[s] +
+			           planes[p][2] * batch->z[s] + planes[p][3];
+			if (distance < -batch->radius[s])
+				break;
+		}
+
+		if (p == 6)
+			mask |= (1u << s);
+	}
+
+	return mask;
+}
+
+
+#ifdef HAVE_X86_SIMD
+
+__attribute__((target("sse2")))
+static uint32_t
+cull_spheres_test_sse2 (const struct cull_batch *batch, const vec4 *planes)
+{
+	uint32_t s, p, mask = 0;
+	__m128 x, y, z, negRadius, distance, visible;
+
+	for (s = 0; s < CULL_BATCH_SIZE; s += 4) {
+		x = _mm_loadu_ps(batch->x + s);
+		y = _mm_loadu_ps(batch->y + s);
+		z = _mm_loadu_ps(batch->z + s);
+		negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(batch->radius + s));
+		visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+		for (p = 0; p < 6; p++) {
+			distance = _mm_mul_ps(x, _mm_set1_ps(planes[p][0]));
+			distance = _mm_add_ps(distance, _mm_mul_ps(y, _mm_set1_ps(planes[p][1])));
+			distance = _mm_add_ps(distance, _mm_mul_ps(z, _mm_set1_ps(planes[p][2])));
+			distance = _mm_add_ps(distance, _mm_set1_ps(planes[p][3]));
+			visible = _mm_andnot_ps(_mm_cmplt_ps(distance, negRadius), visible);
+		}
+
+		mask |= (uint32_t) _mm_movemask_ps(visible) << s;
+	}
+
+	return mask & ((1u << batch->count) - 1);
+}
+
+
+__attribute__((target("avx")))
+static uint32_t
+cull_spheres_test_avx (const struct cull_batch *batch, const vec4 *planes)
+{
+	uint32_t p, mask;
+	__m256 x, y, z, negRadius, distance, visible;
+
+	x = _mm256_loadu_ps(batch->x);
+	y = _mm256_loadu_ps(batch->y);
+	z = _mm256_loadu_ps(batch->z);
+	negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(batch->radius));
+	visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+	for (p = 0; p < 6; p++) {
+		distance = _mm256_mul_ps(x, _mm256_set1_ps(planes[p][0]));
+		distance = _mm256_add_ps(distance, _mm256_mul_ps(y, _mm256_set1_ps(planes[p][1])));
+		distance = _mm256_add_ps(distance, _mm256_mul_ps(z, _mm256_set1_ps(planes[p][2])));
+		distance = _mm256_add_ps(distance, _mm256_set1_ps(planes[p][3]));
+		visible = _mm256_andnot_ps(_mm256_cmp_ps(distance, negRadius, _CMP_LT_OQ), visible);
+	}
+
+	mask = (uint32_t) _mm256_movemask_ps(visible);
+
+	return mask & ((1u << batch->count) - 1);
+}
+
+#endif /* HAVE_X86_SIMD */
+
+
+static struct cull_kernels cull_kernels;
+static pthread_once_t cull_kernels_once = PTHREAD_ONCE_INIT;
+
+
+static void
+cull_kernels_init (void)
+{
+	cull_kernels.spheres_test = cull_spheres_test_scalar;
+
+#ifdef HAVE_X86_SIMD
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("sse2"))
+		cull_kernels.spheres_test = cull_spheres_test_sse2;
+
+	if (__builtin_cpu_supports("avx"))
+		cull_kernels.spheres_test = cull_spheres_test_avx;
+#endif
+}
+
+
+/* Tests every sphere in @batch appending visible nodes to @drawList. Empties @batch. */
+static uint32_t
+cull_batch_flush (struct cull_batch *batch, const vec4 *planes, uint32_t *drawList)
+{
+	uint32_t s, mask, drawCount = 0;
+
+	mask = cull_kernels.spheres_test(batch, planes);
+	for (s = 0; s < batch->count; s++)
+		if (mask & (1u << s))
+			drawList[drawCount++] = batch->node[s];
+
+	batch->count = 0;
+
+	return drawCount;
+}
+
+
+uint32_t
+kmr_gltf_loader_scene_graph_cull (struct kmr_gltf_loader_scene_graph_cull_info *cullInfo)
+{
+	uint32_t n, instance = 0, drawCount = 0;
+	float center[3], radius;
+	vec4 planes[6];
+
+	struct cull_batch batch;
+	struct kmr_gltf_loader_mesh_data *meshData = NULL;
+	struct kmr_gltf_loader_scene_graph *sceneGraph = cullInfo->sceneGraph;
+	struct kmr_gltf_loader_skin *skin = cullInfo->skin;
+
+	pthread_once(&cull_kernels_once, cull_kernels_init);
+	cull_planes_extract((const float *) cullInfo->viewProjection, planes);
+	memset(&batch, 0, sizeof(batch));
+
+	for (n = 0; n < sceneGraph->nodeCount; n++) {
+		if (sceneGraph->objectType[n] == KMR_GLTF_LOADER_GLTF_MESH ||
+		    (sceneGraph->objectType[n] == KMR_GLTF_LOADER_GLTF_SKIN && !skin))
+		{
+			/* Without joint matrices skinned nodes fall back to their bind pose under the node */
+			if (sceneGraph->meshIndex[n] >= cullInfo->mesh->meshDataCount)
+				continue;
+
+			meshData = &cullInfo->mesh->meshData[sceneGraph->meshIndex[n]];
+			if (!meshData->vertexBufferDataCount)
+				continue;
+
+			cull_sphere_transform((const float *) sceneGraph->worldMatrix[n], meshData->sphereCenter,
+			                      meshData->sphereRadius, center, &radius);
+		} else if (sceneGraph->objectType[n] == KMR_GLTF_LOADER_GLTF_SKIN) {
+			/* Instances are stored in scene graph order */
+			while (instance < skin->instanceCount && skin->instances[instance].node < n)
+				instance++;
+
+			if (instance == skin->instanceCount || skin->instances[instance].node != n ||
+			    skin->instances[instance].meshIndex >= cullInfo->mesh->meshDataCount)
+				continue;
+
+			meshData = &cullInfo->mesh->meshData[skin->instances[instance].meshIndex];
+			if (!meshData->vertexBufferDataCount)
+				continue;
+
+			cull_skinned_sphere_get(skin, skin->instances[instance].skinIndex, meshData, center, &radius);
+		} else {
+			continue;
+		}
+
+		batch.x[batch.count] = center[0];
+		batch.y[batch.count] = center[1];
+		batch.z[batch.count] = center[2];
+		batch.radius[batch.count] = radius;
+		batch.node[batch.count] = n;
+
+		if (++batch.count == CULL_BATCH_SIZE)
+			drawCount += cull_batch_flush(&batch, (const vec4 *) planes, cullInfo->drawList + drawCount);
+	}
+
+	if (batch.count)
+		drawCount += cull_batch_flush(&batch, (const vec4 *) planes, cullInfo->drawList + drawCount);
+
+	return drawCount;
+}
+
+/****************************************************
+ * END OF kmr_gltf_loader_scene_graph_cull FUNCTION *
+ ****************************************************/
@@ -0,0 +1,572 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "gltf-skin.h"
+#include "gltf-loader-private.h"
+
+
+/*********************************************************************************
+ * START OF kmr_gltf_loader_skin_{create,palette_update,apply,destroy} FUNCTIONS *
+ *********************************************************************************/
+
+#define SKIN_ALIGNMENT 64
+#define SKIN_JOB_VERTEX_COUNT (1 << 14)
+
+
+/*
+ * Positions and normals of consecutive vertices. Interleaved and structure
+ * of arrays layouts only differ in where both start and their stride.
+ */
+struct skin_vertex_stream {
+	uint8_t  *position;
+	uint8_t  *normal;
+	uint32_t stride;
+};
+
+
+/*
+ * Skinning kernels: Blend the joint matrices of @count vertices by their weights then
+ * transform positions and normals read from @src and write them to @dst. @palette points
+ * to the first joint matrix of the vertices' skin. Normals are transformed by the upper
+ * 3x3 of the blended matrix and renormalized, non-uniform joint scale isn't accounted for.
+ * @matrix_multiply is the scene graph's matrix kernel, used to build joint palettes.
+ */
+struct skin_kernels {
+	void (*vertex_skin)(struct skin_vertex_stream *dst, const struct skin_vertex_stream *src,
+	                    const uint16_t (*joints)[4], const vec4 *weights, const mat4 *palette, uint32_t count);
+	void (*matrix_multiply)(mat4 *dst, const mat4 *a, const uint32_t *aIndex, const mat4 *b, uint32_t start, uint32_t end);
+};
+
+
+static void
+vertex_skin_scalar (struct skin_vertex_stream *dst, const struct skin_vertex_stream *src,
+                    const uint16_t (*joints)[4], const vec4 *weights, const mat4 *palette, uint32_t count)
+{
+	uint32_t v, k, i;
+	float m[16], p[3], n[3], length;
+	const float *j;
+	float *pd, *nd;
+
+	for (v = 0; v < count; v++) {
+		memset(m, 0, sizeof(m));
+		for (k = 0; k < 4; k++) {
+			if (weights[v][k] == 0.0f)
+				continue;
+
+			j = (const float *) palette[joints[v][k]];
+			for (i = 0; i < 16; i++)
+				m[i] += j[i] * weights[v][k];
+		}
+
+		memcpy(p, src->position + (v * src->stride), sizeof(p));
+		memcpy(n, src->normal + (v * src->stride), sizeof(n));
+		pd = (float *) (dst->position + (v * dst->stride));
+		nd = (float *) (dst->normal + (v * dst->stride));
+
+		for (i = 0; i < 3; i++) {
+			pd[i] = m[0*4+i] * p[0] + m[1*4+i] * p[1] + m[2*4+i] * p[2] + m[3*4+i];
+			nd[i] = m[0*4+i] * n[0] + m[1*4+i] * n[1] + m[2*4+i] * n[2];
+		}
+
+		length = sqrtf(nd[0] * nd[0] + nd[1] * nd[1] + nd[2] * nd[2]);
+		if (length > 0.0f) {
+			nd[0] /= length;
+			nd[1] /= length;
+			nd[2] /= length;
+		}
+	}
+}
+
+
+#ifdef HAVE_X86_SIMD
+
+__attribute__((target("sse2")))
+static void
+vertex_skin_sse2 (struct skin_vertex_stream *dst, const struct skin_vertex_stream *src,
+                  const uint16_t (*joints)[4], const vec4 *weights, const mat4 *palette, uint32_t count)
+{
+	uint32_t v, k;
+	const float *j, *p, *n;
+	float *pd, *nd;
+	__m128 w, c0, c1, c2, c3, position, normal, length;
+
+	for (v = 0; v < count; v++) {
+		/* Blended matrix columns, unused influences have zero weight */
+		c0 = c1 = c2 = c3 = _mm_setzero_ps();
+		for (k = 0; k < 4; k++) {
+			w = _mm_set1_ps(weights[v][k]);
+			j = (const float *) palette[joints[v][k]];
+			c0 = _mm_add_ps(c0, _mm_mul_ps(_mm_loadu_ps(j + 0), w));
+			c1 = _mm_add_ps(c1, _mm_mul_ps(_mm_loadu_ps(j + 4), w));
+			c2 = _mm_add_ps(c2, _mm_mul_ps(_mm_loadu_ps(j + 8), w));
+			c3 = _mm_add_ps(c3, _mm_mul_ps(_mm_loadu_ps(j + 12), w));
+		}
+
+		p = (const float *) (src->position + (v * src->stride));
+		n = (const float *) (src->normal + (v * src->stride));
+		pd = (float *) (dst->position + (v * dst->stride));
+		nd = (float *) (dst->normal + (v * dst->stride));
+
+		position = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p[0])), _mm_mul_ps(c1, _mm_set1_ps(p[1]))),
+		                      _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(p[2])), c3));
+		normal = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(n[0])), _mm_mul_ps(c1, _mm_set1_ps(n[1]))),
+		                    _mm_mul_ps(c2, _mm_set1_ps(n[2])));
+
+		/* x*x + y*y + z*z in the lowest lane, SSE2 has no dot product instruction */
+		length = _mm_mul_ps(normal, normal);
+		length = _mm_add_ss(_mm_add_ss(length, _mm_shuffle_ps(length, length, 0x55)), _mm_shuffle_ps(length, length, 0xAA));
+		if (_mm_cvtss_f32(length) > 0.0f)
+			normal = _mm_div_ps(normal, _mm_sqrt_ps(_mm_shuffle_ps(length, length, 0x00)));
+
+		/* Three floats per vector, the fourth belongs to the next attribute */
+		_mm_storel_pi((__m64 *) pd, position);
+		_mm_store_ss(pd + 2, _mm_movehl_ps(position, position));
+		_mm_storel_pi((__m64 *) nd, normal);
+		_mm_store_ss(nd + 2, _mm_movehl_ps(normal, normal));
+	}
+}
+
+#endif /* HAVE_X86_SIMD */
+
+
+static struct skin_kernels skin_kernels;
+static pthread_once_t skin_kernels_once = PTHREAD_ONCE_INIT;
+
+
+static void
+skin_kernels_init (void)
+{
+	skin_kernels.vertex_skin = vertex_skin_scalar;
+	skin_kernels.matrix_multiply = kmr_gltf_loader_scene_graph_kernels_get()->matrix_multiply;
+
+#ifdef HAVE_X86_SIMD
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("sse2"))
+		skin_kernels.vertex_skin = vertex_skin_sse2;
+#endif
+}
+
+
+/*
+ * Reads JOINTS_0/WEIGHTS_0 of a primitive. Influences of joints outside of [0, @jointLimit)
+ * are dropped and the remaining weights renormalized. Vertices left without any influence
+ * are bound to the skin's first joint.
+ */
+static int
+skin_primitive_read (cgltf_primitive *primitive, uint32_t jointLimit,
+                     uint16_t (*vertexJoints)[4], vec4 *vertexWeights, uint32_t vertexCount)
+{
+	cgltf_size a;
+	uint32_t v, k, dropped = 0;
+	cgltf_uint joints[4];
+	float weights[4], weightSum;
+
+	cgltf_accessor *jointsAccessor = NULL, *weightsAccessor = NULL;
+
+	for (a = 0; a < primitive->attributes_count; a++) {
+		if (primitive->attributes[a].index != 0)
+			continue;
+
+		if (primitive->attributes[a].type == cgltf_attribute_type_joints)
+			jointsAccessor = primitive->attributes[a].data;
+		else if (primitive->attributes[a].type == cgltf_attribute_type_weights)
+			weightsAccessor = primitive->attributes[a].data;
+	}
+
+	if (!jointsAccessor || !weightsAccessor)
+		kmr_utils_log(KMR_WARNING, "[!] kmr_gltf_loader_skin_create: skinned primitive without JOINTS_0/WEIGHTS_0, binding to first joint");
+
+	for (v = 0; v < vertexCount; v++) {
+		memset(joints, 0, sizeof(joints));
+		memset(weights, 0, sizeof(weights));
+
+		if (jointsAccessor && weightsAccessor && v < jointsAccessor->count && v < weightsAccessor->count) {
+			if (!cgltf_accessor_read_uint(jointsAccessor, v, joints, 4) ||
+			    !cgltf_accessor_read_float(weightsAccessor, v, weights, 4))
+			{
+				kmr_utils_log(KMR_DANGER, "[x] kmr_gltf_loader_skin_create: failed to read JOINTS_0/WEIGHTS_0 (sparse accessors are unsupported)");
+				return -1;
+			}
+		}
+
+		weightSum = 0.0f;
+		for (k = 0; k < 4; k++) {
+			if (joints[k] >= jointLimit || weights[k] < 0.0f) {
+				dropped += (weights[k] != 0.0f);
+				joints[k] = 0;
+				weights[k] = 0.0f;
+			}
+
+			weightSum += weights[k];
+		}
+
+		if (weightSum <= 0.0f)
+			weights[0] = weightSum = 1.0f;
+
+		for (k = 0; k < 4; k++) {
+			vertexJoints[v][k] = joints[k];
+			vertexWeights[v][k] = weights[k] / weightSum;
+		}
+	}
+
+	if (dropped)
+		kmr_utils_log(KMR_WARNING, "[!] kmr_gltf_loader_skin_create: dropped %u influence(s) of out of range joints", dropped);
+
+	return 0;
+}
+
+
+struct kmr_gltf_loader_skin *
+kmr_gltf_loader_skin_create (struct kmr_gltf_loader_skin_create_info *skinInfo)
+{
+	uint32_t s, j, m, n, p, v, jointCount = 0, instanceCount = 0, vertexCount = 0, primitiveVertexCount;
+	uint32_t *meshFirstVertex = NULL, *meshJointLimit = NULL;
+	size_t offset = 0, offsets[3];
+	uint8_t *block = NULL;
+
+	cgltf_data *gltfData = skinInfo->gltfFile->gltfData;
+	cgltf_skin *gltfSkin = NULL;
+	cgltf_node *gltfNode = NULL;
+	cgltf_accessor *accessor = NULL;
+
+	struct kmr_gltf_loader_scene_graph *sceneGraph = skinInfo->sceneGraph;
+	struct kmr_gltf_loader_skin *skin = NULL;
+	struct kmr_gltf_loader_skin_instance *instance = NULL;
+
+	skin = calloc(1, sizeof(struct kmr_gltf_loader_skin));
+	if (!skin) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(skin): %s", strerror(errno));
+		return NULL;
+	}
+
+	meshFirstVertex = malloc((gltfData->meshes_count + 1) * sizeof(uint32_t));
+	meshJointLimit = malloc((gltfData->meshes_count + 1) * sizeof(uint32_t));
+	if (!meshFirstVertex || !meshJointLimit) {
+		kmr_utils_log(KMR_DANGER, "[x] malloc: %s", strerror(errno));
+		goto exit_error_kmr_gltf_loader_skin_create;
+	}
+
+	memset(meshFirstVertex, 0xff, (gltfData->meshes_count + 1) * sizeof(uint32_t));
+	memset(meshJointLimit, 0xff, (gltfData->meshes_count + 1) * sizeof(uint32_t));
+
+	for (s = 0; s < gltfData->skins_count; s++)
+		jointCount += gltfData->skins[s].joints_count;
+
+	/*
+	 * First pass acquire skinned mesh instances of the scene. A mesh's vertices are stored
+	 * once however many nodes instance it, joint indices must be valid for every skin used.
+	 */
+	for (n = 0; n < sceneGraph->nodeCount; n++) {
+		gltfNode = &gltfData->nodes[sceneGraph->nodeIndex[n]];
+		if (!gltfNode->skin || !gltfNode->mesh)
+			continue;
+
+		if (!gltfNode->skin->joints_count) {
+			kmr_utils_log(KMR_WARNING, "[!] kmr_gltf_loader_skin_create: node %u references a skin without joints, ignoring",
+			              sceneGraph->nodeIndex[n]);
+			continue;
+		}
+
+		m = cgltf_mesh_index(gltfData, gltfNode->mesh);
+		if (meshFirstVertex[m] == UINT32_MAX) {
+			meshFirstVertex[m] = vertexCount;
+			for (p = 0; p < gltfNode->mesh->primitives_count; p++)
+				vertexCount += primitive_vertex_count_get(&gltfNode->mesh->primitives[p]);
+		}
+
+		if (gltfNode->skin->joints_count < meshJointLimit[m])
+			meshJointLimit[m] = gltfNode->skin->joints_count;
+
+		instanceCount++;
+	}
+
+	skin->skinData = calloc(gltfData->skins_count + 1, sizeof(struct kmr_gltf_loader_skin_data));
+	skin->instances = calloc(instanceCount + 1, sizeof(struct kmr_gltf_loader_skin_instance));
+	if (!skin->skinData || !skin->instances) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc: %s", strerror(errno));
+		goto exit_error_kmr_gltf_loader_skin_create;
+	}
+
+	/* Palette first so it starts SKIN_ALIGNMENT aligned, matrices are followed by joint indices */
+	offsets[0] = offset; offset += jointCount * sizeof(mat4);     /* palette */
+	offsets[1] = offset; offset += jointCount * sizeof(mat4);     /* inverseBindMatrices */
+	offsets[2] = offset; offset += jointCount * sizeof(uint32_t); /* joints */
+	offset = (offset + SKIN_ALIGNMENT - 1) & ~((size_t) SKIN_ALIGNMENT - 1);
+
+	block = aligned_alloc(SKIN_ALIGNMENT, offset ? offset : SKIN_ALIGNMENT);
+	if (!block) {
+		kmr_utils_log(KMR_DANGER, "[x] aligned_alloc(palette): %s", strerror(errno));
+		goto exit_error_kmr_gltf_loader_skin_create;
+	}
+
+	skin->palette = (mat4 *) (block + offsets[0]);
+	skin->inverseBindMatrices = (mat4 *) (block + offsets[1]);
+	skin->joints = (uint32_t *) (block + offsets[2]);
+
+	offset = vertexCount * (sizeof(vec4) + sizeof(*skin->vertexJoints));
+	offset = (offset + SKIN_ALIGNMENT - 1) & ~((size_t) SKIN_ALIGNMENT - 1);
+
+	block = aligned_alloc(SKIN_ALIGNMENT, offset ? offset : SKIN_ALIGNMENT);
+	if (!block) {
+		kmr_utils_log(KMR_DANGER, "[x] aligned_alloc(vertexWeights): %s", strerror(errno));
+		goto exit_error_kmr_gltf_loader_skin_create;
+	}
+
+	skin->vertexWeights = (vec4 *) block;
+	skin->vertexJoints = (uint16_t (*)[4]) (block + (vertexCount * sizeof(vec4)));
+
+	skin->skinDataCount = gltfData->skins_count;
+	skin->jointCount = jointCount;
+	skin->instanceCount = instanceCount;
+	skin->vertexCount = vertexCount;
+
+	/* Joints map to scene graph nodes, palette updates then index straight into the world matrices */
+	jointCount = 0;
+	for (s = 0; s < gltfData->skins_count; s++) {
+		gltfSkin = &gltfData->skins[s];
+		skin->skinData[s].firstJoint = jointCount;
+		skin->skinData[s].jointCount = gltfSkin->joints_count;
+
+		for (j = 0; j < gltfSkin->joints_count; j++) {
+			skin->joints[jointCount + j] = sceneGraph->gltfNodeMap[cgltf_node_index(gltfData, gltfSkin->joints[j])];
+			if (skin->joints[jointCount + j] == SCENE_GRAPH_NO_PARENT)
+				kmr_utils_log(KMR_WARNING, "[!] kmr_gltf_loader_skin_create: joint %u of skin %u isn't part of the scene", j, s);
+
+			glm_mat4_identity(skin->inverseBindMatrices[jointCount + j]);
+		}
+
+		accessor = gltfSkin->inverse_bind_matrices;
+		if (accessor && gltfSkin->joints_count) {
+			if (accessor->type != cgltf_type_mat4 || accessor->count < gltfSkin->joints_count) {
+				kmr_utils_log(KMR_DANGER, "[x] kmr_gltf_loader_skin_create: skin %u inverse bind matrices accessor must hold %zu MAT4",
+				              s, gltfSkin->joints_count);
+				goto exit_error_kmr_gltf_loader_skin_create;
+			}
+
+			if (cgltf_accessor_unpack_floats(accessor, (float *) skin->inverseBindMatrices[jointCount], gltfSkin->joints_count * 16) !=
+			    gltfSkin->joints_count * 16)
+			{
+				kmr_utils_log(KMR_DANGER, "[x] cgltf_accessor_unpack_floats: failed to read accessor %zu",
+				              cgltf_accessor_index(gltfData, accessor));
+				goto exit_error_kmr_gltf_loader_skin_create;
+			}
+		}
+
+		jointCount += gltfSkin->joints_count;
+	}
+
+	/* Second pass store instances and the joints/weights of every instanced mesh */
+	instanceCount = 0;
+	for (n = 0; n < sceneGraph->nodeCount; n++) {
+		gltfNode = &gltfData->nodes[sceneGraph->nodeIndex[n]];
+		if (!gltfNode->skin || !gltfNode->mesh || !gltfNode->skin->joints_count)
+			continue;
+
+		m = cgltf_mesh_index(gltfData, gltfNode->mesh);
+		instance = &skin->instances[instanceCount++];
+		instance->node = n;
+		instance->skinIndex = cgltf_skin_index(gltfData, gltfNode->skin);
+		instance->meshIndex = m;
+		instance->firstVertex = meshFirstVertex[m];
+		instance->vertexCount = 0;
+		for (p = 0; p < gltfNode->mesh->primitives_count; p++)
+			instance->vertexCount += primitive_vertex_count_get(&gltfNode->mesh->primitives[p]);
+
+		/* Joint limit doubles as a marker for meshes already read */
+		if (meshJointLimit[m] == UINT32_MAX)
+			continue;
+
+		v = meshFirstVertex[m];
+		for (p = 0; p < gltfNode->mesh->primitives_count; p++) {
+			primitiveVertexCount = primitive_vertex_count_get(&gltfNode->mesh->primitives[p]);
+			if (skin_primitive_read(&gltfNode->mesh->primitives[p], meshJointLimit[m],
+			                        skin->vertexJoints + v, skin->vertexWeights + v, primitiveVertexCount) == -1)
+				goto exit_error_kmr_gltf_loader_skin_create;
+			v += primitiveVertexCount;
+		}
+
+		meshJointLimit[m] = UINT32_MAX;
+	}
+
+	/* CPU features are only checked once, palette updates and skinning reuse the same kernels */
+	pthread_once(&skin_kernels_once, skin_kernels_init);
+	kmr_gltf_loader_skin_palette_update(skin, sceneGraph);
+
+	free(meshFirstVertex);
+	free(meshJointLimit);
+	return skin;
+
+exit_error_kmr_gltf_loader_skin_create:
+	free(meshFirstVertex);
+	free(meshJointLimit);
+	kmr_gltf_loader_skin_destroy(skin);
+	return NULL;
+}
+
+
+void
+kmr_gltf_loader_skin_palette_update (struct kmr_gltf_loader_skin *skin, struct kmr_gltf_loader_scene_graph *sceneGraph)
+{
+	/* Joints outside of the scene are marked like root nodes and keep their inverse bind matrix */
+	skin_kernels.matrix_multiply(skin->palette, (const mat4 *) sceneGraph->worldMatrix, skin->joints,
+	                             (const mat4 *) skin->inverseBindMatrices, 0, skin->jointCount);
+}
+
+
+struct skin_apply_job {
+	struct skin_vertex_stream src;
+	struct skin_vertex_stream dst;
+	const uint16_t            (*joints)[4];
+	const vec4                *weights;
+	const mat4                *palette;
+	uint32_t                  count;
+};
+
+
+struct skin_apply {
+	struct skin_apply_job *jobs;
+};
+
+
+static int
+skin_apply_job_run (void *userData, uint32_t jobIndex)
+{
+	struct skin_apply *apply = userData;
+	struct skin_apply_job *job = &apply->jobs[jobIndex];
+
+	skin_kernels.vertex_skin(&job->dst, &job->src, job->joints, job->weights, job->palette, job->count);
+	return 0;
+}
+
+
+/* Positions/normals of mesh @meshIndex starting at vertex @first inside of memory laid out like the mesh arena */
+static struct skin_vertex_stream
+skin_vertex_stream_get (struct kmr_gltf_loader_mesh *mesh, uint32_t meshIndex, uint8_t *arena, uint32_t first)
+{
+	struct skin_vertex_stream stream;
+	struct kmr_gltf_loader_mesh_data *meshData = &mesh->meshData[meshIndex];
+	struct kmr_gltf_loader_mesh_vertex_streams streams;
+	uint8_t *vertices = arena + meshData->vertexBufferDataOffset;
+
+	if (mesh->vertexLayout == KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_SOA) {
+		streams = mesh_vertex_streams_carve(vertices, meshData->vertexBufferDataCount);
+		stream.position = (uint8_t *) (streams.position + first);
+		stream.normal = (uint8_t *) (streams.normal + first);
+		stream.stride = sizeof(vec3);
+		return stream;
+	}
+
+	vertices += first * sizeof(struct kmr_gltf_loader_mesh_vertex_data);
+	stream.position = vertices + offsetof(struct kmr_gltf_loader_mesh_vertex_data, position);
+	stream.normal = vertices + offsetof(struct kmr_gltf_loader_mesh_vertex_data, normal);
+	stream.stride = sizeof(struct kmr_gltf_loader_mesh_vertex_data);
+	return stream;
+}
+
+
+int
+kmr_gltf_loader_skin_apply (struct kmr_gltf_loader_skin_apply_info *skinApplyInfo)
+{
+	uint32_t i, first, jobCount = 0;
+	int ret = -1;
+	bool *meshSkinned = NULL;
+
+	struct kmr_gltf_loader_skin *skin = skinApplyInfo->skin;
+	struct kmr_gltf_loader_mesh *mesh = skinApplyInfo->mesh;
+	struct kmr_gltf_loader_skin_instance *instance = NULL;
+
+	struct skin_apply apply;
+	struct skin_apply_job *job = NULL;
+	struct kmr_utils_worker_pool_run_info workerPoolRunInfo;
+
+	if (!skinApplyInfo->dst || skinApplyInfo->dst == mesh->arena) {
+		kmr_utils_log(KMR_DANGER, "[x] kmr_gltf_loader_skin_apply: destination must be a copy of the mesh arena");
+		return -1;
+	}
+
+	if (mesh->vertexLayout == KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_PACKED) {
+		kmr_utils_log(KMR_DANGER, "[x] kmr_gltf_loader_skin_apply: packed vertices can't be skinned");
+		return -1;
+	}
+
+	if (mesh->optimized) {
+		kmr_utils_log(KMR_DANGER, "[x] kmr_gltf_loader_skin_apply: mesh vertices were reordered by kmr_gltf_loader_mesh_optimize()");
+		return -1;
+	}
+
+	for (i = 0; i < skin->instanceCount; i++) {
+		instance = &skin->instances[i];
+		if (instance->meshIndex >= mesh->meshDataCount ||
+		    mesh->meshData[instance->meshIndex].vertexBufferDataCount != instance->vertexCount)
+		{
+			kmr_utils_log(KMR_DANGER, "[x] kmr_gltf_loader_skin_apply: mesh %u vertices don't match the skin, was it welded?",
+			              instance->meshIndex);
+			return -1;
+		}
+	}
+
+	meshSkinned = calloc(mesh->meshDataCount + 1, sizeof(bool));
+	apply.jobs = calloc(((skin->vertexCount / SKIN_JOB_VERTEX_COUNT) + skin->instanceCount) + 1, sizeof(struct skin_apply_job));
+	if (!meshSkinned || !apply.jobs) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc: %s", strerror(errno));
+		goto exit_kmr_gltf_loader_skin_apply;
+	}
+
+	/*
+	 * Split meshes into fixed size chunks. Walking instances back to front writes each
+	 * mesh once (last instance wins) so no two jobs ever touch the same vertices.
+	 */
+	for (i = skin->instanceCount; i > 0; i--) {
+		instance = &skin->instances[i-1];
+		if (meshSkinned[instance->meshIndex])
+			continue;
+
+		meshSkinned[instance->meshIndex] = true;
+		for (first = 0; first < instance->vertexCount; first += SKIN_JOB_VERTEX_COUNT) {
+			job = &apply.jobs[jobCount++];
+			job->src = skin_vertex_stream_get(mesh, instance->meshIndex, mesh->arena, first);
+			job->dst = skin_vertex_stream_get(mesh, instance->meshIndex, skinApplyInfo->dst, first);
+			job->joints = (const uint16_t (*)[4]) skin->vertexJoints + instance->firstVertex + first;
+			job->weights = (const vec4 *) skin->vertexWeights + instance->firstVertex + first;
+			job->palette = (const mat4 *) skin->palette + skin->skinData[instance->skinIndex].firstJoint;
+			job->count = ((instance->vertexCount - first) < SKIN_JOB_VERTEX_COUNT) ?
+			             (instance->vertexCount - first) : SKIN_JOB_VERTEX_COUNT;
+		}
+	}
+
+	workerPoolRunInfo.threadCount = skinApplyInfo->threadCount;
+	workerPoolRunInfo.jobCount = jobCount;
+	workerPoolRunInfo.job = skin_apply_job_run;
+	workerPoolRunInfo.userData = &apply;
+
+	ret = kmr_utils_worker_pool_run(&workerPoolRunInfo);
+
+exit_kmr_gltf_loader_skin_apply:
+	free(apply.jobs);
+	free(meshSkinned);
+	return ret;
+}
+
+
+void
+kmr_gltf_loader_skin_destroy (struct kmr_gltf_loader_skin *skin)
+{
+	if (!skin)
+		return;
+
+	/* @palette and @vertexWeights start the allocations backing the other arrays */
+	free(skin->skinData);
+	free(skin->palette);
+	free(skin->instances);
+	free(skin->vertexWeights);
+	free(skin);
+}
+
+/*******************************************************************************
+ * END OF kmr_gltf_loader_skin_{create,palette_update,apply,destroy} FUNCTIONS *
+ *******************************************************************************/
@@ -0,0 +1,1129 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <float.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+#include "obj-loader.h"
+#include "fast_obj.h"
+
+
+#define OBJ_CHUNK_SIZE_DEFAULT (4u << 20)
+
+
+/*
+ * A line range of the OBJ file parsed by its own fast_obj instance. Parser state set by
+ * earlier chunks ("mtllib", "g" and "usemtl" lines) is replayed ahead of the chunk's lines
+ * from @prefix, so faces at the start of a chunk land in the right group and material.
+ */
+struct obj_chunk {
+	const char  *fileName;
+	const char  *data;
+	size_t      dataSize;
+	char        *prefix;
+	size_t      prefixSize;
+	size_t      readOffset;
+
+	/* Found while scanning the chunk's lines, pointers into the mapped file */
+	const char  **mtllibLines;
+	uint32_t    mtllibLineCount;
+	const char  *groupLine;
+	const char  *materialLine;
+	bool        relative;
+
+	fastObjMesh *objMesh;
+	uint32_t    attributeFirst[3];
+	uint32_t    *materialRemap;
+	uint32_t    *groupRemap;
+};
+
+
+enum obj_attribute {
+	OBJ_ATTRIBUTE_POSITION = 0,
+	OBJ_ATTRIBUTE_TEXCOORD = 1,
+	OBJ_ATTRIBUTE_NORMAL   = 2,
+};
+
+
+/* Faces of a (merged) group parsed by one chunk */
+struct obj_segment {
+	uint32_t chunk;
+	uint32_t group;
+};
+
+
+/* Position, texture coordinate and normal index of a face corner in merged (global) numbering */
+struct obj_corner {
+	uint32_t p;
+	uint32_t t;
+	uint32_t n;
+};
+
+
+struct obj_primitive {
+	uint32_t          meshIndex;
+	uint32_t          primitiveIndex;
+	uint32_t          materialIndex;
+	uint32_t          triangleCount;
+	struct obj_corner *corners;
+	uint32_t          cornerCount;
+	uint32_t          *indices;
+};
+
+
+struct obj_build {
+	struct obj_chunk                 *chunks;
+	uint32_t                         chunkCount;
+	uint32_t                         attributeCount[3];
+	uint32_t                         materialCount;
+	struct obj_segment               *segments;
+	uint32_t                         *segmentOffsets;
+	struct obj_primitive             *primitives;
+	struct kmr_gltf_loader_mesh_data *meshData;
+	bool                             weld;
+};
+
+
+static const uint32_t obj_attribute_strides[] = { 3, 2, 3 };
+
+
+static inline bool
+obj_is_whitespace (char c)
+{
+	return (c == ' ' || c == '\t' || c == '\r');
+}
+
+
+static inline const char *
+obj_line_end (const char *line, const char *end)
+{
+	const char *newline = memchr(line, '\n', end - line);
+	return (newline) ? newline + 1 : end;
+}
+
+
+/*
+ * Finds the lines of a chunk that change parser state carried into later chunks, along with
+ * faces using relative indices. Keywords are matched the same way fast_obj matches them.
+ */
+static int
+obj_chunk_scan_job_run (void *userData, uint32_t jobIndex)
+{
+	const char *line, *next, *p, *end, **mtllibLines = NULL;
+
+	struct obj_chunk *chunk = &((struct obj_chunk *) userData)[jobIndex];
+
+	end = chunk->data + chunk->dataSize;
+	for (line = chunk->data; line < end; line = next) {
+		next = obj_line_end(line, end);
+
+		for (p = line; p < next && obj_is_whitespace(*p); p++)
+			;
+
+		if (next - p < 2)
+			continue;
+
+		if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+			if (!chunk->relative && memchr(p, '-', next - p))
+				chunk->relative = true;
+		} else if (p[0] == 'g' && (p[1] == ' ' || p[1] == '\t')) {
+			chunk->groupLine = p;
+		} else if (next - p > 6 && !memcmp(p, "usemtl", 6) && obj_is_whitespace(p[6])) {
+			chunk->materialLine = p;
+		} else if (next - p > 6 && !memcmp(p, "mtllib", 6) && obj_is_whitespace(p[6])) {
+			mtllibLines = realloc(chunk->mtllibLines, (chunk->mtllibLineCount + 1) * sizeof(const char *));
+			if (!mtllibLines) {
+				kmr_utils_log(KMR_DANGER, "[x] realloc(mtllibLines): %s", strerror(errno));
+				return -1;
+			}
+
+			chunk->mtllibLines = mtllibLines;
+			chunk->mtllibLines[chunk->mtllibLineCount++] = p;
+		}
+	}
+
+	return 0;
+}
+
+
+static size_t
+obj_prefix_append (char *dst, size_t offset, const char *line, const char *end)
+{
+	size_t size = obj_line_end(line, end) - line;
+
+	if (dst)
+		memcpy(dst + offset, line, size);
+
+	/* Last line of the file may not end in a newline */
+	if (!size || line[size - 1] != '\n') {
+		if (dst)
+			dst[offset + size] = '\n';
+		size++;
+	}
+
+	return size;
+}
+
+
+/* Replays the state left behind by chunks [0, @chunkIndex) ahead of chunk @chunkIndex */
+static int
+obj_chunk_prefix_set (struct obj_chunk *chunks, uint32_t chunkIndex, const char *end)
+{
+	int pass;
+	uint32_t c, l;
+	size_t size = 0;
+	const char *groupLine = NULL, *materialLine = NULL;
+	char *prefix = NULL;
+
+	for (c = 0; c < chunkIndex; c++) {
+		groupLine = (chunks[c].groupLine) ? chunks[c].groupLine : groupLine;
+		materialLine = (chunks[c].materialLine) ? chunks[c].materialLine : materialLine;
+	}
+
+	/* First pass sizes the prefix, second pass writes it */
+	for (pass = 0; pass < 2; pass++) {
+		size = 0;
+		for (c = 0; c < chunkIndex; c++)
+			for (l = 0; l < chunks[c].mtllibLineCount; l++)
+				size += obj_prefix_append(prefix, size, chunks[c].mtllibLines[l], end);
+
+		if (groupLine)
+			size += obj_prefix_append(prefix, size, groupLine, end);
+		if (materialLine)
+			size += obj_prefix_append(prefix, size, materialLine, end);
+
+		if (pass || !size)
+			break;
+
+		prefix = malloc(size);
+		if (!prefix) {
+			kmr_utils_log(KMR_DANGER, "[x] malloc(prefix): %s", strerror(errno));
+			return -1;
+		}
+	}
+
+	chunks[chunkIndex].prefix = prefix;
+	chunks[chunkIndex].prefixSize = (prefix) ? size : 0;
+
+	return 0;
+}
+
+
+/*
+ * fast_obj file callbacks. The OBJ file itself is served from the chunk
+ * (prefix first), .mtl libraries it references are read from disk.
+ */
+static void *
+obj_file_open (const char *path, void *userData)
+{
+	struct obj_chunk *chunk = userData;
+
+	if (path == chunk->fileName)
+		return chunk;
+
+	return fopen(path, "rb");
+}
+
+
+static void
+obj_file_close (void *file, void *userData)
+{
+	if (file != userData)
+		fclose(file);
+}
+
+
+static size_t
+obj_file_read (void *file, void *dst, size_t bytes, void *userData)
+{
+	size_t size, read = 0;
+	struct obj_chunk *chunk = userData;
+
+	if (file != userData)
+		return fread(dst, 1, bytes, file);
+
+	if (chunk->readOffset < chunk->prefixSize) {
+		size = chunk->prefixSize - chunk->readOffset;
+		size = (size < bytes) ? size : bytes;
+		memcpy(dst, chunk->prefix + chunk->readOffset, size);
+		chunk->readOffset += size;
+		read += size;
+	}
+
+	if (read < bytes && chunk->readOffset < chunk->prefixSize + chunk->dataSize) {
+		size = chunk->prefixSize + chunk->dataSize - chunk->readOffset;
+		size = (size < bytes - read) ? size : bytes - read;
+		memcpy((char *) dst + read, chunk->data + (chunk->readOffset - chunk->prefixSize), size);
+		chunk->readOffset += size;
+		read += size;
+	}
+
+	return read;
+}
+
+
+static unsigned long
+obj_file_size (void *file, void *userData)
+{
+	long position, size;
+	struct obj_chunk *chunk = userData;
+
+	if (file == userData)
+		return chunk->prefixSize + chunk->dataSize;
+
+	position = ftell(file);
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fseek(file, position, SEEK_SET);
+
+	return (size < 0) ? 0 : size;
+}
+
+
+static int
+obj_chunk_parse_job_run (void *userData, uint32_t jobIndex)
+{
+	struct obj_chunk *chunk = &((struct obj_chunk *) userData)[jobIndex];
+
+	fastObjCallbacks callbacks = {
+		.file_open = obj_file_open,
+		.file_close = obj_file_close,
+		.file_read = obj_file_read,
+		.file_size = obj_file_size,
+	};
+
+	chunk->objMesh = fast_obj_read_with_callbacks(chunk->fileName, &callbacks, chunk);
+	if (!chunk->objMesh) {
+		kmr_utils_log(KMR_DANGER, "[x] fast_obj_read_with_callbacks(%s): Failed to parse chunk %u", chunk->fileName, jobIndex);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/*
+ * Maps names of groups or materials parsed by different chunks to one index
+ * in order of first appearance. Open addressing, slots store index + 1.
+ */
+struct obj_name {
+	const char *name;
+	uint32_t   chunk;
+	uint32_t   local;
+};
+
+
+struct obj_name_table {
+	struct obj_name *names;
+	uint32_t        nameCount;
+	uint32_t        nameCapacity;
+	uint32_t        *slots;
+	uint32_t        slotCount;
+};
+
+
+static uint32_t
+obj_name_hash (const char *name)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*name)
+		hash = (hash ^ (uint8_t) *name++) * 16777619u;
+
+	return hash;
+}
+
+
+static int
+obj_name_table_index_get (struct obj_name_table *table, const char *name, uint32_t chunk, uint32_t local, uint32_t *index)
+{
+	uint32_t i, slot, slotCount, *slots = NULL;
+	struct obj_name *names = NULL;
+
+	name = (name) ? name : "";
+
+	if ((table->nameCount + 1) * 2 > table->slotCount) {
+		slotCount = (table->slotCount) ? table->slotCount * 2 : 64;
+		slots = calloc(slotCount, sizeof(uint32_t));
+		if (!slots) {
+			kmr_utils_log(KMR_DANGER, "[x] calloc(slots): %s", strerror(errno));
+			return -1;
+		}
+
+		for (i = 0; i < table->nameCount; i++) {
+			slot = obj_name_hash(table->names[i].name) & (slotCount - 1);
+			while (slots[slot])
+				slot = (slot + 1) & (slotCount - 1);
+			slots[slot] = i + 1;
+		}
+
+		free(table->slots);
+		table->slots = slots;
+		table->slotCount = slotCount;
+	}
+
+	slot = obj_name_hash(name) & (table->slotCount - 1);
+	while (table->slots[slot]) {
+		if (!strcmp(table->names[table->slots[slot] - 1].name, name)) {
+			*index = table->slots[slot] - 1;
+			return 0;
+		}
+
+		slot = (slot + 1) & (table->slotCount - 1);
+	}
+
+	if (table->nameCount == table->nameCapacity) {
+		table->nameCapacity = (table->nameCapacity) ? table->nameCapacity * 2 : 32;
+		names = realloc(table->names, table->nameCapacity * sizeof(struct obj_name));
+		if (!names) {
+			kmr_utils_log(KMR_DANGER, "[x] realloc(names): %s", strerror(errno));
+			return -1;
+		}
+
+		table->names = names;
+	}
+
+	table->names[table->nameCount].name = name;
+	table->names[table->nameCount].chunk = chunk;
+	table->names[table->nameCount].local = local;
+	table->slots[slot] = table->nameCount + 1;
+	*index = table->nameCount++;
+
+	return 0;
+}
+
+
+static void
+obj_name_table_free (struct obj_name_table *table)
+{
+	free(table->names);
+	free(table->slots);
+}
+
+
+/* Element of global (1-based) attribute @index inside of the chunk that parsed it */
+static const float *
+obj_attribute_get (struct obj_build *build, enum obj_attribute attribute, uint32_t index)
+{
+	uint32_t low = 0, high = build->chunkCount, mid;
+	const float *data = NULL;
+	struct obj_chunk *chunk = NULL;
+
+	/* Last chunk whose first element is at or before @index, index 0 is chunk 0's dummy */
+	while (high - low > 1) {
+		mid = (low + high) / 2;
+		if (build->chunks[mid].attributeFirst[attribute] <= index)
+			low = mid;
+		else
+			high = mid;
+	}
+
+	chunk = &build->chunks[low];
+	switch (attribute) {
+		case OBJ_ATTRIBUTE_POSITION:
+			data = chunk->objMesh->positions;
+			break;
+		case OBJ_ATTRIBUTE_TEXCOORD:
+			data = chunk->objMesh->texcoords;
+			break;
+		default:
+			data = chunk->objMesh->normals;
+			break;
+	}
+
+	if (index)
+		index = index - chunk->attributeFirst[attribute] + 1;
+
+	return data + (index * obj_attribute_strides[attribute]);
+}
+
+
+static inline uint32_t
+obj_face_material_get (struct obj_build *build, struct obj_chunk *chunk, uint32_t face)
+{
+	uint32_t material = chunk->objMesh->face_materials[face];
+
+	if (material < chunk->objMesh->material_count)
+		return chunk->materialRemap[material];
+
+	/* fast_obj gives faces ahead of any "usemtl" the first material of the file */
+	return (build->materialCount) ? 0 : UINT32_MAX;
+}
+
+
+/* Primitives of a mesh, one per material used by the group in ascending material order */
+struct obj_mesh {
+	uint32_t primitiveCount;
+	uint32_t *materials;
+	uint32_t *triangleCounts;
+};
+
+
+struct obj_mesh_count {
+	struct obj_build *build;
+	struct obj_mesh  *meshes;
+};
+
+
+static int
+obj_mesh_count_job_run (void *userData, uint32_t jobIndex)
+{
+	uint32_t s, f, m, material, faceEnd, *counts = NULL;
+
+	struct obj_mesh_count *meshCount = userData;
+	struct obj_build *build = meshCount->build;
+	struct obj_mesh *mesh = &meshCount->meshes[jobIndex];
+	struct obj_chunk *chunk = NULL;
+	fastObjGroup *group = NULL;
+
+	/* Last slot counts faces without a material */
+	counts = calloc(build->materialCount + 1, sizeof(uint32_t));
+	if (!counts) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(counts): %s", strerror(errno));
+		return -1;
+	}
+
+	for (s = build->segmentOffsets[jobIndex]; s < build->segmentOffsets[jobIndex + 1]; s++) {
+		chunk = &build->chunks[build->segments[s].chunk];
+		group = &chunk->objMesh->groups[build->segments[s].group];
+		faceEnd = group->face_offset + group->face_count;
+
+		for (f = group->face_offset; f < faceEnd; f++) {
+			if (chunk->objMesh->face_vertices[f] < 3)
+				continue;
+
+			material = obj_face_material_get(build, chunk, f);
+			counts[(material == UINT32_MAX) ? build->materialCount : material] += chunk->objMesh->face_vertices[f] - 2;
+		}
+	}
+
+	for (m = 0; m <= build->materialCount; m++)
+		mesh->primitiveCount += !!counts[m];
+
+	mesh->materials = malloc((mesh->primitiveCount * 2 * sizeof(uint32_t)) + 1);
+	if (!mesh->materials) {
+		kmr_utils_log(KMR_DANGER, "[x] malloc(materials): %s", strerror(errno));
+		free(counts);
+		return -1;
+	}
+
+	mesh->triangleCounts = mesh->materials + mesh->primitiveCount;
+	for (m = 0, s = 0; m <= build->materialCount; m++) {
+		if (!counts[m])
+			continue;
+
+		mesh->materials[s] = (m == build->materialCount) ? UINT32_MAX : m;
+		mesh->triangleCounts[s++] = counts[m];
+	}
+
+	free(counts);
+
+	return 0;
+}
+
+
+static inline uint32_t
+obj_corner_hash (const struct obj_corner *corner)
+{
+	uint32_t hash = (corner->p * 0x9e3779b1u) ^ (corner->t * 0x85ebca77u) ^ (corner->n * 0xc2b2ae3du);
+	return hash ^ (hash >> 15);
+}
+
+
+/*
+ * Triangulates the faces of a primitive as fans and resolves every corner to global
+ * attribute indices. When welding, corners referencing the same attributes share one
+ * entry in @corners. Unique corners are compacted to the front as they are found.
+ */
+static int
+obj_primitive_weld_job_run (void *userData, uint32_t jobIndex)
+{
+	uint32_t s, f, v, i, c, faceEnd, indexOffset, faceVertexCount, hash, slot, tableSize = 16, unique = 0, cornerCount = 0;
+	uint32_t *table = NULL;
+
+	struct obj_build *build = userData;
+	struct obj_primitive *primitive = &build->primitives[jobIndex];
+	struct obj_chunk *chunk = NULL;
+	struct obj_corner corner;
+	fastObjGroup *group = NULL;
+	fastObjIndex *faceIndices = NULL;
+
+	primitive->corners = malloc((uint64_t) primitive->triangleCount * 3 * sizeof(struct obj_corner));
+	primitive->indices = malloc((uint64_t) primitive->triangleCount * 3 * sizeof(uint32_t));
+	if (!primitive->corners || !primitive->indices) {
+		kmr_utils_log(KMR_DANGER, "[x] malloc(corners): %s", strerror(errno));
+		return -1;
+	}
+
+	if (build->weld) {
+		while (tableSize < (uint64_t) primitive->triangleCount * 3 * 2)
+			tableSize <<= 1;
+
+		table = malloc(tableSize * sizeof(uint32_t));
+		if (!table) {
+			kmr_utils_log(KMR_DANGER, "[x] malloc(table): %s", strerror(errno));
+			return -1;
+		}
+
+		memset(table, 0xff, tableSize * sizeof(uint32_t));
+	}
+
+	for (s = build->segmentOffsets[primitive->meshIndex]; s < build->segmentOffsets[primitive->meshIndex + 1]; s++) {
+		chunk = &build->chunks[build->segments[s].chunk];
+		group = &chunk->objMesh->groups[build->segments[s].group];
+		faceEnd = group->face_offset + group->face_count;
+		indexOffset = group->index_offset;
+
+		for (f = group->face_offset; f < faceEnd; indexOffset += faceVertexCount, f++) {
+			faceVertexCount = chunk->objMesh->face_vertices[f];
+			if (faceVertexCount < 3 || obj_face_material_get(build, chunk, f) != primitive->materialIndex)
+				continue;
+
+			faceIndices = chunk->objMesh->indices + indexOffset;
+			for (v = 2; v < faceVertexCount; v++) {
+				for (c = 0; c < 3; c++) {
+					i = (c == 0) ? 0 : (c == 1) ? v - 1 : v;
+					corner.p = faceIndices[i].p;
+					corner.t = faceIndices[i].t;
+					corner.n = faceIndices[i].n;
+
+					if (corner.p >= build->attributeCount[OBJ_ATTRIBUTE_POSITION] ||
+					    corner.t >= build->attributeCount[OBJ_ATTRIBUTE_TEXCOORD] ||
+					    corner.n >= build->attributeCount[OBJ_ATTRIBUTE_NORMAL])
+					{
+						kmr_utils_log(KMR_DANGER, "[x] obj_primitive_weld_job_run: Face references undefined vertex %u/%u/%u",
+						              corner.p, corner.t, corner.n);
+						free(table);
+						return -1;
+					}
+
+					if (!table) {
+						primitive->corners[unique] = corner;
+						primitive->indices[cornerCount++] = unique++;
+						continue;
+					}
+
+					hash = obj_corner_hash(&corner) & (tableSize - 1);
+					while ((slot = table[hash]) != UINT32_MAX) {
+						if (!memcmp(&primitive->corners[slot], &corner, sizeof(struct obj_corner)))
+							break;
+						hash = (hash + 1) & (tableSize - 1);
+					}
+
+					if (slot == UINT32_MAX) {
+						slot = table[hash] = unique++;
+						primitive->corners[slot] = corner;
+					}
+
+					primitive->indices[cornerCount++] = slot;
+				}
+			}
+		}
+	}
+
+	free(table);
+	primitive->cornerCount = unique;
+
+	return 0;
+}
+
+
+/* Writes the vertices and indices of a primitive to their place in the decode arena */
+static int
+obj_primitive_fill_job_run (void *userData, uint32_t jobIndex)
+{
+	uint32_t v, i;
+	const float *texCoord = NULL;
+
+	struct obj_build *build = userData;
+	struct obj_primitive *obj = &build->primitives[jobIndex];
+	struct kmr_gltf_loader_mesh_data *meshData = &build->meshData[obj->meshIndex];
+	struct kmr_gltf_loader_mesh_primitive *primitive = &meshData->primitives[obj->primitiveIndex];
+	struct kmr_gltf_loader_mesh_vertex_data *vertex = NULL;
+
+	for (i = 0; i < 3; i++) {
+		primitive->aabbMin[i] = FLT_MAX;
+		primitive->aabbMax[i] = -FLT_MAX;
+	}
+
+	primitive->sphereRadius = -1.0f;
+
+	for (v = 0; v < obj->cornerCount; v++) {
+		vertex = &meshData->vertexBufferData[primitive->firstVertex + v];
+
+		memcpy(vertex->position, obj_attribute_get(build, OBJ_ATTRIBUTE_POSITION, obj->corners[v].p), sizeof(vec3));
+		memcpy(vertex->normal, obj_attribute_get(build, OBJ_ATTRIBUTE_NORMAL, obj->corners[v].n), sizeof(vec3));
+		glm_vec3_one(vertex->color);
+
+		/* OBJ texture coordinates have a bottom left origin */
+		if (obj->corners[v].t) {
+			texCoord = obj_attribute_get(build, OBJ_ATTRIBUTE_TEXCOORD, obj->corners[v].t);
+			vertex->texCoord[0] = texCoord[0];
+			vertex->texCoord[1] = 1.0f - texCoord[1];
+		} else {
+			vertex->texCoord[0] = vertex->texCoord[1] = 0.0f;
+		}
+
+		glm_vec3_minv(primitive->aabbMin, vertex->position, primitive->aabbMin);
+		glm_vec3_maxv(primitive->aabbMax, vertex->position, primitive->aabbMax);
+	}
+
+	for (i = 0; i < primitive->indexCount; i++)
+		meshData->indexBufferData[primitive->firstIndex + i] = obj->indices[i] + primitive->firstVertex;
+
+	free(obj->corners);
+	free(obj->indices);
+	obj->corners = NULL;
+	obj->indices = NULL;
+
+	return 0;
+}
+
+
+static char *
+obj_string_pool_copy (char *stringPool, uint32_t *offset, const char *string)
+{
+	char *copy = NULL;
+
+	if (!string)
+		return NULL;
+
+	copy = stringPool + *offset;
+	strcpy(copy, string);
+	*offset += strlen(string) + 1;
+
+	return copy;
+}
+
+
+static int
+obj_materials_create (struct kmr_obj_loader *obj, struct obj_build *build, struct obj_name_table *materials)
+{
+	uint32_t m, offset = 0;
+	uint64_t stringPoolSize = 0;
+
+	fastObjMaterial *material = NULL;
+	struct kmr_obj_loader_material_data *materialData = NULL;
+
+	for (m = 0; m < materials->nameCount; m++) {
+		material = &build->chunks[materials->names[m].chunk].objMesh->materials[materials->names[m].local];
+		stringPoolSize += strlen(materials->names[m].name) + 1;
+		stringPoolSize += (material->map_Kd.path) ? strlen(material->map_Kd.path) + 1 : 0;
+		stringPoolSize += (material->map_bump.path) ? strlen(material->map_bump.path) + 1 : 0;
+	}
+
+	if (!materials->nameCount)
+		return 0;
+
+	obj->materialData = calloc(materials->nameCount, sizeof(struct kmr_obj_loader_material_data));
+	obj->stringPool = malloc(stringPoolSize);
+	if (!obj->materialData || !obj->stringPool) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(materialData): %s", strerror(errno));
+		return -1;
+	}
+
+	obj->materialDataCount = materials->nameCount;
+	obj->stringPoolSize = stringPoolSize;
+
+	for (m = 0; m < materials->nameCount; m++) {
+		material = &build->chunks[materials->names[m].chunk].objMesh->materials[materials->names[m].local];
+		materialData = &obj->materialData[m];
+
+		materialData->materialName = obj_string_pool_copy(obj->stringPool, &offset, materials->names[m].name);
+		materialData->diffuseTexturePath = obj_string_pool_copy(obj->stringPool, &offset, material->map_Kd.path);
+		materialData->normalTexturePath = obj_string_pool_copy(obj->stringPool, &offset, material->map_bump.path);
+		memcpy(materialData->ambient, material->Ka, sizeof(vec3));
+		memcpy(materialData->diffuse, material->Kd, sizeof(vec3));
+		memcpy(materialData->specular, material->Ks, sizeof(vec3));
+		memcpy(materialData->emission, material->Ke, sizeof(vec3));
+		materialData->shininess = material->Ns;
+		materialData->dissolve = material->d;
+	}
+
+	return 0;
+}
+
+
+/*
+ * Splits the mapped file into at most @chunkCount line aligned chunks. Chunks
+ * past the first that use relative face indices collapse everything into one.
+ */
+static uint32_t
+obj_chunks_split (struct obj_chunk *chunks, uint32_t chunkCount, struct kmr_utils_file *file, const char *fileName)
+{
+	uint32_t c, count = 0;
+	uint64_t start = 0, end;
+	const char *bytes = (const char *) file->bytes, *newline = NULL;
+
+	for (c = 0; c < chunkCount && start < file->byteSize; c++) {
+		end = file->byteSize;
+		if (c + 1 < chunkCount) {
+			end = (uint64_t) file->byteSize * (c + 1) / chunkCount;
+			end = (end < start) ? start : end;
+			newline = memchr(bytes + end, '\n', file->byteSize - end);
+			end = (newline) ? (uint64_t) (newline - bytes) + 1 : file->byteSize;
+		}
+
+		chunks[count].fileName = fileName;
+		chunks[count].data = bytes + start;
+		chunks[count].dataSize = end - start;
+		count++;
+		start = end;
+	}
+
+	return count;
+}
+
+
+static void
+obj_chunks_free (struct obj_chunk *chunks, uint32_t chunkCount)
+{
+	uint32_t c;
+
+	if (!chunks)
+		return;
+
+	for (c = 0; c < chunkCount; c++) {
+		free(chunks[c].prefix);
+		free(chunks[c].mtllibLines);
+		free(chunks[c].materialRemap);
+		free(chunks[c].groupRemap);
+		if (chunks[c].objMesh)
+			fast_obj_destroy(chunks[c].objMesh);
+	}
+
+	free(chunks);
+}
+
+
+struct kmr_obj_loader *
+kmr_obj_loader_create (struct kmr_obj_loader_create_info *objInfo)
+{
+	uint32_t c, g, m, p, a, chunkCount = 0, threadCount, chunkSize, meshCount = 0, primitiveCount = 0;
+	uint32_t firstIndex = 0, vertexOffset, indexOffset, segmentCount = 0, index;
+	uint64_t vertexCount = 0, indexCount = 0, decodeArenaSize;
+	uint8_t *decodeArena = NULL, *vertexCursor = NULL, *indexCursor = NULL;
+	bool relative = false;
+
+	struct kmr_utils_file file = {0};
+	struct obj_chunk *chunks = NULL;
+	struct obj_build build = {0};
+	struct obj_mesh *meshes = NULL;
+	struct obj_mesh_count meshCountJob;
+	struct obj_name_table groups = {0}, materials = {0};
+	struct obj_primitive *objPrimitives = NULL;
+	struct kmr_utils_worker_pool_run_info workerPoolRunInfo;
+	struct kmr_gltf_loader_mesh_emit_info emitInfo;
+	struct kmr_gltf_loader_mesh_optimize_info optimizeInfo;
+
+	struct kmr_obj_loader *obj = NULL;
+	struct kmr_gltf_loader_mesh *mesh = NULL;
+	struct kmr_gltf_loader_mesh_data *meshData = NULL;
+	struct kmr_gltf_loader_mesh_primitive *primitives = NULL;
+	fastObjMesh *objMesh = NULL;
+
+	obj = calloc(1, sizeof(struct kmr_obj_loader));
+	mesh = calloc(1, sizeof(struct kmr_gltf_loader_mesh));
+	if (!obj || !mesh) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(obj): %s", strerror(errno));
+		free(obj); free(mesh);
+		return NULL;
+	}
+
+	obj->mesh = mesh;
+	mesh->vertexLayout = objInfo->vertexLayout;
+
+	file = kmr_utils_file_map(objInfo->fileName, true);
+	if (!file.bytes)
+		goto exit_error_kmr_obj_loader_create;
+
+	threadCount = (objInfo->threadCount) ? objInfo->threadCount : (uint32_t) sysconf(_SC_NPROCESSORS_ONLN);
+	chunkSize = (objInfo->chunkSize) ? objInfo->chunkSize : OBJ_CHUNK_SIZE_DEFAULT;
+	chunkCount = file.byteSize / chunkSize;
+	chunkCount = (chunkCount > threadCount) ? threadCount : chunkCount;
+	chunkCount = (chunkCount) ? chunkCount : 1;
+
+	chunks = calloc(chunkCount, sizeof(struct obj_chunk));
+	if (!chunks) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(chunks): %s", strerror(errno));
+		goto exit_error_kmr_obj_loader_create;
+	}
+
+	chunkCount = obj_chunks_split(chunks, chunkCount, &file, objInfo->fileName);
+
+	workerPoolRunInfo.threadCount = objInfo->threadCount;
+	workerPoolRunInfo.jobCount = chunkCount;
+	workerPoolRunInfo.job = obj_chunk_scan_job_run;
+	workerPoolRunInfo.userData = chunks;
+
+	if (chunkCount > 1 && kmr_utils_worker_pool_run(&workerPoolRunInfo) == -1)
+		goto exit_error_kmr_obj_loader_create;
+
+	/* Relative indices resolve against everything parsed before them, which a chunk doesn't see */
+	for (c = 1; c < chunkCount; c++)
+		relative |= chunks[c].relative;
+
+	if (relative) {
+		for (c = 0; c < chunkCount; c++)
+			free(chunks[c].mtllibLines);
+		memset(chunks, 0, chunkCount * sizeof(struct obj_chunk));
+		chunkCount = obj_chunks_split(chunks, 1, &file, objInfo->fileName);
+	}
+
+	for (c = 1; c < chunkCount; c++) {
+		if (obj_chunk_prefix_set(chunks, c, (const char *) file.bytes + file.byteSize) == -1)
+			goto exit_error_kmr_obj_loader_create;
+	}
+
+	workerPoolRunInfo.jobCount = chunkCount;
+	workerPoolRunInfo.job = obj_chunk_parse_job_run;
+	if (kmr_utils_worker_pool_run(&workerPoolRunInfo) == -1)
+		goto exit_error_kmr_obj_loader_create;
+
+	/*
+	 * Merge chunks in file order. Positive face indices already count from the start of
+	 * the file, so attribute arrays only need their offsets (minus each chunk's dummy).
+	 */
+	build.chunks = chunks;
+	build.chunkCount = chunkCount;
+	build.weld = !!(objInfo->flags & KMR_OBJ_LOADER_CREATE_WELD);
+	for (a = 0; a < 3; a++)
+		build.attributeCount[a] = 1;
+
+	for (c = 0; c < chunkCount; c++) {
+		objMesh = chunks[c].objMesh;
+		chunks[c].attributeFirst[OBJ_ATTRIBUTE_POSITION] = build.attributeCount[OBJ_ATTRIBUTE_POSITION];
+		chunks[c].attributeFirst[OBJ_ATTRIBUTE_TEXCOORD] = build.attributeCount[OBJ_ATTRIBUTE_TEXCOORD];
+		chunks[c].attributeFirst[OBJ_ATTRIBUTE_NORMAL] = build.attributeCount[OBJ_ATTRIBUTE_NORMAL];
+		build.attributeCount[OBJ_ATTRIBUTE_POSITION] += objMesh->position_count - 1;
+		build.attributeCount[OBJ_ATTRIBUTE_TEXCOORD] += objMesh->texcoord_count - 1;
+		build.attributeCount[OBJ_ATTRIBUTE_NORMAL] += objMesh->normal_count - 1;
+
+		chunks[c].materialRemap = calloc(objMesh->material_count + 1, sizeof(uint32_t));
+		chunks[c].groupRemap = calloc(objMesh->group_count + 1, sizeof(uint32_t));
+		if (!chunks[c].materialRemap || !chunks[c].groupRemap) {
+			kmr_utils_log(KMR_DANGER, "[x] calloc(remap): %s", strerror(errno));
+			goto exit_error_kmr_obj_loader_create;
+		}
+
+		for (m = 0; m < objMesh->material_count; m++) {
+			if (obj_name_table_index_get(&materials, objMesh->materials[m].name, c, m, &chunks[c].materialRemap[m]) == -1)
+				goto exit_error_kmr_obj_loader_create;
+		}
+
+		for (g = 0; g < objMesh->group_count; g++) {
+			if (obj_name_table_index_get(&groups, objMesh->groups[g].name, c, g, &chunks[c].groupRemap[g]) == -1)
+				goto exit_error_kmr_obj_loader_create;
+		}
+
+		segmentCount += objMesh->group_count;
+	}
+
+	meshCount = groups.nameCount;
+	build.materialCount = materials.nameCount;
+	if (meshCount > UINT16_MAX) {
+		kmr_utils_log(KMR_DANGER, "[x] kmr_obj_loader_create(%s): %u groups exceed %u", objInfo->fileName, meshCount, UINT16_MAX);
+		goto exit_error_kmr_obj_loader_create;
+	}
+
+	/* Segments of every group in chunk order */
+	build.segments = calloc(segmentCount + 1, sizeof(struct obj_segment));
+	build.segmentOffsets = calloc(meshCount + 2, sizeof(uint32_t));
+	meshes = calloc(meshCount + 1, sizeof(struct obj_mesh));
+	if (!build.segments || !build.segmentOffsets || !meshes) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(segments): %s", strerror(errno));
+		goto exit_error_kmr_obj_loader_create;
+	}
+
+	for (c = 0; c < chunkCount; c++)
+		for (g = 0; g < chunks[c].objMesh->group_count; g++)
+			build.segmentOffsets[chunks[c].groupRemap[g] + 2]++;
+
+	for (g = 2; g < meshCount + 2; g++)
+		build.segmentOffsets[g] += build.segmentOffsets[g - 1];
+
+	for (c = 0; c < chunkCount; c++) {
+		for (g = 0; g < chunks[c].objMesh->group_count; g++) {
+			index = build.segmentOffsets[chunks[c].groupRemap[g] + 1]++;
+			build.segments[index].chunk = c;
+			build.segments[index].group = g;
+		}
+	}
+
+	meshCountJob.build = &build;
+	meshCountJob.meshes = meshes;
+	workerPoolRunInfo.jobCount = meshCount;
+	workerPoolRunInfo.job = obj_mesh_count_job_run;
+	workerPoolRunInfo.userData = &meshCountJob;
+
+	if (kmr_utils_worker_pool_run(&workerPoolRunInfo) == -1)
+		goto exit_error_kmr_obj_loader_create;
+
+	for (g = 0; g < meshCount; g++)
+		primitiveCount += meshes[g].primitiveCount;
+
+	/* Same allocation kmr_gltf_loader_mesh_create() makes so kmr_gltf_loader_mesh_destroy() applies */
+	meshData = calloc(1, (meshCount * sizeof(struct kmr_gltf_loader_mesh_data)) +
+	                     (primitiveCount * sizeof(struct kmr_gltf_loader_mesh_primitive)));
+	objPrimitives = calloc(primitiveCount + 1, sizeof(struct obj_primitive));
+	if (!meshData || !objPrimitives) {
+		kmr_utils_log(KMR_DANGER, "[x] calloc(meshData): %s", strerror(errno));
+		free(meshData);
+		goto exit_error_kmr_obj_loader_create;
+	}
+
+	mesh->meshData = meshData;
+	mesh->meshDataCount = meshCount;
+	primitives = (struct kmr_gltf_loader_mesh_primitive *) (meshData + meshCount);
+
+	for (g = 0, p = 0; g < meshCount; g++) {
+		meshData[g].primitives = (meshes[g].primitiveCount) ? primitives : NULL;
+		meshData[g].primitiveCount = meshes[g].primitiveCount;
+		primitives += meshes[g].primitiveCount;
+
+		for (m = 0; m < meshes[g].primitiveCount; m++, p++) {
+			objPrimitives[p].meshIndex = g;
+			objPrimitives[p].primitiveIndex = m;
+			objPrimitives[p].materialIndex = meshes[g].materials[m];
+			objPrimitives[p].triangleCount = meshes[g].triangleCounts[m];
+		}
+	}
+
+	build.primitives = objPrimitives;
+	build.meshData = meshData;
+	workerPoolRunInfo.jobCount = primitiveCount;
+	workerPoolRunInfo.job = obj_primitive_weld_job_run;
+	workerPoolRunInfo.userData = &build;
+
+	if (kmr_utils_worker_pool_run(&workerPoolRunInfo) == -1)
+		goto exit_error_kmr_obj_loader_create;
+
+	/* Vertex counts are known once welded, lay out the decode arena */
+	for (g = 0, p = 0; g < meshCount; g++) {
+		vertexOffset = indexOffset = 0;
+		for (m = 0; m < meshData[g].primitiveCount; m++, p++) {
+			meshData[g].primitives[m].type = cgltf_primitive_type_triangles;
+			meshData[g].primitives[m].materialIndex = objPrimitives[p].materialIndex;
+			meshData[g].primitives[m].firstIndex = indexOffset;
+			meshData[g].primitives[m].indexCount = objPrimitives[p].triangleCount * 3;
+			meshData[g].primitives[m].firstVertex = vertexOffset;
+			meshData[g].primitives[m].vertexCount = objPrimitives[p].cornerCount;
+			vertexOffset += meshData[g].primitives[m].vertexCount;
+			indexOffset += meshData[g].primitives[m].indexCount;
+		}
+
+		meshData[g].firstIndex = firstIndex;
+		meshData[g].indexType = VK_INDEX_TYPE_UINT32;
+		meshData[g].indexBufferDataCount = indexOffset;
+		meshData[g].indexBufferDataSize = indexOffset * sizeof(uint32_t);
+		meshData[g].vertexBufferDataCount = vertexOffset;
+		meshData[g].vertexBufferDataSize = vertexOffset * sizeof(struct kmr_gltf_loader_mesh_vertex_data);
+		glm_vec3_one(meshData[g].positionScale);
+		glm_vec3_zero(meshData[g].positionOffset);
+		firstIndex += indexOffset;
+		vertexCount += vertexOffset;
+		indexCount += indexOffset;
+	}
+
+	decodeArenaSize = (vertexCount * sizeof(struct kmr_gltf_loader_mesh_vertex_data)) + (indexCount * sizeof(uint32_t));
+	if (decodeArenaSize > UINT32_MAX) {
+		kmr_utils_log(KMR_DANGER, "[x] kmr_obj_loader_create: Mesh data exceeds %" PRIu32 " bytes", UINT32_MAX);
+		goto exit_error_kmr_obj_loader_create;
+	}
+
+	if (decodeArenaSize) {
+		decodeArena = malloc(decodeArenaSize);
+		if (!decodeArena) {
+			kmr_utils_log(KMR_DANGER, "[x] malloc(decodeArena): %s", strerror(errno));
+			goto exit_error_kmr_obj_loader_create;
+		}
+	}
+
+	vertexCursor = decodeArena;
+	indexCursor = decodeArena + (vertexCount * sizeof(struct kmr_gltf_loader_mesh_vertex_data));
+	for (g = 0; g < meshCount; g++) {
+		meshData[g].vertexBufferData = (struct kmr_gltf_loader_mesh_vertex_data *) vertexCursor;
+		meshData[g].indexBufferData = (uint32_t *) indexCursor;
+		vertexCursor += meshData[g].vertexBufferDataSize;
+		indexCursor += meshData[g].indexBufferDataSize;
+	}
+
+	workerPoolRunInfo.job = obj_primitive_fill_job_run;
+	if (kmr_utils_worker_pool_run(&workerPoolRunInfo) == -1)
+		goto exit_error_kmr_obj_loader_create;
+
+	/* Welding already happened on attribute indices, only downsizing is left */
+	emitInfo.mesh = mesh;
+	emitInfo.threadCount = objInfo->threadCount;
+	emitInfo.flags = (objInfo->flags & KMR_OBJ_LOADER_CREATE_INDEX_DOWNSIZE) ? KMR_GLTF_LOADER_MESH_CREATE_INDEX_DOWNSIZE : 0;
+	emitInfo.arena = objInfo->arena;
+	emitInfo.arenaSize = objInfo->arenaSize;
+
+	if (kmr_gltf_loader_mesh_emit(&emitInfo) == -1)
+		goto exit_error_kmr_obj_loader_create;
+
+	free(decodeArena);
+	decodeArena = NULL;
+
+	if (objInfo->flags & KMR_OBJ_LOADER_CREATE_OPTIMIZE) {
+		optimizeInfo.mesh = mesh;
+		optimizeInfo.cacheSize = 0;
+		optimizeInfo.threadCount = objInfo->threadCount;
+		if (kmr_gltf_loader_mesh_optimize(&optimizeInfo) == -1)
+			goto exit_error_kmr_obj_loader_create;
+	}
+
+	if (obj_materials_create(obj, &build, &materials) == -1)
+		goto exit_error_kmr_obj_loader_create;
+
+	for (g = 0; g < meshCount; g++)
+		free(meshes[g].materials);
+	free(meshes);
+	free(objPrimitives);
+	free(build.segments);
+	free(build.segmentOffsets);
+	obj_name_table_free(&groups);
+	obj_name_table_free(&materials);
+	obj_chunks_free(chunks, chunkCount);
+	kmr_utils_file_unmap(&file);
+
+	return obj;
+
+exit_error_kmr_obj_loader_create:
+	if (meshes) {
+		for (g = 0; g < meshCount; g++)
+			free(meshes[g].materials);
+		free(meshes);
+	}
+	if (objPrimitives) {
+		for (p = 0; p < primitiveCount; p++) {
+			free(objPrimitives[p].corners);
+			free(objPrimitives[p].indices);
+		}
+		free(objPrimitives);
+	}
+	free(decodeArena);
+	free(build.segments);
+	free(build.segmentOffsets);
+	obj_name_table_free(&groups);
+	obj_name_table_free(&materials);
+	obj_chunks_free(chunks, chunkCount);
+	kmr_utils_file_unmap(&file);
+	kmr_obj_loader_destroy(obj);
+	return NULL;
+}
+
+
+void
+kmr_obj_loader_destroy (struct kmr_obj_loader *obj)
+{
+	if (!obj)
+		return;
+
+	kmr_gltf_loader_mesh_destroy(obj->mesh);
+	free(obj->materialData);
+	free(obj->stringPool);
+	free(obj);
+}
@@ -8,7 +8,9 @@
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <stdint.h>
+#include <pthread.h>
 #include <libgen.h>    // dirname(3)
+#include <math.h>
 #define HAVE_POSIX_TIMER
 #include <time.h>
 #ifdef CLOCK_MONOTONIC
@@ -18,6 +20,12 @@
 #endif
 
 #include <stb_image.h>
+#include <vulkan/vulkan.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
 
 #include "utils.h"
 
@@ -44,23 +52,358 @@ exit_error_utils_aligned_buffer:
 }
 
 
-struct kmr_utils_image_buffer kmr_utils_image_buffer_create(struct kmr_utils_image_buffer_create_info *kmsutils)
+/*
+ * Block (or texel for uncompressed formats) layout of the formats KTX2/DDS
+ * payloads are passed through as. DDS files name formats by DXGI_FORMAT,
+ * KTX2 files store the VkFormat directly. A @dxgiFormat of 0 is a format
+ * only KTX2 can carry.
+ */
+struct image_buffer_block_format {
+	uint32_t vkFormat;
+	uint32_t dxgiFormat;
+	uint8_t  blockWidth;
+	uint8_t  blockHeight;
+	uint8_t  blockBytes;
+	uint8_t  channels;
+};
+
+
+#define ASTC_BLOCK_FORMATS(w, h) \
+	{ VK_FORMAT_ASTC_##w##x##h##_UNORM_BLOCK, 0, w, h, 16, 4 }, \
+	{ VK_FORMAT_ASTC_##w##x##h##_SRGB_BLOCK, 0, w, h, 16, 4 }
+
+static const struct image_buffer_block_format block_formats[] = {
+	{ VK_FORMAT_R8G8B8A8_UNORM, 28, 1, 1, 4, 4 },
+	{ VK_FORMAT_R8G8B8A8_SRGB, 29, 1, 1, 4, 4 },
+	{ VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 71, 4, 4, 8, 4 },
+	{ VK_FORMAT_BC1_RGBA_SRGB_BLOCK, 72, 4, 4, 8, 4 },
+	{ VK_FORMAT_BC1_RGB_UNORM_BLOCK, 0, 4, 4, 8, 3 },
+	{ VK_FORMAT_BC1_RGB_SRGB_BLOCK, 0, 4, 4, 8, 3 },
+	{ VK_FORMAT_BC2_UNORM_BLOCK, 74, 4, 4, 16, 4 },
+	{ VK_FORMAT_BC2_SRGB_BLOCK, 75, 4, 4, 16, 4 },
+	{ VK_FORMAT_BC3_UNORM_BLOCK, 77, 4, 4, 16, 4 },
+	{ VK_FORMAT_BC3_SRGB_BLOCK, 78, 4, 4, 16, 4 },
+	{ VK_FORMAT_BC4_UNORM_BLOCK, 80, 4, 4, 8, 1 },
+	{ VK_FORMAT_BC4_SNORM_BLOCK, 81, 4, 4, 8, 1 },
+	{ VK_FORMAT_BC5_UNORM_BLOCK, 83, 4, 4, 16, 2 },
+	{ VK_FORMAT_BC5_SNORM_BLOCK, 84, 4, 4, 16, 2 },
+	{ VK_FORMAT_BC6H_UFLOAT_BLOCK, 95, 4, 4, 16, 3 },
+	{ VK_FORMAT_BC6H_SFLOAT_BLOCK, 96, 4, 4, 16, 3 },
+	{ VK_FORMAT_BC7_UNORM_BLOCK, 98, 4, 4, 16, 4 },
+	{ VK_FORMAT_BC7_SRGB_BLOCK, 99, 4, 4, 16, 4 },
+	{ VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, 0, 4, 4, 8, 3 },
+	{ VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK, 0, 4, 4, 8, 3 },
+	{ VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK, 0, 4, 4, 8, 4 },
+	{ VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK, 0, 4, 4, 8, 4 },
+	{ VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, 0, 4, 4, 16, 4 },
+	{ VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK, 0, 4, 4, 16, 4 },
+	{ VK_FORMAT_EAC_R11_UNORM_BLOCK, 0, 4, 4, 8, 1 },
+	{ VK_FORMAT_EAC_R11_SNORM_BLOCK, 0, 4, 4, 8, 1 },
+	{ VK_FORMAT_EAC_R11G11_UNORM_BLOCK, 0, 4, 4, 16, 2 },
+	{ VK_FORMAT_EAC_R11G11_SNORM_BLOCK, 0, 4, 4, 16, 2 },
+	ASTC_BLOCK_FORMATS(4, 4),
+	ASTC_BLOCK_FORMATS(5, 4),
+	ASTC_BLOCK_FORMATS(5, 5),
+	ASTC_BLOCK_FORMATS(6, 5),
+	ASTC_BLOCK_FORMATS(6, 6),
+	ASTC_BLOCK_FORMATS(8, 5),
+	ASTC_BLOCK_FORMATS(8, 6),
+	ASTC_BLOCK_FORMATS(8, 8),
+	ASTC_BLOCK_FORMATS(10, 5),
+	ASTC_BLOCK_FORMATS(10, 6),
+	ASTC_BLOCK_FORMATS(10, 8),
+	ASTC_BLOCK_FORMATS(10, 10),
+	ASTC_BLOCK_FORMATS(12, 10),
+	ASTC_BLOCK_FORMATS(12, 12),
+};
+
+
+/* Looks up by @vkFormat if not VK_FORMAT_UNDEFINED, otherwise by @dxgiFormat */
+static const struct image_buffer_block_format *image_buffer_block_format_get(uint32_t vkFormat, uint32_t dxgiFormat)
+{
+	size_t f;
+
+	for (f = 0; f < ARRAY_LEN(block_formats); f++) {
+		if (vkFormat != VK_FORMAT_UNDEFINED && block_formats[f].vkFormat == vkFormat)
+			return &block_formats[f];
+
+		if (vkFormat == VK_FORMAT_UNDEFINED && dxgiFormat && block_formats[f].dxgiFormat == dxgiFormat)
+			return &block_formats[f];
+	}
+
+	return NULL;
+}
+
+
+/* Byte size of a @width x @height image made of whole blocks of @format */
+static size_t image_buffer_block_level_size(const struct image_buffer_block_format *format, uint32_t width, uint32_t height)
+{
+	return (size_t) format->blockBytes *
+	       ((width + format->blockWidth - 1) / format->blockWidth) *
+	       ((height + format->blockHeight - 1) / format->blockHeight);
+}
+
+
+/* Containers are little endian and fields aren't guaranteed to be aligned */
+static uint32_t image_buffer_read_u32(const uint8_t *bytes)
+{
+	uint32_t value;
+	memcpy(&value, bytes, sizeof(value));
+	return value;
+}
+
+
+static uint64_t image_buffer_read_u64(const uint8_t *bytes)
+{
+	uint64_t value;
+	memcpy(&value, bytes, sizeof(value));
+	return value;
+}
+
+
+static const uint8_t ktx2_identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+#define KTX2_LEVEL_INDEX_OFFSET 80
+#define KTX2_LEVEL_INDEX_ENTRY_SIZE 24
+
+/*
+ * https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+ * Levels are stored smallest first in the file, they're copied
+ * into @pixels largest first so mip level 0 starts at offset 0.
+ */
+static struct kmr_utils_image_buffer image_buffer_ktx2_load(const uint8_t *bytes, size_t byteSize, const char *name)
+{
+	uint32_t vkFormat, width, height, depth, layerCount, faceCount, levelCount, supercompression, level;
+	uint64_t levelOffset, levelSize;
+	size_t imageSize = 0;
+	const struct image_buffer_block_format *format = NULL;
+	struct kmr_utils_image_buffer imageData;
+
+	memset(&imageData, 0, sizeof(imageData));
+
+	if (byteSize < KTX2_LEVEL_INDEX_OFFSET)
+		goto exit_error_utils_image_buffer_ktx2_corrupt;
+
+	vkFormat = image_buffer_read_u32(bytes + 12);
+	width = image_buffer_read_u32(bytes + 20);
+	height = image_buffer_read_u32(bytes + 24);
+	depth = image_buffer_read_u32(bytes + 28);
+	layerCount = image_buffer_read_u32(bytes + 32);
+	faceCount = image_buffer_read_u32(bytes + 36);
+	levelCount = image_buffer_read_u32(bytes + 40);
+	supercompression = image_buffer_read_u32(bytes + 44);
+
+	/* 0 asks the loader to generate mips, only the base level is stored */
+	if (!levelCount)
+		levelCount = 1;
+
+	if (vkFormat == VK_FORMAT_UNDEFINED || supercompression) {
+		kmr_utils_log(KMR_DANGER, "[x] KTX2: %s is supercompressed (Basis Universal/zstd) and needs transcoding, unsupported", name);
+		return imageData;
+	}
+
+	if (!width || !height || depth > 1 || layerCount > 1 || faceCount != 1 || levelCount > KMR_UTILS_IMAGE_BUFFER_MIP_LEVEL_MAX) {
+		kmr_utils_log(KMR_DANGER, "[x] KTX2: %s isn't a single 2D image with at most %u mip levels, unsupported",
+		              name, KMR_UTILS_IMAGE_BUFFER_MIP_LEVEL_MAX);
+		return imageData;
+	}
+
+	/* Level sizes can only be checked for formats with a known block layout */
+	format = image_buffer_block_format_get(vkFormat, 0);
+	if (!format) {
+		kmr_utils_log(KMR_DANGER, "[x] KTX2: %s VkFormat %u isn't block compressed/RGBA8, unsupported", name, vkFormat);
+		return imageData;
+	}
+
+	if (byteSize < KTX2_LEVEL_INDEX_OFFSET + (size_t) levelCount * KTX2_LEVEL_INDEX_ENTRY_SIZE)
+		goto exit_error_utils_image_buffer_ktx2_corrupt;
+
+	for (level = 0; level < levelCount; level++) {
+		levelOffset = image_buffer_read_u64(bytes + KTX2_LEVEL_INDEX_OFFSET + level * KTX2_LEVEL_INDEX_ENTRY_SIZE);
+		levelSize = image_buffer_read_u64(bytes + KTX2_LEVEL_INDEX_OFFSET + level * KTX2_LEVEL_INDEX_ENTRY_SIZE + 8);
+		if (levelSize > byteSize || levelOffset > byteSize - levelSize)
+			goto exit_error_utils_image_buffer_ktx2_corrupt;
+
+		imageData.mipLevels[level].offset = imageSize;
+		imageData.mipLevels[level].width = (width >> level) ? (width >> level) : 1;
+		imageData.mipLevels[level].height = (height >> level) ? (height >> level) : 1;
+		imageData.mipLevels[level].size = image_buffer_block_level_size(format, imageData.mipLevels[level].width,
+		                                                                imageData.mipLevels[level].height);
+
+		/* Without supercompression byteLength is exactly one image of the level */
+		if (levelSize != imageData.mipLevels[level].size)
+			goto exit_error_utils_image_buffer_ktx2_corrupt;
+
+		imageSize += levelSize;
+	}
+
+	imageData.pixels = malloc(imageSize);
+	if (!imageData.pixels) {
+		kmr_utils_log(KMR_DANGER, "[x] malloc: %s", strerror(errno));
+		return imageData;
+	}
+
+	for (level = 0; level < levelCount; level++) {
+		levelOffset = image_buffer_read_u64(bytes + KTX2_LEVEL_INDEX_OFFSET + level * KTX2_LEVEL_INDEX_ENTRY_SIZE);
+		memcpy(imageData.pixels + imageData.mipLevels[level].offset, bytes + levelOffset, imageData.mipLevels[level].size);
+	}
+
+	imageData.imageWidth = width;
+	imageData.imageHeight = height;
+	imageData.imageChannels = format->channels;
+	imageData.imageSize = imageSize;
+	imageData.vkFormat = vkFormat;
+	imageData.mipLevelCount = levelCount;
+	return imageData;
+
+exit_error_utils_image_buffer_ktx2_corrupt:
+	kmr_utils_log(KMR_DANGER, "[x] KTX2: %s is truncated or has out of range level offsets/sizes", name);
+	memset(&imageData, 0, sizeof(imageData));
+	return imageData;
+}
+
+
+#define DDS_MAGIC 0x20534444 // "DDS "
+#define DDS_HEADER_SIZE 128  // Including magic
+#define DDS_HEADER_DXT10_SIZE 20
+#define DDS_PIXEL_FORMAT_FOURCC 0x4
+#define DDS_PIXEL_FORMAT_RGB 0x40
+#define DDS_CAPS2_CUBEMAP 0x200
+#define DDS_CAPS2_VOLUME 0x200000
+#define DDS_DXT10_DIMENSION_TEXTURE2D 3
+#define DDS_DXT10_MISC_TEXTURECUBE 0x4
+#define DDS_FOURCC(a, b, c, d) ((uint32_t) (a) | ((uint32_t) (b) << 8) | ((uint32_t) (c) << 16) | ((uint32_t) (d) << 24))
+
+/*
+ * https://learn.microsoft.com/en-us/windows/win32/direct3ddds/dds-header
+ * Mip levels are stored largest first, so the whole chain is a single copy.
+ */
+static struct kmr_utils_image_buffer image_buffer_dds_load(const uint8_t *bytes, size_t byteSize, const char *name)
+{
+	uint32_t width, height, levelCount, pixelFormatFlags, fourCC, caps2, dxgiFormat = 0, level;
+	size_t dataOffset = DDS_HEADER_SIZE, imageSize = 0;
+	const struct image_buffer_block_format *format = NULL;
+	struct kmr_utils_image_buffer imageData;
+
+	memset(&imageData, 0, sizeof(imageData));
+
+	if (byteSize < DDS_HEADER_SIZE)
+		goto exit_error_utils_image_buffer_dds_corrupt;
+
+	height = image_buffer_read_u32(bytes + 12);
+	width = image_buffer_read_u32(bytes + 16);
+	levelCount = image_buffer_read_u32(bytes + 28);
+	pixelFormatFlags = image_buffer_read_u32(bytes + 80);
+	fourCC = image_buffer_read_u32(bytes + 84);
+	caps2 = image_buffer_read_u32(bytes + 112);
+
+	if (!levelCount)
+		levelCount = 1;
+
+	if (pixelFormatFlags & DDS_PIXEL_FORMAT_FOURCC) {
+		switch (fourCC) {
+			case DDS_FOURCC('D', 'X', 'T', '1'): dxgiFormat = 71; break;
+			case DDS_FOURCC('D', 'X', 'T', '2'):
+			case DDS_FOURCC('D', 'X', 'T', '3'): dxgiFormat = 74; break;
+			case DDS_FOURCC('D', 'X', 'T', '4'):
+			case DDS_FOURCC('D', 'X', 'T', '5'): dxgiFormat = 77; break;
+			case DDS_FOURCC('A', 'T', 'I', '1'):
+			case DDS_FOURCC('B', 'C', '4', 'U'): dxgiFormat = 80; break;
+			case DDS_FOURCC('B', 'C', '4', 'S'): dxgiFormat = 81; break;
+			case DDS_FOURCC('A', 'T', 'I', '2'):
+			case DDS_FOURCC('B', 'C', '5', 'U'): dxgiFormat = 83; break;
+			case DDS_FOURCC('B', 'C', '5', 'S'): dxgiFormat = 84; break;
+			case DDS_FOURCC('D', 'X', '1', '0'):
+				if (byteSize < DDS_HEADER_SIZE + DDS_HEADER_DXT10_SIZE)
+					goto exit_error_utils_image_buffer_dds_corrupt;
+
+				if (image_buffer_read_u32(bytes + 132) != DDS_DXT10_DIMENSION_TEXTURE2D ||
+				    image_buffer_read_u32(bytes + 136) & DDS_DXT10_MISC_TEXTURECUBE ||
+				    image_buffer_read_u32(bytes + 140) > 1)
+				{
+					caps2 |= DDS_CAPS2_VOLUME;
+				}
+
+				dxgiFormat = image_buffer_read_u32(bytes + 128);
+				dataOffset += DDS_HEADER_DXT10_SIZE;
+				break;
+			default:
+				break;
+		}
+	} else if (pixelFormatFlags & DDS_PIXEL_FORMAT_RGB && image_buffer_read_u32(bytes + 88) == 32 &&
+	           image_buffer_read_u32(bytes + 92) == 0x000000ff && image_buffer_read_u32(bytes + 96) == 0x0000ff00 &&
+	           image_buffer_read_u32(bytes + 100) == 0x00ff0000 && image_buffer_read_u32(bytes + 104) == 0xff000000)
+	{
+		dxgiFormat = 28;
+	}
+
+	format = image_buffer_block_format_get(VK_FORMAT_UNDEFINED, dxgiFormat);
+	if (!format) {
+		kmr_utils_log(KMR_DANGER, "[x] DDS: %s pixel format has no block compressed/RGBA8 VkFormat, unsupported", name);
+		return imageData;
+	}
+
+	if (!width || !height || caps2 & (DDS_CAPS2_CUBEMAP | DDS_CAPS2_VOLUME) || levelCount > KMR_UTILS_IMAGE_BUFFER_MIP_LEVEL_MAX) {
+		kmr_utils_log(KMR_DANGER, "[x] DDS: %s isn't a single 2D image with at most %u mip levels, unsupported",
+		              name, KMR_UTILS_IMAGE_BUFFER_MIP_LEVEL_MAX);
+		return imageData;
+	}
+
+	for (level = 0; level < levelCount; level++) {
+		imageData.mipLevels[level].offset = imageSize;
+		imageData.mipLevels[level].width = (width >> level) ? (width >> level) : 1;
+		imageData.mipLevels[level].height = (height >> level) ? (height >> level) : 1;
+		imageData.mipLevels[level].size = image_buffer_block_level_size(format, imageData.mipLevels[level].width,
+		                                                                imageData.mipLevels[level].height);
+		imageSize += imageData.mipLevels[level].size;
+	}
+
+	if (dataOffset > byteSize || imageSize > byteSize - dataOffset)
+		goto exit_error_utils_image_buffer_dds_corrupt;
+
+	imageData.pixels = malloc(imageSize);
+	if (!imageData.pixels) {
+		kmr_utils_log(KMR_DANGER, "[x] malloc: %s", strerror(errno));
+		memset(&imageData, 0, sizeof(imageData));
+		return imageData;
+	}
+
+	memcpy(imageData.pixels, bytes + dataOffset, imageSize);
+
+	imageData.imageWidth = width;
+	imageData.imageHeight = height;
+	imageData.imageChannels = format->channels;
+	imageData.imageSize = imageSize;
+	imageData.vkFormat = format->vkFormat;
+	imageData.mipLevelCount = levelCount;
+	return imageData;
+
+exit_error_utils_image_buffer_dds_corrupt:
+	kmr_utils_log(KMR_DANGER, "[x] DDS: %s is truncated", name);
+	memset(&imageData, 0, sizeof(imageData));
+	return imageData;
+}
+
+
+/*
+ * Decodes an encoded (PNG, JPEG, ...) image already in memory. @name
+ * is only used to tell the user which image failed to decode. KTX2
+ * and DDS containers are recognized by their magic and passed through.
+ */
+static struct kmr_utils_image_buffer image_buffer_decode(const uint8_t *bytes, size_t byteSize, const char *name)
 {
-	char *imageFile = NULL;
 	uint8_t bitsPerPixel = 8;
 	uint8_t *pixels = NULL;
 	int imageWidth = 0, imageHeight = 0, imageChannels = 0;
-	int imageSize = 0, requestedImageChannels = 0;
-	struct kmr_utils_file loadedImageFile;
+	int requestedImageChannels = 0;
+	size_t imageSize = 0;
+	struct kmr_utils_image_buffer imageData;
 
-	/* Choosing to load image into memory using custom function versus using stbi_load */
-	imageFile = kmr_utils_concat_file_to_dir(kmsutils->directory, kmsutils->filename, kmsutils->maxStrLen);
-	if (!imageFile)
-		goto exit_error_utils_image_buffer;
+	if (byteSize >= sizeof(ktx2_identifier) && !memcmp(bytes, ktx2_identifier, sizeof(ktx2_identifier)))
+		return image_buffer_ktx2_load(bytes, byteSize, name);
 
-	loadedImageFile = kmr_utils_file_load(imageFile);
-	if (!loadedImageFile.bytes)
-		goto exit_error_utils_image_buffer_free_imageFile;
+	if (byteSize >= sizeof(uint32_t) && image_buffer_read_u32(bytes) == DDS_MAGIC)
+		return image_buffer_dds_load(bytes, byteSize, name);
 
 	/*
 	 * force 32-bit textures for common Vulkan compatibility. It appears that
@@ -78,8 +421,8 @@ struct kmr_utils_image_buffer kmr_utils_image_buffer_create(struct kmr_utils_ima
 	 * the Image metadata to signal that this image uses 2 bytes (16bits) per
 	 * channel.
 	 */
-	if (stbi_is_16_bit_from_memory(loadedImageFile.bytes, loadedImageFile.byteSize)) {
-		pixels = (uint8_t *) stbi_load_16_from_memory(loadedImageFile.bytes, loadedImageFile.byteSize, &imageWidth, &imageHeight, &imageChannels, requestedImageChannels);
+	if (stbi_is_16_bit_from_memory(bytes, byteSize)) {
+		pixels = (uint8_t *) stbi_load_16_from_memory(bytes, byteSize, &imageWidth, &imageHeight, &imageChannels, requestedImageChannels);
 		if (pixels) {
 			bitsPerPixel = 16;
 		}
@@ -92,25 +435,48 @@ struct kmr_utils_image_buffer kmr_utils_image_buffer_create(struct kmr_utils_ima
 	 * image as we used to do.
 	 */
 	if (!pixels)
-		pixels = (uint8_t *) stbi_load_from_memory(loadedImageFile.bytes, loadedImageFile.byteSize, &imageWidth, &imageHeight, &imageChannels, requestedImageChannels);
+		pixels = (uint8_t *) stbi_load_from_memory(bytes, byteSize, &imageWidth, &imageHeight, &imageChannels, requestedImageChannels);
 
 	if (!pixels) {
-		kmr_utils_log(KMR_DANGER, "[x] stbi_load_from_memory: Unknown image format. STB cannot decode image data for %s", imageFile);
-		goto exit_error_utils_image_buffer_free_loadedImageFileBytes;
+		kmr_utils_log(KMR_DANGER, "[x] stbi_load_from_memory: Unknown image format. STB cannot decode image data for %s", name);
+		return (struct kmr_utils_image_buffer) { .pixels = NULL, .bitsPerPixel = 0, .imageWidth = 0, .imageHeight = 0, .imageChannels = 0, .imageSize = 0, .imageBufferOffset = 0 };
 	}
 
-	free(imageFile);
-	free(loadedImageFile.bytes);
+	imageSize = (size_t) imageWidth * imageHeight * requestedImageChannels * (bitsPerPixel / 8);
+
+	imageData = (struct kmr_utils_image_buffer) { .pixels = pixels, .bitsPerPixel = bitsPerPixel, .imageWidth = imageWidth, .imageHeight = imageHeight,
+	                                              .imageChannels = imageChannels, .imageSize = imageSize, .imageBufferOffset = 0,
+	                                              .vkFormat = VK_FORMAT_UNDEFINED, .mipLevelCount = 1 };
+	imageData.mipLevels[0] = (struct kmr_utils_image_buffer_mip_level) { .offset = 0, .size = imageSize, .width = imageWidth, .height = imageHeight };
+	return imageData;
+}
+
+
+struct kmr_utils_image_buffer kmr_utils_image_buffer_create(struct kmr_utils_image_buffer_create_info *kmsutils)
+{
+	char *imageFile = NULL;
+	struct kmr_utils_file loadedImageFile;
+	struct kmr_utils_image_buffer imageData;
+
+	/*
+	 * Choosing to map image into memory using custom function versus using stbi_load.
+	 * Whole file gets decoded so pre-fault all pages up front.
+	 */
+	imageFile = kmr_utils_concat_file_to_dir(kmsutils->directory, kmsutils->filename, kmsutils->maxStrLen);
+	if (!imageFile)
+		goto exit_error_utils_image_buffer;
+
+	loadedImageFile = kmr_utils_file_map(imageFile, true);
+	if (!loadedImageFile.bytes)
+		goto exit_error_utils_image_buffer_free_imageFile;
 
-	imageSize += (imageWidth * imageHeight) * requestedImageChannels;
+	imageData = image_buffer_decode(loadedImageFile.bytes, loadedImageFile.byteSize, imageFile);
 
-	return (struct kmr_utils_image_buffer) { .pixels = pixels, .bitsPerPixel = bitsPerPixel, .imageWidth = imageWidth, .imageHeight = imageHeight,
-	                                         .imageChannels = imageChannels, .imageSize = imageSize, .imageBufferOffset = 0 };
+	free(imageFile);
+	kmr_utils_file_unmap(&loadedImageFile);
+
+	return imageData;
 
-//exit_error_utils_image_buffer_free_stbdata:
-//	stbi_image_free(pixels);
-exit_error_utils_image_buffer_free_loadedImageFileBytes:
-	free(loadedImageFile.bytes);
 exit_error_utils_image_buffer_free_imageFile:
 	free(imageFile);
 exit_error_utils_image_buffer:
@@ -118,6 +484,419 @@ exit_error_utils_image_buffer:
 }
 
 
+struct kmr_utils_image_buffer kmr_utils_image_buffer_memory_create(struct kmr_utils_image_buffer_memory_create_info *kmsutils)
+{
+	return image_buffer_decode(kmsutils->bytes, kmsutils->byteSize, (kmsutils->name) ? kmsutils->name : "image in memory");
+}
+
+
+/*
+ * Taps of a 2:1 downsample. Destination texel x is centered between
+ * source texels 2x and 2x + 1, tap t reads source texel 2x + @first + t
+ * (clamped to the edge).
+ */
+struct mip_filter_kernel {
+	int32_t  first;
+	uint32_t tapCount;
+	float    weights[6];
+};
+
+
+struct mip_tables {
+	struct mip_filter_kernel box;
+	struct mip_filter_kernel kaiser;
+	float                    srgb8ToLinear[256];
+	/* Linear value halfway between sRGB codes i and i + 1 */
+	float                    srgb8Threshold[255];
+	/* Smallest sRGB code of each 1/4096 linear bucket, at most one code off */
+	uint8_t                  srgb8Encode[4097];
+	float                    srgb16ToLinear[65536];
+};
+
+
+static struct mip_tables mip_tables;
+static pthread_once_t mip_tables_once = PTHREAD_ONCE_INIT;
+
+
+static float srgb_to_linear(float value)
+{
+	return (value <= 0.04045f) ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+}
+
+
+static float linear_to_srgb(float value)
+{
+	return (value <= 0.0031308f) ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+}
+
+
+/* Zeroth order modified Bessel function of the first kind */
+static float bessel_i0(float x)
+{
+	float sum = 1.0f, term = 1.0f;
+	uint32_t k;
+
+	for (k = 1; k < 32; k++) {
+		term *= (x * 0.5f / k) * (x * 0.5f / k);
+		sum += term;
+	}
+
+	return sum;
+}
+
+
+/*
+ * Kaiser (alpha 4) windowed sinc with its cutoff at half the source
+ * Nyquist frequency, 3 source texels of support on each side.
+ */
+static void mip_tables_init(void)
+{
+	const float alpha = 4.0f, radius = 3.0f;
+	float t, x, sum = 0.0f;
+	uint32_t i, code;
+
+	mip_tables.box = (struct mip_filter_kernel) { .first = 0, .tapCount = 2, .weights = { 0.5f, 0.5f } };
+
+	mip_tables.kaiser.first = -2;
+	mip_tables.kaiser.tapCount = 6;
+	for (i = 0; i < mip_tables.kaiser.tapCount; i++) {
+		t = (float) i - 2.5f;
+		x = (float) M_PI * t * 0.5f;
+		mip_tables.kaiser.weights[i] = (sinf(x) / x) * bessel_i0(alpha * sqrtf(1.0f - (t / radius) * (t / radius))) / bessel_i0(alpha);
+		sum += mip_tables.kaiser.weights[i];
+	}
+
+	for (i = 0; i < mip_tables.kaiser.tapCount; i++)
+		mip_tables.kaiser.weights[i] /= sum;
+
+	for (i = 0; i < ARRAY_LEN(mip_tables.srgb8ToLinear); i++)
+		mip_tables.srgb8ToLinear[i] = srgb_to_linear(i / 255.0f);
+
+	for (i = 0; i < ARRAY_LEN(mip_tables.srgb8Threshold); i++)
+		mip_tables.srgb8Threshold[i] = srgb_to_linear((i + 0.5f) / 255.0f);
+
+	for (i = 0; i < ARRAY_LEN(mip_tables.srgb16ToLinear); i++)
+		mip_tables.srgb16ToLinear[i] = srgb_to_linear(i / 65535.0f);
+
+	for (i = 0, code = 0; i < ARRAY_LEN(mip_tables.srgb8Encode); i++) {
+		while (code < ARRAY_LEN(mip_tables.srgb8Threshold) && i / 4096.0f > mip_tables.srgb8Threshold[code])
+			code++;
+		mip_tables.srgb8Encode[i] = code;
+	}
+}
+
+
+static void mip_row_accumulate_scalar(float *acc, const float *src, float weight, uint32_t count)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; i++)
+		acc[i] += src[i] * weight;
+}
+
+
+/* @src and @dst are RGBA float texels */
+static void mip_row_downsample_scalar(float *dst, const float *src, uint32_t srcWidth, uint32_t dstWidth,
+                                      const struct mip_filter_kernel *kernel)
+{
+	uint32_t x, t, c;
+	int32_t sx;
+
+	for (x = 0; x < dstWidth; x++) {
+		for (c = 0; c < 4; c++)
+			dst[x * 4 + c] = 0.0f;
+
+		for (t = 0; t < kernel->tapCount; t++) {
+			sx = (int32_t) (x * 2) + kernel->first + (int32_t) t;
+			sx = (sx < 0) ? 0 : (sx >= (int32_t) srcWidth) ? (int32_t) srcWidth - 1 : sx;
+			for (c = 0; c < 4; c++)
+				dst[x * 4 + c] += src[sx * 4 + c] * kernel->weights[t];
+		}
+	}
+}
+
+
+#ifdef HAVE_X86_SIMD
+
+__attribute__((target("sse2")))
+static void mip_row_accumulate_sse2(float *acc, const float *src, float weight, uint32_t count)
+{
+	uint32_t i = 0;
+	__m128 vweight = _mm_set1_ps(weight);
+
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(_mm_loadu_ps(src + i), vweight)));
+
+	mip_row_accumulate_scalar(acc + i, src + i, weight, count - i);
+}
+
+
+/* One RGBA texel per register */
+__attribute__((target("sse2")))
+static void mip_row_downsample_sse2(float *dst, const float *src, uint32_t srcWidth, uint32_t dstWidth,
+                                    const struct mip_filter_kernel *kernel)
+{
+	uint32_t x, t;
+	int32_t sx;
+	__m128 sum;
+
+	for (x = 0; x < dstWidth; x++) {
+		sum = _mm_setzero_ps();
+		for (t = 0; t < kernel->tapCount; t++) {
+			sx = (int32_t) (x * 2) + kernel->first + (int32_t) t;
+			sx = (sx < 0) ? 0 : (sx >= (int32_t) srcWidth) ? (int32_t) srcWidth - 1 : sx;
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src + (sx * 4)), _mm_set1_ps(kernel->weights[t])));
+		}
+		_mm_storeu_ps(dst + (x * 4), sum);
+	}
+}
+
+
+__attribute__((target("avx")))
+static void mip_row_accumulate_avx(float *acc, const float *src, float weight, uint32_t count)
+{
+	uint32_t i = 0;
+	__m256 vweight = _mm256_set1_ps(weight);
+
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_ps(acc + i, _mm256_add_ps(_mm256_loadu_ps(acc + i), _mm256_mul_ps(_mm256_loadu_ps(src + i), vweight)));
+
+	mip_row_accumulate_scalar(acc + i, src + i, weight, count - i);
+}
+
+#endif /* HAVE_X86_SIMD */
+
+
+struct mip_kernels {
+	void (*row_accumulate)(float *acc, const float *src, float weight, uint32_t count);
+	void (*row_downsample)(float *dst, const float *src, uint32_t srcWidth, uint32_t dstWidth,
+	                       const struct mip_filter_kernel *kernel);
+};
+
+
+static void mip_kernels_get(struct mip_kernels *kernels)
+{
+	kernels->row_accumulate = mip_row_accumulate_scalar;
+	kernels->row_downsample = mip_row_downsample_scalar;
+
+#ifdef HAVE_X86_SIMD
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("sse2")) {
+		kernels->row_accumulate = mip_row_accumulate_sse2;
+		kernels->row_downsample = mip_row_downsample_sse2;
+	}
+
+	if (__builtin_cpu_supports("avx"))
+		kernels->row_accumulate = mip_row_accumulate_avx;
+#endif
+}
+
+
+/* Alpha (every 4th channel) is never sRGB encoded */
+static void mip_row_linearize(float *dst, const uint8_t *src, uint32_t width, bool sixteenBit, bool srgb)
+{
+	const uint16_t *src16 = (const uint16_t *) src;
+	uint32_t i;
+
+	if (sixteenBit && srgb) {
+		for (i = 0; i < width * 4; i += 4) {
+			dst[i + 0] = mip_tables.srgb16ToLinear[src16[i + 0]];
+			dst[i + 1] = mip_tables.srgb16ToLinear[src16[i + 1]];
+			dst[i + 2] = mip_tables.srgb16ToLinear[src16[i + 2]];
+			dst[i + 3] = src16[i + 3] * (1.0f / 65535.0f);
+		}
+	} else if (sixteenBit) {
+		for (i = 0; i < width * 4; i++)
+			dst[i] = src16[i] * (1.0f / 65535.0f);
+	} else if (srgb) {
+		for (i = 0; i < width * 4; i += 4) {
+			dst[i + 0] = mip_tables.srgb8ToLinear[src[i + 0]];
+			dst[i + 1] = mip_tables.srgb8ToLinear[src[i + 1]];
+			dst[i + 2] = mip_tables.srgb8ToLinear[src[i + 2]];
+			dst[i + 3] = src[i + 3] * (1.0f / 255.0f);
+		}
+	} else {
+		for (i = 0; i < width * 4; i++)
+			dst[i] = src[i] * (1.0f / 255.0f);
+	}
+}
+
+
+/*
+ * Rounds to the nearest sRGB code. The sRGB curve is at most 12.92 * 255 / 4096
+ * codes steep per bucket, so one threshold compare corrects the table guess.
+ */
+static uint8_t mip_linear_to_srgb8(float value)
+{
+	uint32_t code = mip_tables.srgb8Encode[(uint32_t) (value * 4096.0f)];
+
+	if (code < ARRAY_LEN(mip_tables.srgb8Threshold) && value > mip_tables.srgb8Threshold[code])
+		code++;
+
+	return (uint8_t) code;
+}
+
+
+/* Kaiser taps have negative lobes so values get clamped */
+static void mip_row_encode(uint8_t *dst, const float *src, uint32_t width, bool sixteenBit, bool srgb)
+{
+	uint16_t *dst16 = (uint16_t *) dst;
+	uint32_t i;
+	float value;
+
+	for (i = 0; i < width * 4; i++) {
+		value = (src[i] < 0.0f) ? 0.0f : (src[i] > 1.0f) ? 1.0f : src[i];
+		if (sixteenBit)
+			dst16[i] = (uint16_t) (((srgb && (i & 3) != 3) ? linear_to_srgb(value) : value) * 65535.0f + 0.5f);
+		else
+			dst[i] = (srgb && (i & 3) != 3) ? mip_linear_to_srgb8(value) : (uint8_t) (value * 255.0f + 0.5f);
+	}
+}
+
+
+#define MIP_ROWS_PER_JOB 16
+
+struct mip_level_build {
+	const uint8_t                  *srcPixels;
+	uint8_t                        *dstPixels;
+	uint32_t                       srcWidth;
+	uint32_t                       srcHeight;
+	uint32_t                       dstWidth;
+	uint32_t                       dstHeight;
+	uint32_t                       texelSize;
+	bool                           srgb;
+	const struct mip_filter_kernel *kernel;
+	const struct mip_kernels       *kernels;
+};
+
+
+/*
+ * Each destination row sums its source rows in linear space (vertical
+ * pass) then filters that row down horizontally. Jobs own a band of
+ * destination rows so they never write to the same memory.
+ */
+static int mip_level_build_job_run(void *userData, uint32_t jobIndex)
+{
+	struct mip_level_build *build = userData;
+	uint32_t y, yEnd, t;
+	int32_t sy;
+	bool sixteenBit = (build->texelSize == 8);
+	float *acc = NULL, *row = NULL;
+
+	acc = malloc((size_t) build->srcWidth * 8 * sizeof(float));
+	if (!acc) {
+		kmr_utils_log(KMR_DANGER, "[x] malloc: %s", strerror(errno));
+		return -1;
+	}
+
+	row = acc + ((size_t) build->srcWidth * 4);
+
+	y = jobIndex * MIP_ROWS_PER_JOB;
+	yEnd = (y + MIP_ROWS_PER_JOB < build->dstHeight) ? y + MIP_ROWS_PER_JOB : build->dstHeight;
+	for (; y < yEnd; y++) {
+		memset(acc, 0, (size_t) build->srcWidth * 4 * sizeof(float));
+
+		for (t = 0; t < build->kernel->tapCount; t++) {
+			sy = (int32_t) (y * 2) + build->kernel->first + (int32_t) t;
+			sy = (sy < 0) ? 0 : (sy >= (int32_t) build->srcHeight) ? (int32_t) build->srcHeight - 1 : sy;
+
+			mip_row_linearize(row, build->srcPixels + ((size_t) sy * build->srcWidth * build->texelSize), build->srcWidth, sixteenBit, build->srgb);
+			build->kernels->row_accumulate(acc, row, build->kernel->weights[t], build->srcWidth * 4);
+		}
+
+		build->kernels->row_downsample(row, acc, build->srcWidth, build->dstWidth, build->kernel);
+		mip_row_encode(build->dstPixels + ((size_t) y * build->dstWidth * build->texelSize), row, build->dstWidth, sixteenBit, build->srgb);
+	}
+
+	free(acc);
+	return 0;
+}
+
+
+int kmr_utils_image_buffer_mip_chain_create(struct kmr_utils_image_buffer_mip_chain_create_info *kmsutils)
+{
+	struct kmr_utils_image_buffer *imageBuffer = kmsutils->imageBuffer;
+	struct kmr_utils_image_buffer_mip_level mipLevels[KMR_UTILS_IMAGE_BUFFER_MIP_LEVEL_MAX];
+	uint32_t level, levelCount = 1, texelSize;
+	size_t imageSize = 0;
+	uint8_t *pixels = NULL;
+
+	struct mip_kernels kernels;
+	struct mip_level_build build;
+	struct kmr_utils_worker_pool_run_info workerPoolRunInfo;
+
+	/* Block compressed and already mipped images are left as is */
+	if (kmsutils->filter == KMR_UTILS_IMAGE_BUFFER_MIP_FILTER_NONE || !imageBuffer->pixels ||
+	    imageBuffer->vkFormat != VK_FORMAT_UNDEFINED || imageBuffer->mipLevelCount > 1 ||
+	    (imageBuffer->bitsPerPixel != 8 && imageBuffer->bitsPerPixel != 16))
+	{
+		return 0;
+	}
+
+	/* stb_image hands out RGBA regardless of @imageChannels */
+	texelSize = 4 * (imageBuffer->bitsPerPixel / 8);
+
+	while (levelCount < KMR_UTILS_IMAGE_BUFFER_MIP_LEVEL_MAX &&
+	       ((imageBuffer->imageWidth >> levelCount) || (imageBuffer->imageHeight >> levelCount)))
+	{
+		levelCount++;
+	}
+
+	for (level = 0; level < levelCount; level++) {
+		mipLevels[level].width = (imageBuffer->imageWidth >> level) ? (imageBuffer->imageWidth >> level) : 1;
+		mipLevels[level].height = (imageBuffer->imageHeight >> level) ? (imageBuffer->imageHeight >> level) : 1;
+		mipLevels[level].offset = imageSize;
+		mipLevels[level].size = (size_t) mipLevels[level].width * mipLevels[level].height * texelSize;
+		imageSize += mipLevels[level].size;
+	}
+
+	if (levelCount == 1)
+		return 0;
+
+	/* Level 0 stays where it is, smaller levels get appended */
+	pixels = realloc(imageBuffer->pixels, imageSize);
+	if (!pixels) {
+		kmr_utils_log(KMR_DANGER, "[x] realloc: %s", strerror(errno));
+		return -1;
+	}
+
+	imageBuffer->pixels = pixels;
+
+	pthread_once(&mip_tables_once, mip_tables_init);
+	mip_kernels_get(&kernels);
+
+	build.texelSize = texelSize;
+	build.srgb = kmsutils->srgb;
+	build.kernel = (kmsutils->filter == KMR_UTILS_IMAGE_BUFFER_MIP_FILTER_KAISER) ? &mip_tables.kaiser : &mip_tables.box;
+	build.kernels = &kernels;
+
+	workerPoolRunInfo.threadCount = kmsutils->threadCount;
+	workerPoolRunInfo.job = mip_level_build_job_run;
+	workerPoolRunInfo.userData = &build;
+
+	/* Each level is filtered from the one above it */
+	for (level = 1; level < levelCount; level++) {
+		build.srcPixels = pixels + mipLevels[level - 1].offset;
+		build.dstPixels = pixels + mipLevels[level].offset;
+		build.srcWidth = mipLevels[level - 1].width;
+		build.srcHeight = mipLevels[level - 1].height;
+		build.dstWidth = mipLevels[level].width;
+		build.dstHeight = mipLevels[level].height;
+
+		workerPoolRunInfo.jobCount = (build.dstHeight + MIP_ROWS_PER_JOB - 1) / MIP_ROWS_PER_JOB;
+		if (kmr_utils_worker_pool_run(&workerPoolRunInfo) == -1)
+			return -1;
+	}
+
+	imageBuffer->imageSize = imageSize;
+	imageBuffer->mipLevelCount = levelCount;
+	memcpy(imageBuffer->mipLevels, mipLevels, levelCount * sizeof(struct kmr_utils_image_buffer_mip_level));
+
+	return 0;
+}
+
+
 struct kmr_utils_file kmr_utils_file_load(const char *filename)
 {
 	FILE *stream = NULL;
@@ -178,6 +957,141 @@ exit_error_utils_file_load:
 }
 
 
+struct kmr_utils_file kmr_utils_file_map(const char *filename, bool populate)
+{
+	int fd = -1;
+	struct stat s = {0};
+	unsigned char *bytes = NULL;
+
+	fd = open(filename, O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {
+		kmr_utils_log(KMR_DANGER, "[x] open(%s): %s", filename, strerror(errno));
+		goto exit_error_utils_file_map;
+	}
+
+	if (fstat(fd, &s) == -1) {
+		kmr_utils_log(KMR_DANGER, "[x] fstat: %s", strerror(errno));
+		goto exit_error_utils_file_map_close;
+	}
+
+	/* mmap(2) fails with EINVAL given a zero length */
+	if (s.st_size == 0) {
+		kmr_utils_log(KMR_DANGER, "[x] kmr_utils_file_map(%s): File is empty", filename);
+		goto exit_error_utils_file_map_close;
+	}
+
+	/*
+	 * MAP_PRIVATE so that the mapping may be handed to libraries that
+	 * assume they own writable memory without ever touching the file.
+	 */
+	bytes = mmap(NULL, s.st_size, PROT_READ | PROT_WRITE,
+	             MAP_PRIVATE | ((populate) ? MAP_POPULATE : 0), fd, 0);
+	if (bytes == MAP_FAILED) {
+		kmr_utils_log(KMR_DANGER, "[x] mmap: %s", strerror(errno));
+		goto exit_error_utils_file_map_close;
+	}
+
+	if (populate && madvise(bytes, s.st_size, MADV_WILLNEED) == -1)
+		kmr_utils_log(KMR_WARNING, "[!] madvise: %s", strerror(errno));
+
+	/* Mapping stays valid after the file descriptor is closed */
+	close(fd);
+
+	return (struct kmr_utils_file) { .bytes = bytes, .byteSize = s.st_size };
+
+exit_error_utils_file_map_close:
+	close(fd);
+exit_error_utils_file_map:
+	return (struct kmr_utils_file) { .bytes = NULL, .byteSize = 0 };
+}
+
+
+void kmr_utils_file_unmap(struct kmr_utils_file *file)
+{
+	if (!file || !file->bytes)
+		return;
+
+	munmap(file->bytes, file->byteSize);
+	file->bytes = NULL;
+	file->byteSize = 0;
+}
+
+
+struct worker_pool {
+	struct kmr_utils_worker_pool_run_info *runInfo;
+	uint32_t                              nextJob;
+	int                                   failed;
+};
+
+
+static void *worker_pool_thread(void *data)
+{
+	uint32_t jobIndex;
+	struct worker_pool *pool = data;
+
+	while (!__atomic_load_n(&pool->failed, __ATOMIC_RELAXED)) {
+		jobIndex = __atomic_fetch_add(&pool->nextJob, 1, __ATOMIC_RELAXED);
+		if (jobIndex >= pool->runInfo->jobCount)
+			break;
+
+		if (pool->runInfo->job(pool->runInfo->userData, jobIndex) == -1)
+			__atomic_store_n(&pool->failed, 1, __ATOMIC_RELAXED);
+	}
+
+	return NULL;
+}
+
+
+int kmr_utils_worker_pool_run(struct kmr_utils_worker_pool_run_info *kmsutils)
+{
+	long cpuCount;
+	uint32_t t, threadCount = kmsutils->threadCount;
+	pthread_t *threads = NULL;
+	struct worker_pool pool;
+
+	if (!kmsutils->jobCount)
+		return 0;
+
+	if (!threadCount) {
+		cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+		threadCount = (cpuCount > 0) ? (uint32_t) cpuCount : 1;
+	}
+
+	if (threadCount > kmsutils->jobCount)
+		threadCount = kmsutils->jobCount;
+
+	pool.runInfo = kmsutils;
+	pool.nextJob = 0;
+	pool.failed = 0;
+
+	/* Calling thread counts as one of the workers */
+	if (threadCount > 1) {
+		threads = calloc(threadCount - 1, sizeof(pthread_t));
+		if (!threads) {
+			kmr_utils_log(KMR_WARNING, "[!] calloc(threads): %s, running jobs serially", strerror(errno));
+			threadCount = 1;
+		}
+	}
+
+	for (t = 0; t < threadCount - 1; t++) {
+		errno = pthread_create(&threads[t], NULL, worker_pool_thread, &pool);
+		if (errno) {
+			kmr_utils_log(KMR_WARNING, "[!] pthread_create: %s, continuing with %u thread(s)", strerror(errno), t + 1);
+			break;
+		}
+	}
+
+	worker_pool_thread(&pool);
+
+	while (t--)
+		pthread_join(threads[t], NULL);
+
+	free(threads);
+
+	return (pool.failed) ? -1 : 0;
+}
+
+
 // https://www.roxlu.com/2014/047/high-resolution-timer-function-in-c-c--
 uint64_t kmr_utils_nanosecond(void)
 {
@@ -0,0 +1,143 @@
+#include <stdlib.h>
+#include <math.h>
+#include "gltf-loader.h"
+#include "gltf-scene-graph.h"
+#include "gltf-animation.h"
+#include "test-utils.h"
+
+/* Nodes of GLTF_ANIMATION_MODEL in the GLTF file "nodes" (json key) array */
+enum animation_node {
+	ANIMATION_NODE_LINEAR                      = 0,
+	ANIMATION_NODE_LINEAR_SAME_HEMISPHERE      = 1,
+	ANIMATION_NODE_LINEAR_WIDE                 = 2,
+	ANIMATION_NODE_LINEAR_WIDE_SAME_HEMISPHERE = 3,
+	ANIMATION_NODE_STEP                        = 4,
+	ANIMATION_NODE_CUBIC                       = 5,
+};
+
+
+static int
+animation_sample (struct kmr_gltf_loader_animation *animation, struct kmr_gltf_loader_scene_graph *sceneGraph,
+                  uint32_t animationIndex, float time)
+{
+	struct kmr_gltf_loader_animation_sample_info sampleInfo;
+
+	sampleInfo.animation = animation;
+	sampleInfo.sceneGraph = sceneGraph;
+	sampleInfo.animationIndex = animationIndex;
+	sampleInfo.time = time;
+	return kmr_gltf_loader_animation_sample(&sampleInfo);
+}
+
+
+int main(void)
+{
+	int ret = 0;
+	uint32_t n, node[6];
+
+	/*
+	 * Rotations interpolate from identity to 90 degrees about Z and 120 degrees
+	 * about Y. Half way there, slerp gives 45 and 60 degrees, whichever hemisphere
+	 * the second key was stored in. Nlerp with a corrected factor is close enough.
+	 */
+	const float rotation45Z[4] = { 0.0f, 0.0f, 0.38268343f, 0.92387953f };
+	const float rotation60Y[4] = { 0.0f, 0.5f, 0.0f, 0.86602540f };
+	const float rotation90ZNegated[4] = { 0.0f, 0.0f, -0.70710678f, -0.70710678f };
+	const float translationHalf[3] = { 1.0f, 2.0f, 3.0f };
+	const float translationFirst[3] = { 0.0f, 0.0f, 0.0f };
+	const float scaleKeys[3][3] = { { 1.0f, 1.0f, 1.0f }, { 2.0f, 2.0f, 2.0f }, { 3.0f, 3.0f, 3.0f } };
+
+	/*
+	 * Hermite spline from value (0,0,0) with out-tangent (3,0,0) to value (4,0,0) with
+	 * in-tangent (0,0,6) over 2 seconds. Tangents are scaled by the key interval:
+	 * u = 0.25: h00 = 0.84375, h10 = 0.140625 * 2, h01 = 0.15625, h11 = -0.046875 * 2
+	 * u = 0.5:  h00 = 0.5,     h10 = 0.125 * 2,    h01 = 0.5,     h11 = -0.125 * 2
+	 */
+	const float cubicQuarter[3] = { 0.28125f * 3.0f + 0.15625f * 4.0f, 0.0f, -0.09375f * 6.0f };
+	const float cubicHalf[3] = { 0.25f * 3.0f + 0.5f * 4.0f, 0.0f, -0.25f * 6.0f };
+	const float cubicLast[3] = { 4.0f, 0.0f, 0.0f };
+
+	struct kmr_gltf_loader_file *gltfLoaderFile = NULL;
+	struct kmr_gltf_loader_scene_graph *gltfLoaderSceneGraph = NULL;
+	struct kmr_gltf_loader_animation *gltfLoaderAnimation = NULL;
+
+	struct kmr_gltf_loader_animation_create_info gltfAnimationInfo;
+
+	if (test_gltf_scene_load(GLTF_ANIMATION_MODEL, &gltfLoaderFile, &gltfLoaderSceneGraph) == -1 ||
+	    gltfLoaderSceneGraph->nodeCount != 6)
+	{
+		ret = 1; goto exit_error_gltf_animation_sampling;
+	}
+
+	for (n = 0; n < 6; n++)
+		node[n] = gltfLoaderSceneGraph->gltfNodeMap[n];
+
+	gltfAnimationInfo.gltfFile = gltfLoaderFile;
+	gltfAnimationInfo.sceneGraph = gltfLoaderSceneGraph;
+	gltfLoaderAnimation = kmr_gltf_loader_animation_create(&gltfAnimationInfo);
+	if (!gltfLoaderAnimation || gltfLoaderAnimation->animationDataCount != 1 ||
+	    gltfLoaderAnimation->channelCount != 7 || gltfLoaderAnimation->animationData[0].duration != 2.0f)
+	{
+		ret = 1; goto exit_error_gltf_animation_sampling;
+	}
+
+	if (animation_sample(gltfLoaderAnimation, gltfLoaderSceneGraph, 0, 0.5f) == -1) { ret = 1; goto exit_error_gltf_animation_sampling; }
+
+	if (!test_vec_near(gltfLoaderSceneGraph->translation[node[ANIMATION_NODE_LINEAR]], translationHalf, 3, 0.00001f) ||
+	    !test_vec_near(gltfLoaderSceneGraph->rotation[node[ANIMATION_NODE_LINEAR]], rotation45Z, 4, 0.001f) ||
+	    !test_vec_near(gltfLoaderSceneGraph->rotation[node[ANIMATION_NODE_LINEAR_SAME_HEMISPHERE]], rotation45Z, 4, 0.001f) ||
+	    !test_vec_near(gltfLoaderSceneGraph->rotation[node[ANIMATION_NODE_LINEAR_WIDE]], rotation60Y, 4, 0.001f) ||
+	    !test_vec_near(gltfLoaderSceneGraph->rotation[node[ANIMATION_NODE_LINEAR_WIDE_SAME_HEMISPHERE]], rotation60Y, 4, 0.001f) ||
+	    !test_vec_near(gltfLoaderSceneGraph->scale[node[ANIMATION_NODE_STEP]], scaleKeys[0], 3, 0.00001f) ||
+	    !test_vec_near(gltfLoaderSceneGraph->translation[node[ANIMATION_NODE_CUBIC]], cubicQuarter, 3, 0.00001f))
+	{
+		ret = 1; goto exit_error_gltf_animation_sampling;
+	}
+
+	/* Sampled TRS must reach the world matrix, first column is the rotated X axis */
+	if (kmr_gltf_loader_scene_graph_update(gltfLoaderSceneGraph) != 6 ||
+	    !test_vec_near(gltfLoaderSceneGraph->worldMatrix[node[ANIMATION_NODE_LINEAR]][3], translationHalf, 3, 0.00001f) ||
+	    fabsf(gltfLoaderSceneGraph->worldMatrix[node[ANIMATION_NODE_LINEAR]][0][0] - 0.70710678f) > 0.001f ||
+	    fabsf(gltfLoaderSceneGraph->worldMatrix[node[ANIMATION_NODE_LINEAR]][0][1] - 0.70710678f) > 0.001f)
+	{
+		ret = 1; goto exit_error_gltf_animation_sampling;
+	}
+
+	if (animation_sample(gltfLoaderAnimation, gltfLoaderSceneGraph, 0, 1.0f) == -1 ||
+	    !test_vec_near(gltfLoaderSceneGraph->translation[node[ANIMATION_NODE_CUBIC]], cubicHalf, 3, 0.00001f))
+	{
+		ret = 1; goto exit_error_gltf_animation_sampling;
+	}
+
+	/* Step holds the previous key until the next one */
+	if (animation_sample(gltfLoaderAnimation, gltfLoaderSceneGraph, 0, 1.5f) == -1 ||
+	    !test_vec_near(gltfLoaderSceneGraph->scale[node[ANIMATION_NODE_STEP]], scaleKeys[1], 3, 0.00001f))
+	{
+		ret = 1; goto exit_error_gltf_animation_sampling;
+	}
+
+	/* Times outside of the keys clamp, seeking backwards must not reuse the cached key */
+	if (animation_sample(gltfLoaderAnimation, gltfLoaderSceneGraph, 0, -1.0f) == -1 ||
+	    !test_vec_near(gltfLoaderSceneGraph->translation[node[ANIMATION_NODE_LINEAR]], translationFirst, 3, 0.00001f) ||
+	    !test_vec_near(gltfLoaderSceneGraph->scale[node[ANIMATION_NODE_STEP]], scaleKeys[0], 3, 0.00001f))
+	{
+		ret = 1; goto exit_error_gltf_animation_sampling;
+	}
+
+	if (animation_sample(gltfLoaderAnimation, gltfLoaderSceneGraph, 0, 10.0f) == -1 ||
+	    !test_vec_near(gltfLoaderSceneGraph->rotation[node[ANIMATION_NODE_LINEAR]], rotation90ZNegated, 4, 0.00001f) ||
+	    !test_vec_near(gltfLoaderSceneGraph->scale[node[ANIMATION_NODE_STEP]], scaleKeys[2], 3, 0.00001f) ||
+	    !test_vec_near(gltfLoaderSceneGraph->translation[node[ANIMATION_NODE_CUBIC]], cubicLast, 3, 0.00001f))
+	{
+		ret = 1; goto exit_error_gltf_animation_sampling;
+	}
+
+	/* Out of range animations are rejected */
+	if (animation_sample(gltfLoaderAnimation, gltfLoaderSceneGraph, 1, 0.0f) != -1) { ret = 1; goto exit_error_gltf_animation_sampling; }
+
+exit_error_gltf_animation_sampling:
+	kmr_gltf_loader_animation_destroy(gltfLoaderAnimation);
+	kmr_gltf_loader_scene_graph_destroy(gltfLoaderSceneGraph);
+	kmr_gltf_loader_file_destroy(gltfLoaderFile);
+	return ret;
+}
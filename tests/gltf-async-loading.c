@@ -0,0 +1,146 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include "gltf-loader.h"
+#include "gltf-scene-graph.h"
+#include "gltf-async.h"
+
+struct async_stage_order {
+	uint32_t stageCount;
+	uint32_t stages[4];
+};
+
+
+static void
+async_stage_record (struct kmr_gltf_loader_async UNUSED *async, enum kmr_gltf_loader_async_stage stage, void *userData)
+{
+	struct async_stage_order *order = userData;
+
+	if (order->stageCount < 4)
+		order->stages[order->stageCount] = stage;
+	order->stageCount++;
+}
+
+
+int main(void)
+{
+	int ret = 0, epollFd = -1;
+	uint32_t asyncStages = 0;
+	uint32_t i, m;
+	struct kmr_gltf_loader_material_data *materialData[2];
+	cgltf_material *material = NULL;
+
+	struct kmr_gltf_loader_file *gltfLoaderFile = NULL;
+	struct kmr_gltf_loader_mesh *gltfLoaderFileMesh = NULL;
+	struct kmr_gltf_loader_scene_graph *gltfLoaderSceneGraph = NULL;
+	struct kmr_gltf_loader_async *gltfLoaderAsync = NULL;
+
+	struct kmr_gltf_loader_file_create_info gltfLoaderFileCreateInfo;
+	struct kmr_gltf_loader_mesh_create_info gltfMeshInfo;
+	struct kmr_gltf_loader_scene_graph_create_info gltfSceneGraphInfo;
+	struct kmr_gltf_loader_async_create_info gltfAsyncInfo;
+	struct async_stage_order asyncStageOrder;
+	struct epoll_event event;
+
+	gltfLoaderFileCreateInfo.fileName = GLTF_MODEL;
+	gltfLoaderFileCreateInfo.flags = KMR_GLTF_LOADER_FILE_CREATE_MMAP;
+	gltfLoaderFile = kmr_gltf_loader_file_create(&gltfLoaderFileCreateInfo);
+	if (!gltfLoaderFile) { ret = 1; goto exit_error_gltf_async_loading; }
+
+	memset(&gltfMeshInfo, 0, sizeof(gltfMeshInfo));
+	gltfMeshInfo.gltfFile = gltfLoaderFile;
+	gltfMeshInfo.flags = KMR_GLTF_LOADER_MESH_CREATE_WELD | KMR_GLTF_LOADER_MESH_CREATE_INDEX_DOWNSIZE;
+	gltfMeshInfo.vertexLayout = KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_INTERLEAVED;
+	gltfLoaderFileMesh = kmr_gltf_loader_mesh_create(&gltfMeshInfo);
+	if (!gltfLoaderFileMesh) { ret = 1; goto exit_error_gltf_async_loading; }
+
+	gltfSceneGraphInfo.gltfFile = gltfLoaderFile;
+	gltfSceneGraphInfo.sceneIndex = 0;
+	gltfLoaderSceneGraph = kmr_gltf_loader_scene_graph_create(&gltfSceneGraphInfo);
+	if (!gltfLoaderSceneGraph) { ret = 1; goto exit_error_gltf_async_loading; }
+
+	asyncStageOrder.stageCount = 0;
+	gltfAsyncInfo.fileName = GLTF_MODEL;
+	gltfAsyncInfo.fileFlags = KMR_GLTF_LOADER_FILE_CREATE_MMAP;
+	gltfAsyncInfo.bufferIndex = 0;
+	gltfAsyncInfo.meshFlags = gltfMeshInfo.flags;
+	gltfAsyncInfo.vertexLayout = gltfMeshInfo.vertexLayout;
+	gltfAsyncInfo.sceneIndex = 0;
+	gltfAsyncInfo.stages = KMR_GLTF_LOADER_ASYNC_STAGE_MATERIAL | KMR_GLTF_LOADER_ASYNC_STAGE_TEXTURE_IMAGE;
+	gltfAsyncInfo.threadCount = 0;
+	gltfAsyncInfo.mipFilter = KMR_UTILS_IMAGE_BUFFER_MIP_FILTER_NONE;
+	gltfAsyncInfo.callback = async_stage_record;
+	gltfAsyncInfo.userData = &asyncStageOrder;
+	gltfLoaderAsync = kmr_gltf_loader_async_create(&gltfAsyncInfo);
+	if (!gltfLoaderAsync) { ret = 1; goto exit_error_gltf_async_loading; }
+
+	epollFd = epoll_create1(0);
+	if (epollFd == -1) { ret = 1; goto exit_error_gltf_async_loading; }
+
+	event.events = EPOLLIN;
+	event.data.fd = gltfLoaderAsync->eventFd;
+	if (epoll_ctl(epollFd, EPOLL_CTL_ADD, gltfLoaderAsync->eventFd, &event) == -1) { ret = 1; goto exit_error_gltf_async_loading; }
+
+	while (!(asyncStages & (KMR_GLTF_LOADER_ASYNC_STAGE_TEXTURE_IMAGE | KMR_GLTF_LOADER_ASYNC_STAGE_FAILED))) {
+		if (epoll_wait(epollFd, &event, 1, -1) == -1) { ret = 1; goto exit_error_gltf_async_loading; }
+		asyncStages |= kmr_gltf_loader_async_poll(gltfLoaderAsync);
+	}
+
+	/* Geometry is handed over first and must match what was loaded synchronously */
+	if (asyncStages & KMR_GLTF_LOADER_ASYNC_STAGE_FAILED || asyncStageOrder.stageCount != 3 ||
+	    asyncStageOrder.stages[0] != KMR_GLTF_LOADER_ASYNC_STAGE_GEOMETRY ||
+	    asyncStageOrder.stages[1] != KMR_GLTF_LOADER_ASYNC_STAGE_MATERIAL ||
+	    asyncStageOrder.stages[2] != KMR_GLTF_LOADER_ASYNC_STAGE_TEXTURE_IMAGE ||
+	    gltfLoaderAsync->geometryTime > gltfLoaderAsync->textureImageTime ||
+	    gltfLoaderAsync->mesh->meshDataCount != gltfLoaderFileMesh->meshDataCount ||
+	    gltfLoaderAsync->sceneGraph->nodeCount != gltfLoaderSceneGraph->nodeCount ||
+	    gltfLoaderAsync->textureImage->imageCount != gltfLoaderFile->gltfData->images_count)
+	{
+		ret = 1; goto exit_error_gltf_async_loading;
+	}
+
+	for (m = 0; m < gltfLoaderFileMesh->meshDataCount; m++) {
+		if (gltfLoaderAsync->mesh->meshData[m].vertexBufferDataCount != gltfLoaderFileMesh->meshData[m].vertexBufferDataCount) {
+			ret = 1; goto exit_error_gltf_async_loading;
+		}
+	}
+
+	/* One material per GLTF material, referenced by index from primitives, equal names interned once */
+	if (gltfLoaderAsync->material->materialDataCount != gltfLoaderFile->gltfData->materials_count) {
+		ret = 1; goto exit_error_gltf_async_loading;
+	}
+
+	for (m = 0; m < gltfLoaderAsync->mesh->meshDataCount; m++) {
+		for (i = 0; i < gltfLoaderAsync->mesh->meshData[m].primitiveCount; i++) {
+			material = gltfLoaderFile->gltfData->meshes[m].primitives[i].material;
+			if (gltfLoaderAsync->mesh->meshData[m].primitives[i].materialIndex !=
+			    ((material) ? cgltf_material_index(gltfLoaderFile->gltfData, material) : UINT32_MAX))
+			{
+				ret = 1; goto exit_error_gltf_async_loading;
+			}
+		}
+	}
+
+	for (m = 0; m < gltfLoaderAsync->material->materialDataCount; m++) {
+		for (i = m + 1; i < gltfLoaderAsync->material->materialDataCount; i++) {
+			materialData[0] = &gltfLoaderAsync->material->materialData[m];
+			materialData[1] = &gltfLoaderAsync->material->materialData[i];
+			if (materialData[0]->materialName && materialData[1]->materialName &&
+			    !strcmp(materialData[0]->materialName, materialData[1]->materialName) &&
+			    materialData[0]->materialName != materialData[1]->materialName)
+			{
+				ret = 1; goto exit_error_gltf_async_loading;
+			}
+		}
+	}
+
+exit_error_gltf_async_loading:
+	if (epollFd != -1)
+		close(epollFd);
+	kmr_gltf_loader_async_destroy(gltfLoaderAsync);
+	kmr_gltf_loader_scene_graph_destroy(gltfLoaderSceneGraph);
+	kmr_gltf_loader_mesh_destroy(gltfLoaderFileMesh);
+	kmr_gltf_loader_file_destroy(gltfLoaderFile);
+	return ret;
+}
@@ -0,0 +1,98 @@
+#include <stdlib.h>
+#include <string.h>
+#include "gltf-loader.h"
+
+/* Buffers of GLTF_BUFFERS_MODEL in the GLTF file "buffers" (json key) array */
+enum buffer_index {
+	BUFFER_POSITION = 0, /* buffers-positions.bin */
+	BUFFER_NORMAL   = 1, /* data URI */
+	BUFFER_INDEX    = 2, /* buffers-indices.bin */
+	BUFFER_TEXCOORD = 3, /* data URI */
+	BUFFER_COUNT    = 4,
+};
+
+
+int main(void)
+{
+	int ret = 0;
+	uint32_t f, v;
+
+	const float positions[4][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 }, { 0, 1, 0 } };
+	const float normals[4][3] = { { 0, 0, 1 }, { 0, 0, 1 }, { 0, 0, 1 }, { 0, 0, 1 } };
+	const uint16_t indices[8] = { 0, 1, 2, 0, 2, 3, 0, 0 };
+	const float texCoords[4][2] = { { 0, 1 }, { 1, 1 }, { 1, 0 }, { 0, 0 } };
+
+	const void *expected[BUFFER_COUNT] = { positions, normals, indices, texCoords };
+	const size_t expectedSize[BUFFER_COUNT] = { sizeof(positions), sizeof(normals), sizeof(indices), sizeof(texCoords) };
+
+	const enum kmr_gltf_loader_file_create_flags flags[2] = { 0, KMR_GLTF_LOADER_FILE_CREATE_MMAP };
+
+	cgltf_buffer *buffer = NULL;
+	struct kmr_gltf_loader_mesh_data *meshData = NULL;
+	struct kmr_gltf_loader_file *gltfLoaderFile = NULL;
+	struct kmr_gltf_loader_mesh *gltfLoaderFileMesh = NULL;
+
+	struct kmr_gltf_loader_file_create_info gltfLoaderFileCreateInfo;
+	struct kmr_gltf_loader_mesh_create_info gltfMeshInfo;
+
+	/* External files and data URIs load on separate workers, read or mapped */
+	for (f = 0; f < 2; f++) {
+		gltfLoaderFileCreateInfo.fileName = GLTF_BUFFERS_MODEL;
+		gltfLoaderFileCreateInfo.flags = flags[f];
+		gltfLoaderFile = kmr_gltf_loader_file_create(&gltfLoaderFileCreateInfo);
+		if (!gltfLoaderFile || gltfLoaderFile->gltfData->buffers_count != BUFFER_COUNT) {
+			ret = 1; goto exit_error_gltf_buffer_loading;
+		}
+
+		for (v = 0; v < BUFFER_COUNT; v++) {
+			buffer = &gltfLoaderFile->gltfData->buffers[v];
+			if (!buffer->data || buffer->size != expectedSize[v] || memcmp(buffer->data, expected[v], expectedSize[v])) {
+				ret = 1; goto exit_error_gltf_buffer_loading;
+			}
+		}
+
+		/* Accessors of one primitive spread out over every buffer */
+		memset(&gltfMeshInfo, 0, sizeof(gltfMeshInfo));
+		gltfMeshInfo.gltfFile = gltfLoaderFile;
+		gltfMeshInfo.threadCount = 1;
+		gltfLoaderFileMesh = kmr_gltf_loader_mesh_create(&gltfMeshInfo);
+		if (!gltfLoaderFileMesh || gltfLoaderFileMesh->meshDataCount != 1 ||
+		    gltfLoaderFileMesh->meshData[0].vertexBufferDataCount != 4 ||
+		    gltfLoaderFileMesh->meshData[0].indexBufferDataCount != 6)
+		{
+			ret = 1; goto exit_error_gltf_buffer_loading;
+		}
+
+		meshData = &gltfLoaderFileMesh->meshData[0];
+		for (v = 0; v < 4; v++) {
+			if (memcmp(meshData->vertexBufferData[v].position, positions[v], sizeof(vec3)) ||
+			    memcmp(meshData->vertexBufferData[v].normal, normals[v], sizeof(vec3)) ||
+			    memcmp(meshData->vertexBufferData[v].texCoord, texCoords[v], sizeof(vec2)))
+			{
+				ret = 1; goto exit_error_gltf_buffer_loading;
+			}
+		}
+
+		for (v = 0; v < 6; v++) {
+			if (meshData->indexBufferData[v] != indices[v]) {
+				ret = 1; goto exit_error_gltf_buffer_loading;
+			}
+		}
+
+		kmr_gltf_loader_mesh_destroy(gltfLoaderFileMesh); gltfLoaderFileMesh = NULL;
+		kmr_gltf_loader_file_destroy(gltfLoaderFile); gltfLoaderFile = NULL;
+	}
+
+	/* A .bin file shorter than its buffer's byteLength fails the whole load */
+	for (f = 0; f < 2; f++) {
+		gltfLoaderFileCreateInfo.fileName = GLTF_BUFFERS_SHORT_MODEL;
+		gltfLoaderFileCreateInfo.flags = flags[f];
+		gltfLoaderFile = kmr_gltf_loader_file_create(&gltfLoaderFileCreateInfo);
+		if (gltfLoaderFile) { ret = 1; goto exit_error_gltf_buffer_loading; }
+	}
+
+exit_error_gltf_buffer_loading:
+	kmr_gltf_loader_mesh_destroy(gltfLoaderFileMesh);
+	kmr_gltf_loader_file_destroy(gltfLoaderFile);
+	return ret;
+}
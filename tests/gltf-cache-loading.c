@@ -0,0 +1,210 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "gltf-loader.h"
+#include "gltf-cache.h"
+
+
+/* Copies @srcFileName to @dstFileName then appends @trailer to the copy */
+static int
+file_copy (const char *srcFileName, const char *dstFileName, const char *trailer)
+{
+	int ret = -1;
+	FILE *stream = NULL;
+	struct kmr_utils_file file;
+
+	file = kmr_utils_file_load(srcFileName);
+	if (!file.bytes)
+		return -1;
+
+	stream = fopen(dstFileName, "wb");
+	if (stream && fwrite(file.bytes, 1, file.byteSize, stream) == file.byteSize && fputs(trailer, stream) != EOF)
+		ret = 0;
+
+	if (stream && fclose(stream) == EOF)
+		ret = -1;
+
+	free(file.bytes);
+	return ret;
+}
+
+
+int main(void)
+{
+	int ret = 0;
+	uint32_t m;
+	char *materialName[2];
+
+	struct kmr_utils_image_buffer *imageData[2];
+	struct kmr_gltf_loader_file *gltfLoaderFile = NULL;
+	struct kmr_gltf_loader_file *gltfLoaderRewriteFile = NULL;
+	struct kmr_gltf_loader_mesh *gltfLoaderFileMesh = NULL;
+	struct kmr_gltf_loader_material *gltfLoaderMaterial = NULL;
+	struct kmr_gltf_loader_node *gltfLoaderFileNode = NULL;
+	struct kmr_gltf_loader_node *gltfLoaderRewriteNode = NULL;
+	struct kmr_gltf_loader_texture_image *gltfLoaderTextureImage = NULL;
+	struct kmr_gltf_loader_cache *gltfLoaderCache = NULL;
+
+	struct kmr_gltf_loader_file_create_info gltfLoaderFileCreateInfo;
+	struct kmr_gltf_loader_mesh_create_info gltfMeshInfo;
+	struct kmr_gltf_loader_material_create_info gltfMaterialInfo;
+	struct kmr_gltf_loader_node_create_info gltfLoaderFileNodeInfo;
+	struct kmr_gltf_loader_texture_image_create_info gltfTextureImagesInfo;
+	struct kmr_gltf_loader_cache_write_info gltfCacheWriteInfo;
+	struct kmr_gltf_loader_cache_create_info gltfCacheInfo;
+
+	gltfLoaderFileCreateInfo.fileName = GLTF_MODEL;
+	gltfLoaderFileCreateInfo.flags = KMR_GLTF_LOADER_FILE_CREATE_MMAP;
+	gltfLoaderFile = kmr_gltf_loader_file_create(&gltfLoaderFileCreateInfo);
+	if (!gltfLoaderFile) { ret = 1; goto exit_error_gltf_cache_loading; }
+
+	memset(&gltfMeshInfo, 0, sizeof(gltfMeshInfo));
+	gltfMeshInfo.gltfFile = gltfLoaderFile;
+	gltfMeshInfo.flags = KMR_GLTF_LOADER_MESH_CREATE_WELD | KMR_GLTF_LOADER_MESH_CREATE_INDEX_DOWNSIZE;
+	gltfMeshInfo.vertexLayout = KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_INTERLEAVED;
+	gltfLoaderFileMesh = kmr_gltf_loader_mesh_create(&gltfMeshInfo);
+	if (!gltfLoaderFileMesh) { ret = 1; goto exit_error_gltf_cache_loading; }
+
+	gltfMaterialInfo.gltfFile = gltfLoaderFile;
+	gltfLoaderMaterial = kmr_gltf_loader_material_create(&gltfMaterialInfo);
+	if (!gltfLoaderMaterial) { ret = 1; goto exit_error_gltf_cache_loading; }
+
+	gltfLoaderFileNodeInfo.gltfFile = gltfLoaderFile;
+	gltfLoaderFileNodeInfo.sceneIndex = 0;
+	gltfLoaderFileNode = kmr_gltf_loader_node_create(&gltfLoaderFileNodeInfo);
+	if (!gltfLoaderFileNode) { ret = 1; goto exit_error_gltf_cache_loading; }
+
+	/* Generated mip chains give every image more than one level to rebase */
+	gltfTextureImagesInfo.gltfFile = gltfLoaderFile;
+	gltfTextureImagesInfo.directory = GLTF_MODEL;
+	gltfTextureImagesInfo.threadCount = 0;
+	gltfTextureImagesInfo.mipFilter = KMR_UTILS_IMAGE_BUFFER_MIP_FILTER_BOX;
+	gltfLoaderTextureImage = kmr_gltf_loader_texture_image_create(&gltfTextureImagesInfo);
+	if (!gltfLoaderTextureImage) { ret = 1; goto exit_error_gltf_cache_loading; }
+
+	gltfCacheWriteInfo.gltfFile = gltfLoaderFile;
+	gltfCacheWriteInfo.sourceFileName = GLTF_MODEL;
+	gltfCacheWriteInfo.cacheFileName = GLTF_CACHE;
+	gltfCacheWriteInfo.mesh = gltfLoaderFileMesh;
+	gltfCacheWriteInfo.material = gltfLoaderMaterial;
+	gltfCacheWriteInfo.node = gltfLoaderFileNode;
+	gltfCacheWriteInfo.textureImage = gltfLoaderTextureImage;
+	if (kmr_gltf_loader_cache_write(&gltfCacheWriteInfo) == -1) { ret = 1; goto exit_error_gltf_cache_loading; }
+
+	gltfCacheInfo.cacheFileName = GLTF_CACHE;
+	gltfCacheInfo.sourceFileName = GLTF_MODEL;
+	gltfLoaderCache = kmr_gltf_loader_cache_create(&gltfCacheInfo);
+	if (!gltfLoaderCache || !gltfLoaderCache->mesh || !gltfLoaderCache->material ||
+	    !gltfLoaderCache->node || !gltfLoaderCache->textureImage)
+	{
+		ret = 1; goto exit_error_gltf_cache_loading;
+	}
+
+	/* Baked data must be identical to what was just processed */
+	if (gltfLoaderCache->mesh->meshDataCount != gltfLoaderFileMesh->meshDataCount ||
+	    gltfLoaderCache->mesh->arenaSize != gltfLoaderFileMesh->arenaSize ||
+	    memcmp(gltfLoaderCache->mesh->arena, gltfLoaderFileMesh->arena, gltfLoaderFileMesh->arenaSize) ||
+	    gltfLoaderCache->node->nodeDataCount != gltfLoaderFileNode->nodeDataCount ||
+	    memcmp(gltfLoaderCache->node->nodeData, gltfLoaderFileNode->nodeData,
+	           gltfLoaderFileNode->nodeDataCount * sizeof(struct kmr_gltf_loader_node_data)))
+	{
+		ret = 1; goto exit_error_gltf_cache_loading;
+	}
+
+	for (m = 0; m < gltfLoaderFileMesh->meshDataCount; m++) {
+		if (gltfLoaderCache->mesh->meshData[m].indexBufferDataCount != gltfLoaderFileMesh->meshData[m].indexBufferDataCount ||
+		    (gltfLoaderFileMesh->meshData[m].indexBufferDataSize &&
+		     memcmp(gltfLoaderCache->mesh->meshData[m].indexBufferData, gltfLoaderFileMesh->meshData[m].indexBufferData,
+		            gltfLoaderFileMesh->meshData[m].indexBufferDataSize)))
+		{
+			ret = 1; goto exit_error_gltf_cache_loading;
+		}
+	}
+
+	/* Material names are rebased into the cache's string pool */
+	if (gltfLoaderCache->material->materialDataCount != gltfLoaderMaterial->materialDataCount) {
+		ret = 1; goto exit_error_gltf_cache_loading;
+	}
+
+	for (m = 0; m < gltfLoaderMaterial->materialDataCount; m++) {
+		materialName[0] = gltfLoaderCache->material->materialData[m].materialName;
+		materialName[1] = gltfLoaderMaterial->materialData[m].materialName;
+		if (!materialName[0] != !materialName[1] || (materialName[0] && strcmp(materialName[0], materialName[1])) ||
+		    memcmp(&gltfLoaderCache->material->materialData[m].pbrMetallicRoughness,
+		           &gltfLoaderMaterial->materialData[m].pbrMetallicRoughness,
+		           sizeof(struct kmr_gltf_loader_cgltf_pbr_metallic_roughness)))
+		{
+			ret = 1; goto exit_error_gltf_cache_loading;
+		}
+	}
+
+	/* Pixels are rebased into the cache's texel section, mip levels stay relative to their image */
+	if (gltfLoaderCache->textureImage->imageCount != gltfLoaderTextureImage->imageCount ||
+	    gltfLoaderCache->textureImage->totalBufferSize != gltfLoaderTextureImage->totalBufferSize)
+	{
+		ret = 1; goto exit_error_gltf_cache_loading;
+	}
+
+	for (m = 0; m < gltfLoaderTextureImage->imageCount; m++) {
+		imageData[0] = &gltfLoaderCache->textureImage->imageData[m];
+		imageData[1] = &gltfLoaderTextureImage->imageData[m];
+		if (imageData[0]->imageWidth != imageData[1]->imageWidth ||
+		    imageData[0]->imageHeight != imageData[1]->imageHeight ||
+		    imageData[0]->imageSize != imageData[1]->imageSize ||
+		    imageData[0]->mipLevelCount != imageData[1]->mipLevelCount ||
+		    memcmp(imageData[0]->mipLevels, imageData[1]->mipLevels, imageData[1]->mipLevelCount * sizeof(imageData[1]->mipLevels[0])) ||
+		    memcmp(imageData[0]->pixels, imageData[1]->pixels, imageData[1]->imageSize))
+		{
+			ret = 1; goto exit_error_gltf_cache_loading;
+		}
+	}
+
+	kmr_gltf_loader_cache_destroy(gltfLoaderCache); gltfLoaderCache = NULL;
+
+	/*
+	 * Bake a copy of a small self contained model, then rewrite the copy. The
+	 * cache must be accepted before and rejected once its source hash changed.
+	 */
+	if (file_copy(GLTF_REWRITE_SOURCE, GLTF_REWRITE_MODEL, "") == -1) { ret = 1; goto exit_error_gltf_cache_loading; }
+
+	gltfLoaderFileCreateInfo.fileName = GLTF_REWRITE_MODEL;
+	gltfLoaderFileCreateInfo.flags = 0;
+	gltfLoaderRewriteFile = kmr_gltf_loader_file_create(&gltfLoaderFileCreateInfo);
+	if (!gltfLoaderRewriteFile) { ret = 1; goto exit_error_gltf_cache_loading; }
+
+	gltfLoaderFileNodeInfo.gltfFile = gltfLoaderRewriteFile;
+	gltfLoaderFileNodeInfo.sceneIndex = 0;
+	gltfLoaderRewriteNode = kmr_gltf_loader_node_create(&gltfLoaderFileNodeInfo);
+	if (!gltfLoaderRewriteNode) { ret = 1; goto exit_error_gltf_cache_loading; }
+
+	memset(&gltfCacheWriteInfo, 0, sizeof(gltfCacheWriteInfo));
+	gltfCacheWriteInfo.gltfFile = gltfLoaderRewriteFile;
+	gltfCacheWriteInfo.sourceFileName = GLTF_REWRITE_MODEL;
+	gltfCacheWriteInfo.cacheFileName = GLTF_REWRITE_CACHE;
+	gltfCacheWriteInfo.node = gltfLoaderRewriteNode;
+	if (kmr_gltf_loader_cache_write(&gltfCacheWriteInfo) == -1) { ret = 1; goto exit_error_gltf_cache_loading; }
+
+	gltfCacheInfo.cacheFileName = GLTF_REWRITE_CACHE;
+	gltfCacheInfo.sourceFileName = GLTF_REWRITE_MODEL;
+	gltfLoaderCache = kmr_gltf_loader_cache_create(&gltfCacheInfo);
+	if (!gltfLoaderCache || !gltfLoaderCache->node || gltfLoaderCache->mesh) { ret = 1; goto exit_error_gltf_cache_loading; }
+
+	kmr_gltf_loader_cache_destroy(gltfLoaderCache); gltfLoaderCache = NULL;
+
+	/* Trailing whitespace keeps the JSON valid but changes the hash */
+	if (file_copy(GLTF_REWRITE_SOURCE, GLTF_REWRITE_MODEL, "\n") == -1) { ret = 1; goto exit_error_gltf_cache_loading; }
+
+	gltfLoaderCache = kmr_gltf_loader_cache_create(&gltfCacheInfo);
+	if (gltfLoaderCache) { ret = 1; goto exit_error_gltf_cache_loading; }
+
+exit_error_gltf_cache_loading:
+	kmr_gltf_loader_cache_destroy(gltfLoaderCache);
+	kmr_gltf_loader_node_destroy(gltfLoaderRewriteNode);
+	kmr_gltf_loader_file_destroy(gltfLoaderRewriteFile);
+	kmr_gltf_loader_texture_image_destroy(gltfLoaderTextureImage);
+	kmr_gltf_loader_node_destroy(gltfLoaderFileNode);
+	kmr_gltf_loader_material_destroy(gltfLoaderMaterial);
+	kmr_gltf_loader_mesh_destroy(gltfLoaderFileMesh);
+	kmr_gltf_loader_file_destroy(gltfLoaderFile);
+	return ret;
+}
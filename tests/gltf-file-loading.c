@@ -1,29 +1,146 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include "gltf-loader.h"
+#include "gltf-scene-graph.h"
+#include "gltf-bvh.h"
+#include "gltf-animation.h"
+#include "gltf-skin.h"
+#include "gltf-mesh-lod.h"
 
 int main(void)
 {
 	int ret = 0;
+	uint32_t m, v, a, l, index, indexCount, meshNodeCount;
+	float acmr, weightSum, distance, *position;
+	void *arena = NULL;
+	uint32_t *drawList = NULL;
 
 	struct kmr_gltf_loader_file *gltfLoaderFile = NULL;
 	struct kmr_gltf_loader_mesh *gltfLoaderFileMesh = NULL;
+	struct kmr_gltf_loader_mesh_lod *gltfLoaderMeshLod = NULL;
 	struct kmr_gltf_loader_node *gltfLoaderFileNode = NULL;
+	struct kmr_gltf_loader_scene_graph *gltfLoaderSceneGraph = NULL;
+	struct kmr_gltf_loader_animation *gltfLoaderAnimation = NULL;
+	struct kmr_gltf_loader_skin *gltfLoaderSkin = NULL;
+	struct kmr_gltf_loader_bvh *gltfLoaderBvh = NULL;
 
 	struct kmr_gltf_loader_file_create_info gltfLoaderFileCreateInfo;
 	struct kmr_gltf_loader_mesh_create_info gltfMeshInfo;
+	struct kmr_gltf_loader_mesh_optimize_info gltfMeshOptimizeInfo;
+	struct kmr_gltf_loader_mesh_lod_create_info gltfMeshLodInfo;
+	struct kmr_gltf_loader_mesh_lod_select_info gltfMeshLodSelectInfo;
 	struct kmr_gltf_loader_node_create_info gltfLoaderFileNodeInfo;
+	struct kmr_gltf_loader_scene_graph_create_info gltfSceneGraphInfo;
+	struct kmr_gltf_loader_animation_create_info gltfAnimationInfo;
+	struct kmr_gltf_loader_animation_sample_info gltfAnimationSampleInfo;
+	struct kmr_gltf_loader_skin_create_info gltfSkinInfo;
+	struct kmr_gltf_loader_scene_graph_cull_info gltfCullInfo;
+	struct kmr_gltf_loader_bvh_create_info gltfBvhInfo;
+	struct kmr_gltf_loader_bvh_cull_info gltfBvhCullInfo;
+	struct kmr_gltf_loader_bvh_pick_info gltfBvhPickInfo;
 
 	gltfLoaderFileCreateInfo.fileName = GLTF_MODEL;
+	gltfLoaderFileCreateInfo.flags = KMR_GLTF_LOADER_FILE_CREATE_MMAP;
 	gltfLoaderFile = kmr_gltf_loader_file_create(&gltfLoaderFileCreateInfo);
 	if (!gltfLoaderFile) { ret = 1; goto exit_error_gltf_file_loading; }
 
 	gltfMeshInfo.gltfFile = gltfLoaderFile;
 	gltfMeshInfo.bufferIndex = 0;
+	gltfMeshInfo.threadCount = 0;
+	gltfMeshInfo.flags = KMR_GLTF_LOADER_MESH_CREATE_WELD | KMR_GLTF_LOADER_MESH_CREATE_INDEX_DOWNSIZE;
+	gltfMeshInfo.vertexLayout = KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_INTERLEAVED;
+	gltfMeshInfo.arenaSize = kmr_gltf_loader_mesh_arena_size_get(&gltfMeshInfo);
+	gltfMeshInfo.arena = arena = malloc(gltfMeshInfo.arenaSize + 1);
+	if (!arena) { ret = 1; goto exit_error_gltf_file_loading; }
+
 	gltfLoaderFileMesh = kmr_gltf_loader_mesh_create(&gltfMeshInfo);
 	if (!gltfLoaderFileMesh) { ret = 1; goto exit_error_gltf_file_loading; }
 
+	/* All vertices and indices must land inside of the caller provided arena */
+	if (gltfLoaderFileMesh->arena != arena || gltfLoaderFileMesh->arenaSize > gltfMeshInfo.arenaSize) { ret = 1; goto exit_error_gltf_file_loading; }
+
+	acmr = 0.0f;
+	for (m = 0; m < gltfLoaderFileMesh->meshDataCount; m++)
+		acmr += kmr_gltf_loader_mesh_acmr_get(&gltfLoaderFileMesh->meshData[m], 0);
+
+	gltfMeshOptimizeInfo.mesh = gltfLoaderFileMesh;
+	gltfMeshOptimizeInfo.cacheSize = 0;
+	gltfMeshOptimizeInfo.threadCount = 0;
+	if (kmr_gltf_loader_mesh_optimize(&gltfMeshOptimizeInfo) == -1) { ret = 1; goto exit_error_gltf_file_loading; }
+
+	for (m = 0; m < gltfLoaderFileMesh->meshDataCount; m++)
+		acmr -= kmr_gltf_loader_mesh_acmr_get(&gltfLoaderFileMesh->meshData[m], 0);
+
+	/* Optimized index buffers should never be worse */
+	if (acmr < -0.001f) { ret = 1; goto exit_error_gltf_file_loading; }
+
+	/* Every vertex must lie inside of its mesh bounding box and sphere */
+	for (m = 0; m < gltfLoaderFileMesh->meshDataCount; m++) {
+		for (v = 0; v < gltfLoaderFileMesh->meshData[m].vertexBufferDataCount; v++) {
+			position = gltfLoaderFileMesh->meshData[m].vertexBufferData[v].position;
+			for (a = 0; a < 3; a++) {
+				if (position[a] < gltfLoaderFileMesh->meshData[m].aabbMin[a] - 0.001f ||
+				    position[a] > gltfLoaderFileMesh->meshData[m].aabbMax[a] + 0.001f)
+				{
+					ret = 1; goto exit_error_gltf_file_loading;
+				}
+			}
+
+			if (glm_vec3_distance(position, gltfLoaderFileMesh->meshData[m].sphereCenter) >
+			    gltfLoaderFileMesh->meshData[m].sphereRadius * 1.001f + 0.001f)
+			{
+				ret = 1; goto exit_error_gltf_file_loading;
+			}
+		}
+	}
+
+	gltfMeshLodInfo.mesh = gltfLoaderFileMesh;
+	gltfMeshLodInfo.levelCount = 3;
+	gltfMeshLodInfo.ratios[0] = 0.5f;
+	gltfMeshLodInfo.ratios[1] = 0.25f;
+	gltfMeshLodInfo.ratios[2] = 0.0f;
+	gltfMeshLodInfo.threadCount = 0;
+	gltfLoaderMeshLod = kmr_gltf_loader_mesh_lod_create(&gltfMeshLodInfo);
+	if (!gltfLoaderMeshLod || gltfLoaderMeshLod->levelCount != 3) { ret = 1; goto exit_error_gltf_file_loading; }
+
+	/* Levels only ever get coarser and reference vertices of their own mesh */
+	for (m = 0; m < gltfLoaderFileMesh->meshDataCount; m++) {
+		indexCount = gltfLoaderFileMesh->meshData[m].indexBufferDataCount;
+		for (l = 0; l < gltfLoaderMeshLod->levelCount; l++) {
+			if (gltfLoaderMeshLod->lodData[m].levels[l].indexCount > indexCount ||
+			    (l && gltfLoaderMeshLod->lodData[m].levels[l].error < gltfLoaderMeshLod->lodData[m].levels[l - 1].error))
+			{
+				ret = 1; goto exit_error_gltf_file_loading;
+			}
+
+			indexCount = gltfLoaderMeshLod->lodData[m].levels[l].indexCount;
+		}
+
+		for (v = 0; v < gltfLoaderMeshLod->lodData[m].indexBufferDataCount; v++) {
+			index = (gltfLoaderMeshLod->lodData[m].indexType == VK_INDEX_TYPE_UINT16) ?
+			        gltfLoaderMeshLod->lodData[m].indexBufferData16[v] : gltfLoaderMeshLod->lodData[m].indexBufferData[v];
+			if (index >= gltfLoaderFileMesh->meshData[m].vertexBufferDataCount) { ret = 1; goto exit_error_gltf_file_loading; }
+		}
+
+		if (gltfLoaderFileMesh->meshData[m].sphereRadius < 0.0f)
+			continue;
+
+		/* Far away meshes get the coarsest level, cameras inside of a mesh the mesh itself */
+		gltfMeshLodSelectInfo.lod = gltfLoaderMeshLod;
+		gltfMeshLodSelectInfo.mesh = gltfLoaderFileMesh;
+		gltfMeshLodSelectInfo.meshIndex = m;
+		gltfMeshLodSelectInfo.projectionScale = 540.0f;
+		gltfMeshLodSelectInfo.pixelError = 1.0f;
+		glm_mat4_identity(gltfMeshLodSelectInfo.modelView);
+		gltfMeshLodSelectInfo.modelView[3][2] = -1e7f;
+		if (kmr_gltf_loader_mesh_lod_select(&gltfMeshLodSelectInfo) != gltfLoaderMeshLod->levelCount) { ret = 1; goto exit_error_gltf_file_loading; }
+
+		glm_vec3_scale(gltfLoaderFileMesh->meshData[m].sphereCenter, -1.0f, gltfMeshLodSelectInfo.modelView[3]);
+		if (kmr_gltf_loader_mesh_lod_select(&gltfMeshLodSelectInfo) != 0) { ret = 1; goto exit_error_gltf_file_loading; }
+	}
+
 	gltfLoaderFileNodeInfo.gltfFile = gltfLoaderFile;
 	gltfLoaderFileNodeInfo.sceneIndex = 0;
 	gltfLoaderFileNode = kmr_gltf_loader_node_create(&gltfLoaderFileNodeInfo);
@@ -31,9 +148,116 @@ int main(void)
 
 	kmr_gltf_loader_node_display_matrix_transform(gltfLoaderFileNode);
 
+	gltfSceneGraphInfo.gltfFile = gltfLoaderFile;
+	gltfSceneGraphInfo.sceneIndex = 0;
+	gltfLoaderSceneGraph = kmr_gltf_loader_scene_graph_create(&gltfSceneGraphInfo);
+	if (!gltfLoaderSceneGraph || gltfLoaderSceneGraph->nodeCount != gltfLoaderFileNode->nodeDataCount) { ret = 1; goto exit_error_gltf_file_loading; }
+
+	/* Moving the first root node must only update its subtree and translate every world matrix in it */
+	gltfLoaderSceneGraph->translation[0][1] += 2.0f;
+	gltfLoaderSceneGraph->dirty[0] = true;
+	if (kmr_gltf_loader_scene_graph_update(gltfLoaderSceneGraph) != gltfLoaderSceneGraph->subtreeSize[0]) { ret = 1; goto exit_error_gltf_file_loading; }
+	if (kmr_gltf_loader_scene_graph_update(gltfLoaderSceneGraph) != 0) { ret = 1; goto exit_error_gltf_file_loading; }
+
+	for (m = 0; m < gltfLoaderSceneGraph->subtreeSize[0]; m++) {
+		if (fabsf(gltfLoaderSceneGraph->worldMatrix[m][3][1] - gltfLoaderFileNode->nodeData[m].matrixTransform[3][1] - 2.0f) > 0.001f) {
+			ret = 1; goto exit_error_gltf_file_loading;
+		}
+	}
+
+	gltfAnimationInfo.gltfFile = gltfLoaderFile;
+	gltfAnimationInfo.sceneGraph = gltfLoaderSceneGraph;
+	gltfLoaderAnimation = kmr_gltf_loader_animation_create(&gltfAnimationInfo);
+	if (!gltfLoaderAnimation || gltfLoaderAnimation->animationDataCount != gltfLoaderFile->gltfData->animations_count) { ret = 1; goto exit_error_gltf_file_loading; }
+
+	for (m = 0; m < gltfLoaderAnimation->animationDataCount; m++) {
+		gltfAnimationSampleInfo.animation = gltfLoaderAnimation;
+		gltfAnimationSampleInfo.sceneGraph = gltfLoaderSceneGraph;
+		gltfAnimationSampleInfo.animationIndex = m;
+		gltfAnimationSampleInfo.time = gltfLoaderAnimation->animationData[m].duration * 0.5f;
+		if (kmr_gltf_loader_animation_sample(&gltfAnimationSampleInfo) == -1) { ret = 1; goto exit_error_gltf_file_loading; }
+		kmr_gltf_loader_scene_graph_update(gltfLoaderSceneGraph);
+	}
+
+	gltfSkinInfo.gltfFile = gltfLoaderFile;
+	gltfSkinInfo.sceneGraph = gltfLoaderSceneGraph;
+	gltfLoaderSkin = kmr_gltf_loader_skin_create(&gltfSkinInfo);
+	if (!gltfLoaderSkin || gltfLoaderSkin->skinDataCount != gltfLoaderFile->gltfData->skins_count) { ret = 1; goto exit_error_gltf_file_loading; }
+
+	kmr_gltf_loader_skin_palette_update(gltfLoaderSkin, gltfLoaderSceneGraph);
+
+	/* Weights of every skinned vertex must be normalized */
+	for (m = 0; m < gltfLoaderSkin->vertexCount; m++) {
+		weightSum = gltfLoaderSkin->vertexWeights[m][0] + gltfLoaderSkin->vertexWeights[m][1] +
+		            gltfLoaderSkin->vertexWeights[m][2] + gltfLoaderSkin->vertexWeights[m][3];
+		if (fabsf(weightSum - 1.0f) > 0.001f) { ret = 1; goto exit_error_gltf_file_loading; }
+	}
+
+	drawList = calloc(gltfLoaderSceneGraph->nodeCount + 1, sizeof(uint32_t));
+	if (!drawList) { ret = 1; goto exit_error_gltf_file_loading; }
+
+	meshNodeCount = 0;
+	for (m = 0; m < gltfLoaderSceneGraph->nodeCount; m++)
+		meshNodeCount += (gltfLoaderSceneGraph->objectType[m] == KMR_GLTF_LOADER_GLTF_MESH &&
+		                  gltfLoaderFileMesh->meshData[gltfLoaderSceneGraph->objectIndex[m]].vertexBufferDataCount);
+
+	for (m = 0; m < gltfLoaderSkin->instanceCount; m++)
+		meshNodeCount += !!gltfLoaderFileMesh->meshData[gltfLoaderSkin->instances[m].meshIndex].vertexBufferDataCount;
+
+	/* Orthographic frustum spanning +/- 500000 units must see every mesh node */
+	gltfCullInfo.mesh = gltfLoaderFileMesh;
+	gltfCullInfo.sceneGraph = gltfLoaderSceneGraph;
+	gltfCullInfo.skin = gltfLoaderSkin;
+	gltfCullInfo.drawList = drawList;
+	glm_mat4_identity(gltfCullInfo.viewProjection);
+	gltfCullInfo.viewProjection[0][0] = gltfCullInfo.viewProjection[1][1] = gltfCullInfo.viewProjection[2][2] = 0.000001f;
+	gltfCullInfo.viewProjection[3][2] = 0.5f;
+	if (kmr_gltf_loader_scene_graph_cull(&gltfCullInfo) != meshNodeCount) { ret = 1; goto exit_error_gltf_file_loading; }
+
+	/* Moving it far to the side must see none */
+	gltfCullInfo.viewProjection[3][0] = 10.0f;
+	if (kmr_gltf_loader_scene_graph_cull(&gltfCullInfo) != 0) { ret = 1; goto exit_error_gltf_file_loading; }
+
+	gltfBvhInfo.mesh = gltfLoaderFileMesh;
+	gltfBvhInfo.sceneGraph = gltfLoaderSceneGraph;
+	gltfBvhInfo.skin = gltfLoaderSkin;
+	gltfLoaderBvh = kmr_gltf_loader_bvh_create(&gltfBvhInfo);
+	if (!gltfLoaderBvh || gltfLoaderBvh->itemCount != meshNodeCount) { ret = 1; goto exit_error_gltf_file_loading; }
+
+	kmr_gltf_loader_bvh_refit(gltfLoaderBvh, &gltfBvhInfo);
+
+	/* Hierarchy must agree with the flat scan on both frustums */
+	gltfBvhCullInfo.bvh = gltfLoaderBvh;
+	gltfBvhCullInfo.drawList = drawList;
+	memcpy(gltfBvhCullInfo.viewProjection, gltfCullInfo.viewProjection, sizeof(mat4));
+	if (kmr_gltf_loader_bvh_cull(&gltfBvhCullInfo) != 0) { ret = 1; goto exit_error_gltf_file_loading; }
+
+	gltfBvhCullInfo.viewProjection[3][0] = 0.0f;
+	if (kmr_gltf_loader_bvh_cull(&gltfBvhCullInfo) != meshNodeCount) { ret = 1; goto exit_error_gltf_file_loading; }
+
+	/* Ray from far away aimed at the center of the first item must hit something */
+	if (gltfLoaderBvh->itemCount) {
+		gltfBvhPickInfo.bvh = gltfLoaderBvh;
+		gltfBvhPickInfo.maxDistance = INFINITY;
+		gltfBvhPickInfo.distance = &distance;
+		for (a = 0; a < 3; a++) {
+			gltfBvhPickInfo.origin[a] = 100000.0f;
+			gltfBvhPickInfo.direction[a] = ((gltfLoaderBvh->itemAabbMin[0][a] + gltfLoaderBvh->itemAabbMax[0][a]) * 0.5f) - 100000.0f;
+		}
+
+		if (kmr_gltf_loader_bvh_pick(&gltfBvhPickInfo) == UINT32_MAX || distance > 1.0f) { ret = 1; goto exit_error_gltf_file_loading; }
+	}
+
 exit_error_gltf_file_loading:
+	kmr_gltf_loader_bvh_destroy(gltfLoaderBvh);
+	kmr_gltf_loader_skin_destroy(gltfLoaderSkin);
+	kmr_gltf_loader_animation_destroy(gltfLoaderAnimation);
+	kmr_gltf_loader_scene_graph_destroy(gltfLoaderSceneGraph);
 	kmr_gltf_loader_node_destroy(gltfLoaderFileNode);
+	kmr_gltf_loader_mesh_lod_destroy(gltfLoaderMeshLod);
 	kmr_gltf_loader_mesh_destroy(gltfLoaderFileMesh);
 	kmr_gltf_loader_file_destroy(gltfLoaderFile);
+	free(drawList);
+	free(arena);
 	return ret;
 }
@@ -0,0 +1,78 @@
+#include <stdlib.h>
+#include <string.h>
+#include "gltf-loader.h"
+
+/* Images of GLTF_IMAGE_MODEL in the GLTF file "images" (json key) array */
+enum image_index {
+	IMAGE_BUFFER_VIEW = 0, /* PNG inside of the GLB binary chunk */
+	IMAGE_DATA_URI    = 1, /* Base64 PNG data URI */
+	IMAGE_COUNT       = 2,
+};
+
+
+int main(void)
+{
+	int ret = 0;
+	uint32_t f;
+
+	/* 2x2 RGBA: red, green, blue, half transparent white */
+	const uint8_t bufferViewPixels[16] = {
+		255, 0, 0, 255, 0, 255, 0, 255,
+		0, 0, 255, 255, 255, 255, 255, 128,
+	};
+
+	/* 1x2 RGB expanded to RGBA */
+	const uint8_t dataUriPixels[8] = { 10, 20, 30, 255, 40, 50, 60, 255 };
+
+	const enum kmr_gltf_loader_file_create_flags flags[2] = { 0, KMR_GLTF_LOADER_FILE_CREATE_MMAP };
+
+	struct kmr_utils_image_buffer *imageData = NULL;
+	struct kmr_gltf_loader_file *gltfLoaderFile = NULL;
+	struct kmr_gltf_loader_texture_image *gltfLoaderTextureImage = NULL;
+
+	struct kmr_gltf_loader_file_create_info gltfLoaderFileCreateInfo;
+	struct kmr_gltf_loader_texture_image_create_info gltfTextureImagesInfo;
+
+	/* Reading and mapping the .glb must decode the same images, no image file is ever opened */
+	for (f = 0; f < 2; f++) {
+		gltfLoaderFileCreateInfo.fileName = GLTF_IMAGE_MODEL;
+		gltfLoaderFileCreateInfo.flags = flags[f];
+		gltfLoaderFile = kmr_gltf_loader_file_create(&gltfLoaderFileCreateInfo);
+		if (!gltfLoaderFile) { ret = 1; goto exit_error_gltf_image_loading; }
+
+		gltfTextureImagesInfo.gltfFile = gltfLoaderFile;
+		gltfTextureImagesInfo.directory = NULL;
+		gltfTextureImagesInfo.threadCount = 0;
+		gltfTextureImagesInfo.mipFilter = KMR_UTILS_IMAGE_BUFFER_MIP_FILTER_NONE;
+		gltfLoaderTextureImage = kmr_gltf_loader_texture_image_create(&gltfTextureImagesInfo);
+		if (!gltfLoaderTextureImage || gltfLoaderTextureImage->imageCount != IMAGE_COUNT) {
+			ret = 1; goto exit_error_gltf_image_loading;
+		}
+
+		imageData = &gltfLoaderTextureImage->imageData[IMAGE_BUFFER_VIEW];
+		if (imageData->imageWidth != 2 || imageData->imageHeight != 2 || imageData->bitsPerPixel != 8 ||
+		    imageData->imageSize != sizeof(bufferViewPixels) || imageData->mipLevelCount != 1 ||
+		    imageData->imageBufferOffset != 0 || memcmp(imageData->pixels, bufferViewPixels, sizeof(bufferViewPixels)))
+		{
+			ret = 1; goto exit_error_gltf_image_loading;
+		}
+
+		/* Offsets into the shared staging buffer are 16 byte aligned */
+		imageData = &gltfLoaderTextureImage->imageData[IMAGE_DATA_URI];
+		if (imageData->imageWidth != 1 || imageData->imageHeight != 2 || imageData->bitsPerPixel != 8 ||
+		    imageData->imageSize != sizeof(dataUriPixels) || imageData->imageBufferOffset != 16 ||
+		    memcmp(imageData->pixels, dataUriPixels, sizeof(dataUriPixels)) ||
+		    gltfLoaderTextureImage->totalBufferSize != 16 + sizeof(dataUriPixels))
+		{
+			ret = 1; goto exit_error_gltf_image_loading;
+		}
+
+		kmr_gltf_loader_texture_image_destroy(gltfLoaderTextureImage); gltfLoaderTextureImage = NULL;
+		kmr_gltf_loader_file_destroy(gltfLoaderFile); gltfLoaderFile = NULL;
+	}
+
+exit_error_gltf_image_loading:
+	kmr_gltf_loader_texture_image_destroy(gltfLoaderTextureImage);
+	kmr_gltf_loader_file_destroy(gltfLoaderFile);
+	return ret;
+}
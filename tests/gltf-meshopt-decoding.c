@@ -0,0 +1,149 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include "gltf-loader.h"
+
+/* Buffer views of GLTF_MESHOPT_MODEL in the GLTF file "bufferViews" (json key) array */
+enum meshopt_view {
+	MESHOPT_VIEW_POSITION    = 0, /* ATTRIBUTES, snorm16 positions (KHR_mesh_quantization) */
+	MESHOPT_VIEW_NORMAL      = 1, /* ATTRIBUTES + OCTAHEDRAL, snorm8 normals */
+	MESHOPT_VIEW_TRIANGLES   = 2, /* TRIANGLES, 16 bit indices */
+	MESHOPT_VIEW_SEQUENCE    = 3, /* INDICES, 32 bit indices */
+	MESHOPT_VIEW_QUATERNION  = 4, /* ATTRIBUTES + QUATERNION */
+	MESHOPT_VIEW_EXPONENTIAL = 5, /* ATTRIBUTES + EXPONENTIAL, float texture coordinates */
+	MESHOPT_VIEW_COUNT       = 6,
+};
+
+
+int main(void)
+{
+	int ret = 0;
+	uint32_t v, c;
+
+	/* Cube corners at +-0.5, fourth component is padding */
+	const int16_t positions[8][4] = {
+		{ -16384, -16384, -16384, 0 }, { 16384, -16384, -16384, 0 }, { 16384, 16384, -16384, 0 }, { -16384, 16384, -16384, 0 },
+		{ -16384, -16384, 16384, 0 }, { 16384, -16384, 16384, 0 }, { 16384, 16384, 16384, 0 }, { -16384, 16384, 16384, 0 },
+	};
+
+	/*
+	 * Stored as octahedral (x, y, 127). z = 127 - |x| - |y| and when negative x and y
+	 * are folded by z, then the vector is rescaled to 127. (64,0) gives (64,0,63) and
+	 * (100,-50) gives (77,-27,-23) before scaling.
+	 */
+	const int8_t normals[8][4] = {
+		{ 127, 0, 0, 0 }, { 0, 127, 0, 0 }, { 0, 0, 127, 0 }, { 91, 0, 89, 0 },
+		{ -104, 52, 50, 0 }, { 115, -40, -34, 0 }, { -106, -59, -37, 0 }, { 13, 26, 124, 0 },
+	};
+
+	const uint16_t triangles[36] = {
+		0, 2, 1, 0, 3, 2, 4, 5, 6, 4, 6, 7, 0, 1, 5, 0, 5, 4,
+		1, 2, 6, 1, 6, 5, 2, 3, 7, 2, 7, 6, 3, 0, 4, 3, 4, 7,
+	};
+
+	const uint32_t sequence[6] = { 7, 3, 1, 0, 6, 2 };
+
+	/*
+	 * Identity stored with w as the dropped (largest) component and (.5,.5,.5,.5) stored
+	 * with x dropped: 23170 * (sqrt(.5) / 32767) * 32767 rounds to 16384, the rebuilt
+	 * component sqrt(1 - 3 * .5^2) is truncated to 16383.
+	 */
+	const int16_t quaternions[2][4] = { { 0, 0, 0, 32767 }, { 16383, 16384, 16384, 16384 } };
+
+	/* 24 bit mantissa * 2^(8 bit exponent) */
+	const float texCoords[8][2] = {
+		{ 0.25f, 0.5f }, { -0.5f, 3.0f }, { 0.5f, 0.0f }, { 0.75f, 1.25f },
+		{ -1.0f, 0.875f }, { 0.75f, 0.498046875f }, { 4.0f, -1.5f }, { 0.0625f, 0.5f },
+	};
+
+	const void *expected[MESHOPT_VIEW_COUNT] = { positions, normals, triangles, sequence, quaternions, texCoords };
+	const size_t expectedSize[MESHOPT_VIEW_COUNT] = {
+		sizeof(positions), sizeof(normals), sizeof(triangles), sizeof(sequence), sizeof(quaternions), sizeof(texCoords)
+	};
+
+	cgltf_buffer_view *view = NULL;
+	struct kmr_gltf_loader_file *gltfLoaderFile = NULL;
+	struct kmr_gltf_loader_mesh *gltfLoaderFileMesh = NULL;
+	struct kmr_gltf_loader_mesh *gltfLoaderFileMeshPacked = NULL;
+	struct kmr_gltf_loader_mesh_data *meshData = NULL;
+
+	struct kmr_gltf_loader_file_create_info gltfLoaderFileCreateInfo;
+	struct kmr_gltf_loader_mesh_create_info gltfMeshInfo;
+
+	gltfLoaderFileCreateInfo.fileName = GLTF_MESHOPT_MODEL;
+	gltfLoaderFileCreateInfo.flags = 0;
+	gltfLoaderFile = kmr_gltf_loader_file_create(&gltfLoaderFileCreateInfo);
+	if (!gltfLoaderFile || gltfLoaderFile->gltfData->buffer_views_count != MESHOPT_VIEW_COUNT) {
+		ret = 1; goto exit_error_gltf_meshopt_decoding;
+	}
+
+	/* Every compressed view is decoded while loading, filters included */
+	for (v = 0; v < MESHOPT_VIEW_COUNT; v++) {
+		view = &gltfLoaderFile->gltfData->buffer_views[v];
+		if (!view->data || view->size != expectedSize[v] || memcmp(view->data, expected[v], expectedSize[v])) {
+			ret = 1; goto exit_error_gltf_meshopt_decoding;
+		}
+	}
+
+	memset(&gltfMeshInfo, 0, sizeof(gltfMeshInfo));
+	gltfMeshInfo.gltfFile = gltfLoaderFile;
+	gltfMeshInfo.threadCount = 1;
+	gltfLoaderFileMesh = kmr_gltf_loader_mesh_create(&gltfMeshInfo);
+	if (!gltfLoaderFileMesh || gltfLoaderFileMesh->meshData[0].vertexBufferDataCount != 16 ||
+	    gltfLoaderFileMesh->meshData[0].indexBufferDataCount != 42)
+	{
+		ret = 1; goto exit_error_gltf_meshopt_decoding;
+	}
+
+	/* Accessors read the decoded views like any other. Each primitive appends its own 8 vertices */
+	meshData = &gltfLoaderFileMesh->meshData[0];
+	for (v = 0; v < 8; v++) {
+		for (c = 0; c < 3; c++) {
+			if (fabsf(meshData->vertexBufferData[v].position[c] - (positions[v][c] / 32767.0f)) > 0.00001f ||
+			    fabsf(meshData->vertexBufferData[v + 8].position[c] - (positions[v][c] / 32767.0f)) > 0.00001f)
+			{
+				ret = 1; goto exit_error_gltf_meshopt_decoding;
+			}
+		}
+
+		if (meshData->vertexBufferData[v].texCoord[0] != texCoords[v][0] ||
+		    meshData->vertexBufferData[v].texCoord[1] != texCoords[v][1])
+		{
+			ret = 1; goto exit_error_gltf_meshopt_decoding;
+		}
+	}
+
+	/* Second primitive's indices are rebased past the first primitive's vertices */
+	for (v = 0; v < 6; v++) {
+		if (meshData->indexBufferData[36 + v] != sequence[v] + 8) {
+			ret = 1; goto exit_error_gltf_meshopt_decoding;
+		}
+	}
+
+	/* Snorm16 positions are passed through to the packed layout as is, no re-quantization */
+	gltfMeshInfo.vertexLayout = KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_PACKED;
+	gltfLoaderFileMeshPacked = kmr_gltf_loader_mesh_create(&gltfMeshInfo);
+	if (!gltfLoaderFileMeshPacked) { ret = 1; goto exit_error_gltf_meshopt_decoding; }
+
+	meshData = &gltfLoaderFileMeshPacked->meshData[0];
+	for (c = 0; c < 3; c++) {
+		if (meshData->positionScale[c] != 1.0f || meshData->positionOffset[c] != 0.0f) {
+			ret = 1; goto exit_error_gltf_meshopt_decoding;
+		}
+	}
+
+	for (v = 0; v < meshData->vertexBufferDataCount; v++) {
+		for (c = 0; c < 3; c++) {
+			if (meshData->vertexBufferDataPacked[v].position[c] != positions[v % 8][c]) {
+				ret = 1; goto exit_error_gltf_meshopt_decoding;
+			}
+		}
+	}
+
+exit_error_gltf_meshopt_decoding:
+	kmr_gltf_loader_mesh_destroy(gltfLoaderFileMeshPacked);
+	kmr_gltf_loader_mesh_destroy(gltfLoaderFileMesh);
+	kmr_gltf_loader_file_destroy(gltfLoaderFile);
+	return ret;
+}
@@ -0,0 +1,60 @@
+#include <stdlib.h>
+#include <string.h>
+#include "gltf-loader.h"
+
+
+int main(void)
+{
+	int ret = 0;
+	uint32_t i, l;
+
+	struct kmr_utils_image_buffer *imageData = NULL;
+	struct kmr_gltf_loader_file *gltfLoaderFile = NULL;
+	struct kmr_gltf_loader_texture_image *gltfLoaderTextureImage = NULL;
+
+	struct kmr_gltf_loader_file_create_info gltfLoaderFileCreateInfo;
+	struct kmr_gltf_loader_texture_image_create_info gltfTextureImagesInfo;
+
+	gltfLoaderFileCreateInfo.fileName = GLTF_MODEL;
+	gltfLoaderFileCreateInfo.flags = KMR_GLTF_LOADER_FILE_CREATE_MMAP;
+	gltfLoaderFile = kmr_gltf_loader_file_create(&gltfLoaderFileCreateInfo);
+	if (!gltfLoaderFile) { ret = 1; goto exit_error_gltf_mip_generation; }
+
+	gltfTextureImagesInfo.gltfFile = gltfLoaderFile;
+	gltfTextureImagesInfo.directory = GLTF_MODEL;
+	gltfTextureImagesInfo.threadCount = 0;
+	gltfTextureImagesInfo.mipFilter = KMR_UTILS_IMAGE_BUFFER_MIP_FILTER_KAISER;
+	gltfLoaderTextureImage = kmr_gltf_loader_texture_image_create(&gltfTextureImagesInfo);
+	if (!gltfLoaderTextureImage || gltfLoaderTextureImage->imageCount != gltfLoaderFile->gltfData->images_count) {
+		ret = 1; goto exit_error_gltf_mip_generation;
+	}
+
+	/* Every mip level must be inside its image and images block aligned in the shared buffer */
+	for (i = 0; i < gltfLoaderTextureImage->imageCount; i++) {
+		imageData = &gltfLoaderTextureImage->imageData[i];
+		if (!imageData->mipLevelCount || imageData->imageBufferOffset % 16 ||
+		    imageData->imageBufferOffset + imageData->imageSize > gltfLoaderTextureImage->totalBufferSize)
+		{
+			ret = 1; goto exit_error_gltf_mip_generation;
+		}
+
+		for (l = 0; l < imageData->mipLevelCount; l++) {
+			if (imageData->mipLevels[l].offset + imageData->mipLevels[l].size > imageData->imageSize) {
+				ret = 1; goto exit_error_gltf_mip_generation;
+			}
+		}
+
+		/* Decoded images get a generated chain down to 1x1 */
+		if (imageData->vkFormat == VK_FORMAT_UNDEFINED && imageData->mipLevelCount < KMR_UTILS_IMAGE_BUFFER_MIP_LEVEL_MAX &&
+		    (imageData->mipLevels[imageData->mipLevelCount - 1].width != 1 ||
+		     imageData->mipLevels[imageData->mipLevelCount - 1].height != 1))
+		{
+			ret = 1; goto exit_error_gltf_mip_generation;
+		}
+	}
+
+exit_error_gltf_mip_generation:
+	kmr_gltf_loader_texture_image_destroy(gltfLoaderTextureImage);
+	kmr_gltf_loader_file_destroy(gltfLoaderFile);
+	return ret;
+}
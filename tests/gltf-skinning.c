@@ -0,0 +1,168 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "gltf-loader.h"
+#include "gltf-scene-graph.h"
+#include "gltf-skin.h"
+#include "test-utils.h"
+
+/* Nodes of GLTF_SKIN_MODEL in the GLTF file "nodes" (json key) array */
+enum skin_node {
+	SKIN_NODE_SKINNED     = 0,
+	SKIN_NODE_ROOT_JOINT  = 1,
+	SKIN_NODE_CHILD_JOINT = 2,
+};
+
+
+/* Position and normal of vertex @v of the first mesh inside of memory laid out like the mesh arena */
+static void
+skin_vertex_get (struct kmr_gltf_loader_mesh *mesh, void *arena, uint32_t v, float **position, float **normal)
+{
+	struct kmr_gltf_loader_mesh_data *meshData = &mesh->meshData[0];
+	uint8_t *positions, *normals;
+
+	if (mesh->vertexLayout == KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_SOA) {
+		positions = (uint8_t *) (meshData->vertexStreams.position + v);
+		normals = (uint8_t *) (meshData->vertexStreams.normal + v);
+	} else {
+		positions = (uint8_t *) meshData->vertexBufferData[v].position;
+		normals = (uint8_t *) meshData->vertexBufferData[v].normal;
+	}
+
+	*position = (float *) ((uint8_t *) arena + (positions - (uint8_t *) mesh->arena));
+	*normal = (float *) ((uint8_t *) arena + (normals - (uint8_t *) mesh->arena));
+}
+
+
+int main(void)
+{
+	int ret = 0;
+	uint32_t i, v, layout;
+	float *position = NULL, *normal = NULL;
+	void *dst = NULL;
+
+	/*
+	 * The root joint is moved from (0,1,0) to (1,1,0) and the child joint, bound rotated 90 degrees
+	 * about Z at (0,3,0), is unrotated. Joint matrices are world * inverse bind:
+	 * joint 0: T(1,1,0) * T(0,-1,0) = T(1,0,0)
+	 * joint 1: T(1,3,0) * (R(-90 Z) with translation (-3,0,0)) = R(-90 Z) with translation (-2,3,0)
+	 */
+	const float identity[16] = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+	const float rotationIdentity[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	const mat4 palette[2] = {
+		{ { 1.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f, 1.0f } },
+		{ { 0.0f, -1.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f, 0.0f }, { -2.0f, 3.0f, 0.0f, 1.0f } },
+	};
+
+	/*
+	 * Joint 0 maps p to (x + 1, y, z), joint 1 to (y - 2, 3 - x, z). Vertices:
+	 * 0: (0,0,0) joint 0                  -> (1,0,0),   normal (1,0,0) -> (1,0,0)
+	 * 1: (0,3,0) joint 1                  -> (1,3,0),   normal (1,0,0) -> (0,-1,0)
+	 * 2: (1,3,0) 0.5 joint 0, 0.5 joint 1 -> (1.5,2.5,0), normal (0,0,1) -> (0,0,1)
+	 * 3: (1,0,0) 0.25 joint 0, 0.75 joint 1 -> 0.25 * (2,0,0) + 0.75 * (-2,2,0) = (-1,1.5,0),
+	 *    normal (1,0,0) -> (0.25,-0.75,0) renormalized
+	 */
+	const float positions[4][3] = { { 1.0f, 0.0f, 0.0f }, { 1.0f, 3.0f, 0.0f }, { 1.5f, 2.5f, 0.0f }, { -1.0f, 1.5f, 0.0f } };
+	const float normals[4][3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.31622777f, -0.94868330f, 0.0f } };
+
+	const enum kmr_gltf_loader_mesh_vertex_layout layouts[2] = {
+		KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_INTERLEAVED, KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_SOA
+	};
+
+	struct kmr_gltf_loader_file *gltfLoaderFile = NULL;
+	struct kmr_gltf_loader_mesh *gltfLoaderFileMesh = NULL;
+	struct kmr_gltf_loader_scene_graph *gltfLoaderSceneGraph = NULL;
+	struct kmr_gltf_loader_skin *gltfLoaderSkin = NULL;
+
+	struct kmr_gltf_loader_mesh_create_info gltfMeshInfo;
+	struct kmr_gltf_loader_mesh_optimize_info gltfMeshOptimizeInfo;
+	struct kmr_gltf_loader_skin_create_info gltfSkinInfo;
+	struct kmr_gltf_loader_skin_apply_info gltfSkinApplyInfo;
+
+	if (test_gltf_scene_load(GLTF_SKIN_MODEL, &gltfLoaderFile, &gltfLoaderSceneGraph) == -1) { ret = 1; goto exit_error_gltf_skinning; }
+
+	gltfSkinInfo.gltfFile = gltfLoaderFile;
+	gltfSkinInfo.sceneGraph = gltfLoaderSceneGraph;
+	gltfLoaderSkin = kmr_gltf_loader_skin_create(&gltfSkinInfo);
+	if (!gltfLoaderSkin || gltfLoaderSkin->skinDataCount != 1 || gltfLoaderSkin->jointCount != 2 ||
+	    gltfLoaderSkin->instanceCount != 1 || gltfLoaderSkin->vertexCount != 4 ||
+	    gltfLoaderSkin->instances[0].node != gltfLoaderSceneGraph->gltfNodeMap[SKIN_NODE_SKINNED] ||
+	    gltfLoaderSkin->instances[0].meshIndex != 0)
+	{
+		ret = 1; goto exit_error_gltf_skinning;
+	}
+
+	/* In the bind pose every joint matrix is the identity */
+	for (i = 0; i < gltfLoaderSkin->jointCount; i++) {
+		if (!test_vec_near((const float *) gltfLoaderSkin->palette[i], identity, 16, 0.00001f)) {
+			ret = 1; goto exit_error_gltf_skinning;
+		}
+	}
+
+	gltfLoaderSceneGraph->translation[gltfLoaderSceneGraph->gltfNodeMap[SKIN_NODE_ROOT_JOINT]][0] = 1.0f;
+	gltfLoaderSceneGraph->dirty[gltfLoaderSceneGraph->gltfNodeMap[SKIN_NODE_ROOT_JOINT]] = true;
+	memcpy(gltfLoaderSceneGraph->rotation[gltfLoaderSceneGraph->gltfNodeMap[SKIN_NODE_CHILD_JOINT]], rotationIdentity, sizeof(rotationIdentity));
+	gltfLoaderSceneGraph->dirty[gltfLoaderSceneGraph->gltfNodeMap[SKIN_NODE_CHILD_JOINT]] = true;
+	kmr_gltf_loader_scene_graph_update(gltfLoaderSceneGraph);
+	kmr_gltf_loader_skin_palette_update(gltfLoaderSkin, gltfLoaderSceneGraph);
+
+	for (i = 0; i < gltfLoaderSkin->jointCount; i++) {
+		if (!test_vec_near((const float *) gltfLoaderSkin->palette[i], (const float *) palette[i], 16, 0.00001f)) {
+			ret = 1; goto exit_error_gltf_skinning;
+		}
+	}
+
+	for (layout = 0; layout < 2; layout++) {
+		gltfMeshInfo.gltfFile = gltfLoaderFile;
+		gltfMeshInfo.bufferIndex = 0;
+		gltfMeshInfo.threadCount = layout;
+		gltfMeshInfo.flags = 0;
+		gltfMeshInfo.vertexLayout = layouts[layout];
+		gltfMeshInfo.arena = NULL;
+		gltfMeshInfo.arenaSize = 0;
+		gltfLoaderFileMesh = kmr_gltf_loader_mesh_create(&gltfMeshInfo);
+		if (!gltfLoaderFileMesh) { ret = 1; goto exit_error_gltf_skinning; }
+
+		dst = calloc(1, gltfLoaderFileMesh->arenaSize);
+		if (!dst) { ret = 1; goto exit_error_gltf_skinning; }
+		memcpy(dst, gltfLoaderFileMesh->arena, gltfLoaderFileMesh->arenaSize);
+
+		gltfSkinApplyInfo.skin = gltfLoaderSkin;
+		gltfSkinApplyInfo.mesh = gltfLoaderFileMesh;
+		gltfSkinApplyInfo.dst = dst;
+		gltfSkinApplyInfo.threadCount = layout;
+		if (kmr_gltf_loader_skin_apply(&gltfSkinApplyInfo) == -1) { ret = 1; goto exit_error_gltf_skinning; }
+
+		for (v = 0; v < 4; v++) {
+			skin_vertex_get(gltfLoaderFileMesh, dst, v, &position, &normal);
+			if (!test_vec_near(position, positions[v], 3, 0.00001f) || !test_vec_near(normal, normals[v], 3, 0.00001f)) {
+				ret = 1; goto exit_error_gltf_skinning;
+			}
+		}
+
+		/* Bind pose vertices in the arena are left untouched */
+		skin_vertex_get(gltfLoaderFileMesh, gltfLoaderFileMesh->arena, 1, &position, &normal);
+		if (position[1] != 3.0f || normal[0] != 1.0f) { ret = 1; goto exit_error_gltf_skinning; }
+
+		/* Optimizing reorders vertices away from the skin's joints and weights, skinning must refuse it */
+		gltfMeshOptimizeInfo.mesh = gltfLoaderFileMesh;
+		gltfMeshOptimizeInfo.cacheSize = 0;
+		gltfMeshOptimizeInfo.threadCount = 1;
+		if (kmr_gltf_loader_mesh_optimize(&gltfMeshOptimizeInfo) == -1 || !gltfLoaderFileMesh->optimized ||
+		    kmr_gltf_loader_skin_apply(&gltfSkinApplyInfo) != -1)
+		{
+			ret = 1; goto exit_error_gltf_skinning;
+		}
+
+		kmr_gltf_loader_mesh_destroy(gltfLoaderFileMesh); gltfLoaderFileMesh = NULL;
+		free(dst); dst = NULL;
+	}
+
+exit_error_gltf_skinning:
+	kmr_gltf_loader_skin_destroy(gltfLoaderSkin);
+	kmr_gltf_loader_scene_graph_destroy(gltfLoaderSceneGraph);
+	kmr_gltf_loader_mesh_destroy(gltfLoaderFileMesh);
+	kmr_gltf_loader_file_destroy(gltfLoaderFile);
+	free(dst);
+	return ret;
+}
@@ -0,0 +1,105 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <vulkan/vulkan.h>
+#include "utils.h"
+
+
+static struct kmr_utils_image_buffer
+image_load (const char *filename)
+{
+	struct kmr_utils_image_buffer_create_info imageDataCreateInfo;
+
+	imageDataCreateInfo.directory = TEXTURE_DIR;
+	imageDataCreateInfo.filename = filename;
+	imageDataCreateInfo.maxStrLen = (1<<10);
+	return kmr_utils_image_buffer_create(&imageDataCreateInfo);
+}
+
+
+/* Fixture payloads count up from a different base value in every mip level */
+static bool
+image_level_check (struct kmr_utils_image_buffer *imageData, uint32_t level, size_t offset, size_t size,
+                   uint32_t width, uint32_t height, uint8_t base)
+{
+	size_t i;
+
+	if (imageData->mipLevels[level].offset != offset || imageData->mipLevels[level].size != size ||
+	    imageData->mipLevels[level].width != width || imageData->mipLevels[level].height != height)
+		return false;
+
+	for (i = 0; i < size; i++)
+		if (imageData->pixels[offset + i] != (uint8_t) (base + i))
+			return false;
+
+	return true;
+}
+
+
+int main(void)
+{
+	int ret = 0;
+	uint32_t i;
+
+	struct kmr_utils_image_buffer imageData;
+
+	/* Each is rejected with pixels set to NULL */
+	const char *rejected[] = {
+		"texture-truncated.ktx2",      /* Largest level cut short */
+		"texture-unknown-format.ktx2", /* VK_FORMAT_R16G16B16A16_SFLOAT has no block layout */
+		"texture-level-size.ktx2",     /* Level 0 byteLength isn't 4 BC1 blocks */
+		"texture-truncated.dds",
+		"texture-unknown-format.dds",  /* FourCC isn't a DXGI/legacy block format */
+	};
+
+	memset(&imageData, 0, sizeof(imageData));
+
+	/*
+	 * 8x8 BC1 with 3 levels. KTX2 stores levels smallest first, they must come
+	 * back largest first: 4 blocks of 8 bytes, then 1 block each for 4x4 and 2x2.
+	 */
+	imageData = image_load("texture-bc1.ktx2");
+	if (!imageData.pixels || imageData.vkFormat != VK_FORMAT_BC1_RGBA_UNORM_BLOCK || imageData.bitsPerPixel ||
+	    imageData.imageWidth != 8 || imageData.imageHeight != 8 || imageData.imageSize != 48 ||
+	    imageData.mipLevelCount != 3 ||
+	    !image_level_check(&imageData, 0, 0, 32, 8, 8, 0x10) ||
+	    !image_level_check(&imageData, 1, 32, 8, 4, 4, 0x40) ||
+	    !image_level_check(&imageData, 2, 40, 8, 2, 2, 0x60))
+	{
+		ret = 1; goto exit_error_image_container_loading;
+	}
+
+	free(imageData.pixels); imageData.pixels = NULL;
+
+	/* 8x8 DXT5 with 2 levels, already stored largest first */
+	imageData = image_load("texture-bc3.dds");
+	if (!imageData.pixels || imageData.vkFormat != VK_FORMAT_BC3_UNORM_BLOCK || imageData.imageSize != 80 ||
+	    imageData.imageWidth != 8 || imageData.imageHeight != 8 || imageData.mipLevelCount != 2 ||
+	    !image_level_check(&imageData, 0, 0, 64, 8, 8, 0x80) ||
+	    !image_level_check(&imageData, 1, 64, 16, 4, 4, 0xd0))
+	{
+		ret = 1; goto exit_error_image_container_loading;
+	}
+
+	free(imageData.pixels); imageData.pixels = NULL;
+
+	/* 2x2 DXGI_FORMAT_R8G8B8A8_UNORM_SRGB behind a DX10 header */
+	imageData = image_load("texture-rgba-dx10.dds");
+	if (!imageData.pixels || imageData.vkFormat != VK_FORMAT_R8G8B8A8_SRGB || imageData.imageSize != 16 ||
+	    imageData.imageChannels != 4 || imageData.mipLevelCount != 1 ||
+	    !image_level_check(&imageData, 0, 0, 16, 2, 2, 0x01))
+	{
+		ret = 1; goto exit_error_image_container_loading;
+	}
+
+	free(imageData.pixels); imageData.pixels = NULL;
+
+	for (i = 0; i < ARRAY_LEN(rejected); i++) {
+		imageData = image_load(rejected[i]);
+		if (imageData.pixels) { ret = 1; goto exit_error_image_container_loading; }
+	}
+
+exit_error_image_container_loading:
+	free(imageData.pixels);
+	return ret;
+}
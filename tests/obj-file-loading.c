@@ -0,0 +1,147 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "obj-loader.h"
+
+
+static struct kmr_obj_loader *
+obj_load (const char *fileName, uint32_t threadCount, uint32_t chunkSize, enum kmr_obj_loader_create_flags flags)
+{
+	struct kmr_obj_loader_create_info objInfo;
+
+	memset(&objInfo, 0, sizeof(objInfo));
+	objInfo.fileName = fileName;
+	objInfo.threadCount = threadCount;
+	objInfo.chunkSize = chunkSize;
+	objInfo.flags = flags;
+	objInfo.vertexLayout = KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_INTERLEAVED;
+	return kmr_obj_loader_create(&objInfo);
+}
+
+
+/* Meshes, primitives, vertices, indices and materials of @a and @b must be identical */
+static bool
+obj_equal (struct kmr_obj_loader *a, struct kmr_obj_loader *b)
+{
+	uint32_t m;
+
+	struct kmr_gltf_loader_mesh_data *meshDataA = NULL, *meshDataB = NULL;
+
+	if (a->mesh->meshDataCount != b->mesh->meshDataCount || a->materialDataCount != b->materialDataCount)
+		return false;
+
+	for (m = 0; m < a->mesh->meshDataCount; m++) {
+		meshDataA = &a->mesh->meshData[m];
+		meshDataB = &b->mesh->meshData[m];
+		if (meshDataA->firstIndex != meshDataB->firstIndex ||
+		    meshDataA->vertexBufferDataCount != meshDataB->vertexBufferDataCount ||
+		    meshDataA->indexBufferDataCount != meshDataB->indexBufferDataCount ||
+		    meshDataA->primitiveCount != meshDataB->primitiveCount ||
+		    memcmp(meshDataA->vertexBufferData, meshDataB->vertexBufferData, meshDataA->vertexBufferDataSize) ||
+		    memcmp(meshDataA->indexBufferData, meshDataB->indexBufferData, meshDataA->indexBufferDataSize) ||
+		    memcmp(meshDataA->primitives, meshDataB->primitives, meshDataA->primitiveCount * sizeof(struct kmr_gltf_loader_mesh_primitive)))
+		{
+			return false;
+		}
+	}
+
+	for (m = 0; m < a->materialDataCount; m++) {
+		if (strcmp(a->materialData[m].materialName, b->materialData[m].materialName) ||
+		    memcmp(a->materialData[m].diffuse, b->materialData[m].diffuse, sizeof(vec3)))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+int main(void)
+{
+	int ret = 0;
+	uint32_t f, v, c;
+
+	struct kmr_gltf_loader_mesh_data *meshData = NULL;
+	struct kmr_obj_loader *objSingle = NULL, *objChunked = NULL;
+
+	const enum kmr_obj_loader_create_flags flags[2] = { 0, KMR_OBJ_LOADER_CREATE_WELD };
+
+	/*
+	 * OBJ_RELATIVE_MODEL: -1 is the last attribute defined so far. The first face uses
+	 * positions 1,2,3 and the second, after a fourth position was added, 1,3,4. Texture
+	 * coordinates follow the same numbering and get flipped to a top left origin.
+	 */
+	const float positions[6][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 }, { 0, 0, 0 }, { 1, 1, 0 }, { 0, 1, 0 } };
+	const float texCoords[6][2] = { { 0, 1 }, { 1, 1 }, { 1, 0 }, { 0, 1 }, { 1, 0 }, { 0, 0 } };
+	const uint32_t indicesWelded[6] = { 0, 1, 2, 0, 2, 3 };
+	const uint32_t vertexWelded[4] = { 0, 1, 2, 5 };
+
+	/*
+	 * OBJ_CHUNKS_MODEL has groups "plane" (two 3x3 quad grids, spread out across the
+	 * file) and "back" (one 2x2 grid) and materials "red" and "green". Parsing it in
+	 * chunks of a few hundred bytes must give the same output as parsing it whole.
+	 */
+	for (f = 0; f < 2; f++) {
+		objSingle = obj_load(OBJ_CHUNKS_MODEL, 1, 0, flags[f]);
+		objChunked = obj_load(OBJ_CHUNKS_MODEL, 4, 256, flags[f]);
+		if (!objSingle || !objChunked || !obj_equal(objSingle, objChunked)) { ret = 1; goto exit_error_obj_file_loading; }
+
+		if (objSingle->mesh->meshDataCount != 2 || objSingle->materialDataCount != 2 ||
+		    strcmp(objSingle->materialData[0].materialName, "red") ||
+		    strcmp(objSingle->materialData[1].materialName, "green") ||
+		    objSingle->mesh->meshData[0].primitiveCount != 2 || objSingle->mesh->meshData[1].primitiveCount != 1 ||
+		    objSingle->mesh->meshData[0].indexBufferDataCount != 36 * 3 ||
+		    objSingle->mesh->meshData[1].indexBufferDataCount != 8 * 3)
+		{
+			ret = 1; goto exit_error_obj_file_loading;
+		}
+
+		/* Welding shares grid corners between triangles of the same material */
+		if ((!flags[f] && objSingle->mesh->meshData[1].vertexBufferDataCount != 24) ||
+		    (flags[f] && objSingle->mesh->meshData[1].vertexBufferDataCount != 9))
+		{
+			ret = 1; goto exit_error_obj_file_loading;
+		}
+
+		kmr_obj_loader_destroy(objSingle); objSingle = NULL;
+		kmr_obj_loader_destroy(objChunked); objChunked = NULL;
+	}
+
+	/* Relative indices can't be resolved by later chunks, loading falls back to one chunk */
+	for (f = 0; f < 2; f++) {
+		objSingle = obj_load(OBJ_RELATIVE_MODEL, 1, 0, flags[f]);
+		objChunked = obj_load(OBJ_RELATIVE_MODEL, 4, 16, flags[f]);
+		if (!objSingle || !objChunked || !obj_equal(objSingle, objChunked) ||
+		    objSingle->mesh->meshDataCount != 1 || objSingle->mesh->meshData[0].indexBufferDataCount != 6 ||
+		    objSingle->mesh->meshData[0].vertexBufferDataCount != ((flags[f]) ? 4 : 6))
+		{
+			ret = 1; goto exit_error_obj_file_loading;
+		}
+
+		meshData = &objSingle->mesh->meshData[0];
+		for (v = 0; v < meshData->vertexBufferDataCount; v++) {
+			c = (flags[f]) ? vertexWelded[v] : v;
+			if (memcmp(meshData->vertexBufferData[v].position, positions[c], sizeof(vec3)) ||
+			    memcmp(meshData->vertexBufferData[v].texCoord, texCoords[c], sizeof(vec2)) ||
+			    meshData->vertexBufferData[v].normal[2] != 1.0f)
+			{
+				ret = 1; goto exit_error_obj_file_loading;
+			}
+		}
+
+		for (v = 0; v < meshData->indexBufferDataCount; v++) {
+			if (meshData->indexBufferData[v] != ((flags[f]) ? indicesWelded[v] : v)) {
+				ret = 1; goto exit_error_obj_file_loading;
+			}
+		}
+
+		kmr_obj_loader_destroy(objSingle); objSingle = NULL;
+		kmr_obj_loader_destroy(objChunked); objChunked = NULL;
+	}
+
+exit_error_obj_file_loading:
+	kmr_obj_loader_destroy(objSingle);
+	kmr_obj_loader_destroy(objChunked);
+	return ret;
+}
@@ -0,0 +1,51 @@
+#ifndef KMR_TEST_UTILS_H
+#define KMR_TEST_UTILS_H
+
+#include <stdbool.h>
+#include <math.h>
+#include "gltf-loader.h"
+#include "gltf-scene-graph.h"
+
+
+/* True if the first @count floats of @a and @b are at most @epsilon apart */
+static inline bool
+test_vec_near (const float *a, const float *b, uint32_t count, float epsilon)
+{
+	uint32_t c;
+
+	for (c = 0; c < count; c++)
+		if (fabsf(a[c] - b[c]) > epsilon)
+			return false;
+
+	return true;
+}
+
+
+/*
+ * Loads @fileName and builds the scene graph of its first scene. On failure whatever
+ * was created is still returned through @gltfLoaderFile/@gltfLoaderSceneGraph for the
+ * caller to destroy.
+ */
+static inline int
+test_gltf_scene_load (const char *fileName, struct kmr_gltf_loader_file **gltfLoaderFile,
+                      struct kmr_gltf_loader_scene_graph **gltfLoaderSceneGraph)
+{
+	struct kmr_gltf_loader_file_create_info gltfLoaderFileCreateInfo;
+	struct kmr_gltf_loader_scene_graph_create_info gltfSceneGraphInfo;
+
+	gltfLoaderFileCreateInfo.fileName = fileName;
+	gltfLoaderFileCreateInfo.flags = 0;
+	*gltfLoaderFile = kmr_gltf_loader_file_create(&gltfLoaderFileCreateInfo);
+	if (!*gltfLoaderFile)
+		return -1;
+
+	gltfSceneGraphInfo.gltfFile = *gltfLoaderFile;
+	gltfSceneGraphInfo.sceneIndex = 0;
+	*gltfLoaderSceneGraph = kmr_gltf_loader_scene_graph_create(&gltfSceneGraphInfo);
+	if (!*gltfLoaderSceneGraph)
+		return -1;
+
+	return 0;
+}
+
+#endif /* KMR_TEST_UTILS_H */
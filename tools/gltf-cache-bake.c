@@ -0,0 +1,162 @@
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "gltf-loader.h"
+#include "gltf-cache.h"
+
+/*
+ * Bakes a .gltf/.glb file into a .kmrcache so applications can skip
+ * JSON parsing, accessor decoding and image decoding on startup.
+ */
+
+static void
+usage (const char *name)
+{
+	fprintf(stderr, "Usage: %s [options] <model.gltf|model.glb> <model.kmrcache>\n"
+	                "  -w  Weld duplicate vertices\n"
+	                "  -d  Downsize indices to 16-bit where possible\n"
+	                "  -o  Optimize index buffers for the post-transform vertex cache\n"
+	                "  -l  Vertex layout: interleaved (default), packed or soa\n"
+	                "  -s  Scene index used to compute node transforms (default 0)\n"
+	                "  -t  Amount of threads (default amount of online CPU's)\n"
+	                "  -m  Generate texture mip chains with filter: box or kaiser\n", name);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+	int opt, ret = EXIT_FAILURE;
+	bool optimize = false;
+
+	struct kmr_gltf_loader_file *gltfLoaderFile = NULL;
+	struct kmr_gltf_loader_mesh *gltfLoaderMesh = NULL;
+	struct kmr_gltf_loader_material *gltfLoaderMaterial = NULL;
+	struct kmr_gltf_loader_node *gltfLoaderNode = NULL;
+	struct kmr_gltf_loader_texture_image *gltfLoaderTextureImage = NULL;
+
+	struct kmr_gltf_loader_file_create_info gltfFileInfo;
+	struct kmr_gltf_loader_mesh_create_info gltfMeshInfo;
+	struct kmr_gltf_loader_mesh_optimize_info gltfMeshOptimizeInfo;
+	struct kmr_gltf_loader_material_create_info gltfMaterialInfo;
+	struct kmr_gltf_loader_node_create_info gltfNodeInfo;
+	struct kmr_gltf_loader_texture_image_create_info gltfTextureImageInfo;
+	struct kmr_gltf_loader_cache_write_info gltfCacheWriteInfo;
+
+	memset(&gltfMeshInfo, 0, sizeof(gltfMeshInfo));
+	memset(&gltfNodeInfo, 0, sizeof(gltfNodeInfo));
+	memset(&gltfTextureImageInfo, 0, sizeof(gltfTextureImageInfo));
+
+	while ((opt = getopt(argc, argv, "wdol:s:t:m:h")) != -1) {
+		switch (opt) {
+			case 'w':
+				gltfMeshInfo.flags |= KMR_GLTF_LOADER_MESH_CREATE_WELD;
+				break;
+			case 'd':
+				gltfMeshInfo.flags |= KMR_GLTF_LOADER_MESH_CREATE_INDEX_DOWNSIZE;
+				break;
+			case 'o':
+				optimize = true;
+				break;
+			case 'l':
+				if (!strcmp(optarg, "interleaved")) {
+					gltfMeshInfo.vertexLayout = KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_INTERLEAVED;
+				} else if (!strcmp(optarg, "packed")) {
+					gltfMeshInfo.vertexLayout = KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_PACKED;
+				} else if (!strcmp(optarg, "soa")) {
+					gltfMeshInfo.vertexLayout = KMR_GLTF_LOADER_MESH_VERTEX_LAYOUT_SOA;
+				} else {
+					usage(argv[0]);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 's':
+				gltfNodeInfo.sceneIndex = strtoul(optarg, NULL, 10);
+				break;
+			case 't':
+				gltfMeshInfo.threadCount = strtoul(optarg, NULL, 10);
+				break;
+			case 'm':
+				if (!strcmp(optarg, "box")) {
+					gltfTextureImageInfo.mipFilter = KMR_UTILS_IMAGE_BUFFER_MIP_FILTER_BOX;
+				} else if (!strcmp(optarg, "kaiser")) {
+					gltfTextureImageInfo.mipFilter = KMR_UTILS_IMAGE_BUFFER_MIP_FILTER_KAISER;
+				} else {
+					usage(argv[0]);
+					return EXIT_FAILURE;
+				}
+				break;
+			default:
+				usage(argv[0]);
+				return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+
+	if (argc - optind != 2) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	gltfFileInfo.fileName = argv[optind];
+	gltfFileInfo.flags = KMR_GLTF_LOADER_FILE_CREATE_MMAP;
+	gltfLoaderFile = kmr_gltf_loader_file_create(&gltfFileInfo);
+	if (!gltfLoaderFile)
+		goto exit_gltf_cache_bake;
+
+	gltfMeshInfo.gltfFile = gltfLoaderFile;
+	gltfMeshInfo.bufferIndex = 0;
+	gltfMeshInfo.arena = NULL;
+	gltfMeshInfo.arenaSize = 0;
+	gltfLoaderMesh = kmr_gltf_loader_mesh_create(&gltfMeshInfo);
+	if (!gltfLoaderMesh)
+		goto exit_gltf_cache_bake;
+
+	if (optimize) {
+		gltfMeshOptimizeInfo.mesh = gltfLoaderMesh;
+		gltfMeshOptimizeInfo.cacheSize = 0;
+		gltfMeshOptimizeInfo.threadCount = gltfMeshInfo.threadCount;
+		if (kmr_gltf_loader_mesh_optimize(&gltfMeshOptimizeInfo) == -1)
+			goto exit_gltf_cache_bake;
+	}
+
+	gltfMaterialInfo.gltfFile = gltfLoaderFile;
+	gltfLoaderMaterial = kmr_gltf_loader_material_create(&gltfMaterialInfo);
+	if (!gltfLoaderMaterial)
+		goto exit_gltf_cache_bake;
+
+	gltfNodeInfo.gltfFile = gltfLoaderFile;
+	gltfLoaderNode = kmr_gltf_loader_node_create(&gltfNodeInfo);
+	if (!gltfLoaderNode)
+		goto exit_gltf_cache_bake;
+
+	if (gltfLoaderFile->gltfData->images_count) {
+		gltfTextureImageInfo.gltfFile = gltfLoaderFile;
+		gltfTextureImageInfo.directory = argv[optind];
+		gltfTextureImageInfo.threadCount = gltfMeshInfo.threadCount;
+		gltfLoaderTextureImage = kmr_gltf_loader_texture_image_create(&gltfTextureImageInfo);
+		if (!gltfLoaderTextureImage)
+			goto exit_gltf_cache_bake;
+	}
+
+	gltfCacheWriteInfo.gltfFile = gltfLoaderFile;
+	gltfCacheWriteInfo.sourceFileName = argv[optind];
+	gltfCacheWriteInfo.cacheFileName = argv[optind + 1];
+	gltfCacheWriteInfo.mesh = gltfLoaderMesh;
+	gltfCacheWriteInfo.material = gltfLoaderMaterial;
+	gltfCacheWriteInfo.node = gltfLoaderNode;
+	gltfCacheWriteInfo.textureImage = gltfLoaderTextureImage;
+	if (kmr_gltf_loader_cache_write(&gltfCacheWriteInfo) == -1)
+		goto exit_gltf_cache_bake;
+
+	kmr_utils_log(KMR_SUCCESS, "Baked %s into %s", argv[optind], argv[optind + 1]);
+	ret = EXIT_SUCCESS;
+
+exit_gltf_cache_bake:
+	kmr_gltf_loader_texture_image_destroy(gltfLoaderTextureImage);
+	kmr_gltf_loader_node_destroy(gltfLoaderNode);
+	kmr_gltf_loader_material_destroy(gltfLoaderMaterial);
+	kmr_gltf_loader_mesh_destroy(gltfLoaderMesh);
+	kmr_gltf_loader_file_destroy(gltfLoaderFile);
+	return ret;
+}